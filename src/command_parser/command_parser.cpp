@@ -2,6 +2,7 @@
 #include "../common/structured_logger.h"
 #include "../common/error_handler.h"
 #include "../common/input_validator.h"
+#include "../common/string_utils.h"
 #include "../task_engine/task_engine.h"
 #include "../llm_connector/llm_connector.h"
 #include <algorithm>
@@ -197,8 +198,7 @@ IntentAnalysis CommandParser::analyzeIntent(const std::string& userInput) {
 }
 
 IntentType CommandParser::classifyIntent(const std::string& input) {
-    std::string lowerInput = input;
-    std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(), ::tolower);
+    std::string lowerInput = utils::StringUtils::toLowerCase(input);
     
     if (containsAutomationKeywords(lowerInput)) {
         return IntentType::AUTOMATION;
@@ -221,8 +221,7 @@ IntentType CommandParser::classifyIntent(const std::string& input) {
 ConfidenceLevel CommandParser::calculateConfidence(const std::string& input, IntentType intent) {
     (void)intent; // TODO: Use intent type in confidence calculation
     int confidenceScore = 0;
-    std::string lowerInput = input;
-    std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(), ::tolower);
+    std::string lowerInput = utils::StringUtils::toLowerCase(input);
     
     // Check for specific keywords that increase confidence
     std::vector<std::string> strongKeywords = {
@@ -293,8 +292,7 @@ std::map<std::string, std::string> CommandParser::extractEntities(const std::str
 
 std::vector<std::string> CommandParser::extractApplicationNames(const std::string& input) {
     std::vector<std::string> apps;
-    std::string lowerInput = input;
-    std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(), ::tolower);
+    std::string lowerInput = utils::StringUtils::toLowerCase(input);
     
     // Common application names
     std::vector<std::string> commonApps = {
@@ -330,8 +328,7 @@ std::vector<std::string> CommandParser::extractFileNames(const std::string& inpu
 
 std::vector<std::string> CommandParser::extractActionVerbs(const std::string& input) {
     std::vector<std::string> verbs;
-    std::string lowerInput = input;
-    std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(), ::tolower);
+    std::string lowerInput = utils::StringUtils::toLowerCase(input);
     
     std::vector<std::string> actionVerbs = {
         "click", "type", "open", "close", "run", "execute", "launch",
@@ -404,8 +401,7 @@ std::vector<ParsedCommand> CommandParser::matchAutomationPatterns(const std::str
 
 std::vector<ParsedCommand> CommandParser::parseUIInteractionCommand(const std::string& input) {
     std::vector<ParsedCommand> commands;
-    std::string lowerInput = input;
-    std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(), ::tolower);
+    std::string lowerInput = utils::StringUtils::toLowerCase(input);
     
     // Extract coordinates
     std::regex coordRegex(R"(\b(\d+)\s*,\s*(\d+)\b)");
@@ -448,8 +444,7 @@ std::vector<ParsedCommand> CommandParser::parseApplicationCommand(const std::str
     
     if (!apps.empty()) {
         std::string app = apps[0];
-        std::string lowerInput = input;
-        std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(), ::tolower);
+        std::string lowerInput = utils::StringUtils::toLowerCase(input);
         
         if (lowerInput.find("open") != std::string::npos || lowerInput.find("launch") != std::string::npos) {
             commands.push_back(createApplicationCommand(app, "launch"));
@@ -555,15 +550,25 @@ ParsedCommand CommandParser::createApplicationCommand(const std::string& appName
 }
 
 std::string CommandParser::normalizeInput(const std::string& input) {
-    std::string normalized = input;
-    
-    // Remove extra whitespace
-    std::regex whitespaceRegex(R"(\s+)");
-    normalized = std::regex_replace(normalized, whitespaceRegex, " ");
+    std::string normalized;
+    normalized.reserve(input.size());
+    
+    // Collapse whitespace runs into single spaces
+    bool inWhitespace = false;
+    for (char c : input) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!inWhitespace) {
+                normalized += ' ';
+                inWhitespace = true;
+            }
+        } else {
+            normalized += c;
+            inWhitespace = false;
+        }
+    }
     
     // Trim leading/trailing whitespace
-    normalized.erase(0, normalized.find_first_not_of(" \t\n\r"));
-    normalized.erase(normalized.find_last_not_of(" \t\n\r") + 1);
+    utils::StringUtils::trimInPlace(normalized);
     
     return normalized;
 }
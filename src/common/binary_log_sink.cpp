@@ -0,0 +1,525 @@
+#include "binary_log_sink.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace burwell {
+
+namespace {
+
+// On-disk layout (all integers little-endian)
+//
+// Segment:  magic "BWBLOG\0\1" | u32 version | u32 segment index | i64 created (ns since epoch)
+//           followed by entries: u32 length (bytes after this field) | u8 kind | body
+//
+//           'T' u32 id | template              defines a template for later records in the segment
+//           'H' u32 thread index | str name    names a thread for later records in the segment
+//           'R' i64 timestamp ns | u32 template id | u32 thread index | i64 duration ns |
+//               u32 context size | MessagePack context | [inline template when template id is 0]
+//
+// Template: u8 level | u32 line | str logger | str file | str message | str operation
+// str:      u32 size | bytes
+constexpr char SEGMENT_MAGIC[8] = {'B', 'W', 'B', 'L', 'O', 'G', '\0', '\1'};
+constexpr uint32_t FORMAT_VERSION = 2;
+constexpr size_t SEGMENT_HEADER_SIZE = 24;
+constexpr size_t MIN_SEGMENT_SIZE = 4096;
+constexpr uint32_t MAX_RECORD_SIZE = 64 * 1024 * 1024;
+constexpr char ENTRY_TEMPLATE = 'T';
+constexpr char ENTRY_THREAD = 'H';
+constexpr char ENTRY_RECORD = 'R';
+constexpr uint32_t INLINE_TEMPLATE_ID = 0;
+
+void appendU8(std::string& out, uint8_t value) {
+    out += static_cast<char>(value);
+}
+
+void appendU32(std::string& out, uint32_t value) {
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+    out.append(bytes, sizeof(bytes));
+}
+
+void appendU64(std::string& out, uint64_t value) {
+    char bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+    out.append(bytes, sizeof(bytes));
+}
+
+void appendI64(std::string& out, int64_t value) {
+    appendU64(out, static_cast<uint64_t>(value));
+}
+
+void appendString(std::string& out, const std::string& value) {
+    appendU32(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+void patchU32(std::string& out, size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void appendTemplate(std::string& out, const LogEntry& entry) {
+    appendU8(out, static_cast<uint8_t>(entry.level));
+    appendU32(out, static_cast<uint32_t>(entry.line));
+    appendString(out, entry.logger_name);
+    appendString(out, entry.file);
+    appendString(out, entry.message);
+    appendString(out, entry.operation_name);
+}
+
+// Bounds-checked little-endian reader over a byte range
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t size) : m_data(data), m_size(size), m_pos(0) {}
+
+    bool readU8(uint8_t& value) {
+        if (m_size - m_pos < 1) return false;
+        value = static_cast<uint8_t>(m_data[m_pos++]);
+        return true;
+    }
+
+    bool readU32(uint32_t& value) {
+        if (m_size - m_pos < 4) return false;
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(m_data[m_pos + i])) << (8 * i);
+        }
+        m_pos += 4;
+        return true;
+    }
+
+    bool readU64(uint64_t& value) {
+        if (m_size - m_pos < 8) return false;
+        value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(m_data[m_pos + i])) << (8 * i);
+        }
+        m_pos += 8;
+        return true;
+    }
+
+    bool readI64(int64_t& value) {
+        uint64_t raw;
+        if (!readU64(raw)) return false;
+        value = static_cast<int64_t>(raw);
+        return true;
+    }
+
+    bool readBytes(size_t count, const char*& bytes) {
+        if (m_size - m_pos < count) return false;
+        bytes = m_data + m_pos;
+        m_pos += count;
+        return true;
+    }
+
+    bool readString(std::string& value) {
+        uint32_t size;
+        const char* bytes;
+        if (!readU32(size) || !readBytes(size, bytes)) return false;
+        value.assign(bytes, size);
+        return true;
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    size_t m_pos;
+};
+
+template <typename TemplateT>
+bool readTemplate(ByteReader& reader, TemplateT& tmpl) {
+    uint8_t level;
+    uint32_t line;
+    if (!reader.readU8(level) || !reader.readU32(line) ||
+        !reader.readString(tmpl.logger) || !reader.readString(tmpl.file) ||
+        !reader.readString(tmpl.message) || !reader.readString(tmpl.operation)) {
+        return false;
+    }
+    tmpl.level = static_cast<::LogLevel>(level);
+    tmpl.line = static_cast<int>(line);
+    return true;
+}
+
+// FNV-1a over the fields that identify a template
+uint64_t hashTemplate(::LogLevel level, int line, const std::string& logger,
+                      const std::string& file, const std::string& message,
+                      const std::string& operation) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        // Field separator so ("ab","c") and ("a","bc") differ
+        hash ^= 0xFF;
+        hash *= 1099511628211ULL;
+    };
+    int levelValue = static_cast<int>(level);
+    mix(reinterpret_cast<const char*>(&levelValue), sizeof(levelValue));
+    mix(reinterpret_cast<const char*>(&line), sizeof(line));
+    mix(logger.data(), logger.size());
+    mix(file.data(), file.size());
+    mix(message.data(), message.size());
+    mix(operation.data(), operation.size());
+    return hash;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return "";
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+bool readSegmentHeader(const std::string& path, int64_t& created) {
+    std::ifstream file(path, std::ios::binary);
+    char header[SEGMENT_HEADER_SIZE];
+    if (!file.read(header, sizeof(header)) ||
+        std::memcmp(header, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0) {
+        return false;
+    }
+    ByteReader reader(header + sizeof(SEGMENT_MAGIC), sizeof(header) - sizeof(SEGMENT_MAGIC));
+    uint32_t version;
+    uint32_t index;
+    return reader.readU32(version) && version == FORMAT_VERSION &&
+           reader.readU32(index) && reader.readI64(created);
+}
+
+} // anonymous namespace
+
+// BinaryLogSink implementation
+BinaryLogSink::BinaryLogSink(const Config& config)
+    : m_config(config)
+    , m_started(false)
+    , m_segmentIndex(0)
+    , m_segmentBytes(0) {
+
+    m_config.segment_count = std::max<size_t>(m_config.segment_count, 1);
+    m_config.segment_size = std::max(m_config.segment_size, MIN_SEGMENT_SIZE);
+
+    fs::path base(m_config.base_path);
+    if (base.has_parent_path()) {
+        std::error_code ec;
+        fs::create_directories(base.parent_path(), ec);
+    }
+
+    openNextSegment();
+}
+
+BinaryLogSink::~BinaryLogSink() {
+    flush();
+}
+
+std::string BinaryLogSink::getSegmentPath(size_t index) const {
+    return m_config.base_path + "." + std::to_string(index);
+}
+
+uint32_t BinaryLogSink::lookupOrRegisterTemplate(const LogEntry& entry) {
+    uint64_t hash = hashTemplate(entry.level, entry.line, entry.logger_name, entry.file,
+                                 entry.message, entry.operation_name);
+
+    auto it = m_templateIndex.find(hash);
+    if (it != m_templateIndex.end()) {
+        for (uint32_t id : it->second) {
+            const Template& tmpl = m_templates[id - 1];
+            if (tmpl.level == entry.level && tmpl.line == entry.line &&
+                tmpl.message == entry.message && tmpl.logger == entry.logger_name &&
+                tmpl.file == entry.file && tmpl.operation == entry.operation_name) {
+                return id;
+            }
+        }
+    }
+
+    if (m_templates.size() >= m_config.max_templates) {
+        // Messages with variable text would fill the segment with definitions
+        return INLINE_TEMPLATE_ID;
+    }
+
+    uint32_t id = static_cast<uint32_t>(m_templates.size() + 1);
+    m_templates.push_back({entry.level, entry.line, entry.logger_name, entry.file,
+                           entry.message, entry.operation_name});
+    m_templateIndex[hash].push_back(id);
+
+    size_t start = m_record.size();
+    appendU32(m_record, 0);
+    appendU8(m_record, static_cast<uint8_t>(ENTRY_TEMPLATE));
+    appendU32(m_record, id);
+    appendTemplate(m_record, entry);
+    patchU32(m_record, start, static_cast<uint32_t>(m_record.size() - start - 4));
+    return id;
+}
+
+uint32_t BinaryLogSink::lookupOrRegisterThread(std::thread::id id) {
+    auto it = m_threadIndex.find(id);
+    if (it != m_threadIndex.end()) {
+        return it->second;
+    }
+
+    uint32_t index = static_cast<uint32_t>(m_threadIndex.size());
+    m_threadIndex.emplace(id, index);
+
+    std::ostringstream name;
+    name << id;
+    size_t start = m_record.size();
+    appendU32(m_record, 0);
+    appendU8(m_record, static_cast<uint8_t>(ENTRY_THREAD));
+    appendU32(m_record, index);
+    appendString(m_record, name.str());
+    patchU32(m_record, start, static_cast<uint32_t>(m_record.size() - start - 4));
+    return index;
+}
+
+void BinaryLogSink::encodeEntry(const LogEntry& entry) {
+    m_record.clear();
+    uint32_t templateId = lookupOrRegisterTemplate(entry);
+    uint32_t threadIndex = lookupOrRegisterThread(entry.thread_id);
+
+    size_t start = m_record.size();
+    appendU32(m_record, 0);  // Length, patched below
+    appendU8(m_record, static_cast<uint8_t>(ENTRY_RECORD));
+    appendI64(m_record, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        entry.timestamp.time_since_epoch()).count());
+    appendU32(m_record, templateId);
+    appendU32(m_record, threadIndex);
+    appendI64(m_record, entry.duration.count());
+    appendU32(m_record, static_cast<uint32_t>(m_context.size()));
+    m_record.append(reinterpret_cast<const char*>(m_context.data()), m_context.size());
+
+    if (templateId == INLINE_TEMPLATE_ID) {
+        appendTemplate(m_record, entry);
+    }
+    patchU32(m_record, start, static_cast<uint32_t>(m_record.size() - start - 4));
+}
+
+void BinaryLogSink::openNextSegment() {
+    if (m_started) {
+        m_segment.close();
+        m_segmentIndex = (m_segmentIndex + 1) % m_config.segment_count;
+    } else {
+        // First segment of this run goes after the newest one on disk
+        int64_t newest = 0;
+        bool found = false;
+        for (size_t i = 0; i < m_config.segment_count; ++i) {
+            int64_t created;
+            if (readSegmentHeader(getSegmentPath(i), created) && (!found || created > newest)) {
+                newest = created;
+                m_segmentIndex = (i + 1) % m_config.segment_count;
+                found = true;
+            }
+        }
+        m_started = true;
+    }
+
+    // Registries are per segment, so the new segment starts without definitions
+    m_templates.clear();
+    m_templateIndex.clear();
+    m_threadIndex.clear();
+
+    // Counted even if the open fails: the next rotation then tries the next file
+    m_segmentBytes = SEGMENT_HEADER_SIZE;
+    m_segment.open(getSegmentPath(m_segmentIndex), std::ios::binary | std::ios::trunc);
+    if (!m_segment) {
+        std::cerr << "Failed to open binary log segment: " << getSegmentPath(m_segmentIndex) << std::endl;
+        return;
+    }
+
+    std::string header(SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    appendU32(header, FORMAT_VERSION);
+    appendU32(header, static_cast<uint32_t>(m_segmentIndex));
+    appendI64(header, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    m_segment.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+void BinaryLogSink::write(const LogEntry& entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_context.clear();
+    if (!entry.context.is_null() && !entry.context.empty()) {
+        nlohmann::json::to_msgpack(entry.context, m_context);
+    }
+
+    encodeEntry(entry);
+    if (m_segmentBytes + m_record.size() > m_config.segment_size &&
+        m_segmentBytes > SEGMENT_HEADER_SIZE) {
+        // The definitions just encoded belong to the old segment; redo them for the new one
+        openNextSegment();
+        encodeEntry(entry);
+    }
+
+    m_segmentBytes += m_record.size();
+    if (m_segment) {
+        m_segment.write(m_record.data(), static_cast<std::streamsize>(m_record.size()));
+    }
+}
+
+void BinaryLogSink::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_segment.is_open()) {
+        m_segment.flush();
+    }
+}
+
+size_t BinaryLogSink::getTemplateCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_templates.size();
+}
+
+// BinaryLogReader implementation
+BinaryLogReader::BinaryLogReader(const std::string& basePath)
+    : m_basePath(basePath)
+    , m_skippedRecords(0) {
+}
+
+bool BinaryLogReader::readSegment(const std::string& path,
+                                  const std::function<void(const LogEntry&)>& onEntry) {
+    std::string contents = readFile(path);
+    if (contents.size() < SEGMENT_HEADER_SIZE) {
+        m_lastError = "Truncated segment header: " + path;
+        return false;
+    }
+
+    // Template and thread ids are only meaningful within their segment
+    m_templates.clear();
+    m_threads.clear();
+
+    ByteReader reader(contents.data() + SEGMENT_HEADER_SIZE, contents.size() - SEGMENT_HEADER_SIZE);
+    uint32_t length;
+    const char* payload;
+    LogEntry entry;
+    // A torn record at the end (crash mid-write) simply ends the segment
+    while (reader.readU32(length) && length <= MAX_RECORD_SIZE && reader.readBytes(length, payload)) {
+        ByteReader record(payload, length);
+        uint8_t kind;
+        uint32_t id;
+        if (!record.readU8(kind)) {
+            ++m_skippedRecords;
+            continue;
+        }
+        if (kind == ENTRY_TEMPLATE) {
+            Template tmpl;
+            if (record.readU32(id) && readTemplate(record, tmpl)) {
+                m_templates[id] = std::move(tmpl);
+            }
+            continue;
+        }
+        if (kind == ENTRY_THREAD) {
+            std::string name;
+            if (record.readU32(id) && record.readString(name)) {
+                m_threads[id] = std::move(name);
+            }
+            continue;
+        }
+        if (kind != ENTRY_RECORD) {
+            ++m_skippedRecords;
+            continue;
+        }
+
+        int64_t timestampNs;
+        uint32_t templateId;
+        uint32_t threadIndex;
+        int64_t durationNs;
+        uint32_t contextSize;
+        const char* contextBytes;
+        if (!record.readI64(timestampNs) || !record.readU32(templateId) ||
+            !record.readU32(threadIndex) || !record.readI64(durationNs) ||
+            !record.readU32(contextSize) || !record.readBytes(contextSize, contextBytes)) {
+            ++m_skippedRecords;
+            continue;
+        }
+
+        Template inlineTemplate;
+        const Template* tmpl = nullptr;
+        if (templateId == INLINE_TEMPLATE_ID) {
+            if (readTemplate(record, inlineTemplate)) {
+                tmpl = &inlineTemplate;
+            }
+        } else {
+            auto it = m_templates.find(templateId);
+            if (it != m_templates.end()) {
+                tmpl = &it->second;
+            }
+        }
+        if (!tmpl) {
+            ++m_skippedRecords;
+            continue;
+        }
+
+        entry.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(timestampNs)));
+        entry.level = tmpl->level;
+        entry.message = tmpl->message;
+        entry.logger_name = tmpl->logger;
+        entry.file = tmpl->file;
+        entry.line = tmpl->line;
+        entry.operation_name = tmpl->operation;
+        entry.duration = std::chrono::nanoseconds(durationNs);
+
+        auto thread = m_threads.find(threadIndex);
+        entry.thread_name = thread != m_threads.end() ? thread->second
+                                                      : "thread-" + std::to_string(threadIndex);
+
+        entry.context = nlohmann::json();
+        if (contextSize > 0) {
+            try {
+                entry.context = nlohmann::json::from_msgpack(
+                    reinterpret_cast<const uint8_t*>(contextBytes),
+                    reinterpret_cast<const uint8_t*>(contextBytes) + contextSize);
+            } catch (const nlohmann::json::exception&) {
+                entry.context = {{"decode_error", "invalid context"}};
+            }
+        }
+
+        onEntry(entry);
+    }
+    return true;
+}
+
+bool BinaryLogReader::read(const std::function<void(const LogEntry&)>& onEntry) {
+    m_lastError.clear();
+    m_skippedRecords = 0;
+
+    // Segment count is not recorded, so take every consecutive <base>.N present
+    std::vector<std::pair<int64_t, std::string>> segments;
+    for (size_t i = 0;; ++i) {
+        std::string path = m_basePath + "." + std::to_string(i);
+        if (!fs::exists(path)) {
+            break;
+        }
+        int64_t created;
+        if (!readSegmentHeader(path, created)) {
+            m_lastError = "Invalid segment header: " + path;
+            return false;
+        }
+        segments.emplace_back(created, path);
+    }
+
+    if (segments.empty()) {
+        m_lastError = "No segments found for " + m_basePath;
+        return false;
+    }
+
+    std::sort(segments.begin(), segments.end());
+    for (const auto& segment : segments) {
+        if (!readSegment(segment.second, onEntry)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace burwell
@@ -0,0 +1,118 @@
+#ifndef BURWELL_BINARY_LOG_SINK_H
+#define BURWELL_BINARY_LOG_SINK_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include "structured_logger.h"
+
+namespace burwell {
+
+/**
+ * @brief Compact binary log sink
+ *
+ * Each entry is stored as a template id, a thread index, the timestamp and
+ * duration, and the context encoded as MessagePack. A template (level, logger,
+ * source location, message and operation) and a thread name are defined once
+ * per segment, ahead of the first record that uses them. Records go to a ring
+ * of fixed-size segment files, so disk usage stays bounded, and every segment
+ * decodes on its own: overwriting a segment also drops its templates.
+ * Decode with BinaryLogReader or the burwell-logdecode tool.
+ */
+class BinaryLogSink : public ILogSink {
+public:
+    struct Config {
+        std::string base_path;                      // Segments <base>.0..N-1
+        size_t segment_size = 16 * 1024 * 1024;     // 16MB per segment
+        size_t segment_count = 4;                   // Ring of 4 segments
+        size_t max_templates = 65536;               // Per segment; further messages are stored inline
+    };
+
+    explicit BinaryLogSink(const Config& config);
+    ~BinaryLogSink();
+
+    void write(const LogEntry& entry) override;
+    void flush() override;
+
+    size_t getTemplateCount() const;
+
+private:
+    struct Template {
+        ::LogLevel level;
+        int line;
+        std::string logger;
+        std::string file;
+        std::string message;
+        std::string operation;
+    };
+
+    // Append the entry to m_record, preceded by any definitions the current segment lacks
+    void encodeEntry(const LogEntry& entry);
+    uint32_t lookupOrRegisterTemplate(const LogEntry& entry);
+    uint32_t lookupOrRegisterThread(std::thread::id id);
+    void openNextSegment();
+    std::string getSegmentPath(size_t index) const;
+
+    Config m_config;
+    mutable std::mutex m_mutex;
+
+    // Registry of the current segment: hash of the template fields -> ids with that hash
+    std::vector<Template> m_templates;              // Index = id - 1
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_templateIndex;
+    std::unordered_map<std::thread::id, uint32_t> m_threadIndex;
+
+    // Current segment
+    std::ofstream m_segment;
+    bool m_started;
+    size_t m_segmentIndex;
+    size_t m_segmentBytes;                          // Also counts entries dropped while the segment failed to open
+
+    // Reused encoding buffers
+    std::string m_record;
+    std::vector<uint8_t> m_context;
+};
+
+/**
+ * @brief Offline decoder for files written by BinaryLogSink
+ *
+ * Rebuilds LogEntry values, oldest segment first, so the regular text and
+ * JSON formatters can render them. Decoded entries carry the original thread
+ * id text in LogEntry::thread_name.
+ */
+class BinaryLogReader {
+public:
+    explicit BinaryLogReader(const std::string& basePath);
+
+    // Returns false if no segment exists or a segment header cannot be read
+    bool read(const std::function<void(const LogEntry&)>& onEntry);
+
+    const std::string& getLastError() const { return m_lastError; }
+    size_t getSkippedRecords() const { return m_skippedRecords; }
+
+private:
+    struct Template {
+        ::LogLevel level;
+        int line;
+        std::string logger;
+        std::string file;
+        std::string message;
+        std::string operation;
+    };
+
+    bool readSegment(const std::string& path, const std::function<void(const LogEntry&)>& onEntry);
+
+    std::string m_basePath;
+    std::unordered_map<uint32_t, Template> m_templates;     // Of the segment being read
+    std::unordered_map<uint32_t, std::string> m_threads;
+    std::string m_lastError;
+    size_t m_skippedRecords;
+};
+
+} // namespace burwell
+
+#endif // BURWELL_BINARY_LOG_SINK_H
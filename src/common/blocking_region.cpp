@@ -0,0 +1,32 @@
+#include "blocking_region.h"
+
+namespace burwell {
+
+namespace {
+
+// Cleared while a region is open, so nested regions see no observer
+thread_local BlockingRegion::Observer* t_observer = nullptr;
+
+} // anonymous namespace
+
+BlockingRegion::BlockingRegion() : m_observer(t_observer) {
+    if (m_observer) {
+        t_observer = nullptr;
+        m_observer->blockingBegin();
+    }
+}
+
+BlockingRegion::~BlockingRegion() {
+    if (m_observer) {
+        m_observer->blockingEnd();
+        t_observer = m_observer;
+    }
+}
+
+BlockingRegion::Observer* BlockingRegion::setThreadObserver(Observer* observer) {
+    Observer* previous = t_observer;
+    t_observer = observer;
+    return previous;
+}
+
+} // namespace burwell
@@ -0,0 +1,45 @@
+#ifndef BURWELL_BLOCKING_REGION_H
+#define BURWELL_BLOCKING_REGION_H
+
+namespace burwell {
+
+/**
+ * @brief Marks the calling thread as blocked for the lifetime of the object
+ *
+ * Wait helpers open one around the wait itself (sleeps, condition waits,
+ * process waits, future gets). On a ThreadPool worker this tells the pool
+ * that the worker is not using its CPU, so an elastic pool can start another
+ * worker while queued tasks wait. On any other thread it only reads a
+ * thread-local. Nested regions count once.
+ */
+class BlockingRegion {
+public:
+    /**
+     * @brief Receives the outermost region entered on a thread
+     */
+    class Observer {
+    public:
+        virtual ~Observer() = default;
+        virtual void blockingBegin() = 0;
+        virtual void blockingEnd() = 0;
+    };
+
+    BlockingRegion();
+    ~BlockingRegion();
+
+    BlockingRegion(const BlockingRegion&) = delete;
+    BlockingRegion& operator=(const BlockingRegion&) = delete;
+
+    /**
+     * @brief Install the observer for the calling thread
+     * @return The previous observer
+     */
+    static Observer* setThreadObserver(Observer* observer);
+
+private:
+    Observer* m_observer;                  // Null unless this is the outermost region
+};
+
+} // namespace burwell
+
+#endif // BURWELL_BLOCKING_REGION_H
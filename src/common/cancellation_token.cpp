@@ -0,0 +1,199 @@
+#include "cancellation_token.h"
+#include <atomic>
+#include <map>
+#include <thread>
+
+namespace burwell {
+
+namespace detail {
+
+struct CancellationState {
+    std::atomic<bool> cancelled{false};
+
+    std::mutex mutex;
+    std::condition_variable wake;          // Sleepers and unregister waits
+    std::map<uint64_t, std::function<void()>> callbacks;
+    uint64_t nextId = 1;
+    uint64_t runningId = 0;                // Callback being run by cancel()
+    bool callbacksDone = false;
+    std::thread::id cancellingThread;
+
+    // Link to the parent scope; the parent only holds a weak reference back
+    std::shared_ptr<CancellationState> parent;
+    uint64_t parentRegistration = 0;
+
+    ~CancellationState();
+
+    // Returns 0 if the callback ran inline because the scope is cancelled
+    uint64_t add(std::function<void()>& callback);
+    void remove(uint64_t id);
+    void cancel();
+};
+
+CancellationState::~CancellationState() {
+    if (parent && parentRegistration != 0) {
+        parent->remove(parentRegistration);
+    }
+}
+
+uint64_t CancellationState::add(std::function<void()>& callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!cancelled.load(std::memory_order_relaxed)) {
+            uint64_t id = nextId++;
+            callbacks.emplace(id, std::move(callback));
+            return id;
+        }
+    }
+    callback();
+    return 0;
+}
+
+void CancellationState::remove(uint64_t id) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (callbacks.erase(id) > 0 || callbacksDone) {
+        return;
+    }
+    // Unregistering from inside a callback must not wait for itself
+    if (cancellingThread == std::this_thread::get_id()) {
+        return;
+    }
+    wake.wait(lock, [&] { return runningId != id; });
+}
+
+void CancellationState::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        cancelled.store(true, std::memory_order_release);
+        cancellingThread = std::this_thread::get_id();
+    }
+    wake.notify_all();
+
+    // Run callbacks one at a time so remove() can tell pending from running
+    while (true) {
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (callbacks.empty()) {
+                runningId = 0;
+                callbacksDone = true;
+                break;
+            }
+            auto it = callbacks.begin();
+            runningId = it->first;
+            callback = std::move(it->second);
+            callbacks.erase(it);
+        }
+        try {
+            callback();
+        } catch (...) {
+            // A failing callback must not stop the others from running
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            runningId = 0;
+        }
+        wake.notify_all();
+    }
+    wake.notify_all();
+}
+
+} // namespace detail
+
+// CancellationRegistration implementation
+
+CancellationRegistration::CancellationRegistration(std::shared_ptr<detail::CancellationState> state, uint64_t id)
+    : m_state(std::move(state))
+    , m_id(id) {
+}
+
+CancellationRegistration::~CancellationRegistration() {
+    reset();
+}
+
+CancellationRegistration::CancellationRegistration(CancellationRegistration&& other) noexcept
+    : m_state(std::move(other.m_state))
+    , m_id(other.m_id) {
+    other.m_id = 0;
+}
+
+CancellationRegistration& CancellationRegistration::operator=(CancellationRegistration&& other) noexcept {
+    if (this != &other) {
+        reset();
+        m_state = std::move(other.m_state);
+        m_id = other.m_id;
+        other.m_id = 0;
+    }
+    return *this;
+}
+
+void CancellationRegistration::reset() {
+    if (m_state && m_id != 0) {
+        m_state->remove(m_id);
+    }
+    m_state.reset();
+    m_id = 0;
+}
+
+// CancellationToken implementation
+
+bool CancellationToken::isCancelled() const {
+    return m_state && m_state->cancelled.load(std::memory_order_acquire);
+}
+
+CancellationRegistration CancellationToken::onCancel(std::function<void()> callback) const {
+    if (!m_state) {
+        return CancellationRegistration();
+    }
+    uint64_t id = m_state->add(callback);
+    if (id == 0) {
+        return CancellationRegistration();
+    }
+    return CancellationRegistration(m_state, id);
+}
+
+bool CancellationToken::sleepFor(std::chrono::milliseconds duration) const {
+    BlockingRegion blocking;
+    if (!m_state) {
+        std::this_thread::sleep_for(duration);
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    return !m_state->wake.wait_for(lock, duration, [this] {
+        return m_state->cancelled.load(std::memory_order_relaxed);
+    });
+}
+
+// CancellationSource implementation
+
+CancellationSource::CancellationSource()
+    : m_state(std::make_shared<detail::CancellationState>()) {
+}
+
+CancellationSource::CancellationSource(const CancellationToken& parent)
+    : m_state(std::make_shared<detail::CancellationState>()) {
+    if (!parent.m_state) {
+        return;
+    }
+    std::weak_ptr<detail::CancellationState> weakChild = m_state;
+    std::function<void()> propagate = [weakChild] {
+        if (auto child = weakChild.lock()) {
+            child->cancel();
+        }
+    };
+    m_state->parent = parent.m_state;
+    m_state->parentRegistration = parent.m_state->add(propagate);
+}
+
+void CancellationSource::cancel() {
+    m_state->cancel();
+}
+
+bool CancellationSource::isCancelled() const {
+    return m_state->cancelled.load(std::memory_order_acquire);
+}
+
+} // namespace burwell
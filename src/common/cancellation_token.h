@@ -0,0 +1,134 @@
+#ifndef BURWELL_CANCELLATION_TOKEN_H
+#define BURWELL_CANCELLATION_TOKEN_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "blocking_region.h"
+
+namespace burwell {
+
+namespace detail {
+struct CancellationState;
+}
+
+/**
+ * @brief RAII handle for a callback registered on a CancellationToken
+ *
+ * Destroying the handle unregisters the callback. If the callback is running
+ * on another thread at that moment, the destructor waits for it to return,
+ * so objects the callback captured can be destroyed right after.
+ */
+class CancellationRegistration {
+public:
+    CancellationRegistration() = default;
+    ~CancellationRegistration();
+
+    CancellationRegistration(CancellationRegistration&& other) noexcept;
+    CancellationRegistration& operator=(CancellationRegistration&& other) noexcept;
+    CancellationRegistration(const CancellationRegistration&) = delete;
+    CancellationRegistration& operator=(const CancellationRegistration&) = delete;
+
+    void reset();
+
+private:
+    friend class CancellationToken;
+    CancellationRegistration(std::shared_ptr<detail::CancellationState> state, uint64_t id);
+
+    std::shared_ptr<detail::CancellationState> m_state;
+    uint64_t m_id = 0;
+};
+
+/**
+ * @brief Read-only view of a cancellation scope
+ *
+ * Tokens are cheap to copy and safe to share between threads. A
+ * default-constructed token is never cancelled. Blocking helpers
+ * (sleepFor, waitFor) return as soon as the scope is cancelled instead
+ * of polling a flag.
+ */
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    bool isCancelled() const;
+    bool canBeCancelled() const { return static_cast<bool>(m_state); }
+
+    /**
+     * @brief Run callback once when the scope is cancelled
+     * @return Registration that unregisters on destruction
+     * @note Runs the callback immediately on this thread if already cancelled.
+     *       Callbacks run on the cancelling thread and must not block.
+     */
+    CancellationRegistration onCancel(std::function<void()> callback) const;
+
+    /**
+     * @brief Sleep for duration unless cancelled first
+     * @return true if the full duration elapsed, false if cancelled
+     */
+    bool sleepFor(std::chrono::milliseconds duration) const;
+
+    /**
+     * @brief condition_variable::wait_for that also wakes on cancellation
+     * @return The predicate's final value; check isCancelled() to tell apart
+     * @note Cancellation takes the waiter's mutex to notify, so do not cancel
+     *       while holding that mutex.
+     */
+    template <typename Predicate>
+    bool waitFor(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+                 std::chrono::milliseconds timeout, Predicate predicate) const {
+        BlockingRegion blocking;
+        if (!m_state) {
+            return condition.wait_for(lock, timeout, predicate);
+        }
+        // Register unlocked: if already cancelled the callback runs inline
+        std::mutex* mutex = lock.mutex();
+        lock.unlock();
+        CancellationRegistration registration = onCancel([mutex, &condition] {
+            std::lock_guard<std::mutex> guard(*mutex);
+            condition.notify_all();
+        });
+        lock.lock();
+        condition.wait_for(lock, timeout, [&] { return predicate() || isCancelled(); });
+        bool satisfied = predicate();
+        // A callback running elsewhere needs the mutex; let it finish before unregistering
+        lock.unlock();
+        registration.reset();
+        lock.lock();
+        return satisfied;
+    }
+
+private:
+    friend class CancellationSource;
+    explicit CancellationToken(std::shared_ptr<detail::CancellationState> state)
+        : m_state(std::move(state)) {}
+
+    std::shared_ptr<detail::CancellationState> m_state;
+};
+
+/**
+ * @brief Owner side of a cancellation scope
+ *
+ * Copies share the same scope. A source created from a parent token is
+ * cancelled together with its parent (request -> script -> command), while
+ * cancelling the child leaves the parent untouched.
+ */
+class CancellationSource {
+public:
+    CancellationSource();
+    explicit CancellationSource(const CancellationToken& parent);
+
+    void cancel();
+    bool isCancelled() const;
+    CancellationToken token() const { return CancellationToken(m_state); }
+
+private:
+    std::shared_ptr<detail::CancellationState> m_state;
+};
+
+} // namespace burwell
+
+#endif // BURWELL_CANCELLATION_TOKEN_H
@@ -222,6 +222,58 @@ std::string ConfigManager::getLogSourceLocationLevels() const {
     return "NONE"; // Default value - no source location logging
 }
 
+std::string ConfigManager::getBinaryLogFile() const {
+    if (m_config.contains("logging") && m_config["logging"].contains("binary_log_file")) {
+        return m_config["logging"]["binary_log_file"].get<std::string>();
+    }
+    return ""; // Default value - binary logging disabled
+}
+
+int ConfigManager::getBinaryLogSegmentSizeMb() const {
+    if (m_config.contains("logging") && m_config["logging"].contains("binary_log_segment_size_mb")) {
+        int sizeMb = m_config["logging"]["binary_log_segment_size_mb"].get<int>();
+        if (sizeMb >= 1 && sizeMb <= 1024) {
+            return sizeMb;
+        }
+        SLOG_WARNING().message("binary_log_segment_size_mb must be between 1 and 1024, using default")
+            .context("value", sizeMb);
+    }
+    return 16; // Default value
+}
+
+int ConfigManager::getBinaryLogSegments() const {
+    if (m_config.contains("logging") && m_config["logging"].contains("binary_log_segments")) {
+        int segments = m_config["logging"]["binary_log_segments"].get<int>();
+        if (segments >= 1 && segments <= 1024) {
+            return segments;
+        }
+        SLOG_WARNING().message("binary_log_segments must be between 1 and 1024, using default")
+            .context("value", segments);
+    }
+    return 4; // Default value
+}
+
+std::vector<std::string> ConfigManager::getBinaryLogLoggers() const {
+    if (m_config.contains("logging") && m_config["logging"].contains("binary_log_loggers")) {
+        return m_config["logging"]["binary_log_loggers"].get<std::vector<std::string>>();
+    }
+    return {}; // Default value - every logger
+}
+
+int ConfigManager::getLogAsyncQueueCapacity() const {
+    if (m_config.contains("logging") && m_config["logging"].contains("async_queue_capacity")) {
+        return m_config["logging"]["async_queue_capacity"].get<int>();
+    }
+    return 8192; // Default value
+}
+
+std::string ConfigManager::getLogAsyncOverflowPolicy() const {
+    if (m_config.contains("logging") && m_config["logging"].contains("async_overflow_policy")) {
+        return m_config["logging"]["async_overflow_policy"].get<std::string>();
+    }
+    return "drop_debug_first"; // Default value
+}
+
 // LLM Provider Configuration
 std::string ConfigManager::getActiveProvider() const {
     // First try to get the best available provider based on API keys
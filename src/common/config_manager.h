@@ -41,6 +41,12 @@ public:
     int getLogMaxSizeMb() const;
     int getLogMaxFiles() const;
     std::string getLogSourceLocationLevels() const;
+    std::string getBinaryLogFile() const;
+    int getBinaryLogSegmentSizeMb() const;
+    int getBinaryLogSegments() const;
+    std::vector<std::string> getBinaryLogLoggers() const;
+    int getLogAsyncQueueCapacity() const;
+    std::string getLogAsyncOverflowPolicy() const;
     
     // LLM Provider Configuration
     std::string getActiveProvider() const;
@@ -1,5 +1,6 @@
 #include "error_handler.h"
 #include "structured_logger.h"
+#include "shutdown_manager.h"
 #include <thread>
 #include <chrono>
 #include <sstream>
@@ -88,8 +89,9 @@ bool ErrorHandler::attemptRecovery(const ErrorInfo& error) {
         
         // Add delay before retry
         auto delayIter = m_retryDelays.find(error.type);
-        if (delayIter != m_retryDelays.end()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(delayIter->second));
+        if (delayIter != m_retryDelays.end() &&
+            !burwell::ShutdownManager::getInstance().getToken().sleepFor(std::chrono::milliseconds(delayIter->second))) {
+            return false;
         }
         
         m_retryCount[error.type]++;
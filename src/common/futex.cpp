@@ -0,0 +1,84 @@
+#include "futex.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace burwell {
+
+#if defined(__linux__)
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "futex word must be a plain 32-bit integer");
+
+namespace {
+
+long futexCall(std::atomic<uint32_t>& word, int op, uint32_t value) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), op, value, nullptr, nullptr, 0);
+}
+
+} // anonymous namespace
+
+void Futex::wait(std::atomic<uint32_t>& word, uint32_t expected) {
+    futexCall(word, FUTEX_WAIT_PRIVATE, expected);
+}
+
+void Futex::wakeOne(std::atomic<uint32_t>& word) {
+    futexCall(word, FUTEX_WAKE_PRIVATE, 1);
+}
+
+void Futex::wakeAll(std::atomic<uint32_t>& word) {
+    futexCall(word, FUTEX_WAKE_PRIVATE, INT_MAX);
+}
+
+#else
+
+// WaitOnAddress needs Windows 8 and the build targets Windows 7, so park on a
+// condition variable chosen by address instead. The waiter checks the word
+// under the bucket lock and wakers take that lock before notifying, so a wake
+// between the check and the sleep cannot be lost.
+namespace {
+
+struct ParkingBucket {
+    std::mutex mutex;
+    std::condition_variable wake;
+};
+
+constexpr size_t PARKING_BUCKETS = 64;
+
+ParkingBucket& bucketFor(const void* address) {
+    static ParkingBucket buckets[PARKING_BUCKETS];
+    auto key = reinterpret_cast<uintptr_t>(address);
+    return buckets[(key >> 4) % PARKING_BUCKETS];
+}
+
+} // anonymous namespace
+
+void Futex::wait(std::atomic<uint32_t>& word, uint32_t expected) {
+    ParkingBucket& bucket = bucketFor(&word);
+    std::unique_lock<std::mutex> lock(bucket.mutex);
+    if (word.load(std::memory_order_acquire) == expected) {
+        bucket.wake.wait(lock);
+    }
+}
+
+void Futex::wakeOne(std::atomic<uint32_t>& word) {
+    // Other words share the bucket, so waking only one might pick the wrong waiter
+    wakeAll(word);
+}
+
+void Futex::wakeAll(std::atomic<uint32_t>& word) {
+    ParkingBucket& bucket = bucketFor(&word);
+    { std::lock_guard<std::mutex> lock(bucket.mutex); }
+    bucket.wake.notify_all();
+}
+
+#endif
+
+} // namespace burwell
@@ -0,0 +1,42 @@
+#ifndef BURWELL_FUTEX_H
+#define BURWELL_FUTEX_H
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace burwell {
+
+/**
+ * @brief Park and wake threads on the value of a 32-bit atomic
+ *
+ * The building block for locks that spin first and then sleep in the
+ * kernel. On Linux this is the futex system call; elsewhere a fixed table
+ * of mutex/condition variable buckets hashed by address gives the same
+ * contract. Waits can return spuriously, so callers re-check their word.
+ */
+class Futex {
+public:
+    // Blocks while word still holds expected; returns at once if it does not
+    static void wait(std::atomic<uint32_t>& word, uint32_t expected);
+    static void wakeOne(std::atomic<uint32_t>& word);
+    static void wakeAll(std::atomic<uint32_t>& word);
+
+    // Hint to the CPU that this thread is spinning (pause/yield instruction)
+    static inline void relax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+};
+
+} // namespace burwell
+
+#endif // BURWELL_FUTEX_H
@@ -0,0 +1,334 @@
+#include "json_stream_writer.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BURWELL_JSON_WRITER_SSE2 1
+#else
+#define BURWELL_JSON_WRITER_SSE2 0
+#endif
+
+namespace burwell {
+namespace utils {
+
+namespace {
+
+constexpr int MAX_WRITER_DEPTH = 64;
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+// Bytes that can be copied verbatim: printable ASCII other than '"' and '\\'
+inline bool isPlainByte(unsigned char c) {
+    return c >= 0x20 && c < 0x80 && c != '"' && c != '\\';
+}
+
+// Length of the plain run at the start of data
+size_t plainPrefixLength(const char* data, size_t size) {
+    size_t i = 0;
+#if BURWELL_JSON_WRITER_SSE2
+    const __m128i controlLimit = _mm_set1_epi8(0x20);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // Signed compare flags both control characters and bytes >= 0x80
+        __m128i special = _mm_or_si128(_mm_cmplt_epi8(chunk, controlLimit),
+                                       _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                    _mm_cmpeq_epi8(chunk, backslash)));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            unsigned bits = static_cast<unsigned>(mask);
+            size_t offset = 0;
+            while ((bits & 1u) == 0) {
+                bits >>= 1;
+                ++offset;
+            }
+            return i + offset;
+        }
+    }
+#endif
+    while (i < size && isPlainByte(static_cast<unsigned char>(data[i]))) {
+        ++i;
+    }
+    return i;
+}
+
+// Length of the valid UTF-8 sequence starting at data, or 0 if invalid.
+// Same acceptance rules as nlohmann's decoder (no overlongs or surrogates).
+size_t utf8SequenceLength(const unsigned char* data, size_t size) {
+    unsigned char lead = data[0];
+    size_t length;
+    unsigned char minSecond = 0x80;
+    unsigned char maxSecond = 0xBF;
+
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) minSecond = 0xA0;
+        if (lead == 0xED) maxSecond = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) minSecond = 0x90;
+        if (lead == 0xF4) maxSecond = 0x8F;
+    } else {
+        return 0;
+    }
+
+    if (size < length || data[1] < minSecond || data[1] > maxSecond) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; ++i) {
+        if (data[i] < 0x80 || data[i] > 0xBF) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+} // anonymous namespace
+
+JsonStreamWriter::JsonStreamWriter(std::string& out)
+    : m_out(out)
+    , m_hasElements(0)
+    , m_depth(0)
+    , m_afterKey(false)
+    , m_ok(true) {
+}
+
+void JsonStreamWriter::beforeValue() {
+    if (m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    if (m_depth > 0) {
+        uint64_t bit = uint64_t(1) << (m_depth - 1);
+        if (m_hasElements & bit) {
+            m_out += ',';
+        }
+        m_hasElements |= bit;
+    }
+}
+
+void JsonStreamWriter::beginObject() {
+    beforeValue();
+    m_out += '{';
+    if (m_depth < MAX_WRITER_DEPTH) {
+        ++m_depth;
+        m_hasElements &= ~(uint64_t(1) << (m_depth - 1));
+    }
+}
+
+void JsonStreamWriter::endObject() {
+    m_out += '}';
+    if (m_depth > 0) {
+        --m_depth;
+    }
+}
+
+void JsonStreamWriter::beginArray() {
+    beforeValue();
+    m_out += '[';
+    if (m_depth < MAX_WRITER_DEPTH) {
+        ++m_depth;
+        m_hasElements &= ~(uint64_t(1) << (m_depth - 1));
+    }
+}
+
+void JsonStreamWriter::endArray() {
+    m_out += ']';
+    if (m_depth > 0) {
+        --m_depth;
+    }
+}
+
+void JsonStreamWriter::key(std::string_view name) {
+    beforeValue();
+    m_ok &= appendQuoted(m_out, name);
+    m_out += ':';
+    m_afterKey = true;
+}
+
+void JsonStreamWriter::value(std::string_view str) {
+    beforeValue();
+    m_ok &= appendQuoted(m_out, str);
+}
+
+void JsonStreamWriter::value(bool b) {
+    beforeValue();
+    m_out += b ? "true" : "false";
+}
+
+void JsonStreamWriter::value(int64_t number) {
+    beforeValue();
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* pos = end;
+    uint64_t magnitude = number < 0 ? uint64_t(0) - static_cast<uint64_t>(number)
+                                    : static_cast<uint64_t>(number);
+    do {
+        *--pos = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (number < 0) {
+        *--pos = '-';
+    }
+    m_out.append(pos, static_cast<size_t>(end - pos));
+}
+
+void JsonStreamWriter::value(uint64_t number) {
+    beforeValue();
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* pos = end;
+    do {
+        *--pos = static_cast<char>('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    m_out.append(pos, static_cast<size_t>(end - pos));
+}
+
+void JsonStreamWriter::value(double number) {
+    beforeValue();
+    appendDouble(m_out, number);
+}
+
+void JsonStreamWriter::nullValue() {
+    beforeValue();
+    m_out += "null";
+}
+
+void JsonStreamWriter::rawValue(std::string_view json) {
+    beforeValue();
+    m_out.append(json.data(), json.size());
+}
+
+void JsonStreamWriter::beginRawString() {
+    beforeValue();
+    m_out += '"';
+}
+
+void JsonStreamWriter::endRawString() {
+    m_out += '"';
+}
+
+void JsonStreamWriter::value(const nlohmann::json& json) {
+    switch (json.type()) {
+        case nlohmann::json::value_t::object: {
+            beforeValue();
+            m_out += '{';
+            bool first = true;
+            // object_t is a std::map, so iteration order matches dump()
+            for (const auto& [name, member] : json.get_ref<const nlohmann::json::object_t&>()) {
+                if (!first) {
+                    m_out += ',';
+                }
+                first = false;
+                m_ok &= appendQuoted(m_out, name);
+                m_out += ':';
+                m_afterKey = true;
+                value(member);
+            }
+            m_out += '}';
+            break;
+        }
+        case nlohmann::json::value_t::array: {
+            beforeValue();
+            m_out += '[';
+            bool first = true;
+            for (const auto& element : json.get_ref<const nlohmann::json::array_t&>()) {
+                if (!first) {
+                    m_out += ',';
+                }
+                first = false;
+                m_afterKey = true;   // Separator already written
+                value(element);
+            }
+            m_out += ']';
+            break;
+        }
+        case nlohmann::json::value_t::string:
+            value(std::string_view(json.get_ref<const std::string&>()));
+            break;
+        case nlohmann::json::value_t::boolean:
+            value(json.get<bool>());
+            break;
+        case nlohmann::json::value_t::number_integer:
+            value(json.get<int64_t>());
+            break;
+        case nlohmann::json::value_t::number_unsigned:
+            value(json.get<uint64_t>());
+            break;
+        case nlohmann::json::value_t::number_float:
+            value(json.get<double>());
+            break;
+        case nlohmann::json::value_t::null:
+            nullValue();
+            break;
+        default:
+            // Binary and discarded values are rare enough to go through dump()
+            rawValue(json.dump());
+            break;
+    }
+}
+
+bool JsonStreamWriter::appendQuoted(std::string& out, std::string_view str) {
+    out += '"';
+
+    const char* data = str.data();
+    size_t size = str.size();
+    size_t pos = 0;
+
+    while (pos < size) {
+        size_t plain = plainPrefixLength(data + pos, size - pos);
+        out.append(data + pos, plain);
+        pos += plain;
+        if (pos >= size) {
+            break;
+        }
+
+        unsigned char c = static_cast<unsigned char>(data[pos]);
+        if (c >= 0x80) {
+            size_t length = utf8SequenceLength(reinterpret_cast<const unsigned char*>(data + pos),
+                                               size - pos);
+            if (length == 0) {
+                return false;
+            }
+            out.append(data + pos, length);
+            pos += length;
+            continue;
+        }
+
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0x0F]};
+                out.append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+        ++pos;
+    }
+
+    out += '"';
+    return true;
+}
+
+void JsonStreamWriter::appendDouble(std::string& out, double number) {
+    if (!std::isfinite(number)) {
+        out += "null";
+        return;
+    }
+    // Same shortest round-trip algorithm (Grisu2) that nlohmann's serializer uses
+    char buffer[64];
+    char* end = nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), number);
+    out.append(buffer, static_cast<size_t>(end - buffer));
+}
+
+} // namespace utils
+} // namespace burwell
@@ -0,0 +1,99 @@
+#ifndef BURWELL_JSON_STREAM_WRITER_H
+#define BURWELL_JSON_STREAM_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace burwell {
+namespace utils {
+
+/**
+ * @brief Streaming JSON writer that appends compact JSON directly to a string
+ *
+ * Produces exactly the bytes nlohmann::json::dump() would produce for the same
+ * document (no whitespace, UTF-8 passed through, same escapes and number
+ * formatting) without building a json tree first. Keys are written in call
+ * order, so callers emit them sorted when matching a std::map-backed dump.
+ */
+class JsonStreamWriter {
+public:
+    /**
+     * @brief Create a writer appending to out
+     * @param out Destination buffer (must outlive the writer)
+     */
+    explicit JsonStreamWriter(std::string& out);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    /**
+     * @brief Write an object key; the next call must write its value
+     * @param name Key text (UTF-8)
+     */
+    void key(std::string_view name);
+
+    void value(std::string_view str);
+    void value(const char* str) { value(std::string_view(str)); }
+    void value(const std::string& str) { value(std::string_view(str)); }
+    void value(bool b);
+    void value(int number) { value(static_cast<int64_t>(number)); }
+    void value(int64_t number);
+    void value(uint64_t number);
+    void value(double number);
+    void value(const nlohmann::json& json);
+    void nullValue();
+
+    /**
+     * @brief Write pre-encoded JSON text as the next value
+     * @param json Valid JSON text, copied verbatim
+     */
+    void rawValue(std::string_view json);
+
+    /**
+     * @brief Open a string value whose contents the caller appends to out
+     * @note The appended text must already be JSON-safe (e.g. base64);
+     *       close it with endRawString()
+     */
+    void beginRawString();
+    void endRawString();
+
+    /**
+     * @brief Check whether every string written so far was valid UTF-8
+     * @return false if a string was rejected (nlohmann would have thrown)
+     */
+    bool ok() const { return m_ok; }
+
+    /**
+     * @brief Append str to out as a quoted, escaped JSON string
+     * @param out Destination buffer (input/output parameter)
+     * @param str String to encode
+     * @return false if str is not valid UTF-8 (out then holds a partial string)
+     * @note Scans 16 bytes per step with SSE2 where available
+     */
+    static bool appendQuoted(std::string& out, std::string_view str);
+
+    /**
+     * @brief Append a double formatted like nlohmann::json::dump()
+     * @param out Destination buffer (input/output parameter)
+     * @param number Value to format; non-finite values become null
+     */
+    static void appendDouble(std::string& out, double number);
+
+private:
+    void beforeValue();
+
+    std::string& m_out;
+    uint64_t m_hasElements;   // One bit per nesting level: a separator is needed
+    int m_depth;
+    bool m_afterKey;
+    bool m_ok;
+};
+
+} // namespace utils
+} // namespace burwell
+
+#endif // BURWELL_JSON_STREAM_WRITER_H
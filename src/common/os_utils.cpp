@@ -1,5 +1,7 @@
 #include "os_utils.h"
 #include "structured_logger.h"
+#include "shutdown_manager.h"
+#include "blocking_region.h"
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
@@ -31,6 +33,9 @@
     #include <arpa/inet.h>
     #include <sys/sysinfo.h>
     #include <sys/ioctl.h>
+
+    // Declared here: inside the namespace it would name burwell::os::environ
+    extern char **environ;
 #endif
 
 namespace burwell {
@@ -577,8 +582,7 @@ std::vector<std::pair<std::string, std::string>> SystemInfo::getAllEnvironmentVa
         FreeEnvironmentStrings(envStrings);
     }
 #else
-    extern char **environ;
-    for (char **env = environ; *env != nullptr; env++) {
+    for (char **env = ::environ; *env != nullptr; env++) {
         std::string envVar(*env);
         size_t pos = envVar.find('=');
         if (pos != std::string::npos) {
@@ -797,7 +801,19 @@ uint32_t ProcessUtils::launchProcess(const std::string& executablePath,
     if (CreateProcessW(nullptr, const_cast<wchar_t*>(wCmdLine.c_str()), nullptr, nullptr, 
                       FALSE, 0, nullptr, workDirPtr, &si, &pi)) {
         if (waitForExit) {
-            WaitForSingleObject(pi.hProcess, INFINITE);
+            BlockingRegion blocking;
+            // Stop waiting (the process keeps running) as soon as shutdown starts
+            HANDLE cancelEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (cancelEvent) {
+                CancellationRegistration wakeOnCancel = ShutdownManager::getInstance().getToken().onCancel(
+                    [cancelEvent]() { SetEvent(cancelEvent); });
+                HANDLE handles[2] = {pi.hProcess, cancelEvent};
+                WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+                wakeOnCancel.reset();
+                CloseHandle(cancelEvent);
+            } else {
+                WaitForSingleObject(pi.hProcess, INFINITE);
+            }
         }
         DWORD processId = pi.dwProcessId;
         CloseHandle(pi.hProcess);
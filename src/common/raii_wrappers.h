@@ -5,6 +5,7 @@
 #include <functional>
 #include <stdexcept>
 #include <string>
+#include "blocking_region.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -386,6 +387,7 @@ public:
     }
     
     DWORD waitForExit(DWORD timeout = INFINITE) {
+        BlockingRegion blocking;
         return ::WaitForSingleObject(get(), timeout);
     }
     
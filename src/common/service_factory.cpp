@@ -17,6 +17,7 @@
 #include "../orchestrator/feedback_controller.h"
 #include "../orchestrator/conversation_manager.h"
 #include <fstream>
+#include <algorithm>
 
 namespace burwell {
 
@@ -40,7 +41,17 @@ void ServiceFactory::initializeServices(const std::string& configPath) {
     
     // Thread pool (singleton)
     m_container.registerFactory<ThreadPool>([this]() {
-        return std::make_shared<ThreadPool>(m_config.threadPoolSize);
+        auto pool = std::make_shared<ThreadPool>(m_config.threadPoolSize);
+        pool->setAgingHalfLife(std::chrono::milliseconds(m_config.threadPoolAgingHalfLifeMs));
+        if (m_config.threadPoolMinThreads > 0 || m_config.threadPoolMaxThreads > 0) {
+            ThreadPool::ElasticSizing sizing;
+            sizing.minThreads = static_cast<size_t>(std::max(m_config.threadPoolMinThreads, 0));
+            sizing.maxThreads = static_cast<size_t>(std::max(m_config.threadPoolMaxThreads, 0));
+            sizing.queueLatencyTarget = std::chrono::milliseconds(m_config.threadPoolQueueLatencyTargetMs);
+            sizing.idleTimeout = std::chrono::milliseconds(m_config.threadPoolIdleTimeoutMs);
+            pool->setElasticSizing(sizing);
+        }
+        return pool;
     }, DIContainer::Lifetime::SINGLETON);
     
     // State manager (singleton, thread-safe version)
@@ -286,6 +297,12 @@ void ServiceFactory::loadConfiguration(const std::string& configPath) {
             m_config.llmProvider = services.value("llmProvider", "default");
             m_config.uiType = services.value("uiType", "console");
             m_config.threadPoolSize = services.value("threadPoolSize", 0);
+            m_config.threadPoolAgingHalfLifeMs = services.value("threadPoolAgingHalfLifeMs",
+                static_cast<int>(ThreadPool::DEFAULT_AGING_HALF_LIFE.count()));
+            m_config.threadPoolMinThreads = services.value("threadPoolMinThreads", 0);
+            m_config.threadPoolMaxThreads = services.value("threadPoolMaxThreads", 0);
+            m_config.threadPoolQueueLatencyTargetMs = services.value("threadPoolQueueLatencyTargetMs", 50);
+            m_config.threadPoolIdleTimeoutMs = services.value("threadPoolIdleTimeoutMs", 30000);
         }
         
         SLOG_INFO().message("Configuration loaded successfully")
@@ -144,6 +144,11 @@ private:
         std::string llmProvider = "default";
         std::string uiType = "console";
         int threadPoolSize = 0;  // 0 = auto-detect
+        int threadPoolAgingHalfLifeMs = 200;  // 0 = strict priority order
+        int threadPoolMinThreads = 0;  // 0 = threadPoolSize
+        int threadPoolMaxThreads = 0;  // 0 = fixed size; above threadPoolSize grows past blocked workers
+        int threadPoolQueueLatencyTargetMs = 50;
+        int threadPoolIdleTimeoutMs = 30000;
     };
     
     ServiceConfig m_config;
@@ -0,0 +1,111 @@
+#include "shutdown_manager.h"
+#include <cerrno>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace burwell {
+
+namespace {
+
+#ifndef _WIN32
+constexpr char RELAY_SHUTDOWN = 1;
+constexpr char RELAY_STOP = 0;
+#endif
+
+} // anonymous namespace
+
+ShutdownManager& ShutdownManager::getInstance() {
+    static ShutdownManager instance;
+    return instance;
+}
+
+ShutdownManager::ShutdownManager()
+    : m_shutdown_requested(false)
+    , m_ctrl_c_count(0) {
+#ifndef _WIN32
+    m_relay_pipe[0] = -1;
+    m_relay_pipe[1] = -1;
+    if (pipe(m_relay_pipe) == 0) {
+        fcntl(m_relay_pipe[1], F_SETFL, O_NONBLOCK);
+        m_relay_thread = std::thread(&ShutdownManager::relayLoop, this);
+    }
+#endif
+}
+
+ShutdownManager::~ShutdownManager() {
+#ifndef _WIN32
+    if (m_relay_thread.joinable()) {
+        char stop = RELAY_STOP;
+        while (::write(m_relay_pipe[1], &stop, 1) < 0 && errno == EINTR) {
+        }
+        m_relay_thread.join();
+    }
+    for (int fd : m_relay_pipe) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+void ShutdownManager::requestShutdown() {
+    m_shutdown_requested = true;
+#ifdef _WIN32
+    // Console control handlers already run on their own thread
+    cancelRoot();
+#else
+    // Only async-signal-safe calls here; the relay thread does the cancel
+    if (m_relay_thread.joinable()) {
+        int savedErrno = errno;
+        char byte = RELAY_SHUTDOWN;
+        ssize_t ignored = ::write(m_relay_pipe[1], &byte, 1);
+        (void)ignored;
+        errno = savedErrno;
+    } else {
+        cancelRoot();
+    }
+#endif
+}
+
+CancellationToken ShutdownManager::getToken() const {
+    std::lock_guard<std::mutex> lock(m_source_mutex);
+    return m_source.token();
+}
+
+void ShutdownManager::reset() {
+    m_shutdown_requested = false;
+    m_ctrl_c_count = 0;
+    // Scopes derived from the old root stay cancelled
+    std::lock_guard<std::mutex> lock(m_source_mutex);
+    m_source = CancellationSource();
+}
+
+void ShutdownManager::cancelRoot() {
+    CancellationSource source;
+    {
+        std::lock_guard<std::mutex> lock(m_source_mutex);
+        source = m_source;
+    }
+    source.cancel();
+}
+
+#ifndef _WIN32
+void ShutdownManager::relayLoop() {
+    char byte = RELAY_STOP;
+    while (true) {
+        ssize_t result = ::read(m_relay_pipe[0], &byte, 1);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0 || byte == RELAY_STOP) {
+            return;
+        }
+        cancelRoot();
+    }
+}
+#endif
+
+} // namespace burwell
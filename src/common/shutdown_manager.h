@@ -2,47 +2,70 @@
 #define BURWELL_SHUTDOWN_MANAGER_H
 
 #include <atomic>
+#include <mutex>
+#include <thread>
+#include "cancellation_token.h"
 
 namespace burwell {
 
 /**
  * @brief Global shutdown manager for handling graceful shutdown
+ *
+ * Owns the root cancellation scope. Request, script and task scopes are
+ * created from getToken(), so a shutdown wakes every cancellable wait.
  */
 class ShutdownManager {
 public:
-    static ShutdownManager& getInstance() {
-        static ShutdownManager instance;
-        return instance;
-    }
-    
-    void requestShutdown() {
-        m_shutdown_requested = true;
-    }
-    
+    static ShutdownManager& getInstance();
+
+    /**
+     * @brief Request shutdown and cancel the root scope
+     * @note Safe to call from a signal handler; on POSIX the callbacks run on
+     *       a relay thread rather than in signal context.
+     */
+    void requestShutdown();
+
     bool isShutdownRequested() const {
         return m_shutdown_requested.load();
     }
-    
+
+    // Root cancellation scope, cancelled by requestShutdown()
+    CancellationToken getToken() const;
+
     void incrementCtrlCCount() {
         m_ctrl_c_count++;
     }
-    
+
     int getCtrlCCount() const {
         return m_ctrl_c_count.load();
     }
-    
-    void reset() {
-        m_shutdown_requested = false;
-        m_ctrl_c_count = 0;
-    }
-    
+
+    void reset();
+
 private:
-    ShutdownManager() : m_shutdown_requested(false), m_ctrl_c_count(0) {}
-    
+    ShutdownManager();
+    ~ShutdownManager();
+
+    ShutdownManager(const ShutdownManager&) = delete;
+    ShutdownManager& operator=(const ShutdownManager&) = delete;
+
+    void cancelRoot();
+#ifndef _WIN32
+    void relayLoop();
+#endif
+
     std::atomic<bool> m_shutdown_requested;
     std::atomic<int> m_ctrl_c_count;
+
+    mutable std::mutex m_source_mutex;
+    CancellationSource m_source;
+
+#ifndef _WIN32
+    int m_relay_pipe[2];
+    std::thread m_relay_thread;
+#endif
 };
 
 } // namespace burwell
 
-#endif // BURWELL_SHUTDOWN_MANAGER_H
\ No newline at end of file
+#endif // BURWELL_SHUTDOWN_MANAGER_H
@@ -2,129 +2,159 @@
 #include "structured_logger.h"
 #include <algorithm>
 #include <cctype>
+#include <iomanip>
 #include <sstream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BURWELL_STRING_UTILS_SSE2 1
+#else
+#define BURWELL_STRING_UTILS_SSE2 0
+#endif
+
 namespace burwell {
 namespace utils {
 
-std::string StringUtils::replaceAll(const std::string& str, const std::string& from, const std::string& to) {
+namespace {
+
+constexpr const char* WHITESPACE_CHARS = " \t\n\r\f\v";
+
+inline char asciiToLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+void asciiToLowerInPlace(char* data, size_t size) {
+    size_t i = 0;
+#if BURWELL_STRING_UTILS_SSE2
+    const __m128i upperA = _mm_set1_epi8('A' - 1);
+    const __m128i upperZ = _mm_set1_epi8('Z' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // Bytes >= 0x80 are negative as signed chars and fail the lower bound
+        __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(chunk, upperA),
+                                        _mm_cmplt_epi8(chunk, upperZ));
+        chunk = _mm_or_si128(chunk, _mm_and_si128(isUpper, caseBit));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), chunk);
+    }
+#endif
+    for (; i < size; ++i) {
+        data[i] = asciiToLower(data[i]);
+    }
+}
+
+} // anonymous namespace
+
+std::string StringUtils::replaceAll(std::string_view str, std::string_view from, std::string_view to) {
+    std::string result(str);
+    replaceAllInPlace(result, from, to);
+    return result;
+}
+
+size_t StringUtils::replaceAllInPlace(std::string& str, std::string_view from, std::string_view to) {
     // Input validation
     if (from.empty()) {
         SLOG_ERROR().message("Empty 'from' parameter in replaceAll");
-        return str; // Return original string on invalid input
+        return 0; // Leave string untouched on invalid input
     }
 
-    std::string result = str;
-    size_t startPos = 0;
-    
-    try {
-        while ((startPos = result.find(from, startPos)) != std::string::npos) {
-            result.replace(startPos, from.length(), to);
-            startPos += to.length(); // Move past the replacement to avoid infinite loop
-        }
-    } catch (const std::exception& e) {
-        SLOG_ERROR().message("Exception in replaceAll").context("error", e.what());
-        return str; // Return original string on error
+    size_t firstMatch = str.find(from);
+    if (firstMatch == std::string::npos) {
+        return 0;
     }
 
-    return result;
-}
+    size_t count = 0;
 
-std::string StringUtils::trim(const std::string& str) {
-    if (str.empty()) {
-        return str;
+    if (to.size() <= from.size()) {
+        // Compact towards the front; the result never outgrows the buffer
+        size_t readPos = firstMatch;
+        size_t writePos = firstMatch;
+        size_t matchPos = firstMatch;
+        while (matchPos != std::string::npos) {
+            // Destination always lies before the unread text, so a forward copy is safe
+            std::copy(str.begin() + readPos, str.begin() + matchPos, str.begin() + writePos);
+            writePos += matchPos - readPos;
+            std::copy(to.begin(), to.end(), str.begin() + writePos);
+            writePos += to.size();
+            readPos = matchPos + from.size();
+            ++count;
+            matchPos = str.find(from, readPos);
+        }
+        std::copy(str.begin() + readPos, str.end(), str.begin() + writePos);
+        str.resize(writePos + (str.size() - readPos));
+        return count;
     }
 
-    try {
-        // Find first non-whitespace character
-        size_t first = str.find_first_not_of(" \t\n\r\f\v");
-        if (first == std::string::npos) {
-            return ""; // String contains only whitespace
-        }
+    // Growing replacement: size the result once and copy every piece exactly once
+    for (size_t pos = firstMatch; pos != std::string::npos; pos = str.find(from, pos + from.size())) {
+        ++count;
+    }
 
-        // Find last non-whitespace character
-        size_t last = str.find_last_not_of(" \t\n\r\f\v");
-        
-        return str.substr(first, (last - first + 1));
-        
-    } catch (const std::exception& e) {
-        SLOG_ERROR().message("Exception in trim").context("error", e.what());
-        return str; // Return original string on error
+    std::string result;
+    result.reserve(str.size() + count * (to.size() - from.size()));
+    size_t readPos = 0;
+    for (size_t pos = firstMatch; pos != std::string::npos; pos = str.find(from, readPos)) {
+        result.append(str, readPos, pos - readPos);
+        result.append(to.data(), to.size());
+        readPos = pos + from.size();
     }
+    result.append(str, readPos, std::string::npos);
+    str.swap(result);
+    return count;
 }
 
-std::string StringUtils::trimLeft(const std::string& str) {
-    if (str.empty()) {
-        return str;
+std::string StringUtils::trim(std::string_view str) {
+    return std::string(trimView(str));
+}
+
+std::string_view StringUtils::trimView(std::string_view str) {
+    // Find first non-whitespace character
+    size_t first = str.find_first_not_of(WHITESPACE_CHARS);
+    if (first == std::string_view::npos) {
+        return std::string_view(); // String is empty or contains only whitespace
     }
 
-    try {
-        size_t first = str.find_first_not_of(" \t\n\r\f\v");
-        if (first == std::string::npos) {
-            return ""; // String contains only whitespace
-        }
-        
-        return str.substr(first);
-        
-    } catch (const std::exception& e) {
-        SLOG_ERROR().message("Exception in trimLeft").context("error", e.what());
-        return str; // Return original string on error
+    // Find last non-whitespace character
+    size_t last = str.find_last_not_of(WHITESPACE_CHARS);
+    return str.substr(first, (last - first + 1));
+}
+
+void StringUtils::trimInPlace(std::string& str) {
+    size_t last = str.find_last_not_of(WHITESPACE_CHARS);
+    if (last == std::string::npos) {
+        str.clear();
+        return;
     }
+    str.erase(last + 1);
+    str.erase(0, str.find_first_not_of(WHITESPACE_CHARS));
 }
 
-std::string StringUtils::trimRight(const std::string& str) {
-    if (str.empty()) {
-        return str;
+std::string StringUtils::trimLeft(std::string_view str) {
+    size_t first = str.find_first_not_of(WHITESPACE_CHARS);
+    if (first == std::string_view::npos) {
+        return ""; // String is empty or contains only whitespace
     }
+    return std::string(str.substr(first));
+}
 
-    try {
-        size_t last = str.find_last_not_of(" \t\n\r\f\v");
-        if (last == std::string::npos) {
-            return ""; // String contains only whitespace
-        }
-        
-        return str.substr(0, last + 1);
-        
-    } catch (const std::exception& e) {
-        SLOG_ERROR().message("Exception in trimRight").context("error", e.what());
-        return str; // Return original string on error
+std::string StringUtils::trimRight(std::string_view str) {
+    size_t last = str.find_last_not_of(WHITESPACE_CHARS);
+    if (last == std::string_view::npos) {
+        return ""; // String is empty or contains only whitespace
     }
+    return std::string(str.substr(0, last + 1));
 }
 
-std::vector<std::string> StringUtils::split(const std::string& str, const std::string& delimiter) {
+std::vector<std::string> StringUtils::split(std::string_view str, std::string_view delimiter) {
     std::vector<std::string> result;
-    
+
     // Input validation
     if (delimiter.empty()) {
         SLOG_ERROR().message("Empty delimiter in split");
-        if (!str.empty()) {
-            result.push_back(str); // Return original string as single element
-        }
-        return result;
-    }
-
-    if (str.empty()) {
-        return result; // Return empty vector for empty string
     }
 
-    try {
-        size_t start = 0;
-        size_t end = 0;
-        
-        while ((end = str.find(delimiter, start)) != std::string::npos) {
-            result.push_back(str.substr(start, end - start));
-            start = end + delimiter.length();
-        }
-        
-        // Add the last part (or the only part if no delimiter found)
-        result.push_back(str.substr(start));
-        
-    } catch (const std::exception& e) {
-        SLOG_ERROR().message("Exception in split").context("error", e.what());
-        result.clear();
-        if (!str.empty()) {
-            result.push_back(str); // Return original string as fallback
-        }
+    for (std::string_view part : splitView(str, delimiter)) {
+        result.emplace_back(part);
     }
 
     return result;
@@ -168,20 +198,29 @@ bool StringUtils::endsWith(const std::string& str, const std::string& suffix) {
     }
 }
 
-std::string StringUtils::toLowerCase(const std::string& str) {
-    std::string result = str;
-    
-    try {
-        std::transform(result.begin(), result.end(), result.begin(),
-                      [](unsigned char c) { return std::tolower(c); });
-    } catch (const std::exception& e) {
-        SLOG_ERROR().message("Exception in toLowerCase").context("error", e.what());
-        return str; // Return original string on error
-    }
-    
+std::string StringUtils::toLowerCase(std::string_view str) {
+    std::string result(str);
+    toLowerCaseInPlace(result);
     return result;
 }
 
+void StringUtils::toLowerCaseInPlace(std::string& str) {
+    asciiToLowerInPlace(str.data(), str.size());
+}
+
+bool StringUtils::containsIgnoreCase(std::string_view haystack, std::string_view needle) {
+    if (needle.empty()) {
+        return true;
+    }
+    if (haystack.size() < needle.size()) {
+        return false;
+    }
+
+    auto it = std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(),
+                          [](char a, char b) { return asciiToLower(a) == asciiToLower(b); });
+    return it != haystack.end();
+}
+
 std::string StringUtils::toUpperCase(const std::string& str) {
     std::string result = str;
     
@@ -196,26 +235,29 @@ std::string StringUtils::toUpperCase(const std::string& str) {
     return result;
 }
 
-std::string StringUtils::join(const std::vector<std::string>& strings, const std::string& delimiter) {
+std::string StringUtils::join(const std::vector<std::string>& strings, std::string_view delimiter) {
+    std::string result;
+    appendJoined(result, strings, delimiter);
+    return result;
+}
+
+void StringUtils::appendJoined(std::string& out, const std::vector<std::string>& strings,
+                               std::string_view delimiter) {
     if (strings.empty()) {
-        return "";
+        return;
     }
 
-    try {
-        std::stringstream result;
-        
-        for (size_t i = 0; i < strings.size(); ++i) {
-            if (i > 0) {
-                result << delimiter;
-            }
-            result << strings[i];
+    size_t totalSize = out.size() + delimiter.size() * (strings.size() - 1);
+    for (const auto& str : strings) {
+        totalSize += str.size();
+    }
+    out.reserve(totalSize);
+
+    for (size_t i = 0; i < strings.size(); ++i) {
+        if (i > 0) {
+            out.append(delimiter.data(), delimiter.size());
         }
-        
-        return result.str();
-        
-    } catch (const std::exception& e) {
-        SLOG_ERROR().message("Exception in join").context("error", e.what());
-        return ""; // Return empty string on error
+        out.append(strings[i]);
     }
 }
 
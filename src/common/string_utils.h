@@ -2,7 +2,10 @@
 #define BURWELL_STRING_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <iterator>
+#include <cstddef>
 
 namespace burwell {
 namespace utils {
@@ -23,7 +26,17 @@ public:
      * @return Modified string with all replacements made
      * @note Validates input parameters and handles edge cases
      */
-    static std::string replaceAll(const std::string& str, const std::string& from, const std::string& to);
+    static std::string replaceAll(std::string_view str, std::string_view from, std::string_view to);
+
+    /**
+     * @brief Replace all occurrences of a substring in place
+     * @param str String to modify (input/output parameter)
+     * @param from Substring to find (must not be empty)
+     * @param to Replacement string (can be empty)
+     * @return Number of replacements made
+     * @note Single pass; shrinking replacements reuse the existing buffer
+     */
+    static size_t replaceAllInPlace(std::string& str, std::string_view from, std::string_view to);
 
     /**
      * @brief Remove leading and trailing whitespace from string
@@ -31,21 +44,34 @@ public:
      * @return Trimmed string
      * @note Handles empty strings and all-whitespace strings properly
      */
-    static std::string trim(const std::string& str);
+    static std::string trim(std::string_view str);
+
+    /**
+     * @brief Trim whitespace without copying
+     * @param str String to trim (input parameter)
+     * @return View into str without leading and trailing whitespace
+     */
+    static std::string_view trimView(std::string_view str);
+
+    /**
+     * @brief Trim whitespace in place, keeping the string's buffer
+     * @param str String to trim (input/output parameter)
+     */
+    static void trimInPlace(std::string& str);
 
     /**
      * @brief Remove leading whitespace from string
      * @param str String to trim (input parameter)
      * @return Left-trimmed string
      */
-    static std::string trimLeft(const std::string& str);
+    static std::string trimLeft(std::string_view str);
 
     /**
      * @brief Remove trailing whitespace from string
      * @param str String to trim (input parameter)
      * @return Right-trimmed string
      */
-    static std::string trimRight(const std::string& str);
+    static std::string trimRight(std::string_view str);
 
     /**
      * @brief Split string by delimiter into vector of strings
@@ -54,7 +80,18 @@ public:
      * @return Vector of split strings (empty if input is empty)
      * @note Validates input and handles consecutive delimiters
      */
-    static std::vector<std::string> split(const std::string& str, const std::string& delimiter);
+    static std::vector<std::string> split(std::string_view str, std::string_view delimiter);
+
+    class SplitRange;
+
+    /**
+     * @brief Lazily split string by delimiter, yielding views into str
+     * @param str String to split (must outlive the range)
+     * @param delimiter Delimiter string (must outlive the range)
+     * @return Range of std::string_view parts with the same parts as split()
+     * @note Allocation free; an empty delimiter yields str as the only part
+     */
+    static SplitRange splitView(std::string_view str, std::string_view delimiter);
 
     /**
      * @brief Check if string starts with specified prefix
@@ -78,9 +115,24 @@ public:
      * @brief Convert string to lowercase
      * @param str String to convert (input parameter)
      * @return Lowercase version of string
-     * @note Handles Unicode characters properly on Windows
+     * @note ASCII case folding only, non-ASCII bytes are left untouched
+     */
+    static std::string toLowerCase(std::string_view str);
+
+    /**
+     * @brief Convert ASCII letters to lowercase in place
+     * @param str String to convert (input/output parameter)
+     * @note Processes 16 bytes per step with SSE2 where available
+     */
+    static void toLowerCaseInPlace(std::string& str);
+
+    /**
+     * @brief Case-insensitive (ASCII) substring search
+     * @param haystack String to search in (input parameter)
+     * @param needle Substring to look for (empty matches)
+     * @return true if needle occurs in haystack ignoring ASCII case
      */
-    static std::string toLowerCase(const std::string& str);
+    static bool containsIgnoreCase(std::string_view haystack, std::string_view needle);
 
     /**
      * @brief Convert string to uppercase
@@ -97,7 +149,17 @@ public:
      * @return Joined string
      * @note Handles empty vector and empty strings properly
      */
-    static std::string join(const std::vector<std::string>& strings, const std::string& delimiter);
+    static std::string join(const std::vector<std::string>& strings, std::string_view delimiter);
+
+    /**
+     * @brief Append joined strings to an existing buffer
+     * @param out Buffer to append to (input/output parameter)
+     * @param strings Vector of strings to join (can be empty)
+     * @param delimiter Delimiter to use between strings (can be empty)
+     * @note Reserves the final size once, so a reused buffer does not reallocate
+     */
+    static void appendJoined(std::string& out, const std::vector<std::string>& strings,
+                             std::string_view delimiter);
 
     /**
      * @brief Check if string contains only whitespace characters
@@ -119,6 +181,84 @@ private:
     static bool isWhitespace(char c);
 };
 
+/**
+ * @brief Forward range over the parts of a string split by a delimiter
+ */
+class StringUtils::SplitRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+        iterator(std::string_view str, std::string_view delimiter)
+            : m_rest(str), m_delimiter(delimiter), m_done(false), m_atEnd(false) {
+            advance();
+        }
+
+        reference operator*() const { return m_current; }
+        pointer operator->() const { return &m_current; }
+
+        iterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator previous = *this;
+            advance();
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const {
+            return m_atEnd == other.m_atEnd &&
+                   (m_atEnd || m_current.data() == other.m_current.data());
+        }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+
+    private:
+        void advance() {
+            if (m_done) {
+                m_atEnd = true;
+                return;
+            }
+            size_t pos = m_delimiter.empty() ? std::string_view::npos : m_rest.find(m_delimiter);
+            if (pos == std::string_view::npos) {
+                m_current = m_rest;
+                m_done = true;
+            } else {
+                m_current = m_rest.substr(0, pos);
+                m_rest.remove_prefix(pos + m_delimiter.size());
+            }
+        }
+
+        std::string_view m_rest;
+        std::string_view m_delimiter;
+        std::string_view m_current;
+        bool m_done = true;
+        bool m_atEnd = true;
+    };
+
+    SplitRange(std::string_view str, std::string_view delimiter)
+        : m_str(str), m_delimiter(delimiter) {}
+
+    // Matches split(): an empty input has no parts at all
+    iterator begin() const { return m_str.empty() ? end() : iterator(m_str, m_delimiter); }
+    iterator end() const { return iterator(); }
+
+private:
+    std::string_view m_str;
+    std::string_view m_delimiter;
+};
+
+inline StringUtils::SplitRange StringUtils::splitView(std::string_view str, std::string_view delimiter) {
+    return SplitRange(str, delimiter);
+}
+
 } // namespace utils
 } // namespace burwell
 
@@ -1,4 +1,6 @@
 #include "structured_logger.h"
+#include "json_stream_writer.h"
+#include "terminal_writer.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -49,14 +51,139 @@ namespace {
 }
 
 // JsonLogFormatter implementation
+namespace {
+    // Per-thread caches for the parts of a JSON line that rarely change
+    struct JsonFormatterCache {
+        std::time_t cached_second = 0;
+        bool has_second = false;
+        std::string cached_date_time;      // "YYYY-MM-DD HH:MM:SS"
+        std::string timestamp;             // cached_date_time plus ".mmm"
+        std::thread::id cached_thread;
+        bool has_thread = false;
+        std::string cached_thread_string;
+        std::string line_buffer;           // Reused by format()
+    };
+    
+    JsonFormatterCache& getJsonFormatterCache() {
+        thread_local JsonFormatterCache cache;
+        return cache;
+    }
+    
+    // Same text as formatTimestamp(), re-rendering the date part once per second
+    const std::string& getCachedTimestamp(JsonFormatterCache& cache,
+                                          const std::chrono::system_clock::time_point& tp) {
+        auto time_t = std::chrono::system_clock::to_time_t(tp);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            tp.time_since_epoch()) % 1000;
+        
+        if (!cache.has_second || cache.cached_second != time_t) {
+            std::stringstream ss;
+            ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+            cache.cached_date_time = ss.str();
+            cache.cached_second = time_t;
+            cache.has_second = true;
+        }
+        
+        int millis = static_cast<int>(ms.count());
+        cache.timestamp = cache.cached_date_time;
+        if (millis < 0) {
+            // Pre-epoch timestamps keep the stream formatting of formatTimestamp()
+            std::stringstream ss;
+            ss << '.' << std::setfill('0') << std::setw(3) << millis;
+            cache.timestamp += ss.str();
+        } else {
+            char fraction[4] = {'.', static_cast<char>('0' + millis / 100),
+                                static_cast<char>('0' + (millis / 10) % 10),
+                                static_cast<char>('0' + millis % 10)};
+            cache.timestamp.append(fraction, sizeof(fraction));
+        }
+        return cache.timestamp;
+    }
+    
+    const std::string& getCachedThreadString(JsonFormatterCache& cache, std::thread::id id) {
+        if (!cache.has_thread || cache.cached_thread != id) {
+            cache.cached_thread_string = threadIdToString(id);
+            cache.cached_thread = id;
+            cache.has_thread = true;
+        }
+        return cache.cached_thread_string;
+    }
+}
+
 std::string JsonLogFormatter::format(const LogEntry& entry) {
+    std::string& buffer = getJsonFormatterCache().line_buffer;
+    buffer.clear();
+    formatTo(entry, buffer);
+    return buffer;
+}
+
+void JsonLogFormatter::formatTo(const LogEntry& entry, std::string& out) {
+    JsonFormatterCache& cache = getJsonFormatterCache();
+    const size_t start = out.size();
+    
+    // Keys are written in the sorted order nlohmann::json's std::map-backed
+    // objects would dump them, so the output stays byte-identical
+    utils::JsonStreamWriter writer(out);
+    writer.beginObject();
+    
+    if (!entry.context.empty()) {
+        writer.key("context");
+        writer.value(entry.context);
+    }
+    
+    if (!entry.operation_name.empty()) {
+        writer.key("duration_ms");
+        writer.value(entry.duration.count() / 1000000.0);
+    }
+    
+    writer.key("level");
+    writer.value(logLevelToString(entry.level));
+    writer.key("logger");
+    writer.value(entry.logger_name);
+    writer.key("message");
+    writer.value(entry.message);
+    
+    if (!entry.operation_name.empty()) {
+        writer.key("operation");
+        writer.value(entry.operation_name);
+    }
+    
+    if (!entry.file.empty()) {
+        writer.key("source");
+        writer.beginObject();
+        writer.key("file");
+        writer.value(entry.file);
+        writer.key("line");
+        writer.value(entry.line);
+        writer.endObject();
+    }
+    
+    writer.key("thread");
+    if (entry.thread_name.empty()) {
+        writer.value(getCachedThreadString(cache, entry.thread_id));
+    } else {
+        writer.value(entry.thread_name);
+    }
+    writer.key("timestamp");
+    writer.value(getCachedTimestamp(cache, entry.timestamp));
+    writer.endObject();
+    out += '\n';
+    
+    if (!writer.ok()) {
+        // Invalid UTF-8 somewhere: defer to nlohmann so behaviour matches exactly
+        out.resize(start);
+        out += formatWithJsonTree(entry);
+    }
+}
+
+std::string JsonLogFormatter::formatWithJsonTree(const LogEntry& entry) {
     nlohmann::json log_json;
     
     log_json["timestamp"] = formatTimestamp(entry.timestamp);
     log_json["level"] = logLevelToString(entry.level);
     log_json["message"] = entry.message;
     log_json["logger"] = entry.logger_name;
-    log_json["thread"] = threadIdToString(entry.thread_id);
+    log_json["thread"] = entry.thread_name.empty() ? threadIdToString(entry.thread_id) : entry.thread_name;
     
     if (!entry.file.empty()) {
         log_json["source"]["file"] = entry.file;
@@ -84,7 +211,7 @@ std::string TextLogFormatter::format(const LogEntry& entry) {
     ss << "[" << std::setw(8) << logLevelToString(entry.level) << "] ";
     
     // Thread ID (shortened)
-    std::string thread_str = threadIdToString(entry.thread_id);
+    std::string thread_str = entry.thread_name.empty() ? threadIdToString(entry.thread_id) : entry.thread_name;
     if (thread_str.length() > 6) {
         thread_str = thread_str.substr(thread_str.length() - 6);
     }
@@ -122,33 +249,38 @@ std::string TextLogFormatter::format(const LogEntry& entry) {
 
 // ConsoleLogSink implementation
 ConsoleLogSink::ConsoleLogSink(std::shared_ptr<ILogFormatter> formatter)
-    : m_formatter(formatter) {}
+    : m_formatter(formatter) {
+    // Construct the writer now: the logger builds its default console sink in
+    // its own constructor, so the writer is destroyed after the logger's final flush
+    utils::TerminalWriter::getInstance();
+}
 
 void ConsoleLogSink::write(const LogEntry& entry) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
-    std::string formatted = m_formatter->format(entry);
+    m_buffer.clear();
+    m_formatter->formatTo(entry, m_buffer);
     
-    // Use different streams and colors based on level
+    // Shares the terminal with the UI through one buffered writer
+    auto& terminal = utils::TerminalWriter::getInstance();
     if (entry.level >= ::LogLevel::ERROR_LEVEL) {
         #ifdef _WIN32
-        HANDLE hConsole = GetStdHandle(STD_ERROR_HANDLE);
-        SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_INTENSITY);
-        #endif
-        
-        std::cerr << formatted;
-        
-        #ifdef _WIN32
-        SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+        if (terminal.isAnsiEnabled()) {
+            // Console attributes would apply at write time, not at frame time
+            m_buffer.insert(0, "\x1b[91m");
+            m_buffer += "\x1b[0m";
+        }
         #endif
+        terminal.write(m_buffer, utils::TerminalWriter::Stream::ERR);
+        // Errors must be on screen before a crash or abort can follow them
+        terminal.flush();
     } else {
-        std::cout << formatted;
+        terminal.write(m_buffer);
     }
 }
 
 void ConsoleLogSink::flush() {
-    std::cout.flush();
-    std::cerr.flush();
+    utils::TerminalWriter::getInstance().flush();
 }
 
 // RotatingFileLogSink implementation
@@ -171,9 +303,10 @@ void RotatingFileLogSink::write(const LogEntry& entry) {
         openNewFile();
     }
     
-    std::string formatted = m_formatter->format(entry);
-    *m_file << formatted;
-    m_current_size += formatted.size();
+    m_buffer.clear();
+    m_formatter->formatTo(entry, m_buffer);
+    m_file->write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_current_size += m_buffer.size();
     
     rotateIfNeeded();
 }
@@ -387,6 +520,7 @@ void PerformanceTracker::reportingLoop(std::chrono::seconds interval) {
                 StructuredLogger::getInstance().info()
                     .message("Performance Report")
                     .context("report", report);
+                StructuredLogger::getInstance().logSuppressionSummaries();
             } catch (...) {
                 // Ignore logging errors
             }
@@ -434,6 +568,303 @@ ScopedTimer& ScopedTimer::operator=(ScopedTimer&& other) noexcept {
     return *this;
 }
 
+// AsyncLogSink implementation
+AsyncLogSink::AsyncLogSink(std::shared_ptr<ILogSink> sink, const Config& config)
+    : m_sink(std::move(sink))
+    , m_config(config)
+    , m_queued(0)
+    , m_next_sequence(0)
+    , m_done_sequence(0)
+    , m_stopping(false)
+    , m_sample_counter(0) {
+    
+    m_config.capacity = std::max<size_t>(m_config.capacity, 1);
+    m_config.sample_rate = std::max<size_t>(m_config.sample_rate, 1);
+    m_writer = std::thread(&AsyncLogSink::writerLoop, this);
+}
+
+AsyncLogSink::~AsyncLogSink() {
+    stop();
+}
+
+void AsyncLogSink::write(const LogEntry& entry) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+        // Writer is gone: deliver directly so late entries are not lost
+        lock.unlock();
+        m_sink->write(entry);
+        return;
+    }
+    
+    if (m_queued >= m_config.capacity && !makeRoom(entry, lock)) {
+        recordDrop(entry.level);
+        return;
+    }
+    if (m_stopping) {
+        lock.unlock();
+        m_sink->write(entry);
+        return;
+    }
+    
+    size_t level = std::min(static_cast<size_t>(entry.level), LEVEL_COUNT - 1);
+    m_queues[level].push_back({m_next_sequence++, entry});
+    ++m_queued;
+    ++m_stats.enqueued;
+    m_stats.max_queue_depth = std::max(m_stats.max_queue_depth, m_queued);
+    lock.unlock();
+    m_not_empty.notify_one();
+}
+
+bool AsyncLogSink::dropOldestBelow(LogLevel level) {
+    // Oldest entry across the level queues below level; each candidate is a queue front
+    std::deque<QueuedEntry>* victim = nullptr;
+    for (size_t i = 0; i < std::min(static_cast<size_t>(level), LEVEL_COUNT); ++i) {
+        if (!m_queues[i].empty() &&
+            (!victim || m_queues[i].front().sequence < victim->front().sequence)) {
+            victim = &m_queues[i];
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+    recordDrop(victim->front().entry.level);
+    victim->pop_front();
+    --m_queued;
+    return true;
+}
+
+bool AsyncLogSink::makeRoom(const LogEntry& entry, std::unique_lock<std::mutex>& lock) {
+    auto waitForSpace = [this, &lock] {
+        ++m_stats.blocked;
+        m_not_full.wait(lock, [this] {
+            return m_stopping || m_queued < m_config.capacity;
+        });
+        return true;
+    };
+    
+    switch (m_config.policy) {
+        case OverflowPolicy::BLOCK:
+            return waitForSpace();
+            
+        case OverflowPolicy::DROP_OLDEST:
+            return dropOldestBelow(static_cast<LogLevel>(LEVEL_COUNT));
+            
+        case OverflowPolicy::DROP_DEBUG_FIRST:
+            // Oldest entry of the lowest level present, unless the new one is lower still
+            for (size_t i = 0; i < LEVEL_COUNT; ++i) {
+                if (m_queues[i].empty()) {
+                    continue;
+                }
+                if (i > static_cast<size_t>(entry.level)) {
+                    return false;
+                }
+                recordDrop(m_queues[i].front().entry.level);
+                m_queues[i].pop_front();
+                --m_queued;
+                return true;
+            }
+            return false;
+        
+        case OverflowPolicy::SAMPLE:
+            if (entry.level < ::LogLevel::WARNING &&
+                m_sample_counter++ % m_config.sample_rate != 0) {
+                return false;
+            }
+            // Only entries below WARNING are ever evicted
+            if (dropOldestBelow(::LogLevel::WARNING)) {
+                return true;
+            }
+            if (entry.level < ::LogLevel::WARNING) {
+                return false;
+            }
+            // Queue holds nothing but WARNING+: wait rather than lose one
+            return waitForSpace();
+    }
+    return false;
+}
+
+void AsyncLogSink::recordDrop(LogLevel level) {
+    // Caller holds m_mutex
+    ++m_stats.dropped;
+    size_t index = static_cast<size_t>(level);
+    if (index < m_stats.dropped_by_level.size()) {
+        ++m_stats.dropped_by_level[index];
+    }
+}
+
+void AsyncLogSink::writerLoop() {
+    LevelQueues batch;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_not_empty.wait(lock, [this] { return m_stopping || m_queued > 0; });
+        if (m_queued == 0) {
+            break;  // Stopping and fully drained
+        }
+        
+        // Take everything queued so producers only contend for the swap
+        for (size_t i = 0; i < LEVEL_COUNT; ++i) {
+            batch[i].swap(m_queues[i]);
+        }
+        size_t written = m_queued;
+        uint64_t batchEnd = m_next_sequence;
+        m_queued = 0;
+        lock.unlock();
+        m_not_full.notify_all();
+        
+        // Merge the level queues back into the order the entries were logged in
+        while (true) {
+            std::deque<QueuedEntry>* next = nullptr;
+            for (auto& queue : batch) {
+                if (!queue.empty() && (!next || queue.front().sequence < next->front().sequence)) {
+                    next = &queue;
+                }
+            }
+            if (!next) {
+                break;
+            }
+            try {
+                m_sink->write(next->front().entry);
+            } catch (...) {
+                // A failing sink must not kill its writer thread
+            }
+            next->pop_front();
+        }
+        
+        lock.lock();
+        m_done_sequence = batchEnd;
+        m_stats.written += written;
+        m_drained.notify_all();
+    }
+    m_done_sequence = m_next_sequence;
+    m_drained.notify_all();
+}
+
+void AsyncLogSink::flush() {
+    {
+        // Entries logged after this point do not hold the flush up
+        std::unique_lock<std::mutex> lock(m_mutex);
+        uint64_t target = m_next_sequence;
+        m_drained.wait(lock, [this, target] { return m_done_sequence >= target; });
+    }
+    m_sink->flush();
+}
+
+void AsyncLogSink::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            return;
+        }
+        m_stopping = true;
+    }
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+    m_sink->flush();
+}
+
+AsyncLogSink::Stats AsyncLogSink::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    stats.queue_depth = m_queued;
+    return stats;
+}
+
+AsyncLogSink::OverflowPolicy AsyncLogSink::overflowPolicyFromString(const std::string& name) {
+    if (name == "block") return OverflowPolicy::BLOCK;
+    if (name == "drop_oldest") return OverflowPolicy::DROP_OLDEST;
+    if (name == "sample") return OverflowPolicy::SAMPLE;
+    return OverflowPolicy::DROP_DEBUG_FIRST;
+}
+
+// LogCallsite implementation
+namespace {
+
+constexpr int64_t SUPPRESSION_SUMMARY_INTERVAL_NS = 10LL * 1000000000LL;
+
+struct LogCallsiteRegistry {
+    std::mutex mutex;
+    std::vector<LogCallsite*> callsites;
+};
+
+LogCallsiteRegistry& getCallsiteRegistry() {
+    static LogCallsiteRegistry registry;
+    return registry;
+}
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+LogCallsite::LogCallsite(const char* file, int line, LogLevel level)
+    : m_file(file)
+    , m_line(line)
+    , m_level(level) {
+    auto& registry = getCallsiteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.callsites.push_back(this);
+}
+
+LogCallsite::~LogCallsite() {
+    auto& registry = getCallsiteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.callsites.erase(std::remove(registry.callsites.begin(), registry.callsites.end(), this),
+                             registry.callsites.end());
+}
+
+bool LogCallsite::sample(uint64_t first, uint64_t everyN) {
+    uint64_t n = m_count.fetch_add(1, std::memory_order_relaxed);
+    if (n < first || everyN <= 1 || (n - first) % everyN == 0) {
+        return true;
+    }
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool LogCallsite::throttle(double burst, double perSecond) {
+    // GCRA: a token bucket kept as a single "theoretical arrival time"
+    int64_t now = steadyNowNs();
+    int64_t interval = perSecond > 0 ? static_cast<int64_t>(1e9 / perSecond) : SUPPRESSION_SUMMARY_INTERVAL_NS;
+    int64_t tolerance = static_cast<int64_t>(std::max(burst - 1.0, 0.0) * static_cast<double>(interval));
+    
+    int64_t tat = m_theoretical_arrival_ns.load(std::memory_order_relaxed);
+    while (true) {
+        int64_t start = std::max(tat, now);
+        if (start - now > tolerance) {
+            break;
+        }
+        if (m_theoretical_arrival_ns.compare_exchange_weak(tat, start + interval,
+                                                           std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    
+    // Let one message through per summary interval so the count gets reported
+    int64_t lastSummary = m_last_summary_ns.load(std::memory_order_relaxed);
+    if (now - lastSummary >= SUPPRESSION_SUMMARY_INTERVAL_NS &&
+        m_last_summary_ns.compare_exchange_strong(lastSummary, now, std::memory_order_relaxed)) {
+        if (lastSummary != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LogCallsite::forEach(const std::function<void(LogCallsite&)>& visitor) {
+    auto& registry = getCallsiteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (LogCallsite* callsite : registry.callsites) {
+        visitor(*callsite);
+    }
+}
+
 // StructuredLogger implementation
 StructuredLogger& StructuredLogger::getInstance() {
     static StructuredLogger instance;
@@ -442,6 +873,7 @@ StructuredLogger& StructuredLogger::getInstance() {
 
 StructuredLogger::StructuredLogger() 
     : m_min_level(::LogLevel::INFO)
+    , m_sinks(std::make_shared<const SinkList>())
     , m_async_enabled(false) {
     
     // Add default console sink
@@ -455,47 +887,153 @@ StructuredLogger::~StructuredLogger() {
 
 void StructuredLogger::setLogLevel(::LogLevel level) {
     std::lock_guard<std::mutex> lock(m_config_mutex);
-    m_min_level = level;
+    m_min_level.store(level, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const StructuredLogger::SinkList> StructuredLogger::getSinks() {
+    std::lock_guard<std::mutex> lock(m_config_mutex);
+    return m_sinks;
+}
+
+void StructuredLogger::replaceSinks(SinkList sinks) {
+    // Caller holds m_config_mutex
+    m_sinks = std::make_shared<const SinkList>(std::move(sinks));
+}
+
+std::shared_ptr<AsyncLogSink> StructuredLogger::createWriter(const SinkRegistration& registration) const {
+    return std::make_shared<AsyncLogSink>(registration.sink,
+                                          registration.async_config.value_or(m_async_config));
 }
 
 void StructuredLogger::addSink(std::shared_ptr<ILogSink> sink) {
+    addSink(std::move(sink), {});
+}
+
+void StructuredLogger::addSink(std::shared_ptr<ILogSink> sink,
+                               const std::vector<std::string>& loggerNames) {
+    SinkRegistration registration{std::move(sink), loggerNames, std::nullopt, nullptr};
+    
     std::lock_guard<std::mutex> lock(m_config_mutex);
-    m_sinks.push_back(sink);
+    if (m_async_enabled) {
+        registration.writer = createWriter(registration);
+    }
+    SinkList sinks = *m_sinks;
+    sinks.push_back(std::move(registration));
+    replaceSinks(std::move(sinks));
 }
 
-void StructuredLogger::removeSink(std::shared_ptr<ILogSink> sink) {
+void StructuredLogger::addSink(std::shared_ptr<ILogSink> sink,
+                               const std::vector<std::string>& loggerNames,
+                               const AsyncLogSink::Config& asyncConfig) {
+    SinkRegistration registration{std::move(sink), loggerNames, asyncConfig, nullptr};
+    
     std::lock_guard<std::mutex> lock(m_config_mutex);
-    m_sinks.erase(std::remove(m_sinks.begin(), m_sinks.end(), sink), m_sinks.end());
+    if (m_async_enabled) {
+        registration.writer = createWriter(registration);
+    }
+    SinkList sinks = *m_sinks;
+    sinks.push_back(std::move(registration));
+    replaceSinks(std::move(sinks));
 }
 
-void StructuredLogger::setAsyncLogging(bool async) {
-    if (m_async_enabled == async) return;
+void StructuredLogger::removeSink(std::shared_ptr<ILogSink> sink) {
+    std::vector<std::shared_ptr<AsyncLogSink>> removedWriters;
+    {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        SinkList sinks;
+        for (const auto& registration : *m_sinks) {
+            if (registration.sink == sink) {
+                if (registration.writer) {
+                    removedWriters.push_back(registration.writer);
+                }
+            } else {
+                sinks.push_back(registration);
+            }
+        }
+        replaceSinks(std::move(sinks));
+    }
     
-    if (async) {
-        m_async_enabled = true;
-        m_logging_thread = std::thread(&StructuredLogger::asyncLoggingLoop, this);
-    } else {
-        m_async_enabled = false;
-        m_shutdown = true;
-        if (m_logging_thread.joinable()) {
-            m_logging_thread.join();
+    // Deliver what is already queued before the sink goes away
+    for (auto& writer : removedWriters) {
+        writer->stop();
+    }
+}
+
+void StructuredLogger::setAsyncLogging(bool async, const AsyncLogSink::Config& config) {
+    std::vector<std::shared_ptr<AsyncLogSink>> oldWriters;
+    {
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        m_async_config = config;
+        if (m_async_enabled == async) return;
+        m_async_enabled = async;
+        
+        SinkList sinks = *m_sinks;
+        for (auto& registration : sinks) {
+            if (registration.writer) {
+                oldWriters.push_back(registration.writer);
+            }
+            registration.writer = async ? createWriter(registration) : nullptr;
+        }
+        replaceSinks(std::move(sinks));
+    }
+    
+    for (auto& writer : oldWriters) {
+        writer->stop();
+    }
+}
+
+void StructuredLogger::logSuppressionSummaries() {
+    // Collect first: logging while holding the callsite registry lock could deadlock
+    struct Summary {
+        const char* file;
+        int line;
+        ::LogLevel level;
+        uint64_t suppressed;
+    };
+    std::vector<Summary> summaries;
+    LogCallsite::forEach([&summaries](LogCallsite& callsite) {
+        uint64_t suppressed = callsite.takeSuppressed();
+        if (suppressed > 0) {
+            summaries.push_back({callsite.getFile(), callsite.getLine(), callsite.getLevel(), suppressed});
         }
-        m_shutdown = false;
+    });
+    
+    for (const auto& summary : summaries) {
+        LogBuilder(this, summary.level)
+            .file(summary.file, summary.line)
+            .message("Suppressed similar messages")
+            .suppressed(summary.suppressed);
     }
 }
 
+AsyncLogSink::Stats StructuredLogger::getSinkStats(const std::shared_ptr<ILogSink>& sink) {
+    auto sinks = getSinks();
+    for (const auto& registration : *sinks) {
+        if (registration.sink == sink && registration.writer) {
+            return registration.writer->getStats();
+        }
+    }
+    return AsyncLogSink::Stats();
+}
+
+uint64_t StructuredLogger::getDroppedEntries() {
+    uint64_t dropped = 0;
+    auto sinks = getSinks();
+    for (const auto& registration : *sinks) {
+        if (registration.writer) {
+            dropped += registration.writer->getStats().dropped;
+        }
+    }
+    return dropped;
+}
+
 void StructuredLogger::log(const LogEntry& entry) {
     // Don't accept new log entries if we're shutting down
     if (m_shutdown) return;
     
-    if (entry.level < m_min_level) return;
+    if (!isLevelEnabled(entry.level)) return;
     
-    if (m_async_enabled && !m_shutdown) {
-        // Only push if the queue accepts it (not closed)
-        m_log_queue.push(entry);
-    } else if (!m_shutdown) {
-        processLogEntry(entry);
-    }
+    processLogEntry(entry);
 }
 
 void StructuredLogger::log(::LogLevel level, const std::string& message,
@@ -535,34 +1073,24 @@ void StructuredLogger::shutdown() {
     // First stop performance reporting to prevent new log entries
     m_performance_tracker.disablePeriodicReporting();
     
+    // Report what rate-limited callsites swallowed before the sinks stop
+    if (!m_shutdown) {
+        logSuppressionSummaries();
+    }
+    
     // Signal shutdown
     m_shutdown = true;
     
-    // If async logging is enabled, stop the thread properly
-    if (m_async_enabled) {
-        // Don't close the queue immediately - let it drain first
-        // Give the logging thread time to process remaining items
-        if (m_logging_thread.joinable()) {
-            // Wait up to 2 seconds for the thread to finish
-            for (int i = 0; i < 20 && !m_log_queue.empty(); ++i) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Drain and stop every sink writer, then flush all sinks one last time
+    try {
+        auto sinks = getSinks();
+        for (const auto& registration : *sinks) {
+            if (registration.writer) {
+                registration.writer->stop();
             }
-            
-            // Now close the queue to unblock the thread if it's waiting
-            m_log_queue.close();
-            
-            // Join the thread
-            m_logging_thread.join();
         }
-        
-        m_async_enabled = false;
-    }
-    
-    // Flush all sinks one last time
-    try {
-        std::lock_guard<std::mutex> lock(m_config_mutex);
-        for (auto& sink : m_sinks) {
-            sink->flush();
+        for (const auto& registration : *sinks) {
+            registration.sink->flush();
         }
     } catch (...) {
         // Ignore errors during shutdown
@@ -570,39 +1098,32 @@ void StructuredLogger::shutdown() {
 }
 
 void StructuredLogger::flush() {
-    // If async logging is enabled, wait for queue to be empty
-    if (m_async_enabled) {
-        // Process any remaining items in the queue
-        while (!m_log_queue.empty()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
-    }
+    logSuppressionSummaries();
     
-    // Flush all sinks
-    std::lock_guard<std::mutex> lock(m_config_mutex);
-    for (auto& sink : m_sinks) {
-        sink->flush();
-    }
-}
-
-void StructuredLogger::asyncLoggingLoop() {
-    while (!m_shutdown) {
-        auto entry_opt = m_log_queue.popWithTimeout(100);
-        if (entry_opt) {
-            processLogEntry(*entry_opt);
+    // Async writers flush only after their queue has drained
+    auto sinks = getSinks();
+    for (const auto& registration : *sinks) {
+        if (registration.writer) {
+            registration.writer->flush();
+        } else {
+            registration.sink->flush();
         }
     }
-    
-    // Process remaining entries
-    while (auto entry_opt = m_log_queue.tryPop()) {
-        processLogEntry(*entry_opt);
-    }
 }
 
 void StructuredLogger::processLogEntry(const LogEntry& entry) {
-    std::lock_guard<std::mutex> lock(m_config_mutex);
-    for (auto& sink : m_sinks) {
-        sink->write(entry);
+    auto sinks = getSinks();
+    for (const auto& registration : *sinks) {
+        if (!registration.loggers.empty() &&
+            std::find(registration.loggers.begin(), registration.loggers.end(),
+                      entry.logger_name) == registration.loggers.end()) {
+            continue;
+        }
+        if (registration.writer) {
+            registration.writer->write(entry);
+        } else {
+            registration.sink->write(entry);
+        }
     }
 }
 
@@ -620,6 +1141,12 @@ StructuredLogger::LogBuilder::message(const std::string& msg) {
     return *this;
 }
 
+StructuredLogger::LogBuilder& 
+StructuredLogger::LogBuilder::logger(const std::string& name) {
+    m_entry.logger_name = name;
+    return *this;
+}
+
 StructuredLogger::LogBuilder& 
 StructuredLogger::LogBuilder::context(const std::string& key, const nlohmann::json& value) {
     m_entry.context[key] = value;
@@ -645,6 +1172,14 @@ StructuredLogger::LogBuilder::duration(std::chrono::nanoseconds ns) {
     return *this;
 }
 
+StructuredLogger::LogBuilder& 
+StructuredLogger::LogBuilder::suppressed(uint64_t count) {
+    if (count > 0) {
+        m_entry.context["suppressed"] = count;
+    }
+    return *this;
+}
+
 StructuredLogger::LogBuilder::~LogBuilder() {
     if (m_logger) {
         m_logger->log(m_entry);
@@ -10,6 +10,11 @@
 #include <mutex>
 #include <shared_mutex>
 #include <vector>
+#include <deque>
+#include <functional>
+#include <array>
+#include <optional>
+#include <condition_variable>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include "thread_safe_queue.h"
@@ -36,6 +41,7 @@ struct LogEntry {
     std::string file;
     int line;
     std::thread::id thread_id;
+    std::string thread_name;  // Shown instead of thread_id when set (e.g. decoded logs)
     nlohmann::json context;  // Additional structured data
     
     // Performance metrics
@@ -52,14 +58,25 @@ class ILogFormatter {
 public:
     virtual ~ILogFormatter() = default;
     virtual std::string format(const LogEntry& entry) = 0;
+    
+    // Append the formatted entry to out; sinks reuse out across entries
+    virtual void formatTo(const LogEntry& entry, std::string& out) { out += format(entry); }
 };
 
 /**
  * @brief JSON log formatter for structured logging
+ *
+ * Writes the entry straight into the output buffer (byte-identical to dumping
+ * an nlohmann::json object of the same fields) instead of building a json tree.
+ * Timestamp and thread id strings are cached per thread.
  */
 class JsonLogFormatter : public ILogFormatter {
 public:
     std::string format(const LogEntry& entry) override;
+    void formatTo(const LogEntry& entry, std::string& out) override;
+    
+private:
+    std::string formatWithJsonTree(const LogEntry& entry);
 };
 
 /**
@@ -92,6 +109,7 @@ public:
 private:
     std::shared_ptr<ILogFormatter> m_formatter;
     std::mutex m_mutex;
+    std::string m_buffer;
 };
 
 /**
@@ -118,6 +136,7 @@ private:
     std::shared_ptr<ILogFormatter> m_formatter;
     std::unique_ptr<std::ofstream> m_file;
     std::mutex m_mutex;
+    std::string m_buffer;
     size_t m_current_size;
     
     void rotateIfNeeded();
@@ -126,6 +145,84 @@ private:
     std::string generateFileName(int index = 0);
 };
 
+/**
+ * @brief Sink decorator that writes through its own bounded queue and thread
+ *
+ * A slow wrapped sink only backs up its own queue; what happens when that
+ * queue is full is decided by the overflow policy.
+ */
+class AsyncLogSink : public ILogSink {
+public:
+    enum class OverflowPolicy {
+        BLOCK,              // Caller waits for space
+        DROP_OLDEST,        // Oldest queued entry is discarded
+        DROP_DEBUG_FIRST,   // Lowest-level queued entry goes first; drop the new one if it is lower
+        SAMPLE              // Keep 1 in sample_rate entries below WARNING, evicting only those;
+                            // WARNING+ waits for space when nothing else can go
+    };
+    
+    struct Config {
+        size_t capacity = 8192;
+        OverflowPolicy policy = OverflowPolicy::DROP_DEBUG_FIRST;
+        size_t sample_rate = 10;
+    };
+    
+    struct Stats {
+        uint64_t enqueued = 0;
+        uint64_t written = 0;
+        uint64_t dropped = 0;
+        std::array<uint64_t, 5> dropped_by_level{};  // Indexed by LogLevel
+        uint64_t blocked = 0;                        // Writes that had to wait (BLOCK, or SAMPLE for WARNING+)
+        size_t queue_depth = 0;
+        size_t max_queue_depth = 0;
+    };
+    
+    AsyncLogSink(std::shared_ptr<ILogSink> sink, const Config& config);
+    ~AsyncLogSink();
+    
+    void write(const LogEntry& entry) override;
+    void flush() override;     // Waits until everything queued before the call is written, then flushes the sink
+    
+    // Drain the queue and stop the writer; later writes go straight to the sink
+    void stop();
+    
+    Stats getStats() const;
+    std::shared_ptr<ILogSink> getSink() const { return m_sink; }
+    
+    static OverflowPolicy overflowPolicyFromString(const std::string& name);
+    
+private:
+    std::shared_ptr<ILogSink> m_sink;
+    Config m_config;
+    
+    struct QueuedEntry {
+        uint64_t sequence;
+        LogEntry entry;
+    };
+    static constexpr size_t LEVEL_COUNT = 5;
+    using LevelQueues = std::array<std::deque<QueuedEntry>, LEVEL_COUNT>;
+    
+    mutable std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::condition_variable m_drained;
+    // One FIFO per level, so every overflow policy evicts from a queue front in O(1);
+    // the writer merges them back into sequence order
+    LevelQueues m_queues;
+    size_t m_queued;
+    uint64_t m_next_sequence;  // Sequence of the next enqueued entry
+    uint64_t m_done_sequence;  // Every entry below this has been written or dropped
+    bool m_stopping;
+    uint64_t m_sample_counter;
+    Stats m_stats;
+    std::thread m_writer;
+    
+    bool makeRoom(const LogEntry& entry, std::unique_lock<std::mutex>& lock);
+    bool dropOldestBelow(LogLevel level);
+    void recordDrop(LogLevel level);
+    void writerLoop();
+};
+
 /**
  * @brief Performance metrics tracker
  */
@@ -200,6 +297,49 @@ private:
     bool m_cancelled;
 };
 
+/**
+ * @brief Rate limiter for a single logging callsite
+ *
+ * Instantiated as a function-local static by the SLOG_*_SAMPLED and
+ * SLOG_*_THROTTLED macros, so each check is a few relaxed atomic operations.
+ * Suppressed messages are counted and reported on the next emitted message
+ * ("suppressed" context) or by StructuredLogger::logSuppressionSummaries().
+ */
+class LogCallsite {
+public:
+    LogCallsite(const char* file, int line, LogLevel level);
+    ~LogCallsite();
+    
+    LogCallsite(const LogCallsite&) = delete;
+    LogCallsite& operator=(const LogCallsite&) = delete;
+    
+    // Log the first `first` messages, then one in every `everyN`
+    bool sample(uint64_t first, uint64_t everyN);
+    
+    // Token bucket: `burst` messages at once, refilled at `perSecond`.
+    // While suppressing, lets one message through every summary interval.
+    bool throttle(double burst, double perSecond);
+    
+    // Suppressed count since the last call (reported with the emitted message)
+    uint64_t takeSuppressed() { return m_suppressed.exchange(0, std::memory_order_relaxed); }
+    
+    const char* getFile() const { return m_file; }
+    int getLine() const { return m_line; }
+    LogLevel getLevel() const { return m_level; }
+    
+    // Visit every live callsite (used for summaries)
+    static void forEach(const std::function<void(LogCallsite&)>& visitor);
+    
+private:
+    const char* m_file;
+    int m_line;
+    LogLevel m_level;
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_suppressed{0};
+    std::atomic<int64_t> m_theoretical_arrival_ns{0};   // GCRA state for throttle()
+    std::atomic<int64_t> m_last_summary_ns{0};
+};
+
 /**
  * @brief Enhanced structured logger
  */
@@ -209,9 +349,23 @@ public:
     
     // Configuration
     void setLogLevel(LogLevel level);
+    bool isLevelEnabled(LogLevel level) const { return level >= m_min_level.load(std::memory_order_relaxed); }
     void addSink(std::shared_ptr<ILogSink> sink);
+    // Route only entries whose logger_name is listed; an empty list means all
+    void addSink(std::shared_ptr<ILogSink> sink, const std::vector<std::string>& loggerNames);
+    // Per-sink queue settings used when async logging is enabled
+    void addSink(std::shared_ptr<ILogSink> sink, const std::vector<std::string>& loggerNames,
+                 const AsyncLogSink::Config& asyncConfig);
     void removeSink(std::shared_ptr<ILogSink> sink);
-    void setAsyncLogging(bool async);
+    // Gives every sink its own queue and writer thread; config applies to sinks without their own
+    void setAsyncLogging(bool async, const AsyncLogSink::Config& config = AsyncLogSink::Config());
+    
+    // Emit "Suppressed similar messages" for rate-limited callsites with pending counts
+    void logSuppressionSummaries();
+    
+    // Queue statistics of a sink's async writer (all zero when not async)
+    AsyncLogSink::Stats getSinkStats(const std::shared_ptr<ILogSink>& sink);
+    uint64_t getDroppedEntries();
     
     // Logging methods
     void log(const LogEntry& entry);
@@ -229,10 +383,12 @@ public:
         LogBuilder(StructuredLogger* logger, LogLevel level);
         
         LogBuilder& message(const std::string& msg);
+        LogBuilder& logger(const std::string& name);
         LogBuilder& context(const std::string& key, const nlohmann::json& value);
         LogBuilder& file(const char* file, int line);
         LogBuilder& operation(const std::string& op);
         LogBuilder& duration(std::chrono::nanoseconds ns);
+        LogBuilder& suppressed(uint64_t count);  // Adds context only when count > 0
         
         ~LogBuilder();  // Logs on destruction
         
@@ -258,21 +414,31 @@ private:
     StructuredLogger();
     ~StructuredLogger();
     
-    LogLevel m_min_level;
-    std::vector<std::shared_ptr<ILogSink>> m_sinks;
+    struct SinkRegistration {
+        std::shared_ptr<ILogSink> sink;
+        std::vector<std::string> loggers;  // Empty: receives every entry
+        std::optional<AsyncLogSink::Config> async_config;
+        std::shared_ptr<AsyncLogSink> writer;  // Set while async logging is enabled
+    };
+    using SinkList = std::vector<SinkRegistration>;
+    
+    std::atomic<LogLevel> m_min_level;
+    // Copy-on-write: writers take a snapshot and never hold m_config_mutex while writing
+    std::shared_ptr<const SinkList> m_sinks;
     std::mutex m_config_mutex;
     
     // Async logging
     bool m_async_enabled;
-    ThreadSafeQueue<LogEntry> m_log_queue;
-    std::thread m_logging_thread;
+    AsyncLogSink::Config m_async_config;
     std::atomic<bool> m_shutdown{false};
     
     // Performance tracking
     PerformanceTracker m_performance_tracker;
     
-    void asyncLoggingLoop();
     void processLogEntry(const LogEntry& entry);
+    std::shared_ptr<const SinkList> getSinks();
+    void replaceSinks(SinkList sinks);
+    std::shared_ptr<AsyncLogSink> createWriter(const SinkRegistration& registration) const;
 };
 
 // Convenience macros for structured logging
@@ -282,6 +448,26 @@ private:
 #define SLOG_ERROR() burwell::StructuredLogger::getInstance().error().file(__FILE__, __LINE__)
 #define SLOG_CRITICAL() burwell::StructuredLogger::getInstance().critical().file(__FILE__, __LINE__)
 
+// Rate-limited variants for hot loops; each expansion owns one static LogCallsite.
+// SAMPLED: first `first` messages, then 1 in `everyN`.
+// THROTTLED: bursts of `burst`, at most `perSecond` sustained.
+// A disabled level skips the callsite entirely, so it neither counts nor suppresses.
+#define BURWELL_SLOG_LIMITED(level, builder, check) \
+    if (static burwell::LogCallsite slog_callsite_(__FILE__, __LINE__, level); \
+        !burwell::StructuredLogger::getInstance().isLevelEnabled(level) || !slog_callsite_.check) {} \
+    else burwell::StructuredLogger::getInstance().builder().file(__FILE__, __LINE__) \
+        .suppressed(slog_callsite_.takeSuppressed())
+
+#define SLOG_DEBUG_SAMPLED(first, everyN) BURWELL_SLOG_LIMITED(::LogLevel::DEBUG, debug, sample(first, everyN))
+#define SLOG_INFO_SAMPLED(first, everyN) BURWELL_SLOG_LIMITED(::LogLevel::INFO, info, sample(first, everyN))
+#define SLOG_WARNING_SAMPLED(first, everyN) BURWELL_SLOG_LIMITED(::LogLevel::WARNING, warning, sample(first, everyN))
+#define SLOG_ERROR_SAMPLED(first, everyN) BURWELL_SLOG_LIMITED(::LogLevel::ERROR_LEVEL, error, sample(first, everyN))
+
+#define SLOG_DEBUG_THROTTLED(burst, perSecond) BURWELL_SLOG_LIMITED(::LogLevel::DEBUG, debug, throttle(burst, perSecond))
+#define SLOG_INFO_THROTTLED(burst, perSecond) BURWELL_SLOG_LIMITED(::LogLevel::INFO, info, throttle(burst, perSecond))
+#define SLOG_WARNING_THROTTLED(burst, perSecond) BURWELL_SLOG_LIMITED(::LogLevel::WARNING, warning, throttle(burst, perSecond))
+#define SLOG_ERROR_THROTTLED(burst, perSecond) BURWELL_SLOG_LIMITED(::LogLevel::ERROR_LEVEL, error, throttle(burst, perSecond))
+
 // Performance timing macros
 #define SCOPED_TIMER(operation) burwell::ScopedTimer _timer(operation)
 #define SCOPED_TIMER_LEVEL(operation, level) burwell::ScopedTimer _timer(operation, level)
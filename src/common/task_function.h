@@ -0,0 +1,129 @@
+#ifndef BURWELL_TASK_FUNCTION_H
+#define BURWELL_TASK_FUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace burwell {
+
+/**
+ * @brief Move-only void() callable with inline storage
+ *
+ * Unlike std::function it accepts move-only callables (a lambda owning a
+ * std::promise, say) and stores any callable of up to INLINE_SIZE bytes
+ * inside the object, so queuing a typical task allocates nothing. Larger
+ * callables fall back to the heap.
+ */
+class TaskFunction {
+public:
+    static constexpr size_t INLINE_SIZE = 64;
+
+    TaskFunction() noexcept : m_ops(nullptr) {}
+    TaskFunction(std::nullptr_t) noexcept : m_ops(nullptr) {}
+
+    template<typename F, typename = typename std::enable_if<
+        !std::is_same<typename std::decay<F>::type, TaskFunction>::value &&
+        !std::is_same<typename std::decay<F>::type, std::nullptr_t>::value>::type>
+    TaskFunction(F&& f) : m_ops(nullptr) {
+        using Callable = typename std::decay<F>::type;
+        if constexpr (fitsInline<Callable>()) {
+            new (&m_storage) Callable(std::forward<F>(f));
+            m_ops = &inlineOps<Callable>();
+        } else {
+            *reinterpret_cast<Callable**>(&m_storage) = new Callable(std::forward<F>(f));
+            m_ops = &heapOps<Callable>();
+        }
+    }
+
+    TaskFunction(TaskFunction&& other) noexcept : m_ops(other.m_ops) {
+        if (m_ops) {
+            m_ops->relocate(&other.m_storage, &m_storage);
+            other.m_ops = nullptr;
+        }
+    }
+
+    TaskFunction& operator=(TaskFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.m_ops) {
+                other.m_ops->relocate(&other.m_storage, &m_storage);
+                m_ops = other.m_ops;
+                other.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    TaskFunction(const TaskFunction&) = delete;
+    TaskFunction& operator=(const TaskFunction&) = delete;
+
+    ~TaskFunction() { reset(); }
+
+    void operator()() { m_ops->invoke(&m_storage); }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+    // False when the callable was too large (or not nothrow-movable) and went to the heap
+    bool isInline() const noexcept { return m_ops == nullptr || m_ops->isInline; }
+
+    void reset() noexcept {
+        if (m_ops) {
+            m_ops->destroy(&m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    using Storage = typename std::aligned_storage<INLINE_SIZE, alignof(std::max_align_t)>::type;
+
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*relocate)(void* from, void* to) noexcept;    // Move into to, destroy from
+        void (*destroy)(void* storage) noexcept;
+        bool isInline;
+    };
+
+    template<typename Callable>
+    static constexpr bool fitsInline() {
+        // Relocation runs in noexcept moves, so a throwing move constructor goes to the heap
+        return sizeof(Callable) <= INLINE_SIZE && alignof(Callable) <= alignof(Storage) &&
+               std::is_nothrow_move_constructible<Callable>::value;
+    }
+
+    template<typename Callable>
+    static const Ops& inlineOps() {
+        static const Ops ops = {
+            [](void* storage) { (*static_cast<Callable*>(storage))(); },
+            [](void* from, void* to) noexcept {
+                Callable* source = static_cast<Callable*>(from);
+                new (to) Callable(std::move(*source));
+                source->~Callable();
+            },
+            [](void* storage) noexcept { static_cast<Callable*>(storage)->~Callable(); },
+            true
+        };
+        return ops;
+    }
+
+    template<typename Callable>
+    static const Ops& heapOps() {
+        static const Ops ops = {
+            [](void* storage) { (**static_cast<Callable**>(storage))(); },
+            [](void* from, void* to) noexcept {
+                *static_cast<Callable**>(to) = *static_cast<Callable**>(from);
+            },
+            [](void* storage) noexcept { delete *static_cast<Callable**>(storage); },
+            false
+        };
+        return ops;
+    }
+
+    Storage m_storage;
+    const Ops* m_ops;
+};
+
+} // namespace burwell
+
+#endif // BURWELL_TASK_FUNCTION_H
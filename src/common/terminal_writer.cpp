@@ -0,0 +1,352 @@
+#include "terminal_writer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#else
+#include <unistd.h>
+#include <sys/ioctl.h>
+#endif
+
+namespace burwell {
+namespace utils {
+
+namespace {
+
+constexpr int DEFAULT_FRAMES_PER_SECOND = 30;
+// Past this, writers render synchronously instead of queueing more
+constexpr size_t MAX_PENDING_BYTES = 4 * 1024 * 1024;
+constexpr int DEFAULT_TERMINAL_WIDTH = 80;
+
+bool detectTerminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return isatty(STDOUT_FILENO) != 0;
+#endif
+}
+
+bool enableAnsi(bool isTerminal) {
+    if (!isTerminal) {
+        return false;
+    }
+#ifdef _WIN32
+    HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (hOut == INVALID_HANDLE_VALUE || !GetConsoleMode(hOut, &mode)) {
+        return false;
+    }
+    return SetConsoleMode(hOut, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+#else
+    const char* term = std::getenv("TERM");
+    return term == nullptr || std::strcmp(term, "dumb") != 0;
+#endif
+}
+
+int getTerminalWidth() {
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
+        return csbi.srWindow.Right - csbi.srWindow.Left + 1;
+    }
+#else
+    struct winsize w;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0 && w.ws_col > 0) {
+        return w.ws_col;
+    }
+#endif
+    return DEFAULT_TERMINAL_WIDTH;
+}
+
+// Append at most maxColumns code points of text, stopping at a newline
+void appendTruncated(std::string& out, const std::string& text, size_t maxColumns) {
+    size_t columns = 0;
+    size_t end = 0;
+    while (end < text.size() && text[end] != '\n' && text[end] != '\r') {
+        unsigned char c = static_cast<unsigned char>(text[end]);
+        if ((c & 0xC0) != 0x80) {
+            if (columns == maxColumns) {
+                break;
+            }
+            ++columns;
+        }
+        ++end;
+    }
+    out.append(text, 0, end);
+}
+
+} // anonymous namespace
+
+TerminalWriter& TerminalWriter::getInstance() {
+    static TerminalWriter instance;
+    return instance;
+}
+
+TerminalWriter::TerminalWriter()
+    : m_isTerminal(detectTerminal())
+    , m_ansiEnabled(enableAnsi(m_isTerminal))
+    , m_pendingBytes(0)
+    , m_statusDirty(false)
+    , m_paused(false)
+    , m_drawnStatusLines(0)
+    , m_hasInputLine(false)
+    , m_inputCursorOffset(0)
+    , m_inputDirty(false)
+    , m_inputDrawn(false)
+    , m_frameIntervalMs(1000 / DEFAULT_FRAMES_PER_SECOND)
+    , m_stopping(false) {
+    m_frameThread = std::thread(&TerminalWriter::frameLoop, this);
+}
+
+TerminalWriter::~TerminalWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        // Leave the screen without a stale status region
+        m_status.clear();
+        m_statusDirty = true;
+        m_hasInputLine = false;
+    }
+    m_wake.notify_all();
+    if (m_frameThread.joinable()) {
+        m_frameThread.join();
+    }
+    render();
+}
+
+void TerminalWriter::write(std::string_view text, Stream stream) {
+    if (text.empty()) {
+        return;
+    }
+
+    bool renderNow = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_pending.empty() && m_pending.back().stream == stream) {
+            m_pending.back().text.append(text.data(), text.size());
+        } else {
+            m_pending.push_back({stream, std::string(text)});
+        }
+        m_pendingBytes += text.size();
+        renderNow = m_pendingBytes > MAX_PENDING_BYTES;
+    }
+
+    if (renderNow) {
+        // Producer outruns the terminal: pay for the write here
+        render();
+    }
+}
+
+void TerminalWriter::writeLine(std::string_view line, Stream stream) {
+    std::string text;
+    text.reserve(line.size() + 1);
+    text.append(line.data(), line.size());
+    text += '\n';
+    write(text, stream);
+}
+
+void TerminalWriter::setStatus(const std::string& key, const std::string& text) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& status : m_status) {
+        if (status.key == key) {
+            if (status.text != text) {
+                status.text = text;
+                status.changed = true;
+                m_statusDirty = true;
+            }
+            return;
+        }
+    }
+    m_status.push_back({key, text, true});
+    m_statusDirty = true;
+}
+
+void TerminalWriter::clearStatus(const std::string& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_status.begin(), m_status.end(),
+                           [&key](const StatusLine& status) { return status.key == key; });
+    if (it != m_status.end()) {
+        m_status.erase(it);
+        m_statusDirty = true;
+    }
+}
+
+void TerminalWriter::flush() {
+    render();
+}
+
+void TerminalWriter::pauseStatus() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_paused = true;
+        m_statusDirty = true;
+    }
+    render();
+}
+
+void TerminalWriter::resumeStatus() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_paused = false;
+        m_statusDirty = true;
+    }
+    m_wake.notify_all();
+}
+
+void TerminalWriter::setInputLine(const std::string& text, size_t cursorOffset) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hasInputLine = true;
+        m_inputLine = text;
+        m_inputCursorOffset = cursorOffset;
+        m_inputDirty = true;
+    }
+    // Keystrokes echo now rather than at the next frame
+    render();
+}
+
+void TerminalWriter::finishInputLine() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_hasInputLine) {
+            return;
+        }
+        m_hasInputLine = false;
+        m_inputDirty = false;
+        std::string line = m_inputLine + '\n';
+        if (!m_pending.empty() && m_pending.back().stream == Stream::OUT) {
+            m_pending.back().text += line;
+        } else {
+            m_pending.push_back({Stream::OUT, std::move(line)});
+        }
+        m_pendingBytes += m_inputLine.size() + 1;
+        m_inputLine.clear();
+    }
+    render();
+}
+
+void TerminalWriter::setFrameRate(int framesPerSecond) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameIntervalMs = 1000 / std::max(1, std::min(framesPerSecond, 1000));
+}
+
+void TerminalWriter::frameLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        m_wake.wait_for(lock, std::chrono::milliseconds(m_frameIntervalMs),
+                        [this] { return m_stopping; });
+        if (m_stopping) {
+            break;
+        }
+        if (m_pending.empty() && !m_statusDirty && !m_inputDirty) {
+            continue;
+        }
+        lock.unlock();
+        render();
+        lock.lock();
+    }
+}
+
+void TerminalWriter::appendStatusRegion(std::string& out) {
+    // Caller holds m_mutex and m_outputMutex
+    size_t width = static_cast<size_t>(std::max(getTerminalWidth(), 2));
+    for (auto& status : m_status) {
+        appendTruncated(out, status.text, width - 1);
+        out += '\n';
+        status.changed = false;
+    }
+    m_drawnStatusLines = m_status.size();
+}
+
+void TerminalWriter::appendInputLine(std::string& out) {
+    // Caller holds m_mutex and m_outputMutex
+    out += '\r';
+    out += m_inputLine;
+    out += "\x1b[K";
+    if (m_inputCursorOffset > 0) {
+        out += "\x1b[" + std::to_string(m_inputCursorOffset) + "D";
+    }
+    m_inputDrawn = true;
+}
+
+void TerminalWriter::render() {
+    std::lock_guard<std::mutex> outputLock(m_outputMutex);
+
+    std::vector<Segment> pending;
+    std::string statusOut;
+    std::string eraseRegion;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pending.swap(m_pending);
+        m_pendingBytes = 0;
+
+        if (m_ansiEnabled) {
+            bool redraw = m_statusDirty || !pending.empty();
+            if (redraw && (m_drawnStatusLines > 0 || m_inputDrawn)) {
+                // The input line, if drawn, is the last line of the region
+                eraseRegion = "\r";
+                if (m_drawnStatusLines > 0) {
+                    eraseRegion += "\x1b[" + std::to_string(m_drawnStatusLines) + "A";
+                }
+                eraseRegion += "\x1b[J";
+                m_drawnStatusLines = 0;
+                m_inputDrawn = false;
+            }
+            if (redraw && !m_paused) {
+                appendStatusRegion(statusOut);
+            }
+            if (m_hasInputLine && (redraw || m_inputDirty)) {
+                appendInputLine(statusOut);
+            }
+        } else if (!m_paused) {
+            // Plain output: each status change becomes an ordinary line
+            for (auto& status : m_status) {
+                if (status.changed) {
+                    statusOut += status.text;
+                    statusOut += '\n';
+                    status.changed = false;
+                }
+            }
+        }
+        m_statusDirty = false;
+        m_inputDirty = false;
+    }
+
+    if (eraseRegion.empty() && statusOut.empty() && pending.empty()) {
+        return;
+    }
+
+    // Consecutive stdout text goes out in a single write
+    std::string out = std::move(eraseRegion);
+    for (auto& segment : pending) {
+        if (segment.stream == Stream::OUT) {
+            out += segment.text;
+        } else {
+            writeTo(stdout, out);
+            std::fflush(stdout);
+            out.clear();
+            writeTo(stderr, segment.text);
+        }
+    }
+    out += statusOut;
+    writeTo(stdout, out);
+    std::fflush(stdout);
+}
+
+void TerminalWriter::writeTo(FILE* file, const std::string& text) {
+    if (!text.empty()) {
+        std::fwrite(text.data(), 1, text.size(), file);
+        if (file == stderr) {
+            std::fflush(stderr);
+        }
+    }
+}
+
+} // namespace utils
+} // namespace burwell
@@ -0,0 +1,134 @@
+#ifndef BURWELL_TERMINAL_WRITER_H
+#define BURWELL_TERMINAL_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+
+namespace burwell {
+namespace utils {
+
+/**
+ * @brief Buffered console writer shared by the UI and console logging
+ *
+ * Lines are queued and written in one batch per frame, so a verbose run costs
+ * a few large writes per second instead of a flush per line. On an ANSI
+ * terminal, status lines (progress, current step) live in a redraw region
+ * at the bottom, and regular lines scroll above it. When stdout is not a TTY,
+ * lines are written as-is and each status change becomes a plain line.
+ * An active prompt's input line is kept below the region and redrawn after
+ * every frame, so log lines never land inside it.
+ */
+class TerminalWriter {
+public:
+    enum class Stream {
+        OUT,
+        ERR
+    };
+
+    static TerminalWriter& getInstance();
+
+    /**
+     * @brief Queue text for output at the next frame
+     * @param text Text to write, normally ending with '\n'
+     * @param stream Destination stream
+     */
+    void write(std::string_view text, Stream stream = Stream::OUT);
+
+    /**
+     * @brief Queue a line; a newline is appended
+     */
+    void writeLine(std::string_view line, Stream stream = Stream::OUT);
+
+    /**
+     * @brief Set or replace a status line in the redraw region
+     * @param key Identifies the line; lines keep their first-set order
+     * @param text Single-line text (truncated to the terminal width)
+     */
+    void setStatus(const std::string& key, const std::string& text);
+    void clearStatus(const std::string& key);
+
+    /**
+     * @brief Write everything pending now (e.g. before reading input)
+     */
+    void flush();
+
+    /**
+     * @brief Erase the status region and stop redrawing it until resumed
+     * @note Use around direct console interaction such as prompts
+     */
+    void pauseStatus();
+    void resumeStatus();
+
+    /**
+     * @brief Keep an input line drawn below the status region (ANSI only)
+     * @param text Prompt and typed text, redrawn after every frame
+     * @param cursorOffset Code points between the cursor and the end of text
+     */
+    void setInputLine(const std::string& text, size_t cursorOffset);
+
+    /**
+     * @brief Stop redrawing the input line and leave it on screen as a regular line
+     */
+    void finishInputLine();
+
+    void setFrameRate(int framesPerSecond);
+    bool isTerminal() const { return m_isTerminal; }
+    bool isAnsiEnabled() const { return m_ansiEnabled; }
+
+private:
+    TerminalWriter();
+    ~TerminalWriter();
+
+    TerminalWriter(const TerminalWriter&) = delete;
+    TerminalWriter& operator=(const TerminalWriter&) = delete;
+
+    struct Segment {
+        Stream stream;
+        std::string text;
+    };
+
+    struct StatusLine {
+        std::string key;
+        std::string text;
+        bool changed;
+    };
+
+    void frameLoop();
+    void render();
+    void appendStatusRegion(std::string& out);
+    void appendInputLine(std::string& out);
+    static void writeTo(FILE* file, const std::string& text);
+
+    bool m_isTerminal;
+    bool m_ansiEnabled;
+
+    std::mutex m_mutex;                 // Guards pending output and status state
+    std::mutex m_outputMutex;           // Serializes rendering
+    std::condition_variable m_wake;
+    std::vector<Segment> m_pending;
+    size_t m_pendingBytes;
+    std::vector<StatusLine> m_status;
+    bool m_statusDirty;
+    bool m_paused;
+    size_t m_drawnStatusLines;          // Lines of the region currently on screen
+    bool m_hasInputLine;
+    std::string m_inputLine;
+    size_t m_inputCursorOffset;
+    bool m_inputDirty;
+    bool m_inputDrawn;                  // Cursor sits on a drawn input line
+    int m_frameIntervalMs;
+    bool m_stopping;
+    std::thread m_frameThread;
+};
+
+} // namespace utils
+} // namespace burwell
+
+#endif // BURWELL_TERMINAL_WRITER_H
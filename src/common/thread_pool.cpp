@@ -1,16 +1,221 @@
 #include "thread_pool.h"
 #include "structured_logger.h"
+#include "shutdown_manager.h"
 #include <sstream>
 #include <algorithm>
+#include <cmath>
 
 namespace burwell {
 
+namespace detail {
+
+namespace {
+
+constexpr size_t BLOCK_GRANULE = 64;
+constexpr size_t BLOCK_CLASSES = 8;           // Blocks of up to 512 bytes are recycled
+constexpr size_t MAX_FREE_BLOCKS = 1024;      // Per class; beyond this blocks go back to the heap
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct alignas(64) SizeClass {
+    SpinLock lock;
+    FreeBlock* head = nullptr;
+    size_t count = 0;
+};
+
+SizeClass* sizeClasses() {
+    // Never destroyed: states may be released by other static destructors at exit
+    static SizeClass* classes = new SizeClass[BLOCK_CLASSES];
+    return classes;
+}
+
+} // anonymous namespace
+
+void* BlockPool::allocate(size_t bytes) {
+    size_t index = bytes == 0 ? 0 : (bytes - 1) / BLOCK_GRANULE;
+    if (index >= BLOCK_CLASSES) {
+        return ::operator new(bytes);
+    }
+    SizeClass& sizeClass = sizeClasses()[index];
+    {
+        std::lock_guard<SpinLock> lock(sizeClass.lock);
+        if (FreeBlock* block = sizeClass.head) {
+            sizeClass.head = block->next;
+            --sizeClass.count;
+            return block;
+        }
+    }
+    return ::operator new((index + 1) * BLOCK_GRANULE);
+}
+
+void BlockPool::deallocate(void* block, size_t bytes) noexcept {
+    size_t index = bytes == 0 ? 0 : (bytes - 1) / BLOCK_GRANULE;
+    if (index < BLOCK_CLASSES) {
+        SizeClass& sizeClass = sizeClasses()[index];
+        std::lock_guard<SpinLock> lock(sizeClass.lock);
+        if (sizeClass.count < MAX_FREE_BLOCKS) {
+            sizeClass.head = new (block) FreeBlock{sizeClass.head};
+            ++sizeClass.count;
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
+} // namespace detail
+
+void ThreadPool::Completion::complete() {
+    TaskFunction next;
+    {
+        std::lock_guard<SpinLock> guard(lock);
+        done = true;
+        next = std::move(continuation);
+    }
+    if (next) {
+        pool->scheduleContinuation(priority, std::move(next));
+    }
+}
+
+void ThreadPool::TaskRing::push(QueuedTask&& task) {
+    if (m_count == m_slots.size()) {
+        std::vector<QueuedTask> grown(m_slots.empty() ? 16 : m_slots.size() * 2);
+        for (size_t i = 0; i < m_count; ++i) {
+            grown[i] = std::move(m_slots[(m_head + i) & (m_slots.size() - 1)]);
+        }
+        m_slots.swap(grown);
+        m_head = 0;
+    }
+    m_slots[(m_head + m_count) & (m_slots.size() - 1)] = std::move(task);
+    ++m_count;
+}
+
+ThreadPool::QueuedTask ThreadPool::TaskRing::pop() {
+    QueuedTask task = std::move(m_slots[m_head]);
+    m_head = (m_head + 1) & (m_slots.size() - 1);
+    --m_count;
+    return task;
+}
+
+void ThreadPool::TaskRing::clear() {
+    while (!empty()) {
+        pop();
+    }
+}
+
+namespace {
+
+template<typename T>
+bool laterDeadline(const T& a, const T& b) {
+    return a.deadline > b.deadline;
+}
+
+} // anonymous namespace
+
+bool ThreadPool::PriorityBand::nextIsDeadlineTask(Clock::duration halfLife) const {
+    if (deadlines.empty()) {
+        return false;
+    }
+    if (fifo.empty() || halfLife == Clock::duration::zero()) {
+        return true;
+    }
+    return deadlines.front().deadline <= fifo.front().enqueued + halfLife;
+}
+
+const ThreadPool::QueuedTask& ThreadPool::PriorityBand::next(Clock::duration halfLife) const {
+    return nextIsDeadlineTask(halfLife) ? deadlines.front() : fifo.front();
+}
+
+ThreadPool::QueuedTask ThreadPool::PriorityBand::pop(Clock::duration halfLife) {
+    if (!nextIsDeadlineTask(halfLife)) {
+        return fifo.pop();
+    }
+    std::pop_heap(deadlines.begin(), deadlines.end(), laterDeadline<QueuedTask>);
+    QueuedTask task = std::move(deadlines.back());
+    deadlines.pop_back();
+    return task;
+}
+
+void ThreadPool::PriorityBand::clear() {
+    fifo.clear();
+    deadlines.clear();
+}
+
+void ThreadPool::WaitHistogram::record(Clock::duration wait) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+    size_t bucket = 0;
+    if (micros > 0) {
+        uint64_t value = static_cast<uint64_t>(micros);
+        size_t msb = 0;
+        for (size_t shift = 32; shift > 0; shift /= 2) {
+            if (value >> (msb + shift)) {
+                msb += shift;
+            }
+        }
+        size_t quarter = msb >= 2 ? (value >> (msb - 2)) & 3 : (value << (2 - msb)) & 3;
+        bucket = std::min(NUM_BUCKETS - 1, 1 + msb * 4 + quarter);
+    }
+    ++m_buckets[bucket];
+    ++m_count;
+    m_max = std::max(m_max, wait);
+}
+
+ThreadPool::QueueWaitStats ThreadPool::WaitHistogram::summarize() const {
+    QueueWaitStats stats{};
+    stats.count = m_count;
+    stats.max = std::chrono::duration_cast<std::chrono::nanoseconds>(m_max);
+    
+    auto percentile = [this, &stats](double fraction) {
+        uint64_t target = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(m_count)));
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            seen += m_buckets[bucket];
+            if (seen >= target) {
+                // Upper bound of the bucket: (5 + quarter) / 4 * 2^msb microseconds
+                double micros = bucket == 0 ? 1.0
+                              : std::ldexp(5.0 + static_cast<double>((bucket - 1) % 4), static_cast<int>((bucket - 1) / 4)) / 4.0;
+                auto bound = std::chrono::nanoseconds(static_cast<int64_t>(micros * 1000.0));
+                return std::min(bound, stats.max);
+            }
+        }
+        return stats.max;
+    };
+    
+    if (m_count > 0) {
+        stats.p50 = percentile(0.50);
+        stats.p90 = percentile(0.90);
+        stats.p99 = percentile(0.99);
+    }
+    return stats;
+}
+
 ThreadPool::ThreadPool(size_t numThreads) 
-    : m_stopping(false)
+    : m_numPendingTasks(0)
+    , m_numIdleWorkers(0)
+    , m_agingHalfLife(Clock::duration::zero())
+    , m_numWorkers(0)
+    , m_coreThreads(0)
+    , m_minThreads(0)
+    , m_maxThreads(0)
+    , m_queueLatencyTarget(Clock::duration::zero())
+    , m_idleTimeout(Clock::duration::zero())
+    , m_supervisorIdle(false)
+    , m_peakThreads(0)
+    , m_threadsAdded(0)
+    , m_threadsRetired(0)
+    , m_numBlockedWorkers(0)
+    , m_blockingObserver(this)
+    , m_stopping(false)
     , m_numBusyThreads(0)
     , m_totalTasksExecuted(0)
     , m_totalTasksFailed(0)
-    , m_totalExecutionTime(0) {
+    , m_heapAllocatedTasks(0)
+    , m_totalExecutionTime(0)
+    , m_deadlineTasksStarted(0)
+    , m_deadlinesMissed(0) {
+    
+    setAgingHalfLife(DEFAULT_AGING_HALF_LIFE);
     
     if (numThreads == 0) {
         numThreads = std::thread::hardware_concurrency();
@@ -22,6 +227,12 @@ ThreadPool::ThreadPool(size_t numThreads)
     SLOG_INFO().message("Creating thread pool")
         .context("num_threads", numThreads);
     
+    m_numWorkers = numThreads;
+    m_coreThreads = numThreads;
+    m_minThreads = numThreads;
+    m_maxThreads = numThreads;
+    m_peakThreads = numThreads;
+    
     // Create worker threads
     for (size_t i = 0; i < numThreads; ++i) {
         m_threads.emplace_back(&ThreadPool::workerThread, this, i);
@@ -32,33 +243,138 @@ ThreadPool::~ThreadPool() {
     shutdown(false);
 }
 
+void ThreadPool::enqueue(Priority priority, TaskFunction func, Clock::time_point deadline) {
+    if (!tryEnqueue(priority, func, deadline)) {
+        throw std::runtime_error("Cannot submit task to stopping thread pool");
+    }
+}
+
+bool ThreadPool::tryEnqueue(Priority priority, TaskFunction& func, Clock::time_point deadline) {
+    bool inlineStorage = func.isInline();
+    Clock::time_point now = Clock::now();
+    bool wake = false;
+    bool pokeSupervisor = false;
+    
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        
+        if (m_stopping) {
+            return false;
+        }
+        
+        PriorityBand& band = m_tasks[static_cast<size_t>(priority)];
+        if (deadline == NO_DEADLINE) {
+            band.fifo.push(QueuedTask{std::move(func), now, deadline});
+        } else {
+            band.deadlines.push_back(QueuedTask{std::move(func), now, deadline});
+            std::push_heap(band.deadlines.begin(), band.deadlines.end(), laterDeadline<QueuedTask>);
+        }
+        m_numPendingTasks++;
+        // Each earlier queued task already woke a worker; only wake another if one is still asleep
+        wake = m_numPendingTasks <= m_numIdleWorkers;
+        // Shrunk below the core size: have the supervisor watch the queue again
+        pokeSupervisor = m_numWorkers < m_coreThreads && m_supervisorIdle;
+    }
+    
+    if (!inlineStorage) {
+        m_heapAllocatedTasks++;
+    }
+    if (wake) {
+        m_condition.notify_one();
+    }
+    if (pokeSupervisor) {
+        m_supervisorCondition.notify_one();
+    }
+    return true;
+}
+
+void ThreadPool::scheduleContinuation(Priority priority, TaskFunction func) {
+    // Once stopping, the queue may never be drained again
+    if (!tryEnqueue(priority, func)) {
+        func();
+    }
+}
+
+ThreadPool::QueuedTask ThreadPool::dequeue(size_t& level) {
+    size_t chosen = NUM_PRIORITIES;
+    Clock::time_point chosenKey;
+    for (size_t candidate = NUM_PRIORITIES; candidate-- > 0;) {
+        if (m_tasks[candidate].empty()) {
+            continue;
+        }
+        if (m_agingHalfLife == Clock::duration::zero()) {
+            chosen = candidate;
+            break;
+        }
+        // A task's aged priority only depends on how long it has waited, so
+        // ranking by queue time shifted by its band's offset gives the same order
+        Clock::time_point key = m_tasks[candidate].next(m_agingHalfLife).enqueued + m_agingOffsets[candidate];
+        if (chosen == NUM_PRIORITIES || key < chosenKey) {
+            chosen = candidate;
+            chosenKey = key;
+        }
+    }
+    
+    level = chosen;
+    m_numPendingTasks--;
+    return m_tasks[chosen].pop(m_agingHalfLife);
+}
+
+void ThreadPool::BlockingObserver::blockingBegin() {
+    m_pool->m_numBlockedWorkers++;
+    // Pairs with the supervisor setting m_supervisorIdle before it reads the blocked count
+    if (m_pool->m_supervisorIdle) {
+        std::lock_guard<std::mutex> lock(m_pool->m_queueMutex);
+        m_pool->m_supervisorCondition.notify_one();
+    }
+}
+
+void ThreadPool::BlockingObserver::blockingEnd() {
+    m_pool->m_numBlockedWorkers--;
+}
+
 void ThreadPool::workerThread(size_t threadId) {
     SLOG_DEBUG().message("Worker thread started")
         .context("thread_id", threadId);
     
+    BlockingRegion::setThreadObserver(&m_blockingObserver);
+    
     while (true) {
-        Task task(Priority::LOW, nullptr);
+        QueuedTask task;
+        size_t level = 0;
         
         {
             std::unique_lock<std::mutex> lock(m_queueMutex);
             
-            m_condition.wait(lock, [this] {
-                return m_stopping || !m_tasks.empty();
-            });
+            auto ready = [this] {
+                return m_stopping || m_numPendingTasks > 0;
+            };
+            m_numIdleWorkers++;
+            if (m_idleTimeout == Clock::duration::zero()) {
+                m_condition.wait(lock, ready);
+            } else if (!m_condition.wait_for(lock, m_idleTimeout, ready) && m_numWorkers > m_minThreads) {
+                m_numIdleWorkers--;
+                recordResize(m_numWorkers, m_numWorkers - 1, Clock::duration::zero());
+                m_numWorkers--;
+                m_threadsRetired++;
+                m_retiredThreads.push_back(threadId);
+                m_supervisorCondition.notify_one();
+                break;
+            }
+            m_numIdleWorkers--;
             
-            if (m_stopping && m_tasks.empty()) {
+            if (m_stopping && m_numPendingTasks == 0) {
                 break;
             }
             
-            if (!m_tasks.empty()) {
-                task = m_tasks.top();
-                m_tasks.pop();
+            if (m_numPendingTasks > 0) {
+                task = dequeue(level);
                 m_numBusyThreads++;
             }
         }
         
         if (task.func) {
-            auto startTime = std::chrono::steady_clock::now();
+            auto startTime = Clock::now();
             
             try {
                 task.func();
@@ -74,12 +390,22 @@ void ThreadPool::workerThread(size_t threadId) {
                 }
             }
             
+            // Captures are released before waitForAll can see this task as finished
+            task.func.reset();
+            
             auto endTime = std::chrono::steady_clock::now();
             auto duration = endTime - startTime;
             
             {
                 std::lock_guard<std::mutex> lock(m_statsMutex);
                 m_totalExecutionTime += duration;
+                m_queueWait[level].record(startTime - task.enqueued);
+                if (task.deadline != NO_DEADLINE) {
+                    m_deadlineTasksStarted++;
+                    if (startTime > task.deadline) {
+                        m_deadlinesMissed++;
+                    }
+                }
             }
             
             m_numBusyThreads--;
@@ -87,6 +413,8 @@ void ThreadPool::workerThread(size_t threadId) {
         }
     }
     
+    BlockingRegion::setThreadObserver(nullptr);
+    
     // Only log in debug mode and catch any errors
     try {
         SLOG_DEBUG().message("Worker thread stopped")
@@ -100,7 +428,7 @@ void ThreadPool::waitForAll() {
     std::unique_lock<std::mutex> lock(m_queueMutex);
     
     m_completionCondition.wait(lock, [this] {
-        return m_tasks.empty() && m_numBusyThreads == 0;
+        return m_numPendingTasks == 0 && m_numBusyThreads == 0;
     });
 }
 
@@ -116,13 +444,20 @@ void ThreadPool::shutdown(bool waitForTasks) {
         
         if (!waitForTasks) {
             // Clear pending tasks
-            while (!m_tasks.empty()) {
-                m_tasks.pop();
+            for (auto& band : m_tasks) {
+                band.clear();
             }
+            m_numPendingTasks = 0;
         }
     }
     
     m_condition.notify_all();
+    m_supervisorCondition.notify_all();
+    
+    // Joined first so m_threads stops changing
+    if (m_supervisor.joinable()) {
+        m_supervisor.join();
+    }
     
     // Wait for all threads to finish
     for (std::thread& thread : m_threads) {
@@ -145,22 +480,41 @@ void ThreadPool::shutdown(bool waitForTasks) {
     }
 }
 
+size_t ThreadPool::getNumThreads() const {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_numWorkers;
+}
+
 size_t ThreadPool::getNumPendingTasks() const {
     std::lock_guard<std::mutex> lock(m_queueMutex);
-    return m_tasks.size();
+    return m_numPendingTasks;
 }
 
 ThreadPool::PoolStats ThreadPool::getStats() const {
     std::lock_guard<std::mutex> lock(m_statsMutex);
     
     PoolStats stats;
-    stats.numThreads = m_threads.size();
-    stats.numBusyThreads = m_numBusyThreads;
+    {
+        std::lock_guard<std::mutex> queueLock(m_queueMutex);
+        stats.numThreads = m_numWorkers;
+        stats.numBusyThreads = m_numBusyThreads;
+        stats.numPendingTasks = m_numPendingTasks;
+        stats.peakThreads = m_peakThreads;
+        stats.totalThreadsAdded = m_threadsAdded;
+        stats.totalThreadsRetired = m_threadsRetired;
+        stats.recentResizes.assign(m_resizes.begin(), m_resizes.end());
+    }
     stats.numIdleThreads = stats.numThreads - stats.numBusyThreads;
-    stats.numPendingTasks = getNumPendingTasks();
+    stats.numBlockedThreads = std::min(m_numBlockedWorkers.load(), stats.numBusyThreads);
     stats.totalTasksExecuted = m_totalTasksExecuted;
     stats.totalTasksFailed = m_totalTasksFailed;
     stats.totalExecutionTime = m_totalExecutionTime;
+    stats.totalHeapAllocatedTasks = m_heapAllocatedTasks;
+    for (size_t level = 0; level < NUM_PRIORITIES; ++level) {
+        stats.queueWait[level] = m_queueWait[level].summarize();
+    }
+    stats.deadlineTasksStarted = m_deadlineTasksStarted;
+    stats.deadlinesMissed = m_deadlinesMissed;
     
     if (stats.totalTasksExecuted > 0) {
         stats.averageTaskTime = stats.totalExecutionTime / stats.totalTasksExecuted;
@@ -171,6 +525,174 @@ ThreadPool::PoolStats ThreadPool::getStats() const {
     return stats;
 }
 
+void ThreadPool::setAgingHalfLife(std::chrono::milliseconds halfLife) {
+    halfLife = std::max(halfLife, std::chrono::milliseconds(0));
+    
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_agingHalfLife = halfLife;
+    for (size_t level = 0; level < NUM_PRIORITIES; ++level) {
+        double levelsAbove = static_cast<double>(NUM_PRIORITIES - level);
+        m_agingOffsets[level] = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(static_cast<double>(halfLife.count()) * std::log2(levelsAbove)));
+    }
+}
+
+void ThreadPool::setElasticSizing(const ElasticSizing& sizing) {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    if (m_stopping) {
+        return;
+    }
+    
+    m_minThreads = sizing.minThreads == 0 ? m_coreThreads : std::min(sizing.minThreads, m_coreThreads);
+    m_maxThreads = std::max(sizing.maxThreads, m_coreThreads);
+    m_queueLatencyTarget = std::max<Clock::duration>(sizing.queueLatencyTarget, std::chrono::milliseconds(1));
+    
+    bool elastic = m_minThreads < m_coreThreads || m_maxThreads > m_coreThreads;
+    // Workers added earlier still retire after idling when sizing is turned off again
+    if (elastic || m_numWorkers > m_coreThreads) {
+        m_idleTimeout = std::max<Clock::duration>(sizing.idleTimeout, std::chrono::milliseconds(1));
+    } else {
+        m_idleTimeout = Clock::duration::zero();
+    }
+    
+    if (elastic && !m_supervisor.joinable()) {
+        m_supervisor = std::thread(&ThreadPool::supervisorThread, this);
+    }
+    m_supervisorCondition.notify_one();
+    size_t minThreads = m_minThreads;
+    size_t maxThreads = m_maxThreads;
+    lock.unlock();
+    
+    SLOG_INFO().message("Thread pool sizing changed")
+        .context("min_threads", minThreads)
+        .context("max_threads", maxThreads)
+        .context("queue_latency_target_ms", sizing.queueLatencyTarget.count())
+        .context("idle_timeout_ms", sizing.idleTimeout.count());
+}
+
+size_t ThreadPool::workersNeeded(Clock::time_point now, Clock::duration& queueLatency) const {
+    queueLatency = Clock::duration::zero();
+    if (m_numPendingTasks <= m_numIdleWorkers || m_numWorkers >= m_maxThreads) {
+        return 0;
+    }
+    
+    // Extra threads only help when workers are blocked (or retired below the core size)
+    size_t runnable = m_numWorkers - std::min(m_numBlockedWorkers.load(), m_numWorkers);
+    if (runnable >= m_coreThreads) {
+        return 0;
+    }
+    
+    Clock::time_point oldest = Clock::time_point::max();
+    for (const PriorityBand& band : m_tasks) {
+        if (!band.empty()) {
+            oldest = std::min(oldest, band.next(m_agingHalfLife).enqueued);
+        }
+    }
+    queueLatency = now - oldest;
+    if (queueLatency <= m_queueLatencyTarget) {
+        return 0;
+    }
+    
+    return std::min({m_numPendingTasks - m_numIdleWorkers, m_coreThreads - runnable, m_maxThreads - m_numWorkers});
+}
+
+void ThreadPool::recordResize(size_t fromThreads, size_t toThreads, Clock::duration queueLatency) {
+    if (m_resizes.size() == MAX_RESIZE_EVENTS) {
+        m_resizes.pop_front();
+    }
+    m_resizes.push_back(ResizeEvent{Clock::now(), fromThreads, toThreads, m_numBlockedWorkers.load(),
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(queueLatency)});
+}
+
+void ThreadPool::supervisorThread() {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    
+    while (!m_stopping) {
+        if (!m_retiredThreads.empty()) {
+            std::vector<size_t> retired;
+            retired.swap(m_retiredThreads);
+            lock.unlock();
+            for (size_t threadId : retired) {
+                m_threads[threadId].join();
+            }
+            lock.lock();
+            m_freeThreadIds.insert(m_freeThreadIds.end(), retired.begin(), retired.end());
+            continue;
+        }
+        
+        Clock::duration queueLatency;
+        size_t needed = workersNeeded(Clock::now(), queueLatency);
+        if (needed > 0) {
+            size_t fromThreads = m_numWorkers;
+            size_t nextThreadId = m_threads.size();
+            std::vector<size_t> threadIds;
+            for (size_t i = 0; i < needed; ++i) {
+                if (!m_freeThreadIds.empty()) {
+                    threadIds.push_back(m_freeThreadIds.back());
+                    m_freeThreadIds.pop_back();
+                } else {
+                    threadIds.push_back(nextThreadId++);
+                }
+            }
+            // Counted before they start so retiring workers see the new size
+            m_numWorkers += needed;
+            lock.unlock();
+            
+            size_t started = 0;
+            try {
+                for (; started < needed; ++started) {
+                    size_t threadId = threadIds[started];
+                    if (threadId >= m_threads.size()) {
+                        m_threads.resize(threadId + 1);
+                    }
+                    m_threads[threadId] = std::thread(&ThreadPool::workerThread, this, threadId);
+                }
+            } catch (const std::exception& e) {
+                SLOG_ERROR().message("Failed to grow thread pool")
+                    .context("error", e.what());
+            }
+            
+            lock.lock();
+            m_numWorkers -= needed - started;
+            m_freeThreadIds.insert(m_freeThreadIds.end(), threadIds.begin() + started, threadIds.end());
+            if (started > 0) {
+                m_threadsAdded += started;
+                m_peakThreads = std::max(m_peakThreads, m_numWorkers);
+                recordResize(m_numWorkers - started, m_numWorkers, queueLatency);
+                size_t blocked = m_numBlockedWorkers.load();
+                lock.unlock();
+                
+                SLOG_DEBUG().message("Thread pool grew")
+                    .context("from_threads", fromThreads)
+                    .context("to_threads", fromThreads + started)
+                    .context("blocked_threads", blocked)
+                    .context("queue_latency_ms", std::chrono::duration<double, std::milli>(queueLatency).count());
+                lock.lock();
+            }
+            if (started < needed) {
+                // Wait for the next blocking change before trying again
+                m_supervisorIdle = true;
+                m_supervisorCondition.wait(lock);
+                m_supervisorIdle = false;
+            }
+            continue;
+        }
+        
+        // Set before reading the blocked count, so a worker that blocks meanwhile sees it and notifies
+        m_supervisorIdle = true;
+        bool watching = (m_numBlockedWorkers > 0 && m_numWorkers < m_maxThreads) ||
+                        (m_numWorkers < m_coreThreads && m_numPendingTasks > 0);
+        if (watching) {
+            m_supervisorIdle = false;
+            m_supervisorCondition.wait_for(lock, std::max<Clock::duration>(m_queueLatencyTarget / 4,
+                                                                           std::chrono::milliseconds(1)));
+        } else {
+            m_supervisorCondition.wait(lock);
+            m_supervisorIdle = false;
+        }
+    }
+}
+
 void ThreadPool::setExceptionHandler(ExceptionHandler handler) {
     m_exceptionHandler = handler;
 }
@@ -184,28 +706,45 @@ AsyncTaskExecutor::AsyncTaskExecutor(size_t numThreads)
 
 AsyncTaskExecutor::~AsyncTaskExecutor() {
     // Cancel all active tasks
+    std::vector<std::shared_ptr<TaskInfo>> tasks;
     {
         std::lock_guard<std::mutex> lock(m_tasksMutex);
         for (auto& pair : m_activeTasks) {
-            pair.second->shouldStop = true;
+            tasks.push_back(pair.second);
         }
     }
+    for (auto& taskInfo : tasks) {
+        taskInfo->cancellation.cancel();
+    }
     
     // Wait for tasks to complete
     m_threadPool.shutdown(true);
 }
 
-AsyncTaskExecutor::TaskId AsyncTaskExecutor::submitTask(TaskFunc task, ThreadPool::Priority priority) {
-    TaskId taskId = generateTaskId();
-    
-    auto taskInfo = std::make_unique<TaskInfo>();
+std::shared_ptr<AsyncTaskExecutor::TaskInfo> AsyncTaskExecutor::createTaskInfo(const CancellationToken& parent) {
+    auto taskInfo = std::make_shared<TaskInfo>();
+    taskInfo->cancellation = CancellationSource(
+        parent.canBeCancelled() ? parent : ShutdownManager::getInstance().getToken());
     taskInfo->shouldStop = false;
     taskInfo->startTime = std::chrono::steady_clock::now();
+    return taskInfo;
+}
+
+AsyncTaskExecutor::TaskId AsyncTaskExecutor::launch(std::shared_ptr<TaskInfo> taskInfo, ThreadPool::Priority priority,
+                                                    std::function<void()> body) {
+    TaskId taskId = generateTaskId();
     
-    auto& shouldStopRef = taskInfo->shouldStop;
-    taskInfo->future = m_threadPool.submit(priority, 
-        [task, &shouldStopRef, taskId, this]() {
-            task(shouldStopRef);
+    // Registered before the task is queued so it cannot miss its own cancellation
+    {
+        std::lock_guard<std::mutex> lock(m_tasksMutex);
+        m_activeTasks[taskId] = taskInfo;
+    }
+    
+    // The map keeps taskInfo alive until the body has returned; capturing it
+    // here would cycle through the future's shared state
+    auto future = m_threadPool.submit(priority,
+        [body, taskId, this]() {
+            body();
             
             // Clean up completed task
             std::lock_guard<std::mutex> lock(m_tasksMutex);
@@ -214,7 +753,7 @@ AsyncTaskExecutor::TaskId AsyncTaskExecutor::submitTask(TaskFunc task, ThreadPoo
     
     {
         std::lock_guard<std::mutex> lock(m_tasksMutex);
-        m_activeTasks[taskId] = std::move(taskInfo);
+        taskInfo->future = future.share();
     }
     
     // Clean up old completed tasks
@@ -223,16 +762,43 @@ AsyncTaskExecutor::TaskId AsyncTaskExecutor::submitTask(TaskFunc task, ThreadPoo
     return taskId;
 }
 
-bool AsyncTaskExecutor::cancelTask(const TaskId& taskId) {
-    std::lock_guard<std::mutex> lock(m_tasksMutex);
+AsyncTaskExecutor::TaskId AsyncTaskExecutor::submitTask(TaskFunc task, ThreadPool::Priority priority) {
+    auto taskInfo = createTaskInfo(CancellationToken());
+    std::atomic<bool>* shouldStop = &taskInfo->shouldStop;
+    taskInfo->stopFlag = taskInfo->cancellation.token().onCancel([shouldStop] {
+        *shouldStop = true;
+    });
     
-    auto it = m_activeTasks.find(taskId);
-    if (it != m_activeTasks.end()) {
-        it->second->shouldStop = true;
-        return true;
+    return launch(taskInfo, priority, [task, shouldStop]() {
+        task(*shouldStop);
+    });
+}
+
+AsyncTaskExecutor::TaskId AsyncTaskExecutor::submitCancellableTask(CancellableTaskFunc task,
+                                                                   ThreadPool::Priority priority,
+                                                                   const CancellationToken& parent) {
+    auto taskInfo = createTaskInfo(parent);
+    CancellationToken token = taskInfo->cancellation.token();
+    
+    return launch(taskInfo, priority, [task, token]() {
+        task(token);
+    });
+}
+
+bool AsyncTaskExecutor::cancelTask(const TaskId& taskId) {
+    std::shared_ptr<TaskInfo> taskInfo;
+    {
+        std::lock_guard<std::mutex> lock(m_tasksMutex);
+        auto it = m_activeTasks.find(taskId);
+        if (it == m_activeTasks.end()) {
+            return false;
+        }
+        taskInfo = it->second;
     }
     
-    return false;
+    // Outside the lock: callbacks may wake waiters that touch this executor
+    taskInfo->cancellation.cancel();
+    return true;
 }
 
 bool AsyncTaskExecutor::isTaskRunning(const TaskId& taskId) const {
@@ -240,8 +806,8 @@ bool AsyncTaskExecutor::isTaskRunning(const TaskId& taskId) const {
     
     auto it = m_activeTasks.find(taskId);
     if (it != m_activeTasks.end()) {
-        auto status = it->second->future.wait_for(std::chrono::seconds(0));
-        return status != std::future_status::ready;
+        const auto& future = it->second->future;
+        return !future.valid() || future.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
     }
     
     return false;
@@ -255,9 +821,14 @@ bool AsyncTaskExecutor::waitForTask(const TaskId& taskId, int timeoutMs) {
         return false; // Task not found
     }
     
-    auto& future = it->second->future;
+    // A copy stays valid if the task finishes and removes itself meanwhile
+    std::shared_future<void> future = it->second->future;
     lock.unlock();
+    if (!future.valid()) {
+        return false;
+    }
     
+    BlockingRegion blocking;
     if (timeoutMs < 0) {
         future.wait();
         return true;
@@ -283,8 +854,8 @@ void AsyncTaskExecutor::cleanupCompletedTasks() {
     
     auto it = m_activeTasks.begin();
     while (it != m_activeTasks.end()) {
-        auto status = it->second->future.wait_for(std::chrono::seconds(0));
-        if (status == std::future_status::ready) {
+        const auto& future = it->second->future;
+        if (future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
             it = m_activeTasks.erase(it);
         } else {
             ++it;
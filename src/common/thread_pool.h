@@ -13,14 +13,77 @@
 #include <atomic>
 #include <chrono>
 #include <map>
+#include <deque>
+#include <tuple>
+#include <type_traits>
+#include <cstdint>
+#include "blocking_region.h"
+#include "cancellation_token.h"
+#include "task_function.h"
+#include "thread_safe_queue.h"
 
 namespace burwell {
 
+namespace detail {
+
+/**
+ * @brief Process-wide free lists of small fixed-size blocks
+ *
+ * Backs the future shared states created by ThreadPool::submit, which are
+ * all freed and allocated again at the task rate; recycled blocks skip malloc.
+ */
+class BlockPool {
+public:
+    static void* allocate(size_t bytes);
+    static void deallocate(void* block, size_t bytes) noexcept;
+};
+
+template<typename T>
+struct PooledAllocator {
+    using value_type = T;
+
+    PooledAllocator() noexcept = default;
+    template<typename U>
+    PooledAllocator(const PooledAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not pooled");
+        return static_cast<T*>(BlockPool::allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        BlockPool::deallocate(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const PooledAllocator<U>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const PooledAllocator<U>&) const noexcept { return false; }
+};
+
+// Runs f and stores its result or exception in promise
+template<typename R, typename F>
+void fulfil(std::promise<R>& promise, F& f) {
+    try {
+        if constexpr (std::is_void<R>::value) {
+            f();
+            promise.set_value();
+        } else {
+            promise.set_value(f());
+        }
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+} // namespace detail
+
 /**
  * @brief Thread pool for executing tasks concurrently
  * 
  * Features:
- * - Task priority support
+ * - Task priority support, with aging so low priorities cannot starve
+ * - Optional start deadlines, earliest first within a priority
+ * - Optional elastic sizing around workers blocked in waits
  * - Graceful shutdown
  * - Thread pool monitoring
  * - Exception handling
@@ -37,6 +100,50 @@ public:
         CRITICAL = 3
     };
     
+    using Clock = std::chrono::steady_clock;
+    
+    static constexpr std::chrono::milliseconds DEFAULT_AGING_HALF_LIFE{200};
+    
+    /**
+     * @brief Time tasks of one priority spent queued before starting
+     */
+    struct QueueWaitStats {
+        size_t count;
+        std::chrono::nanoseconds p50;       // Percentiles are bucket upper bounds, within 25%
+        std::chrono::nanoseconds p90;
+        std::chrono::nanoseconds p99;
+        std::chrono::nanoseconds max;
+    };
+    
+    /**
+     * @brief Bounds and triggers for elastic sizing
+     *
+     * Workers that are blocked (inside a BlockingRegion) do not count toward
+     * the pool's concurrency. When the next queued task has waited longer than
+     * queueLatencyTarget and fewer than the constructor's thread count are
+     * runnable, the pool starts workers to make up the difference, up to
+     * maxThreads. Workers idle for idleTimeout retire, down to minThreads.
+     */
+    struct ElasticSizing {
+        size_t minThreads = 0;                // 0 = the constructor's thread count
+        size_t maxThreads = 0;                // At or below the constructor's count = never grow
+        std::chrono::milliseconds queueLatencyTarget{50};
+        std::chrono::milliseconds idleTimeout{30000};
+    };
+    
+    /**
+     * @brief One change in the number of worker threads
+     */
+    struct ResizeEvent {
+        Clock::time_point time;
+        size_t fromThreads;
+        size_t toThreads;
+        size_t blockedThreads;                // Workers inside blocking regions at the time
+        std::chrono::nanoseconds queueLatency;   // Wait of the next queued task; zero when shrinking
+    };
+    
+    static constexpr size_t MAX_RESIZE_EVENTS = 32;
+    
     /**
      * @brief Thread pool statistics
      */
@@ -49,6 +156,128 @@ public:
         size_t totalTasksFailed;
         std::chrono::nanoseconds totalExecutionTime;
         std::chrono::nanoseconds averageTaskTime;
+        size_t totalHeapAllocatedTasks;       // Callables too large for TaskFunction's inline storage
+        QueueWaitStats queueWait[4];          // Indexed by Priority
+        size_t deadlineTasksStarted;
+        size_t deadlinesMissed;               // Started after their deadline
+        size_t numBlockedThreads;             // Busy workers inside blocking regions
+        size_t peakThreads;
+        size_t totalThreadsAdded;             // By elastic growth
+        size_t totalThreadsRetired;           // After idling
+        std::vector<ResizeEvent> recentResizes;   // Oldest first, at most MAX_RESIZE_EVENTS
+    };
+    
+private:
+    /**
+     * @brief Completion flag and pending continuation of one submitted task
+     */
+    struct Completion {
+        explicit Completion(ThreadPool* owner) : pool(owner), done(false), priority(Priority::NORMAL) {}
+        
+        // Marks the task done and schedules the continuation, if one was attached
+        void complete();
+        
+        ThreadPool* pool;
+        SpinLock lock;
+        bool done;
+        Priority priority;
+        TaskFunction continuation;
+    };
+    
+public:
+    /**
+     * @brief Future of a pool task that can also chain a continuation
+     *
+     * Wraps a std::future<T> rather than deriving from it, so it cannot be
+     * sliced into one that waits outside a blocking region. then() queues its
+     * callable on the pool when this task finishes instead of parking a thread
+     * in get().
+     */
+    template<typename T>
+    class Future {
+    public:
+        Future() = default;
+        
+        bool valid() const noexcept {
+            return m_future.valid();
+        }
+        
+        /**
+         * @brief Run f(std::future<T>) on the pool once this task has finished
+         * @param f Continuation; it receives this future, ready, and may get() it
+         * @param priority Priority the continuation is queued with
+         * @return Future for the continuation's result; this future becomes invalid
+         *
+         * Must be called while the pool is alive. If the pool is stopping the
+         * continuation runs on the thread that completes the task (or on the
+         * caller's thread, if that already happened).
+         */
+        template<typename F>
+        auto then(F&& f, Priority priority = Priority::NORMAL)
+            -> Future<typename std::result_of<typename std::decay<F>::type(std::future<T>)>::type> {
+            
+            using next_type = typename std::result_of<typename std::decay<F>::type(std::future<T>)>::type;
+            
+            if (!m_completion) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+            std::shared_ptr<Completion> completion = std::move(m_completion);
+            auto next = completion->pool->template package<next_type>(
+                [f = std::forward<F>(f), previous = std::move(m_future)]() mutable {
+                    return f(std::move(previous));
+                });
+            
+            bool done;
+            {
+                std::lock_guard<SpinLock> lock(completion->lock);
+                done = completion->done;
+                if (!done) {
+                    completion->priority = priority;
+                    completion->continuation = std::move(next.first);
+                }
+            }
+            if (done) {
+                completion->pool->scheduleContinuation(priority, std::move(next.first));
+            }
+            return std::move(next.second);
+        }
+        
+        // Waits are blocking regions, so a task waiting on another can let an elastic pool grow
+        decltype(auto) get() {
+            BlockingRegion blocking;
+            return m_future.get();
+        }
+        
+        void wait() const {
+            BlockingRegion blocking;
+            m_future.wait();
+        }
+        
+        template<typename Rep, typename Period>
+        std::future_status wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+            BlockingRegion blocking;
+            return m_future.wait_for(timeout);
+        }
+        
+        template<typename ClockType, typename Duration>
+        std::future_status wait_until(const std::chrono::time_point<ClockType, Duration>& deadline) const {
+            BlockingRegion blocking;
+            return m_future.wait_until(deadline);
+        }
+        
+        // Waits on the shared future are not blocking regions; callers open their own
+        std::shared_future<T> share() {
+            return m_future.share();
+        }
+        
+    private:
+        friend class ThreadPool;
+        
+        Future(std::future<T>&& future, std::shared_ptr<Completion> completion)
+            : m_future(std::move(future)), m_completion(std::move(completion)) {}
+        
+        std::future<T> m_future;
+        std::shared_ptr<Completion> m_completion;
     };
     
     /**
@@ -73,28 +302,37 @@ public:
      */
     template<typename F, typename... Args>
     auto submit(Priority priority, F&& f, Args&&... args) 
-        -> std::future<typename std::result_of<F(Args...)>::type> {
+        -> Future<typename std::result_of<F(Args...)>::type> {
         
         using return_type = typename std::result_of<F(Args...)>::type;
         
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-        
-        std::future<return_type> result = task->get_future();
+        auto packaged = package<return_type>(
+            [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(f, args);
+            });
+        enqueue(priority, std::move(packaged.first));
+        return std::move(packaged.second);
+    }
+    
+    /**
+     * @brief Submit a task that should start by deadline
+     *
+     * Among queued tasks of the same priority, those with deadlines start
+     * earliest deadline first. A task that starts late still runs and is
+     * counted in PoolStats::deadlinesMissed.
+     */
+    template<typename F, typename... Args>
+    auto submitWithDeadline(Priority priority, Clock::time_point deadline, F&& f, Args&&... args)
+        -> Future<typename std::result_of<F(Args...)>::type> {
         
-        {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            
-            if (m_stopping) {
-                throw std::runtime_error("Cannot submit task to stopping thread pool");
-            }
-            
-            m_tasks.emplace(priority, [task]() { (*task)(); });
-        }
+        using return_type = typename std::result_of<F(Args...)>::type;
         
-        m_condition.notify_one();
-        return result;
+        auto packaged = package<return_type>(
+            [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(f, args);
+            });
+        enqueue(priority, std::move(packaged.first), deadline);
+        return std::move(packaged.second);
     }
     
     /**
@@ -102,28 +340,43 @@ public:
      */
     template<typename F, typename... Args>
     auto submit(F&& f, Args&&... args) 
-        -> std::future<typename std::result_of<F(Args...)>::type> {
+        -> Future<typename std::result_of<F(Args...)>::type> {
         return submit(Priority::NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
     }
     
+    /**
+     * @brief Queue a callable without creating a future
+     *
+     * The cheapest way to hand work to the pool: a callable that fits in
+     * TaskFunction's inline storage is queued without any allocation.
+     * Exceptions go to the exception handler.
+     */
+    template<typename F>
+    void post(Priority priority, F&& f) {
+        enqueue(priority, TaskFunction(std::forward<F>(f)));
+    }
+    
+    template<typename F>
+    void post(F&& f) {
+        post(Priority::NORMAL, std::forward<F>(f));
+    }
+    
+    /**
+     * @brief post() with a start deadline, ordered as in submitWithDeadline
+     */
+    template<typename F>
+    void postWithDeadline(Priority priority, Clock::time_point deadline, F&& f) {
+        enqueue(priority, TaskFunction(std::forward<F>(f)), deadline);
+    }
+    
     /**
      * @brief Submit a task without waiting for result
      */
     template<typename F, typename... Args>
     void submitDetached(Priority priority, F&& f, Args&&... args) {
-        auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-        
-        {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            
-            if (m_stopping) {
-                throw std::runtime_error("Cannot submit task to stopping thread pool");
-            }
-            
-            m_tasks.emplace(priority, std::move(task));
-        }
-        
-        m_condition.notify_one();
+        post(priority, [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            std::apply(f, args);
+        });
     }
     
     /**
@@ -140,7 +393,7 @@ public:
     /**
      * @brief Get number of worker threads
      */
-    size_t getNumThreads() const { return m_threads.size(); }
+    size_t getNumThreads() const;
     
     /**
      * @brief Get number of pending tasks
@@ -152,6 +405,27 @@ public:
      */
     PoolStats getStats() const;
     
+    /**
+     * @brief Set how fast waiting tasks gain priority
+     * @param halfLife Time over which the gap between a waiting task's priority
+     *                 and the level above CRITICAL halves; zero orders by
+     *                 priority alone
+     *
+     * A task is passed over only by higher priorities that arrived less than
+     * halfLife * log2(gap ratio) after it: with the default 200ms, a LOW task
+     * yields to CRITICAL work for at most 400ms and to HIGH work for 200ms.
+     */
+    void setAgingHalfLife(std::chrono::milliseconds halfLife);
+    
+    /**
+     * @brief Let the pool grow past blocked workers and shrink when idle
+     *
+     * Off by default: the pool keeps the thread count it was built with.
+     * Only waits inside a BlockingRegion are seen as blocking; the wait
+     * helpers in this library open one.
+     */
+    void setElasticSizing(const ElasticSizing& sizing);
+    
     /**
      * @brief Set exception handler for uncaught exceptions in tasks
      */
@@ -160,19 +434,119 @@ public:
     
 private:
     /**
-     * @brief Task with priority
+     * @brief FIFO of the tasks of one priority
+     *
+     * A ring buffer that only ever grows, so a pool in steady state queues
+     * and dequeues without allocating.
      */
-    struct Task {
-        Priority priority;
-        std::function<void()> func;
+    struct QueuedTask {
+        TaskFunction func;
+        Clock::time_point enqueued;
+        Clock::time_point deadline;           // NO_DEADLINE when none was given
+    };
+    
+    class TaskRing {
+    public:
+        bool empty() const { return m_count == 0; }
+        size_t size() const { return m_count; }
+        const QueuedTask& front() const { return m_slots[m_head]; }
+        void push(QueuedTask&& task);
+        QueuedTask pop();
+        void clear();
         
-        Task(Priority p, std::function<void()> f) 
-            : priority(p), func(std::move(f)) {}
+    private:
+        std::vector<QueuedTask> m_slots;      // Size is zero or a power of two
+        size_t m_head = 0;
+        size_t m_count = 0;
+    };
+    
+    /**
+     * @brief Queued tasks of one priority
+     *
+     * Tasks without a deadline wait in FIFO order; those with one in a heap
+     * ordered by deadline. When aging is on, a FIFO task counts as due one
+     * half-life after it was queued, so deadline tasks cannot starve it.
+     */
+    struct PriorityBand {
+        TaskRing fifo;
+        std::vector<QueuedTask> deadlines;    // Min-heap on deadline
         
-        // Operator for priority queue (higher priority first)
-        bool operator<(const Task& other) const {
-            return priority < other.priority;
-        }
+        bool empty() const { return fifo.empty() && deadlines.empty(); }
+        // The task this band would run next; band must not be empty
+        bool nextIsDeadlineTask(Clock::duration halfLife) const;
+        const QueuedTask& next(Clock::duration halfLife) const;
+        QueuedTask pop(Clock::duration halfLife);
+        void clear();
+    };
+    
+    /**
+     * @brief Log-scale histogram of queue waits, four buckets per power of two
+     */
+    class WaitHistogram {
+    public:
+        void record(Clock::duration wait);
+        QueueWaitStats summarize() const;
+        
+    private:
+        static constexpr size_t NUM_BUCKETS = 180;
+        uint64_t m_buckets[NUM_BUCKETS] = {};
+        size_t m_count = 0;
+        Clock::duration m_max = Clock::duration::zero();
+    };
+    
+    static constexpr size_t NUM_PRIORITIES = static_cast<size_t>(Priority::CRITICAL) + 1;
+    static constexpr Clock::time_point NO_DEADLINE = Clock::time_point::max();
+    
+    /**
+     * @brief Wraps f so its result lands in a pooled future shared state
+     * @return The task to queue and the future it fulfils
+     */
+    template<typename R, typename F>
+    std::pair<TaskFunction, Future<R>> package(F&& f) {
+        std::promise<R> promise(std::allocator_arg, detail::PooledAllocator<char>());
+        auto completion = std::allocate_shared<Completion>(detail::PooledAllocator<Completion>(), this);
+        Future<R> future(promise.get_future(), completion);
+        
+        TaskFunction task([f = std::forward<F>(f), promise = std::move(promise),
+                           completion = std::move(completion)]() mutable {
+            detail::fulfil(promise, f);
+            completion->complete();
+        });
+        return {std::move(task), std::move(future)};
+    }
+    
+    /**
+     * @brief Queue a task; throws if the pool is stopping
+     */
+    void enqueue(Priority priority, TaskFunction func, Clock::time_point deadline = NO_DEADLINE);
+    
+    /**
+     * @brief Queue a task; leaves func untouched and returns false if the pool is stopping
+     */
+    bool tryEnqueue(Priority priority, TaskFunction& func, Clock::time_point deadline = NO_DEADLINE);
+    
+    /**
+     * @brief Take the task to run next; m_queueMutex must be held and a task queued
+     * @param level Set to the priority band the task came from
+     */
+    QueuedTask dequeue(size_t& level);
+    
+    /**
+     * @brief Queue a continuation, or run it here if the pool is stopping
+     */
+    void scheduleContinuation(Priority priority, TaskFunction func);
+    
+    /**
+     * @brief Counts this pool's workers in and out of blocking regions
+     */
+    class BlockingObserver : public BlockingRegion::Observer {
+    public:
+        explicit BlockingObserver(ThreadPool* pool) : m_pool(pool) {}
+        void blockingBegin() override;
+        void blockingEnd() override;
+        
+    private:
+        ThreadPool* m_pool;
     };
     
     /**
@@ -180,9 +554,47 @@ private:
      */
     void workerThread(size_t threadId);
     
+    /**
+     * @brief Starts workers when blocked ones leave queued tasks waiting; reaps retired ones
+     */
+    void supervisorThread();
+    
+    /**
+     * @brief Workers to add now; m_queueMutex must be held
+     */
+    size_t workersNeeded(Clock::time_point now, Clock::duration& queueLatency) const;
+    
+    /**
+     * @brief Append to the resize history; m_queueMutex must be held
+     */
+    void recordResize(size_t fromThreads, size_t toThreads, Clock::duration queueLatency);
+    
     // Thread management
-    std::vector<std::thread> m_threads;
-    std::priority_queue<Task> m_tasks;
+    std::vector<std::thread> m_threads;          // Indexed by thread id; only the supervisor changes it once running
+    PriorityBand m_tasks[NUM_PRIORITIES];        // Indexed by Priority
+    size_t m_numPendingTasks;
+    size_t m_numIdleWorkers;                      // Blocked on m_condition
+    Clock::duration m_agingHalfLife;
+    Clock::duration m_agingOffsets[NUM_PRIORITIES];   // halfLife * log2(levels above the task's priority)
+    
+    // Elastic sizing, guarded by m_queueMutex
+    size_t m_numWorkers;                          // Started and not retired
+    size_t m_coreThreads;                         // Runnable workers the pool aims to keep
+    size_t m_minThreads;
+    size_t m_maxThreads;
+    Clock::duration m_queueLatencyTarget;
+    Clock::duration m_idleTimeout;                // Zero while sizing is fixed
+    std::vector<size_t> m_retiredThreads;         // Exited workers waiting to be joined
+    std::vector<size_t> m_freeThreadIds;          // Joined slots of m_threads to reuse
+    std::atomic<bool> m_supervisorIdle;           // Waiting without a timeout; read by blocking workers
+    size_t m_peakThreads;
+    size_t m_threadsAdded;
+    size_t m_threadsRetired;
+    std::deque<ResizeEvent> m_resizes;
+    std::thread m_supervisor;
+    std::condition_variable m_supervisorCondition;
+    std::atomic<size_t> m_numBlockedWorkers;
+    BlockingObserver m_blockingObserver;
     
     // Synchronization
     mutable std::mutex m_queueMutex;
@@ -197,7 +609,11 @@ private:
     mutable std::mutex m_statsMutex;
     std::atomic<size_t> m_totalTasksExecuted;
     std::atomic<size_t> m_totalTasksFailed;
+    std::atomic<size_t> m_heapAllocatedTasks;
     std::chrono::nanoseconds m_totalExecutionTime;
+    WaitHistogram m_queueWait[NUM_PRIORITIES];   // Guarded by m_statsMutex, as are the two below
+    size_t m_deadlineTasksStarted;
+    size_t m_deadlinesMissed;
     
     // Exception handling
     ExceptionHandler m_exceptionHandler;
@@ -260,20 +676,33 @@ private:
 
 /**
  * @brief Async task executor with cancellation support
+ *
+ * Each task runs in its own cancellation scope, a child of the shutdown scope
+ * (or of the given parent), so cancelTask, shutdown and executor destruction
+ * all wake the task's cancellable waits.
  */
 class AsyncTaskExecutor {
 public:
     using TaskId = std::string;
     using TaskFunc = std::function<void(std::atomic<bool>& shouldStop)>;
+    using CancellableTaskFunc = std::function<void(const CancellationToken& token)>;
     
     AsyncTaskExecutor(size_t numThreads = 0);
     ~AsyncTaskExecutor();
     
     /**
-     * @brief Submit a cancellable task
+     * @brief Submit a cancellable task that polls a stop flag
      */
     TaskId submitTask(TaskFunc task, ThreadPool::Priority priority = ThreadPool::Priority::NORMAL);
     
+    /**
+     * @brief Submit a task that receives its cancellation token
+     * @param parent Scope the task belongs to; defaults to the shutdown scope
+     */
+    TaskId submitCancellableTask(CancellableTaskFunc task,
+                                 ThreadPool::Priority priority = ThreadPool::Priority::NORMAL,
+                                 const CancellationToken& parent = CancellationToken());
+    
     /**
      * @brief Cancel a task
      */
@@ -291,17 +720,22 @@ public:
     
 private:
     struct TaskInfo {
+        CancellationSource cancellation;
         std::atomic<bool> shouldStop;
-        std::future<void> future;
+        CancellationRegistration stopFlag;     // Mirrors cancellation into shouldStop
+        std::shared_future<void> future;       // Set once queued
         std::chrono::steady_clock::time_point startTime;
     };
     
     ThreadPool m_threadPool;
     mutable std::mutex m_tasksMutex;
-    std::map<TaskId, std::unique_ptr<TaskInfo>> m_activeTasks;
+    std::map<TaskId, std::shared_ptr<TaskInfo>> m_activeTasks;
     std::atomic<size_t> m_taskCounter;
     
     TaskId generateTaskId();
+    std::shared_ptr<TaskInfo> createTaskInfo(const CancellationToken& parent);
+    TaskId launch(std::shared_ptr<TaskInfo> taskInfo, ThreadPool::Priority priority,
+                  std::function<void()> body);
     void cleanupCompletedTasks();
 };
 
@@ -7,17 +7,30 @@
 #include <optional>
 #include <chrono>
 #include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <iterator>
+#include "blocking_region.h"
+#include "futex.h"
 
 namespace burwell {
 
 /**
  * @brief Thread-safe queue implementation
+ *
+ * Producers only signal the condition variable when a consumer is actually
+ * blocked on it, so a busy queue that consumers drain without waiting costs
+ * no wake-up calls. The bulk operations take the lock once per batch.
+ *
  * @tparam T Element type
  */
 template<typename T>
 class ThreadSafeQueue {
 public:
-    ThreadSafeQueue() : m_closed(false) {}
+    ThreadSafeQueue() : m_closed(false), m_waiters(0) {}
     
     /**
      * @brief Push an item to the queue
@@ -25,14 +38,37 @@ public:
      * @return true if successful, false if queue is closed
      */
     bool push(T item) {
+        size_t wake = 0;
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             if (m_closed) {
                 return false;
             }
             m_queue.push(std::move(item));
+            wake = std::min<size_t>(m_waiters, 1);
         }
-        m_condition.notify_one();
+        notifyConsumers(wake);
+        return true;
+    }
+    
+    /**
+     * @brief Push several items under one lock
+     * @param items Items to push, in order
+     * @return true if successful, false if queue is closed
+     */
+    bool pushBulk(std::vector<T> items) {
+        size_t wake = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed) {
+                return false;
+            }
+            for (auto& item : items) {
+                m_queue.push(std::move(item));
+            }
+            wake = std::min(m_waiters, items.size());
+        }
+        notifyConsumers(wake);
         return true;
     }
     
@@ -42,7 +78,7 @@ public:
      */
     std::optional<T> pop() {
         std::unique_lock<std::mutex> lock(m_mutex);
-        m_condition.wait(lock, [this] { return !m_queue.empty() || m_closed; });
+        waitForItems(lock);
         
         if (m_queue.empty()) {
             return std::nullopt;
@@ -53,6 +89,17 @@ public:
         return item;
     }
     
+    /**
+     * @brief Pop up to maxItems items (blocking until at least one is available)
+     * @param maxItems Largest batch to return
+     * @return Items in queue order, or empty if queue is closed
+     */
+    std::vector<T> popBulk(size_t maxItems) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        waitForItems(lock);
+        return takeFront(maxItems);
+    }
+    
     /**
      * @brief Try to pop an item from the queue (non-blocking)
      * @return Optional containing the item, or empty if queue is empty
@@ -68,6 +115,15 @@ public:
         return item;
     }
     
+    /**
+     * @brief Try to pop up to maxItems items (non-blocking)
+     * @return Items in queue order, empty if the queue is empty
+     */
+    std::vector<T> tryPopBulk(size_t maxItems) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return takeFront(maxItems);
+    }
+    
     /**
      * @brief Pop an item with timeout
      * @param timeoutMs Timeout in milliseconds
@@ -76,12 +132,12 @@ public:
     std::optional<T> popWithTimeout(int timeoutMs) {
         std::unique_lock<std::mutex> lock(m_mutex);
         
-        if (!m_condition.wait_for(lock, std::chrono::milliseconds(timeoutMs),
-                                 [this] { return !m_queue.empty() || m_closed; })) {
-            return std::nullopt;
-        }
-        
-        if (m_queue.empty()) {
+        BlockingRegion blocking;
+        ++m_waiters;
+        bool ready = m_condition.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                          [this] { return !m_queue.empty() || m_closed; });
+        --m_waiters;
+        if (!ready || m_queue.empty()) {
             return std::nullopt;
         }
         
@@ -136,34 +192,98 @@ public:
     }
     
 private:
+    void waitForItems(std::unique_lock<std::mutex>& lock) {
+        if (!m_queue.empty() || m_closed) {
+            return;
+        }
+        BlockingRegion blocking;
+        ++m_waiters;
+        m_condition.wait(lock, [this] { return !m_queue.empty() || m_closed; });
+        --m_waiters;
+    }
+    
+    std::vector<T> takeFront(size_t maxItems) {
+        std::vector<T> items;
+        items.reserve(std::min(maxItems, m_queue.size()));
+        while (items.size() < maxItems && !m_queue.empty()) {
+            items.push_back(std::move(m_queue.front()));
+            m_queue.pop();
+        }
+        return items;
+    }
+    
+    // Called after the lock is released so woken consumers do not block on it
+    void notifyConsumers(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            m_condition.notify_one();
+        }
+    }
+    
     mutable std::mutex m_mutex;
     std::condition_variable m_condition;
     std::queue<T> m_queue;
     bool m_closed;
+    size_t m_waiters;                    // Consumers blocked on m_condition
 };
 
 /**
  * @brief Priority queue with thread safety
+ *
+ * Keeps its own binary heap rather than a std::priority_queue, whose const
+ * top() forces pop to copy the element; here the element is moved out. Wakes
+ * and batching work as in ThreadSafeQueue.
+ *
  * @tparam T Element type
  * @tparam Compare Comparison function
  */
 template<typename T, typename Compare = std::less<T>>
 class ThreadSafePriorityQueue {
 public:
-    ThreadSafePriorityQueue() : m_closed(false) {}
+    explicit ThreadSafePriorityQueue(const Compare& compare = Compare())
+        : m_compare(compare), m_closed(false), m_waiters(0) {}
     
     /**
      * @brief Push an item to the priority queue
      */
     bool push(T item) {
+        size_t wake = 0;
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             if (m_closed) {
                 return false;
             }
-            m_queue.push(std::move(item));
+            m_heap.push_back(std::move(item));
+            std::push_heap(m_heap.begin(), m_heap.end(), m_compare);
+            wake = std::min<size_t>(m_waiters, 1);
         }
-        m_condition.notify_one();
+        notifyConsumers(wake);
+        return true;
+    }
+    
+    /**
+     * @brief Push several items under one lock
+     * @return true if successful, false if queue is closed
+     */
+    bool pushBulk(std::vector<T> items) {
+        size_t wake = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed) {
+                return false;
+            }
+            size_t existing = m_heap.size();
+            m_heap.insert(m_heap.end(), std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+            if (items.size() * 4 > existing) {
+                // Rebuilding is linear; sifting each item up is n log n
+                std::make_heap(m_heap.begin(), m_heap.end(), m_compare);
+            } else {
+                for (size_t i = existing + 1; i <= m_heap.size(); ++i) {
+                    std::push_heap(m_heap.begin(), m_heap.begin() + static_cast<std::ptrdiff_t>(i), m_compare);
+                }
+            }
+            wake = std::min(m_waiters, items.size());
+        }
+        notifyConsumers(wake);
         return true;
     }
     
@@ -172,15 +292,23 @@ public:
      */
     std::optional<T> pop() {
         std::unique_lock<std::mutex> lock(m_mutex);
-        m_condition.wait(lock, [this] { return !m_queue.empty() || m_closed; });
+        waitForItems(lock);
         
-        if (m_queue.empty()) {
+        if (m_heap.empty()) {
             return std::nullopt;
         }
         
-        T item = m_queue.top();
-        m_queue.pop();
-        return item;
+        return takeTop();
+    }
+    
+    /**
+     * @brief Pop up to maxItems items, highest priority first (blocking until at least one is available)
+     * @return Items in priority order, or empty if queue is closed
+     */
+    std::vector<T> popBulk(size_t maxItems) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        waitForItems(lock);
+        return takeTop(maxItems);
     }
     
     /**
@@ -188,13 +316,19 @@ public:
      */
     std::optional<T> tryPop() {
         std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_queue.empty()) {
+        if (m_heap.empty()) {
             return std::nullopt;
         }
         
-        T item = m_queue.top();
-        m_queue.pop();
-        return item;
+        return takeTop();
+    }
+    
+    /**
+     * @brief Try to pop up to maxItems items, highest priority first (non-blocking)
+     */
+    std::vector<T> tryPopBulk(size_t maxItems) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return takeTop(maxItems);
     }
     
     /**
@@ -202,7 +336,7 @@ public:
      */
     size_t size() const {
         std::lock_guard<std::mutex> lock(m_mutex);
-        return m_queue.size();
+        return m_heap.size();
     }
     
     /**
@@ -210,7 +344,7 @@ public:
      */
     bool empty() const {
         std::lock_guard<std::mutex> lock(m_mutex);
-        return m_queue.empty();
+        return m_heap.empty();
     }
     
     /**
@@ -237,90 +371,280 @@ public:
      */
     void clear() {
         std::lock_guard<std::mutex> lock(m_mutex);
-        while (!m_queue.empty()) {
-            m_queue.pop();
-        }
+        m_heap.clear();
     }
     
 private:
+    void waitForItems(std::unique_lock<std::mutex>& lock) {
+        if (!m_heap.empty() || m_closed) {
+            return;
+        }
+        BlockingRegion blocking;
+        ++m_waiters;
+        m_condition.wait(lock, [this] { return !m_heap.empty() || m_closed; });
+        --m_waiters;
+    }
+    
+    T takeTop() {
+        std::pop_heap(m_heap.begin(), m_heap.end(), m_compare);
+        T item = std::move(m_heap.back());
+        m_heap.pop_back();
+        return item;
+    }
+    
+    std::vector<T> takeTop(size_t maxItems) {
+        std::vector<T> items;
+        items.reserve(std::min(maxItems, m_heap.size()));
+        while (items.size() < maxItems && !m_heap.empty()) {
+            items.push_back(takeTop());
+        }
+        return items;
+    }
+    
+    void notifyConsumers(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            m_condition.notify_one();
+        }
+    }
+    
     mutable std::mutex m_mutex;
     std::condition_variable m_condition;
-    std::priority_queue<T, std::vector<T>, Compare> m_queue;
+    std::vector<T> m_heap;               // Max-heap ordered by m_compare
+    Compare m_compare;
     bool m_closed;
+    size_t m_waiters;
 };
 
+namespace detail {
+
+// Spinning only helps when the lock holder can run at the same time
+inline bool spinningHelps() {
+    static const bool helps = std::thread::hardware_concurrency() > 1;
+    return helps;
+}
+
+// Stable per-thread index used to spread readers over ReaderWriterLock slots
+inline size_t readerSlotHint() {
+    static std::atomic<size_t> nextHint{0};
+    thread_local const size_t hint = nextHint.fetch_add(1, std::memory_order_relaxed);
+    return hint;
+}
+
+} // namespace detail
+
 /**
- * @brief Simple spinlock for low-contention scenarios
+ * @brief Spin-then-park mutex
+ *
+ * Uncontended lock and unlock are one atomic operation each. Under contention
+ * the thread spins with a pause instruction and exponential backoff for an
+ * adaptive number of iterations, then sleeps on a Futex until the holder
+ * releases it, so a long critical section costs waiters no CPU.
  */
 class SpinLock {
 public:
-    SpinLock() : m_flag(ATOMIC_FLAG_INIT) {}
-    
+    SpinLock() : m_state(UNLOCKED), m_spinEstimate(MIN_SPINS) {}
+
+    SpinLock(const SpinLock&) = delete;
+    SpinLock& operator=(const SpinLock&) = delete;
+
     void lock() {
-        while (m_flag.test_and_set(std::memory_order_acquire)) {
-            // Spin
+        uint32_t expected = UNLOCKED;
+        if (!m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            lockContended();
         }
     }
-    
+
     void unlock() {
-        m_flag.clear(std::memory_order_release);
+        if (m_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+            Futex::wakeOne(m_state);
+        }
     }
-    
+
     bool try_lock() {
-        return !m_flag.test_and_set(std::memory_order_acquire);
+        uint32_t expected = UNLOCKED;
+        return m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
     }
-    
+
 private:
-    std::atomic_flag m_flag;
+    static constexpr uint32_t UNLOCKED = 0;
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t CONTENDED = 2;     // Locked and a thread may be parked
+    static constexpr uint32_t MIN_SPINS = 16;
+    static constexpr uint32_t MAX_SPINS = 4096;
+    static constexpr uint32_t MAX_BACKOFF = 64;
+
+    void lockContended() {
+        // Spin up to twice what recent acquisitions needed, as glibc's adaptive mutex does
+        const uint32_t estimate = m_spinEstimate.load(std::memory_order_relaxed);
+        const uint32_t budget = detail::spinningHelps() ? std::min(MAX_SPINS, estimate * 2) : 0;
+        uint32_t spins = 0;
+        for (uint32_t backoff = 1; spins < budget; backoff = std::min(backoff * 2, MAX_BACKOFF)) {
+            for (uint32_t i = 0; i < backoff; ++i) {
+                Futex::relax();
+            }
+            spins += backoff;
+            uint32_t expected = UNLOCKED;
+            if (m_state.load(std::memory_order_relaxed) == UNLOCKED &&
+                m_state.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+                adaptSpins(estimate, spins);
+                return;
+            }
+        }
+
+        // Whoever takes the lock from here on leaves it CONTENDED so unlock wakes the next sleeper
+        while (m_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+            Futex::wait(m_state, CONTENDED);
+        }
+        if (budget > 0) {
+            adaptSpins(estimate, budget);
+        }
+    }
+
+    void adaptSpins(uint32_t estimate, uint32_t spins) {
+        int32_t delta = (static_cast<int32_t>(spins) - static_cast<int32_t>(estimate)) / 8;
+        uint32_t next = static_cast<uint32_t>(static_cast<int32_t>(estimate) + delta);
+        m_spinEstimate.store(std::max(MIN_SPINS, std::min(MAX_SPINS / 2, next)), std::memory_order_relaxed);
+    }
+
+    std::atomic<uint32_t> m_state;
+    std::atomic<uint32_t> m_spinEstimate;
 };
 
 /**
- * @brief Reader-writer lock wrapper
+ * @brief Writer-preferring reader-writer lock that scales with readers
+ *
+ * Readers register in one of several cache-line sized counters chosen per
+ * thread, so concurrent readers on different cores do not contend on a shared
+ * word. A writer announces itself, which turns new readers away, and then waits
+ * for every counter to drain. Both sides spin briefly before parking on a Futex.
+ * A read lock must be released on the thread that took it.
  */
 class ReaderWriterLock {
 public:
-    ReaderWriterLock() : m_readers(0), m_writers(0), m_writeRequests(0) {}
-    
+    ReaderWriterLock()
+        : m_slotCount(slotCountFor(std::thread::hardware_concurrency()))
+        , m_slots(new ReaderSlot[m_slotCount])
+        , m_writer(NO_WRITER)
+        , m_drainSequence(0) {}
+
+    ReaderWriterLock(const ReaderWriterLock&) = delete;
+    ReaderWriterLock& operator=(const ReaderWriterLock&) = delete;
+
     void lockRead() {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_readCondition.wait(lock, [this] { 
-            return m_writers == 0 && m_writeRequests == 0; 
-        });
-        m_readers++;
+        std::atomic<uint32_t>& readers = readerSlot();
+        for (;;) {
+            // seq_cst pairs with the writer's store to m_writer followed by its slot scan
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (m_writer.load(std::memory_order_seq_cst) == NO_WRITER) {
+                return;
+            }
+            // A writer is waiting or active: step aside so it can drain, then wait it out
+            releaseReader(readers);
+            waitForWriter();
+        }
     }
-    
+
     void unlockRead() {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_readers--;
-        if (m_readers == 0) {
-            m_writeCondition.notify_one();
-        }
+        releaseReader(readerSlot());
     }
-    
+
     void lockWrite() {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_writeRequests++;
-        m_writeCondition.wait(lock, [this] { 
-            return m_readers == 0 && m_writers == 0; 
-        });
-        m_writeRequests--;
-        m_writers++;
+        m_writerLock.lock();
+        m_writer.store(WRITER, std::memory_order_seq_cst);
+        for (size_t i = 0; i < m_slotCount; ++i) {
+            waitForDrain(m_slots[i].readers);
+        }
     }
-    
+
     void unlockWrite() {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_writers--;
-        m_writeCondition.notify_one();
-        m_readCondition.notify_all();
+        uint32_t previous = m_writer.exchange(NO_WRITER, std::memory_order_release);
+        m_writerLock.unlock();
+        if (previous == WRITER_WITH_WAITERS) {
+            Futex::wakeAll(m_writer);
+        }
     }
-    
+
+    // Standard SharedMutex names, for std::shared_lock and std::unique_lock
+    void lock_shared() { lockRead(); }
+    void unlock_shared() { unlockRead(); }
+    void lock() { lockWrite(); }
+    void unlock() { unlockWrite(); }
+
 private:
-    mutable std::mutex m_mutex;
-    std::condition_variable m_readCondition;
-    std::condition_variable m_writeCondition;
-    int m_readers;
-    int m_writers;
-    int m_writeRequests;
+    static constexpr uint32_t NO_WRITER = 0;
+    static constexpr uint32_t WRITER = 1;
+    static constexpr uint32_t WRITER_WITH_WAITERS = 2;    // Readers are parked on m_writer
+    static constexpr size_t MAX_SLOTS = 64;
+    static constexpr uint32_t SPIN_LIMIT = 1024;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint32_t> readers{0};
+    };
+
+    static size_t slotCountFor(unsigned int cpus) {
+        size_t count = 1;
+        while (count < cpus && count < MAX_SLOTS) {
+            count *= 2;
+        }
+        return count;
+    }
+
+    std::atomic<uint32_t>& readerSlot() {
+        return m_slots[detail::readerSlotHint() & (m_slotCount - 1)].readers;
+    }
+
+    void releaseReader(std::atomic<uint32_t>& readers) {
+        // Only the last reader out of a slot, and only while a writer waits, pays for a wake
+        if (readers.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+            m_writer.load(std::memory_order_seq_cst) != NO_WRITER) {
+            m_drainSequence.fetch_add(1, std::memory_order_seq_cst);
+            Futex::wakeAll(m_drainSequence);
+        }
+    }
+
+    void waitForWriter() {
+        uint32_t spins = detail::spinningHelps() ? 0 : SPIN_LIMIT;
+        for (uint32_t backoff = 1; m_writer.load(std::memory_order_acquire) != NO_WRITER;
+             backoff = std::min<uint32_t>(backoff * 2, 64)) {
+            if (spins < SPIN_LIMIT) {
+                for (uint32_t i = 0; i < backoff; ++i) {
+                    Futex::relax();
+                }
+                spins += backoff;
+                continue;
+            }
+            uint32_t expected = WRITER;
+            if (m_writer.compare_exchange_strong(expected, WRITER_WITH_WAITERS, std::memory_order_relaxed) ||
+                expected == WRITER_WITH_WAITERS) {
+                Futex::wait(m_writer, WRITER_WITH_WAITERS);
+            }
+        }
+    }
+
+    void waitForDrain(std::atomic<uint32_t>& readers) {
+        uint32_t spins = detail::spinningHelps() ? 0 : SPIN_LIMIT;
+        for (uint32_t backoff = 1;; backoff = std::min<uint32_t>(backoff * 2, 64)) {
+            // Read the sequence first so a drain after the check changes it and the wait returns
+            uint32_t sequence = m_drainSequence.load(std::memory_order_seq_cst);
+            if (readers.load(std::memory_order_seq_cst) == 0) {
+                return;
+            }
+            if (spins < SPIN_LIMIT) {
+                for (uint32_t i = 0; i < backoff; ++i) {
+                    Futex::relax();
+                }
+                spins += backoff;
+                continue;
+            }
+            Futex::wait(m_drainSequence, sequence);
+        }
+    }
+
+    const size_t m_slotCount;
+    std::unique_ptr<ReaderSlot[]> m_slots;
+    std::atomic<uint32_t> m_writer;
+    std::atomic<uint32_t> m_drainSequence;
+    SpinLock m_writerLock;                                // Serializes writers
 };
 
 /**
@@ -60,6 +60,7 @@ public:
     bool save();
     bool load();
     void setLibraryPath(const std::string& path);
+    const std::string& getLibraryPath() const { return m_libraryPath; }
     
     // Sequence management
     bool saveSequence(const std::string& name, const std::vector<CPLCommand>& commands,
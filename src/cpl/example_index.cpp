@@ -0,0 +1,302 @@
+#include "example_index.h"
+#include "../common/file_utils.h"
+#include "../common/structured_logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+#include <unordered_set>
+
+namespace burwell {
+namespace cpl {
+
+namespace {
+
+constexpr int INDEX_FORMAT_VERSION = 1;
+
+// Words that carry no intent and only dilute BM25 scores
+const std::unordered_set<std::string>& getStopWords() {
+    static const std::unordered_set<std::string> stopWords = {
+        "a", "an", "and", "are", "as", "at", "be", "by", "for", "from", "in", "into",
+        "is", "it", "me", "my", "of", "on", "or", "please", "that", "the", "then",
+        "this", "to", "with", "you", "your"
+    };
+    return stopWords;
+}
+
+} // anonymous namespace
+
+ExampleIndex::ExampleIndex(double k1, double b)
+    : m_k1(k1)
+    , m_b(b)
+    , m_totalLength(0) {
+}
+
+size_t ExampleIndex::addExample(const std::string& userRequest,
+                                const std::vector<std::string>& commandTypes,
+                                const std::string& exampleText) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    return addExampleLocked(userRequest, commandTypes, exampleText);
+}
+
+size_t ExampleIndex::addExampleLocked(const std::string& userRequest,
+                                      const std::vector<std::string>& commandTypes,
+                                      const std::string& exampleText) {
+    uint32_t docId = static_cast<uint32_t>(m_documents.size());
+
+    std::vector<std::string> terms = tokenize(userRequest);
+    for (const auto& commandType : commandTypes) {
+        std::vector<std::string> typeTerms = tokenize(commandType);
+        terms.insert(terms.end(), typeTerms.begin(), typeTerms.end());
+    }
+
+    // Count term frequencies for this document, then append one posting per term.
+    // Document ids only grow, so every postings list stays sorted without re-sorting.
+    std::unordered_map<uint32_t, uint32_t> termCounts;
+    for (const auto& term : terms) {
+        ++termCounts[getOrCreateTermId(term)];
+    }
+    for (const auto& entry : termCounts) {
+        m_postings[entry.first].push_back({docId, entry.second});
+    }
+
+    Document document;
+    document.userRequest = userRequest;
+    document.commandTypes = commandTypes;
+    document.exampleText = exampleText;
+    document.length = static_cast<uint32_t>(terms.size());
+    document.estimatedTokens = static_cast<uint32_t>(estimateTokenCount(exampleText));
+    m_documents.push_back(std::move(document));
+    m_totalLength += terms.size();
+
+    return docId;
+}
+
+void ExampleIndex::clear() {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_documents.clear();
+    m_termIds.clear();
+    m_postings.clear();
+    m_totalLength = 0;
+}
+
+size_t ExampleIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_documents.size();
+}
+
+std::vector<ExampleMatch> ExampleIndex::query(const std::string& text,
+                                              size_t maxResults,
+                                              size_t tokenBudget) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return queryLocked(text, maxResults, tokenBudget);
+}
+
+std::vector<std::string> ExampleIndex::queryTexts(const std::string& text,
+                                                  size_t maxResults,
+                                                  size_t tokenBudget) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    std::vector<std::string> texts;
+    for (const auto& match : queryLocked(text, maxResults, tokenBudget)) {
+        texts.push_back(m_documents[match.exampleId].exampleText);
+    }
+    return texts;
+}
+
+std::string ExampleIndex::getExampleText(size_t exampleId) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    if (exampleId >= m_documents.size()) {
+        return "";
+    }
+    return m_documents[exampleId].exampleText;
+}
+
+std::vector<ExampleMatch> ExampleIndex::queryLocked(const std::string& text,
+                                                    size_t maxResults,
+                                                    size_t tokenBudget) const {
+    std::vector<ExampleMatch> results;
+    if (maxResults == 0 || m_documents.empty()) {
+        return results;
+    }
+
+    // Repeated query words would otherwise be counted once per occurrence
+    std::vector<std::string> queryTerms = tokenize(text);
+    std::sort(queryTerms.begin(), queryTerms.end());
+    queryTerms.erase(std::unique(queryTerms.begin(), queryTerms.end()), queryTerms.end());
+
+    const double averageLength = static_cast<double>(m_totalLength) / m_documents.size();
+    std::vector<float> scores(m_documents.size(), 0.0f);
+    std::vector<uint32_t> candidates;
+
+    for (const auto& term : queryTerms) {
+        auto termIt = m_termIds.find(term);
+        if (termIt == m_termIds.end()) {
+            continue;
+        }
+
+        const auto& postings = m_postings[termIt->second];
+        const double termIdf = idf(postings.size());
+        for (const auto& posting : postings) {
+            const double tf = posting.termFrequency;
+            const double lengthNorm = 1.0 - m_b + m_b * (m_documents[posting.docId].length / averageLength);
+            const double termScore = termIdf * (tf * (m_k1 + 1.0)) / (tf + m_k1 * lengthNorm);
+
+            if (scores[posting.docId] == 0.0f) {
+                candidates.push_back(posting.docId);
+            }
+            scores[posting.docId] += static_cast<float>(termScore);
+        }
+    }
+
+    if (candidates.empty()) {
+        return results;
+    }
+
+    // Newer examples win ties, they reflect the current command set best
+    auto byScore = [&scores](uint32_t lhs, uint32_t rhs) {
+        if (scores[lhs] != scores[rhs]) {
+            return scores[lhs] > scores[rhs];
+        }
+        return lhs > rhs;
+    };
+
+    // Only order as much of the candidate list as the selection needs. A tight
+    // token budget can skip large examples, so widen the window if it runs dry.
+    size_t sorted = 0;
+    size_t window = std::min(candidates.size(), std::max<size_t>(maxResults * 4, 64));
+    size_t usedTokens = 0;
+    size_t next = 0;
+
+    while (results.size() < maxResults && next < candidates.size()) {
+        if (next == sorted) {
+            std::partial_sort(candidates.begin() + sorted, candidates.begin() + window,
+                              candidates.end(), byScore);
+            sorted = window;
+            window = std::min(candidates.size(), window * 4);
+        }
+
+        uint32_t docId = candidates[next++];
+        const Document& document = m_documents[docId];
+        if (tokenBudget > 0 && usedTokens + document.estimatedTokens > tokenBudget) {
+            continue;
+        }
+
+        usedTokens += document.estimatedTokens;
+        results.push_back({docId, scores[docId], document.estimatedTokens});
+    }
+
+    return results;
+}
+
+nlohmann::json ExampleIndex::toJson() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    nlohmann::json examples = nlohmann::json::array();
+    for (const auto& document : m_documents) {
+        examples.push_back({
+            {"request", document.userRequest},
+            {"command_types", document.commandTypes},
+            {"text", document.exampleText}
+        });
+    }
+
+    return {
+        {"version", INDEX_FORMAT_VERSION},
+        {"k1", m_k1},
+        {"b", m_b},
+        {"examples", examples}
+    };
+}
+
+bool ExampleIndex::fromJson(const nlohmann::json& json) {
+    try {
+        if (!json.is_object() || json.value("version", 0) != INDEX_FORMAT_VERSION ||
+            !json.contains("examples") || !json["examples"].is_array()) {
+            SLOG_WARNING().message("Unsupported example index format");
+            return false;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_documents.clear();
+        m_termIds.clear();
+        m_postings.clear();
+        m_totalLength = 0;
+        m_k1 = json.value("k1", m_k1);
+        m_b = json.value("b", m_b);
+
+        m_documents.reserve(json["examples"].size());
+        for (const auto& example : json["examples"]) {
+            addExampleLocked(example.value("request", ""),
+                             example.value("command_types", std::vector<std::string>{}),
+                             example.value("text", ""));
+        }
+        return true;
+
+    } catch (const std::exception& e) {
+        SLOG_ERROR().message("Failed to load example index").context("error", e.what());
+        return false;
+    }
+}
+
+bool ExampleIndex::saveToFile(const std::string& filePath) const {
+    return utils::FileUtils::saveJsonToFile(filePath, toJson());
+}
+
+bool ExampleIndex::loadFromFile(const std::string& filePath) {
+    nlohmann::json json;
+    if (!utils::FileUtils::loadJsonFromFile(filePath, json)) {
+        return false;
+    }
+    return fromJson(json);
+}
+
+std::vector<std::string> ExampleIndex::tokenize(const std::string& text) {
+    const auto& stopWords = getStopWords();
+    std::vector<std::string> tokens;
+    std::string current;
+
+    auto flush = [&]() {
+        if (current.size() > 1 && stopWords.find(current) == stopWords.end()) {
+            tokens.push_back(current);
+        }
+        current.clear();
+    };
+
+    for (char c : text) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (std::isalnum(uc)) {
+            current += static_cast<char>(std::tolower(uc));
+        } else {
+            flush();
+        }
+    }
+    flush();
+
+    return tokens;
+}
+
+size_t ExampleIndex::estimateTokenCount(const std::string& text) {
+    // Roughly four characters per token for English text and JSON
+    return (text.size() + 3) / 4;
+}
+
+uint32_t ExampleIndex::getOrCreateTermId(const std::string& term) {
+    auto it = m_termIds.find(term);
+    if (it != m_termIds.end()) {
+        return it->second;
+    }
+
+    uint32_t termId = static_cast<uint32_t>(m_postings.size());
+    m_termIds.emplace(term, termId);
+    m_postings.emplace_back();
+    return termId;
+}
+
+double ExampleIndex::idf(size_t documentFrequency) const {
+    const double n = static_cast<double>(m_documents.size());
+    const double df = static_cast<double>(documentFrequency);
+    return std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+}
+
+} // namespace cpl
+} // namespace burwell
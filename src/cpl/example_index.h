@@ -0,0 +1,95 @@
+#ifndef BURWELL_EXAMPLE_INDEX_H
+#define BURWELL_EXAMPLE_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace burwell {
+namespace cpl {
+
+struct ExampleMatch {
+    size_t exampleId;
+    double score;
+    size_t estimatedTokens;
+};
+
+/**
+ * Incrementally updated BM25 index over successful request -> CPL conversions.
+ * Documents are the user request text plus the command types of the generated
+ * commands (MOUSE_CLICK is indexed as "mouse" and "click"), so a request like
+ * "click the OK button" also matches examples by what they executed.
+ * Used by LLMToCPLAdapter to pick few-shot examples under a prompt token budget.
+ */
+class ExampleIndex {
+public:
+    ExampleIndex(double k1 = 1.2, double b = 0.75);
+
+    // Indexing
+    size_t addExample(const std::string& userRequest,
+                      const std::vector<std::string>& commandTypes,
+                      const std::string& exampleText);
+    void clear();
+    size_t size() const;
+
+    // Retrieval: best-scoring examples first, at most maxResults, whose summed
+    // token estimates fit into tokenBudget (0 = unlimited)
+    std::vector<ExampleMatch> query(const std::string& text,
+                                    size_t maxResults,
+                                    size_t tokenBudget = 0) const;
+    std::vector<std::string> queryTexts(const std::string& text,
+                                        size_t maxResults,
+                                        size_t tokenBudget = 0) const;
+    std::string getExampleText(size_t exampleId) const;
+
+    // Persistence (documents are stored, postings are rebuilt on load)
+    nlohmann::json toJson() const;
+    bool fromJson(const nlohmann::json& json);
+    bool saveToFile(const std::string& filePath) const;
+    bool loadFromFile(const std::string& filePath);
+
+    // Tokenization shared by indexing and querying
+    static std::vector<std::string> tokenize(const std::string& text);
+    static size_t estimateTokenCount(const std::string& text);
+
+private:
+    struct Posting {
+        uint32_t docId;
+        uint32_t termFrequency;
+    };
+
+    struct Document {
+        std::string userRequest;
+        std::vector<std::string> commandTypes;
+        std::string exampleText;
+        uint32_t length;
+        uint32_t estimatedTokens;
+    };
+
+    size_t addExampleLocked(const std::string& userRequest,
+                            const std::vector<std::string>& commandTypes,
+                            const std::string& exampleText);
+    std::vector<ExampleMatch> queryLocked(const std::string& text,
+                                          size_t maxResults,
+                                          size_t tokenBudget) const;
+    uint32_t getOrCreateTermId(const std::string& term);
+    double idf(size_t documentFrequency) const;
+
+    double m_k1;
+    double m_b;
+
+    std::vector<Document> m_documents;
+    std::unordered_map<std::string, uint32_t> m_termIds;
+    std::vector<std::vector<Posting>> m_postings;   // Indexed by term id, docIds ascending
+    uint64_t m_totalLength;
+
+    mutable std::shared_mutex m_mutex;
+};
+
+} // namespace cpl
+} // namespace burwell
+
+#endif // BURWELL_EXAMPLE_INDEX_H
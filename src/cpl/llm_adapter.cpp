@@ -0,0 +1,208 @@
+#include "llm_adapter.h"
+#include "../common/structured_logger.h"
+#include "../common/file_utils.h"
+#include <sstream>
+
+namespace burwell {
+namespace cpl {
+
+namespace {
+
+constexpr const char* EXAMPLE_INDEX_FILE_NAME = "example_index.json";
+constexpr int DEFAULT_MAX_EXAMPLES_IN_PROMPT = 5;
+
+std::vector<std::string> collectCommandTypes(const std::vector<CPLCommand>& commands) {
+    std::vector<std::string> types;
+    types.reserve(commands.size());
+    for (const auto& command : commands) {
+        types.push_back(command.type);
+    }
+    return types;
+}
+
+} // anonymous namespace
+
+LLMToCPLAdapter::LLMToCPLAdapter()
+    : m_library(nullptr)
+    , m_parser(nullptr)
+    , m_maxResponseLength(4096)
+    , m_confidenceThreshold(0.7)
+    , m_retryOnLowConfidence(false)
+    , m_includeFeedbackInPrompt(false)
+    , m_maxExamplesInPrompt(DEFAULT_MAX_EXAMPLES_IN_PROMPT)
+    , m_totalConversions(0)
+    , m_successfulConversions(0)
+    , m_failedConversions(0)
+    , m_lastOptimization(std::chrono::system_clock::now())
+    , m_cacheEnabled(false)
+    , m_maxCacheSize(0) {
+}
+
+LLMToCPLAdapter::~LLMToCPLAdapter() {
+    if (m_exampleIndexDirty) {
+        saveExampleIndex();
+    }
+}
+
+bool LLMToCPLAdapter::initialize(std::shared_ptr<LLMConnector> llmConnector,
+                                 CommandLibraryManager* library,
+                                 CPLParser* parser) {
+    m_llmConnector = std::move(llmConnector);
+    m_library = library;
+    m_parser = parser;
+
+    // A missing index only means nothing has been learned yet
+    if (!getExampleIndexFilePath().empty() &&
+        utils::FileUtils::fileExists(getExampleIndexFilePath())) {
+        loadExampleIndex();
+    }
+    return m_llmConnector != nullptr && m_library != nullptr;
+}
+
+// Main conversion interface
+
+LLMResponse LLMToCPLAdapter::streamCommandsForPrompt(const std::string& prompt,
+                                                     StreamingCommandExtractor::CommandCallback onCommand) {
+    LLMResponse response;
+    response.parseSuccess = false;
+    response.confidenceScore = 0.0;
+    if (!m_llmConnector) {
+        response.parseError = "LLM connector not initialized";
+        return response;
+    }
+
+    ++m_totalConversions;
+    StreamingCommandExtractor extractor(std::move(onCommand));
+    nlohmann::json result = m_llmConnector->sendPromptStreaming(prompt,
+        [&extractor, &response](const std::string& text) {
+            response.rawResponse += text;
+            extractor.feed(text);
+            return true;
+        }, ShutdownManager::getInstance().getToken());
+    extractor.finish();
+
+    response.extractedCommands = extractor.getCommands();
+    response.reasoning = extractor.getReasoning();
+    if (result.contains("error")) {
+        response.parseError = result["error"].is_string() ? result["error"].get<std::string>()
+                                                          : result["error"].dump();
+    } else if (extractor.hasError()) {
+        response.parseError = extractor.getError();
+    } else if (response.extractedCommands.empty()) {
+        response.parseError = "LLM response contained no commands";
+    }
+    response.parseSuccess = response.parseError.empty();
+    if (!response.parseSuccess) {
+        ++m_failedConversions;
+    }
+    return response;
+}
+
+// Core conversion methods
+
+std::vector<CPLCommand> LLMToCPLAdapter::parseCommands(const std::string& llmResponse) {
+    // Same extractor that consumes streamed responses, fed the whole text at once
+    return StreamingCommandExtractor::extractAll(llmResponse);
+}
+
+std::string LLMToCPLAdapter::extractReasoningFromResponse(const std::string& response) {
+    StreamingCommandExtractor extractor;
+    extractor.feed(response);
+    return extractor.getReasoning();
+}
+
+// Template and example management
+
+void LLMToCPLAdapter::addSuccessfulExample(const std::string& userRequest,
+                                           const std::vector<CPLCommand>& commands) {
+    if (userRequest.empty() || commands.empty()) {
+        return;
+    }
+
+    m_exampleIndex.addExample(userRequest, collectCommandTypes(commands),
+                              formatExampleForPrompt(userRequest, commands));
+    m_exampleIndexDirty = true;
+}
+
+void LLMToCPLAdapter::recordSuccessfulConversion(const std::string& userRequest,
+                                                 const std::vector<CPLCommand>& commands) {
+    ++m_successfulConversions;
+    for (const auto& command : commands) {
+        ++m_commandTypeCount[command.type];
+    }
+    addSuccessfulExample(userRequest, commands);
+}
+
+std::vector<std::string> LLMToCPLAdapter::getRelevantExamples(const std::string& userRequest) {
+    size_t maxExamples = m_maxExamplesInPrompt > 0
+        ? static_cast<size_t>(m_maxExamplesInPrompt)
+        : static_cast<size_t>(DEFAULT_MAX_EXAMPLES_IN_PROMPT);
+    size_t tokenBudget = m_exampleTokenBudget > 0 ? static_cast<size_t>(m_exampleTokenBudget) : 0;
+
+    return m_exampleIndex.queryTexts(userRequest, maxExamples, tokenBudget);
+}
+
+void LLMToCPLAdapter::setExampleTokenBudget(int maxTokens) {
+    m_exampleTokenBudget = maxTokens;
+}
+
+bool LLMToCPLAdapter::saveExampleIndex() {
+    std::string path = getExampleIndexFilePath();
+    if (path.empty()) {
+        SLOG_WARNING().message("Cannot save example index: no command library path");
+        return false;
+    }
+    if (!m_exampleIndex.saveToFile(path)) {
+        return false;
+    }
+    m_exampleIndexDirty = false;
+    return true;
+}
+
+bool LLMToCPLAdapter::loadExampleIndex() {
+    std::string path = getExampleIndexFilePath();
+    if (path.empty()) {
+        SLOG_WARNING().message("Cannot load example index: no command library path");
+        return false;
+    }
+
+    if (!m_exampleIndex.loadFromFile(path)) {
+        return false;
+    }
+    m_exampleIndexDirty = false;
+
+    SLOG_INFO().message("Example index loaded")
+        .context("path", path)
+        .context("examples", m_exampleIndex.size());
+    return true;
+}
+
+std::string LLMToCPLAdapter::getExampleIndexFilePath() const {
+    // The index lives next to the sequences of the command library it learns from
+    if (!m_library || m_library->getLibraryPath().empty()) {
+        return "";
+    }
+    return m_library->getLibraryPath() + "/" + EXAMPLE_INDEX_FILE_NAME;
+}
+
+// Utility functions
+
+std::string formatExampleForPrompt(const std::string& userRequest,
+                                   const std::vector<CPLCommand>& commands) {
+    nlohmann::json commandsJson = nlohmann::json::array();
+    for (const auto& command : commands) {
+        nlohmann::json commandJson = {{"command", command.type}};
+        if (!command.parameters.empty()) {
+            commandJson["parameters"] = command.parameters;
+        }
+        commandsJson.push_back(commandJson);
+    }
+
+    std::ostringstream example;
+    example << "User request: " << userRequest << "\n";
+    example << "Commands: " << commandsJson.dump() << "\n";
+    return example.str();
+}
+
+} // namespace cpl
+} // namespace burwell
@@ -3,6 +3,9 @@
 
 #include "cpl_parser.h"
 #include "command_library.h"
+#include "cpl_executor.h"
+#include "example_index.h"
+#include "streaming_command_extractor.h"
 #include "../llm_connector/llm_connector.h"
 #include <string>
 #include <vector>
@@ -47,15 +50,19 @@ struct LLMFeedback {
 class LLMToCPLAdapter {
 public:
     LLMToCPLAdapter();
-    ~LLMToCPLAdapter() = default;
+    ~LLMToCPLAdapter();
     
-    // Initialization
+    // Initialization (loads the example index, the destructor saves it)
     bool initialize(std::shared_ptr<LLMConnector> llmConnector, 
                    CommandLibraryManager* library,
                    CPLParser* parser);
     
     // Main conversion interface
     LLMResponse convertUserRequestToCPL(const std::string& userRequest);
+    // Streams the answer to prompt through a StreamingCommandExtractor; onCommand sees each
+    // command as soon as its JSON object is complete, while the LLM is still generating
+    LLMResponse streamCommandsForPrompt(const std::string& prompt,
+                                        StreamingCommandExtractor::CommandCallback onCommand = nullptr);
     LLMResponse improveCommandsWithFeedback(const std::vector<CPLCommand>& commands,
                                           const std::vector<ExecutionResult>& results);
     
@@ -83,6 +90,9 @@ public:
                              const std::vector<CPLCommand>& commands);
     void updatePromptWithNewExamples();
     std::vector<std::string> getRelevantExamples(const std::string& userRequest);
+    void setExampleTokenBudget(int maxTokens);
+    bool saveExampleIndex();
+    bool loadExampleIndex();
     
     // LLM provider abstraction
     void setLLMProvider(const std::string& providerName);
@@ -116,6 +126,7 @@ private:
     std::string buildCommandReference();
     std::string buildExampleSection();
     std::string buildFeedbackSection();
+    std::string getExampleIndexFilePath() const;
     
     // Learning helpers
     void updateSuccessPatterns(const std::string& userRequest,
@@ -147,8 +158,10 @@ private:
     
     // Prompt templates and examples
     LLMPromptTemplate m_currentTemplate;
-    std::vector<std::pair<std::string, std::vector<CPLCommand>>> m_successfulExamples;
     std::vector<std::pair<std::string, std::string>> m_failureExamples;
+    ExampleIndex m_exampleIndex;
+    bool m_exampleIndexDirty = false;     // Examples added since the last load or save
+    int m_exampleTokenBudget = 1500;      // Prompt tokens reserved for few-shot examples
     
     // Learning data
     std::vector<LLMFeedback> m_feedbackHistory;
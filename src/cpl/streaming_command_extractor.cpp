@@ -0,0 +1,328 @@
+#include "streaming_command_extractor.h"
+#include "../common/structured_logger.h"
+#include <cctype>
+
+namespace burwell {
+namespace cpl {
+
+StreamingCommandExtractor::StreamingCommandExtractor(CommandCallback onCommand)
+    : m_onCommand(std::move(onCommand)) {
+    reset();
+}
+
+void StreamingCommandExtractor::reset() {
+    m_state = State::SEEK_START;
+    m_stack.clear();
+    m_pending.clear();
+    m_sawCommands = false;
+    m_inString = false;
+    m_escape = false;
+    m_collectString = false;
+    m_stringBuffer.clear();
+    m_capturing = false;
+    m_captureDepth = 0;
+    m_captureLine = 0;
+    m_capture.clear();
+    m_lineNumber = 1;
+    m_emittedInFeed = 0;
+    m_commands.clear();
+    m_reasoning.clear();
+    m_summary.clear();
+    m_error.clear();
+}
+
+size_t StreamingCommandExtractor::feed(const char* data, size_t size) {
+    m_emittedInFeed = 0;
+    for (size_t i = 0; i < size && m_state != State::DONE; ++i) {
+        consume(data[i]);
+    }
+    return m_emittedInFeed;
+}
+
+size_t StreamingCommandExtractor::feed(const std::string& chunk) {
+    return feed(chunk.data(), chunk.size());
+}
+
+void StreamingCommandExtractor::finish() {
+    if (m_state == State::IN_DOCUMENT) {
+        m_error = "Response ended inside JSON value";
+        SLOG_WARNING().message("Streamed LLM response was truncated")
+            .context("commands_emitted", m_commands.size());
+    }
+}
+
+void StreamingCommandExtractor::consume(char c) {
+    if (c == '\n') {
+        ++m_lineNumber;
+    }
+
+    if (m_state == State::SEEK_START) {
+        seekStart(c);
+    } else {
+        consumeDocument(c);
+    }
+}
+
+void StreamingCommandExtractor::seekStart(char c) {
+    if (m_pending.empty()) {
+        if (c == '{' || c == '[') {
+            m_pending.assign(1, c);
+        }
+        return;
+    }
+
+    if (std::isspace(static_cast<unsigned char>(c))) {
+        m_pending += c;
+        return;
+    }
+
+    // "[{" still needs its first key; "{" is confirmed by it
+    char last = m_pending.back();
+    for (size_t i = m_pending.size(); i-- > 0;) {
+        if (!std::isspace(static_cast<unsigned char>(m_pending[i]))) {
+            last = m_pending[i];
+            break;
+        }
+    }
+    if (last == '[' && c == '{') {
+        m_pending += c;
+        return;
+    }
+    if (last == '{' && c == '"') {
+        std::string start = std::move(m_pending);
+        m_pending.clear();
+        start += c;
+
+        m_state = State::IN_DOCUMENT;
+        m_sawCommands = false;
+        // A bare array at the top level is a command list on its own
+        m_stack.push_back({start[0], start[0] == '{', start[0] == '[', ""});
+        for (size_t i = 1; i < start.size(); ++i) {
+            consumeDocument(start[i]);
+        }
+        return;
+    }
+
+    // Not a plan after all; the rejected text may still contain the real start
+    std::string rest = m_pending.substr(1);
+    m_pending.clear();
+    rest += c;
+    for (char r : rest) {
+        seekStart(r);
+    }
+}
+
+void StreamingCommandExtractor::abandonDocument(const char* error) {
+    if (error) {
+        m_error = error;
+        SLOG_DEBUG().message("Skipping malformed JSON in LLM response")
+            .context("error", error)
+            .context("line", m_lineNumber);
+    }
+    m_state = State::SEEK_START;
+    m_stack.clear();
+    m_inString = false;
+    m_escape = false;
+    m_collectString = false;
+    m_capturing = false;
+    m_capture.clear();
+    m_reasoning.clear();
+    m_summary.clear();
+}
+
+void StreamingCommandExtractor::consumeDocument(char c) {
+    if (m_capturing) {
+        m_capture += c;
+    }
+
+    if (m_inString) {
+        if (m_escape) {
+            m_escape = false;
+        } else if (c == '\\') {
+            m_escape = true;
+        } else if (c == '"') {
+            m_inString = false;
+            onStringEnd();
+            return;
+        }
+        if (m_collectString) {
+            m_stringBuffer += c;
+        }
+        return;
+    }
+
+    switch (c) {
+        case '"': {
+            m_inString = true;
+            m_stringBuffer.clear();
+            // Only the top-level object's keys and its reasoning/summary values matter
+            m_collectString = false;
+            if (m_stack.size() == 1 && m_stack.back().type == '{') {
+                const Frame& top = m_stack.back();
+                m_collectString = top.expectKey || top.key == "reasoning" || top.key == "summary";
+            }
+            break;
+        }
+        case '{':
+        case '[': {
+            Frame& parent = m_stack.back();
+            bool startsCommand = !m_capturing && c == '{' && parent.isCommandArray;
+            bool isCommandArray = !m_capturing && c == '[' && m_stack.size() == 1 &&
+                                  parent.type == '{' && parent.key == "commands";
+
+            m_stack.push_back({c, c == '{', isCommandArray, ""});
+            m_sawCommands = m_sawCommands || isCommandArray;
+
+            if (startsCommand) {
+                m_capturing = true;
+                m_captureDepth = m_stack.size();
+                m_captureLine = m_lineNumber;
+                m_capture.assign(1, c);
+            }
+            break;
+        }
+        case '}':
+        case ']': {
+            if ((c == '}') != (m_stack.back().type == '{')) {
+                abandonDocument("Mismatched bracket in LLM response");
+                return;
+            }
+            bool closesCapture = m_capturing && m_stack.size() == m_captureDepth;
+            char closedType = m_stack.back().type;
+            m_stack.pop_back();
+
+            if (closesCapture) {
+                emitCapturedCommand();
+            }
+            if (m_stack.empty()) {
+                if (closedType == '{' && !m_sawCommands) {
+                    // Some other JSON object, keep looking for the plan
+                    abandonDocument(nullptr);
+                } else {
+                    m_error.clear();
+                    m_state = State::DONE;
+                }
+            }
+            break;
+        }
+        case ':':
+            if (m_stack.back().type == '{') {
+                m_stack.back().expectKey = false;
+            }
+            break;
+        case ',':
+            if (m_stack.back().type == '{') {
+                m_stack.back().expectKey = true;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void StreamingCommandExtractor::onStringEnd() {
+    if (!m_collectString) {
+        return;
+    }
+    m_collectString = false;
+
+    Frame& top = m_stack.back();
+    std::string decoded;
+    if (!decodeJsonString(m_stringBuffer, decoded)) {
+        return;
+    }
+
+    if (top.expectKey) {
+        top.key = std::move(decoded);
+    } else if (top.key == "reasoning") {
+        m_reasoning = std::move(decoded);
+    } else if (top.key == "summary") {
+        m_summary = std::move(decoded);
+    }
+}
+
+void StreamingCommandExtractor::emitCapturedCommand() {
+    m_capturing = false;
+
+    CPLCommand command;
+    try {
+        command = cplCommandFromPlanJson(nlohmann::json::parse(m_capture));
+    } catch (const nlohmann::json::parse_error& e) {
+        command.type.clear();
+        command.isValid = false;
+        command.validationError = std::string("Invalid command JSON: ") + e.what();
+    }
+    command.originalText = std::move(m_capture);
+    command.lineNumber = m_captureLine;
+    m_capture.clear();
+
+    m_commands.push_back(command);
+    ++m_emittedInFeed;
+
+    if (m_onCommand) {
+        m_onCommand(m_commands.back());
+    }
+}
+
+bool StreamingCommandExtractor::decodeJsonString(const std::string& raw, std::string& decoded) {
+    // Plain strings are by far the common case and need no escape processing
+    if (raw.find('\\') == std::string::npos) {
+        decoded = raw;
+        return true;
+    }
+    try {
+        decoded = nlohmann::json::parse("\"" + raw + "\"").get<std::string>();
+        return true;
+    } catch (const nlohmann::json::exception&) {
+        return false;
+    }
+}
+
+std::vector<CPLCommand> StreamingCommandExtractor::extractAll(const std::string& response,
+                                                              std::string* reasoning) {
+    StreamingCommandExtractor extractor;
+    extractor.feed(response);
+    extractor.finish();
+    if (reasoning) {
+        *reasoning = extractor.getReasoning();
+    }
+    return extractor.getCommands();
+}
+
+CPLCommand cplCommandFromPlanJson(const nlohmann::json& commandJson) {
+    CPLCommand command;
+    command.lineNumber = 0;
+    command.isValid = false;
+
+    if (!commandJson.is_object()) {
+        command.validationError = "Command is not a JSON object";
+        return command;
+    }
+
+    if (commandJson.contains("command") && commandJson["command"].is_string()) {
+        command.type = commandJson["command"].get<std::string>();
+    } else if (commandJson.contains("type") && commandJson["type"].is_string()) {
+        command.type = commandJson["type"].get<std::string>();
+    }
+
+    if (commandJson.contains("parameters") && commandJson["parameters"].is_object()) {
+        for (const auto& [name, value] : commandJson["parameters"].items()) {
+            command.parameters[name] = value.is_string() ? value.get<std::string>() : value.dump();
+        }
+    }
+
+    for (const auto& [name, value] : commandJson.items()) {
+        if (name != "command" && name != "type" && name != "parameters" && value.is_primitive()) {
+            command.metadata[name] = value.is_string() ? value.get<std::string>() : value.dump();
+        }
+    }
+
+    command.isValid = !command.type.empty();
+    if (!command.isValid) {
+        command.validationError = "Command object has no command type";
+    }
+    return command;
+}
+
+} // namespace cpl
+} // namespace burwell
@@ -0,0 +1,103 @@
+#ifndef BURWELL_STREAMING_COMMAND_EXTRACTOR_H
+#define BURWELL_STREAMING_COMMAND_EXTRACTOR_H
+
+#include "cpl_parser.h"
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace burwell {
+namespace cpl {
+
+/**
+ * Resumable extractor for LLM plan responses of the form
+ *   {"reasoning": "...", "summary": "...", "commands": [{...}, {...}]}
+ * or a bare command array, optionally wrapped in prose or ``` fences.
+ *
+ * Text can be fed in arbitrary chunks as it streams in; each command object is
+ * converted and emitted the moment its closing brace arrives, so validation or
+ * dry-run simulation can start while the LLM is still generating. Feeding the
+ * same text split at any byte boundary yields the same commands.
+ *
+ * A document only starts at a '{' followed by a key or a '[' followed by an
+ * object, so brackets in the prose are skipped. A malformed document, or an
+ * object without "commands", is dropped and scanning resumes after it.
+ */
+class StreamingCommandExtractor {
+public:
+    using CommandCallback = std::function<void(const CPLCommand&)>;
+
+    explicit StreamingCommandExtractor(CommandCallback onCommand = nullptr);
+
+    // Returns the number of commands emitted while consuming this chunk
+    size_t feed(const char* data, size_t size);
+    size_t feed(const std::string& chunk);
+    void finish();
+    void reset();
+
+    const std::vector<CPLCommand>& getCommands() const { return m_commands; }
+    const std::string& getReasoning() const { return m_reasoning; }
+    const std::string& getSummary() const { return m_summary; }
+    bool isComplete() const { return m_state == State::DONE; }
+    bool hasError() const { return !m_error.empty(); }
+    const std::string& getError() const { return m_error; }
+
+    // One-shot helper for responses that are already complete
+    static std::vector<CPLCommand> extractAll(const std::string& response,
+                                              std::string* reasoning = nullptr);
+
+private:
+    enum class State {
+        SEEK_START,     // Skipping prose until a '{' or '[' that opens a plan
+        IN_DOCUMENT,    // Inside the top-level JSON value
+        DONE            // Top-level value closed, trailing text ignored
+    };
+
+    struct Frame {
+        char type;              // '{' or '['
+        bool expectKey;         // Objects only: next string is a key
+        bool isCommandArray;    // Elements of this array are commands
+        std::string key;        // Last key seen (top-level object only)
+    };
+
+    void consume(char c);
+    void seekStart(char c);
+    void consumeDocument(char c);
+    void abandonDocument(const char* error);
+    void onStringEnd();
+    void emitCapturedCommand();
+    static bool decodeJsonString(const std::string& raw, std::string& decoded);
+
+    CommandCallback m_onCommand;
+    State m_state;
+    std::vector<Frame> m_stack;
+    std::string m_pending;      // Candidate start seen in SEEK_START, not yet confirmed
+    bool m_sawCommands;         // The current document has a command array
+
+    // String scanning
+    bool m_inString;
+    bool m_escape;
+    bool m_collectString;
+    std::string m_stringBuffer;
+
+    // Raw text of the command object currently being received
+    bool m_capturing;
+    size_t m_captureDepth;
+    int m_captureLine;
+    std::string m_capture;
+
+    int m_lineNumber;
+    size_t m_emittedInFeed;
+
+    std::vector<CPLCommand> m_commands;
+    std::string m_reasoning;
+    std::string m_summary;
+    std::string m_error;
+};
+
+CPLCommand cplCommandFromPlanJson(const nlohmann::json& commandJson);
+
+} // namespace cpl
+} // namespace burwell
+
+#endif // BURWELL_STREAMING_COMMAND_EXTRACTOR_H
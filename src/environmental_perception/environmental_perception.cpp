@@ -230,7 +230,8 @@ Screenshot EnvironmentalPerception::captureScreenWindows() {
     bmpInfo.bmiHeader.biBitCount = 24;
     bmpInfo.bmiHeader.biCompression = BI_RGB;
     
-    int dataSize = screenWidth * screenHeight * 3; // 24 bits = 3 bytes per pixel
+    int rowStride = (screenWidth * 3 + 3) & ~3; // 24-bit DIB rows are DWORD aligned
+    int dataSize = rowStride * screenHeight;
     screenshot.data.resize(dataSize);
     
     GetDIBits(memoryDC, bitmap, 0, screenHeight, screenshot.data.data(), &bmpInfo, DIB_RGB_COLORS);
@@ -238,7 +239,7 @@ Screenshot EnvironmentalPerception::captureScreenWindows() {
     screenshot.width = screenWidth;
     screenshot.height = screenHeight;
     screenshot.bitsPerPixel = 24;
-    screenshot.format = "RGB";
+    screenshot.format = "BGR"; // GDI stores 24-bit pixels blue first
     
     // Cleanup
     SelectObject(memoryDC, oldBitmap);
@@ -1,9 +1,12 @@
 #include "http_client.h"
 #include "../common/structured_logger.h"
 #include "../common/error_handler.h"
+#include "../common/blocking_region.h"
 #include <thread>
+#include <cstdio>
 #include <chrono>
 #include <sstream>
+#include <mutex>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -66,22 +69,34 @@ HttpResponse HttpClient::get(const std::string& url, const std::map<std::string,
     return retryRequest(request);
 }
 
-HttpResponse HttpClient::post(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse HttpClient::post(const std::string& url, std::string body, const std::map<std::string, std::string>& headers) {
     HttpRequest request;
     request.url = url;
     request.method = "POST";
-    request.body = body;
+    request.body = std::move(body);
     request.headers = headers;
     request.timeoutMs = m_timeoutMs;
     
     return retryRequest(request);
 }
 
-HttpResponse HttpClient::put(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse HttpClient::put(const std::string& url, std::string body, const std::map<std::string, std::string>& headers) {
     HttpRequest request;
     request.url = url;
     request.method = "PUT";
-    request.body = body;
+    request.body = std::move(body);
+    request.headers = headers;
+    request.timeoutMs = m_timeoutMs;
+    
+    return retryRequest(request);
+}
+
+HttpResponse HttpClient::postStreaming(const std::string& url, HttpRequest::BodyWriter writer,
+                                       const std::map<std::string, std::string>& headers) {
+    HttpRequest request;
+    request.url = url;
+    request.method = "POST";
+    request.streamBody = std::move(writer);
     request.headers = headers;
     request.timeoutMs = m_timeoutMs;
     
@@ -173,6 +188,19 @@ HttpResponse HttpClient::performRequest(const HttpRequest& request) {
             return response;
         }
         
+        // Closing the handles is the only way to abort a blocking WinINet call
+        std::mutex handleMutex;
+        bool handlesClosed = false;
+        auto closeHandles = [&]() {
+            std::lock_guard<std::mutex> lock(handleMutex);
+            if (!handlesClosed) {
+                InternetCloseHandle(hRequest);
+                InternetCloseHandle(hConnect);
+                handlesClosed = true;
+            }
+        };
+        CancellationRegistration abortOnCancel = request.cancellation.onCancel(closeHandles);
+        
         // Set timeout
         DWORD timeout = request.timeoutMs;
         InternetSetOptionA(hRequest, INTERNET_OPTION_CONNECT_TIMEOUT, &timeout, sizeof(timeout));
@@ -186,16 +214,72 @@ HttpResponse HttpClient::performRequest(const HttpRequest& request) {
         }
         
         // Send request
-        BOOL result = HttpSendRequestA(hRequest, 
-                                       headersStr.empty() ? nullptr : headersStr.c_str(),
-                                       headersStr.length(),
-                                       request.body.empty() ? nullptr : (LPVOID)request.body.c_str(),
-                                       request.body.length());
+        BOOL result = FALSE;
+        bool bodyRefused = false;          // The body writer gave up on its own, not the upload
+        if (request.streamBody) {
+            // WinINet does not frame chunked uploads itself, so write the chunk headers here
+            headersStr += "Transfer-Encoding: chunked\r\n";
+            HttpAddRequestHeadersA(hRequest, headersStr.c_str(), static_cast<DWORD>(headersStr.length()),
+                                   HTTP_ADDREQ_FLAG_ADD | HTTP_ADDREQ_FLAG_REPLACE);
+            
+            auto writeAll = [&](const char* data, size_t size) {
+                while (size > 0) {
+                    DWORD written = 0;
+                    BlockingRegion blocking;
+                    if (!InternetWriteFile(hRequest, data, static_cast<DWORD>(size), &written) || written == 0) {
+                        return false;
+                    }
+                    data += written;
+                    size -= written;
+                }
+                return true;
+            };
+            bool chunkFailed = false;
+            auto writeChunk = [&](const char* data, size_t size) {
+                if (size == 0) {
+                    return true;  // A zero-length chunk would end the body
+                }
+                char chunkHeader[24];
+                int headerLength = std::snprintf(chunkHeader, sizeof(chunkHeader), "%zx\r\n", size);
+                chunkFailed = request.cancellation.isCancelled() ||
+                              !writeAll(chunkHeader, static_cast<size_t>(headerLength)) ||
+                              !writeAll(data, size) || !writeAll("\r\n", 2);
+                return !chunkFailed;
+            };
+            
+            INTERNET_BUFFERSA buffers = {};
+            buffers.dwStructSize = sizeof(buffers);
+            {
+                BlockingRegion blocking;
+                result = HttpSendRequestExA(hRequest, &buffers, nullptr, 0, 0);
+            }
+            if (result && !request.streamBody(writeChunk)) {
+                result = FALSE;
+                bodyRefused = !chunkFailed;
+            }
+            if (result && writeAll("0\r\n\r\n", 5)) {
+                BlockingRegion blocking;
+                result = HttpEndRequestA(hRequest, nullptr, 0, 0);
+            } else {
+                result = FALSE;
+            }
+        } else {
+            BlockingRegion blocking;
+            result = HttpSendRequestA(hRequest, 
+                                      headersStr.empty() ? nullptr : headersStr.c_str(),
+                                      headersStr.length(),
+                                      request.body.empty() ? nullptr : (LPVOID)request.body.c_str(),
+                                      request.body.length());
+        }
         
         if (!result) {
-            InternetCloseHandle(hRequest);
-            InternetCloseHandle(hConnect);
-            response.errorMessage = "Failed to send HTTP request";
+            abortOnCancel.reset();
+            closeHandles();
+            response.errorMessage = request.cancellation.isCancelled() ? "HTTP request cancelled"
+                                  : bodyRefused ? "Request body writer failed"
+                                                : "Failed to send HTTP request";
+            // Producing the same body again would fail the same way
+            response.retryable = !bodyRefused;
             return response;
         }
         
@@ -232,22 +316,65 @@ HttpResponse HttpClient::performRequest(const HttpRequest& request) {
         std::string responseBody;
         DWORD bytesRead;
         char buffer[4096];
+        bool streamResponse = request.responseSink && statusCode >= 200 && statusCode < 300;
+        bool sinkStopped = false;
+        // Only the read itself blocks; the sink runs outside the region
+        auto readChunk = [&]() {
+            BlockingRegion blocking;
+            return InternetReadFile(hRequest, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0;
+        };
         
-        while (InternetReadFile(hRequest, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0) {
-            responseBody.append(buffer, bytesRead);
+        while (readChunk()) {
+            if (!streamResponse) {
+                responseBody.append(buffer, bytesRead);
+            } else if (!request.responseSink(buffer, bytesRead)) {
+                sinkStopped = true;
+                break;
+            }
+        }
+        
+        // Bytes already handed to the sink cannot be taken back, so never retry a streamed response
+        response.retryable = !streamResponse;
+        abortOnCancel.reset();
+        if (request.cancellation.isCancelled()) {
+            closeHandles();
+            response.errorMessage = "HTTP request cancelled";
+            return response;
+        }
+        if (sinkStopped) {
+            closeHandles();
+            response.errorMessage = "Response consumer stopped the transfer";
+            return response;
         }
         
         response.body = responseBody;
         response.success = (statusCode >= 200 && statusCode < 300);
         
-        InternetCloseHandle(hRequest);
-        InternetCloseHandle(hConnect);
+        closeHandles();
         
 #else
         // Non-Windows simulation
+        if (request.streamBody) {
+            size_t streamedBytes = 0;
+            bool written = request.streamBody([&streamedBytes](const char*, size_t size) {
+                streamedBytes += size;
+                return true;
+            });
+            SLOG_DEBUG().message("Streamed request body").context("bytes", streamedBytes);
+            if (!written) {
+                response.errorMessage = "Request body writer failed";
+                response.retryable = false;
+                return response;
+            }
+        }
         response.statusCode = 200;
         response.body = R"({"simulated": true, "message": "HTTP client simulated on non-Windows platform"})";
         response.success = true;
+        if (request.responseSink) {
+            request.responseSink(response.body.data(), response.body.size());
+            response.body.clear();
+            response.retryable = false;
+        }
         SLOG_DEBUG().message("HTTP request simulated (non-Windows platform)");
 #endif
         
@@ -267,16 +394,25 @@ HttpResponse HttpClient::retryRequest(const HttpRequest& request) {
     HttpResponse response;
     
     for (int attempt = 0; attempt <= m_maxRetries; ++attempt) {
+        if (request.cancellation.isCancelled()) {
+            response.success = false;
+            response.errorMessage = "HTTP request cancelled";
+            return response;
+        }
+        
         response = performRequest(request);
         
-        if (response.success) {
+        if (response.success || !response.retryable) {
             break;
         }
         
         if (attempt < m_maxRetries) {
             SLOG_WARNING().message("HTTP request failed, retrying").context("attempt", 
                        std::to_string(attempt + 1) + "/" + std::to_string(m_maxRetries + 1) + ")");
-            std::this_thread::sleep_for(std::chrono::milliseconds(m_retryDelay));
+            if (!request.cancellation.sleepFor(std::chrono::milliseconds(m_retryDelay))) {
+                response.errorMessage = "HTTP request cancelled";
+                return response;
+            }
         }
     }
     
@@ -290,7 +426,8 @@ HttpResponse HttpClient::retryRequest(const HttpRequest& request) {
 }
 
 void HttpClient::logRequest(const HttpRequest& request) {
-    SLOG_DEBUG().message("HTTP request").context("method", request.method).context("url", request.url);
+    SLOG_DEBUG().message("HTTP request").context("method", request.method).context("url", request.url)
+        .context("body", request.streamBody ? "chunked" : std::to_string(request.body.length()) + " bytes");
     if (!request.body.empty() && request.body.length() < 500) {
         SLOG_DEBUG().message("Request body").context("body", request.body);
     }
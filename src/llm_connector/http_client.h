@@ -5,6 +5,7 @@
 #include <map>
 #include <functional>
 #include <memory>
+#include "../common/shutdown_manager.h"
 
 namespace burwell {
 
@@ -13,19 +14,30 @@ struct HttpResponse {
     std::string body;
     std::map<std::string, std::string> headers;
     bool success;
+    bool retryable;                    // False when another attempt cannot succeed or would replay a streamed body
     std::string errorMessage;
     
-    HttpResponse() : statusCode(0), success(false) {}
+    HttpResponse() : statusCode(0), success(false), retryable(true) {}
 };
 
 struct HttpRequest {
+    // Receives the next slice of a streamed body; returning false aborts the upload
+    using BodySink = std::function<bool(const char* data, size_t size)>;
+    // Produces the whole body into the sink; called again for every retry
+    using BodyWriter = std::function<bool(const BodySink& sink)>;
+
     std::string url;
     std::string method;
     std::string body;
+    BodyWriter streamBody;             // When set, replaces body and is sent chunked
+    BodySink responseSink;             // When set, receives a 2xx response body as it arrives instead of HttpResponse::body
     std::map<std::string, std::string> headers;
     int timeoutMs;
+    CancellationToken cancellation;    // Aborts the transfer and retry delays
     
-    HttpRequest() : method("GET"), timeoutMs(30000) {}
+    HttpRequest()
+        : method("GET"), timeoutMs(30000)
+        , cancellation(ShutdownManager::getInstance().getToken()) {}
 };
 
 class HttpClient {
@@ -35,8 +47,12 @@ public:
     
     // Core HTTP methods
     HttpResponse get(const std::string& url, const std::map<std::string, std::string>& headers = {});
-    HttpResponse post(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers = {});
-    HttpResponse put(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers = {});
+    HttpResponse post(const std::string& url, std::string body, const std::map<std::string, std::string>& headers = {});
+    HttpResponse put(const std::string& url, std::string body, const std::map<std::string, std::string>& headers = {});
+    
+    // POST with Transfer-Encoding: chunked, so the body never exists in full
+    HttpResponse postStreaming(const std::string& url, HttpRequest::BodyWriter writer,
+                               const std::map<std::string, std::string>& headers = {});
     HttpResponse delete_(const std::string& url, const std::map<std::string, std::string>& headers = {});
     
     // Generic request method
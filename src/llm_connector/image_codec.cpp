@@ -0,0 +1,1135 @@
+#include "image_codec.h"
+#include "../common/string_utils.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BURWELL_IMAGE_SSE2 1
+#endif
+
+namespace burwell {
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Shared Huffman helpers
+// ---------------------------------------------------------------------------
+
+// Code lengths no longer than maxBits. At least two symbols get a code so
+// the resulting prefix code is always complete.
+std::vector<uint8_t> buildCodeLengths(std::vector<uint32_t> freqs, int maxBits) {
+    const size_t count = freqs.size();
+    size_t used = static_cast<size_t>(std::count_if(freqs.begin(), freqs.end(), [](uint32_t f) { return f > 0; }));
+    for (size_t i = 0; used < 2 && i < count; ++i) {
+        if (freqs[i] == 0) {
+            freqs[i] = 1;
+            ++used;
+        }
+    }
+
+    std::vector<uint8_t> lengths(count, 0);
+    while (true) {
+        struct Node {
+            uint64_t freq;
+            int left;
+            int right;   // Symbol index for leaves (left == -1)
+        };
+        std::vector<Node> nodes;
+        nodes.reserve(count * 2);
+        using Entry = std::pair<uint64_t, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+        for (size_t i = 0; i < count; ++i) {
+            if (freqs[i] > 0) {
+                heap.emplace(freqs[i], static_cast<int>(nodes.size()));
+                nodes.push_back({freqs[i], -1, static_cast<int>(i)});
+            }
+        }
+        while (heap.size() > 1) {
+            Entry a = heap.top();
+            heap.pop();
+            Entry b = heap.top();
+            heap.pop();
+            heap.emplace(a.first + b.first, static_cast<int>(nodes.size()));
+            nodes.push_back({a.first + b.first, a.second, b.second});
+        }
+
+        std::fill(lengths.begin(), lengths.end(), 0);
+        int deepest = 0;
+        std::vector<std::pair<int, int>> stack{{heap.top().second, 0}};
+        while (!stack.empty()) {
+            auto [index, depth] = stack.back();
+            stack.pop_back();
+            const Node& node = nodes[index];
+            if (node.left < 0) {
+                lengths[node.right] = static_cast<uint8_t>(depth);
+                deepest = std::max(deepest, depth);
+            } else {
+                stack.emplace_back(node.left, depth + 1);
+                stack.emplace_back(node.right, depth + 1);
+            }
+        }
+        if (deepest <= maxBits) {
+            return lengths;
+        }
+        // Flatten the distribution and retry; converges to a balanced tree
+        for (auto& freq : freqs) {
+            if (freq > 0) {
+                freq = (freq + 1) / 2;
+            }
+        }
+    }
+}
+
+// Canonical codes in symbol order, most significant bit first
+std::vector<uint16_t> assignCanonicalCodes(const std::vector<uint8_t>& lengths) {
+    std::array<uint16_t, 17> lengthCounts{};
+    for (uint8_t length : lengths) {
+        lengthCounts[length]++;
+    }
+    lengthCounts[0] = 0;
+    std::array<uint16_t, 17> nextCode{};
+    uint16_t code = 0;
+    for (int bits = 1; bits <= 16; ++bits) {
+        code = static_cast<uint16_t>((code + lengthCounts[bits - 1]) << 1);
+        nextCode[bits] = code;
+    }
+    std::vector<uint16_t> codes(lengths.size(), 0);
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        if (lengths[i] > 0) {
+            codes[i] = nextCode[lengths[i]]++;
+        }
+    }
+    return codes;
+}
+
+// ---------------------------------------------------------------------------
+// Deflate (RFC 1951) with dynamic Huffman blocks, stored when incompressible
+// ---------------------------------------------------------------------------
+
+constexpr int DEFLATE_WINDOW = 32768;
+constexpr int DEFLATE_HASH_BITS = 15;
+constexpr int DEFLATE_MIN_MATCH = 3;
+constexpr int DEFLATE_MAX_MATCH = 258;
+constexpr int DEFLATE_MAX_CHAIN = 32;
+constexpr int DEFLATE_NICE_MATCH = 128;
+constexpr int DEFLATE_FAR_MIN3 = 4096;        // Length-3 matches further back cost more than literals
+constexpr size_t DEFLATE_BLOCK_TOKENS = 1 << 15;
+constexpr size_t DEFLATE_MAX_STORED = 65535;
+
+const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                8193, 12289, 16385, 24577};
+const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+struct DeflateTables {
+    uint8_t lengthCode[DEFLATE_MAX_MATCH + 1];
+    uint8_t distCode[DEFLATE_WINDOW + 1];
+
+    DeflateTables() {
+        for (int code = 0; code < 29; ++code) {
+            int end = code + 1 < 29 ? LENGTH_BASE[code + 1] : DEFLATE_MAX_MATCH + 1;
+            for (int length = LENGTH_BASE[code]; length < end; ++length) {
+                lengthCode[length] = static_cast<uint8_t>(code);
+            }
+        }
+        // 258 has its own code rather than 227 + 31
+        lengthCode[DEFLATE_MAX_MATCH] = 28;
+        for (int code = 0; code < 30; ++code) {
+            int end = code + 1 < 30 ? DIST_BASE[code + 1] : DEFLATE_WINDOW + 1;
+            for (int dist = DIST_BASE[code]; dist < end; ++dist) {
+                distCode[dist] = static_cast<uint8_t>(code);
+            }
+        }
+    }
+};
+
+const DeflateTables& deflateTables() {
+    static const DeflateTables tables;
+    return tables;
+}
+
+struct LzToken {
+    uint16_t value;      // Literal byte, or match length when distance > 0
+    uint16_t distance;
+};
+
+// Deflate sends Huffman codes most significant bit first into an LSB-first stream
+std::vector<uint16_t> deflateCodes(const std::vector<uint8_t>& lengths) {
+    std::vector<uint16_t> codes = assignCanonicalCodes(lengths);
+    for (size_t i = 0; i < codes.size(); ++i) {
+        uint16_t reversed = 0;
+        for (int bit = 0; bit < lengths[i]; ++bit) {
+            reversed = static_cast<uint16_t>((reversed << 1) | ((codes[i] >> bit) & 1u));
+        }
+        codes[i] = reversed;
+    }
+    return codes;
+}
+
+class LsbBitWriter {
+public:
+    explicit LsbBitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void put(uint32_t value, int bits) {
+        m_bits |= static_cast<uint64_t>(value) << m_count;
+        m_count += bits;
+        while (m_count >= 8) {
+            m_out.push_back(static_cast<uint8_t>(m_bits));
+            m_bits >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    void flush() {
+        if (m_count > 0) {
+            m_out.push_back(static_cast<uint8_t>(m_bits));
+        }
+        m_bits = 0;
+        m_count = 0;
+    }
+
+    // Pads to a byte boundary first
+    void putBytes(const uint8_t* data, size_t size) {
+        flush();
+        m_out.insert(m_out.end(), data, data + size);
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint64_t m_bits = 0;
+    int m_count = 0;
+};
+
+std::vector<LzToken> findMatches(const uint8_t* data, size_t size) {
+    std::vector<LzToken> tokens;
+    tokens.reserve(size / 4 + 16);
+    std::vector<int32_t> head(size_t(1) << DEFLATE_HASH_BITS, -1);
+    std::vector<int32_t> prev(DEFLATE_WINDOW, -1);
+
+    auto hashAt = [data](size_t pos) {
+        uint32_t v = data[pos] | (uint32_t(data[pos + 1]) << 8) | (uint32_t(data[pos + 2]) << 16);
+        return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+    };
+    auto insert = [&](size_t pos) {
+        uint32_t h = hashAt(pos);
+        prev[pos & (DEFLATE_WINDOW - 1)] = head[h];
+        head[h] = static_cast<int32_t>(pos);
+    };
+    auto longestMatch = [&](size_t pos, int& bestLength, int& bestDistance) {
+        bestLength = 0;
+        bestDistance = 0;
+        const int limit = static_cast<int>(std::min<size_t>(DEFLATE_MAX_MATCH, size - pos));
+        int32_t candidate = head[hashAt(pos)];
+        int chain = DEFLATE_MAX_CHAIN;
+        while (candidate >= 0 && chain-- > 0) {
+            int distance = static_cast<int>(pos - candidate);
+            if (distance > DEFLATE_WINDOW) {
+                break;
+            }
+            const uint8_t* a = data + candidate;
+            const uint8_t* b = data + pos;
+            if (a[bestLength] == b[bestLength]) {
+                int length = 0;
+                while (length < limit && a[length] == b[length]) {
+                    ++length;
+                }
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = distance;
+                    if (length >= DEFLATE_NICE_MATCH || length == limit) {
+                        break;
+                    }
+                }
+            }
+            int32_t next = prev[candidate & (DEFLATE_WINDOW - 1)];
+            if (next >= candidate) {
+                break;
+            }
+            candidate = next;
+        }
+        if (bestLength < DEFLATE_MIN_MATCH ||
+            (bestLength == DEFLATE_MIN_MATCH && bestDistance > DEFLATE_FAR_MIN3)) {
+            bestLength = 0;
+        }
+    };
+
+    size_t pos = 0;
+    while (pos < size) {
+        int length = 0;
+        int distance = 0;
+        if (pos + DEFLATE_MIN_MATCH <= size) {
+            longestMatch(pos, length, distance);
+            insert(pos);
+        }
+        // One step of lazy evaluation: prefer a longer match starting at the next byte
+        if (length > 0 && length < DEFLATE_NICE_MATCH && pos + 1 + DEFLATE_MIN_MATCH <= size) {
+            int nextLength = 0;
+            int nextDistance = 0;
+            longestMatch(pos + 1, nextLength, nextDistance);
+            if (nextLength > length) {
+                tokens.push_back({data[pos], 0});
+                ++pos;
+                insert(pos);
+                length = nextLength;
+                distance = nextDistance;
+            }
+        }
+        if (length > 0) {
+            tokens.push_back({static_cast<uint16_t>(length), static_cast<uint16_t>(distance)});
+            size_t end = pos + length;
+            for (size_t q = pos + 1; q < end && q + DEFLATE_MIN_MATCH <= size; ++q) {
+                insert(q);
+            }
+            pos = end;
+        } else {
+            tokens.push_back({data[pos], 0});
+            ++pos;
+        }
+    }
+    return tokens;
+}
+
+void writeStoredBlocks(LsbBitWriter& writer, const uint8_t* data, size_t size, bool final) {
+    size_t offset = 0;
+    do {
+        size_t length = std::min(DEFLATE_MAX_STORED, size - offset);
+        bool last = final && offset + length == size;
+        writer.put(last ? 1 : 0, 1);
+        writer.put(0, 2);
+        writer.flush();
+        writer.put(static_cast<uint32_t>(length), 16);
+        writer.put(static_cast<uint32_t>(~length & 0xFFFF), 16);
+        writer.putBytes(data + offset, length);
+        offset += length;
+    } while (offset < size);
+}
+
+// Tokens cover data[0, size); noise-like runs that Huffman coding would grow are stored
+void writeBlock(LsbBitWriter& writer, const LzToken* tokens, size_t count,
+                const uint8_t* data, size_t size, bool final) {
+    const DeflateTables& tables = deflateTables();
+
+    std::vector<uint32_t> literalFreqs(286, 0);
+    std::vector<uint32_t> distFreqs(30, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (tokens[i].distance == 0) {
+            literalFreqs[tokens[i].value]++;
+        } else {
+            literalFreqs[257 + tables.lengthCode[tokens[i].value]]++;
+            distFreqs[tables.distCode[tokens[i].distance]]++;
+        }
+    }
+    literalFreqs[256]++;
+
+    std::vector<uint8_t> literalLengths = buildCodeLengths(literalFreqs, 15);
+    std::vector<uint8_t> distLengths = buildCodeLengths(distFreqs, 15);
+    std::vector<uint16_t> literalCodes = deflateCodes(literalLengths);
+    std::vector<uint16_t> distCodes = deflateCodes(distLengths);
+
+    int literalCount = 286;
+    while (literalCount > 257 && literalLengths[literalCount - 1] == 0) {
+        --literalCount;
+    }
+    int distCount = 30;
+    while (distCount > 1 && distLengths[distCount - 1] == 0) {
+        --distCount;
+    }
+
+    // Run-length encode the code lengths with symbols 16 (repeat), 17 and 18 (zeros)
+    std::vector<uint8_t> allLengths(literalLengths.begin(), literalLengths.begin() + literalCount);
+    allLengths.insert(allLengths.end(), distLengths.begin(), distLengths.begin() + distCount);
+    struct LengthSymbol {
+        uint8_t symbol;
+        uint8_t extra;
+    };
+    std::vector<LengthSymbol> lengthSymbols;
+    size_t i = 0;
+    while (i < allLengths.size()) {
+        uint8_t current = allLengths[i];
+        size_t run = 1;
+        while (i + run < allLengths.size() && allLengths[i + run] == current) {
+            ++run;
+        }
+        i += run;
+        if (current == 0) {
+            while (run >= 11) {
+                size_t chunk = std::min<size_t>(run, 138);
+                lengthSymbols.push_back({18, static_cast<uint8_t>(chunk - 11)});
+                run -= chunk;
+            }
+            if (run >= 3) {
+                lengthSymbols.push_back({17, static_cast<uint8_t>(run - 3)});
+                run = 0;
+            }
+        } else {
+            lengthSymbols.push_back({current, 0});
+            --run;
+            while (run >= 3) {
+                size_t chunk = std::min<size_t>(run, 6);
+                lengthSymbols.push_back({16, static_cast<uint8_t>(chunk - 3)});
+                run -= chunk;
+            }
+        }
+        for (; run > 0; --run) {
+            lengthSymbols.push_back({current, 0});
+        }
+    }
+
+    std::vector<uint32_t> lengthFreqs(19, 0);
+    for (const auto& entry : lengthSymbols) {
+        lengthFreqs[entry.symbol]++;
+    }
+    std::vector<uint8_t> lengthLengths = buildCodeLengths(lengthFreqs, 7);
+    std::vector<uint16_t> lengthCodes = deflateCodes(lengthLengths);
+    int lengthCodeCount = 19;
+    while (lengthCodeCount > 4 && lengthLengths[CODE_LENGTH_ORDER[lengthCodeCount - 1]] == 0) {
+        --lengthCodeCount;
+    }
+
+    uint64_t dynamicBits = 3 + 14 + 3 * static_cast<uint64_t>(lengthCodeCount);
+    for (const auto& entry : lengthSymbols) {
+        dynamicBits += lengthLengths[entry.symbol] +
+                       (entry.symbol == 16 ? 2 : entry.symbol == 17 ? 3 : entry.symbol == 18 ? 7 : 0);
+    }
+    for (int symbol = 0; symbol < 286; ++symbol) {
+        uint32_t extra = symbol > 256 ? LENGTH_EXTRA[symbol - 257] : 0;
+        dynamicBits += static_cast<uint64_t>(literalFreqs[symbol]) * (literalLengths[symbol] + extra);
+    }
+    for (int symbol = 0; symbol < 30; ++symbol) {
+        dynamicBits += static_cast<uint64_t>(distFreqs[symbol]) * (distLengths[symbol] + DIST_EXTRA[symbol]);
+    }
+    // Header, padding and LEN/NLEN per stored block
+    uint64_t storedBits = 8 * static_cast<uint64_t>(size) +
+                          48 * ((size + DEFLATE_MAX_STORED - 1) / DEFLATE_MAX_STORED);
+    if (size > 0 && storedBits < dynamicBits) {
+        writeStoredBlocks(writer, data, size, final);
+        return;
+    }
+
+    writer.put(final ? 1 : 0, 1);
+    writer.put(2, 2);
+    writer.put(literalCount - 257, 5);
+    writer.put(distCount - 1, 5);
+    writer.put(lengthCodeCount - 4, 4);
+    for (int k = 0; k < lengthCodeCount; ++k) {
+        writer.put(lengthLengths[CODE_LENGTH_ORDER[k]], 3);
+    }
+    for (const auto& entry : lengthSymbols) {
+        writer.put(lengthCodes[entry.symbol], lengthLengths[entry.symbol]);
+        if (entry.symbol == 16) {
+            writer.put(entry.extra, 2);
+        } else if (entry.symbol == 17) {
+            writer.put(entry.extra, 3);
+        } else if (entry.symbol == 18) {
+            writer.put(entry.extra, 7);
+        }
+    }
+
+    for (size_t t = 0; t < count; ++t) {
+        const LzToken& token = tokens[t];
+        if (token.distance == 0) {
+            writer.put(literalCodes[token.value], literalLengths[token.value]);
+            continue;
+        }
+        int lengthCode = tables.lengthCode[token.value];
+        writer.put(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+        writer.put(token.value - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+        int distCode = tables.distCode[token.distance];
+        writer.put(distCodes[distCode], distLengths[distCode]);
+        writer.put(token.distance - DIST_BASE[distCode], DIST_EXTRA[distCode]);
+    }
+    writer.put(literalCodes[256], literalLengths[256]);
+}
+
+// zlib stream (RFC 1950) wrapping deflate blocks
+std::vector<uint8_t> zlibCompress(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> out;
+    out.reserve(data.size() / 4 + 64);
+    out.push_back(0x78);
+    out.push_back(0x9C);
+
+    std::vector<LzToken> tokens = findMatches(data.data(), data.size());
+    LsbBitWriter writer(out);
+    if (tokens.empty()) {
+        writeBlock(writer, nullptr, 0, data.data(), 0, true);
+    }
+    size_t offset = 0;
+    for (size_t start = 0; start < tokens.size(); start += DEFLATE_BLOCK_TOKENS) {
+        size_t count = std::min(DEFLATE_BLOCK_TOKENS, tokens.size() - start);
+        size_t covered = 0;
+        for (size_t t = start; t < start + count; ++t) {
+            covered += tokens[t].distance == 0 ? 1 : tokens[t].value;
+        }
+        writeBlock(writer, tokens.data() + start, count, data.data() + offset, covered,
+                   start + count == tokens.size());
+        offset += covered;
+    }
+    writer.flush();
+
+    uint32_t a = 1;
+    uint32_t b = 0;
+    size_t pos = 0;
+    while (pos < data.size()) {
+        // 5552 is the largest run that cannot overflow 32 bits before the modulo
+        size_t end = std::min(data.size(), pos + 5552);
+        for (; pos < end; ++pos) {
+            a += data[pos];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    uint32_t adler = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(adler >> shift));
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// PNG
+// ---------------------------------------------------------------------------
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[n] = c;
+        }
+        return entries;
+    }();
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+void appendBigEndian32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+void appendPngChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& payload) {
+    appendBigEndian32(out, static_cast<uint32_t>(payload.size()));
+    size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), payload.begin(), payload.end());
+    uint32_t crc = crc32Update(0xFFFFFFFFu, out.data() + typeOffset, out.size() - typeOffset) ^ 0xFFFFFFFFu;
+    appendBigEndian32(out, crc);
+}
+
+inline uint8_t paethPredictor(int a, int b, int c) {
+    int pa = std::abs(b - c);
+    int pb = std::abs(a - c);
+    int pc = std::abs(a + b - 2 * c);
+    int nearest = pb <= pc ? b : c;
+    return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : nearest);
+}
+
+// Applies every PNG filter to a row and keeps the one with the smallest
+// sum of absolute (signed) residuals, the usual heuristic for photos and UIs
+void filterRow(const uint8_t* row, const uint8_t* above, size_t rowBytes, std::vector<uint8_t>& scratch, uint8_t* out) {
+    constexpr size_t BPP = 3;
+    // The sixth scratch row stays zero and stands in for the row above the first
+    if (!above) {
+        above = scratch.data() + rowBytes * 5;
+    }
+    uint64_t bestScore = UINT64_MAX;
+    for (uint8_t filter = 0; filter < 5; ++filter) {
+        uint8_t* candidate = scratch.data() + filter * rowBytes;
+        switch (filter) {
+            case 0:
+                std::memcpy(candidate, row, rowBytes);
+                break;
+            case 1:
+                std::memcpy(candidate, row, BPP);
+                for (size_t i = BPP; i < rowBytes; ++i) {
+                    candidate[i] = static_cast<uint8_t>(row[i] - row[i - BPP]);
+                }
+                break;
+            case 2:
+                for (size_t i = 0; i < rowBytes; ++i) {
+                    candidate[i] = static_cast<uint8_t>(row[i] - above[i]);
+                }
+                break;
+            case 3:
+                for (size_t i = 0; i < BPP; ++i) {
+                    candidate[i] = static_cast<uint8_t>(row[i] - (above[i] >> 1));
+                }
+                for (size_t i = BPP; i < rowBytes; ++i) {
+                    candidate[i] = static_cast<uint8_t>(row[i] - ((row[i - BPP] + above[i]) >> 1));
+                }
+                break;
+            default:
+                for (size_t i = 0; i < BPP; ++i) {
+                    candidate[i] = static_cast<uint8_t>(row[i] - above[i]);
+                }
+                for (size_t i = BPP; i < rowBytes; ++i) {
+                    candidate[i] = static_cast<uint8_t>(row[i] - paethPredictor(row[i - BPP], above[i], above[i - BPP]));
+                }
+                break;
+        }
+        uint64_t score = 0;
+        for (size_t i = 0; i < rowBytes; ++i) {
+            score += static_cast<uint64_t>(std::abs(static_cast<int8_t>(candidate[i])));
+        }
+        if (score < bestScore) {
+            bestScore = score;
+            out[0] = filter;
+            std::memcpy(out + 1, candidate, rowBytes);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Baseline JPEG
+// ---------------------------------------------------------------------------
+
+const uint8_t JPEG_ZIGZAG[64] = {
+     0,  1,  5,  6, 14, 15, 27, 28,
+     2,  4,  7, 13, 16, 26, 29, 42,
+     3,  8, 12, 17, 25, 30, 41, 43,
+     9, 11, 18, 24, 31, 40, 44, 53,
+    10, 19, 23, 32, 39, 45, 52, 54,
+    20, 22, 33, 38, 46, 51, 55, 60,
+    21, 34, 37, 47, 50, 56, 59, 61,
+    35, 36, 48, 49, 57, 58, 62, 63
+};
+
+const uint8_t JPEG_LUMA_QUANT[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99
+};
+
+const uint8_t JPEG_CHROMA_QUANT[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+const float AAN_SCALE[8] = {1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+                            1.0f, 0.785694958f, 0.541196100f, 0.275899379f};
+
+// Arai-Agui-Nakajima float DCT on one row or column; output scale is folded into quantization
+inline void fdct8(float* d0, float* d1, float* d2, float* d3, float* d4, float* d5, float* d6, float* d7) {
+    float tmp0 = *d0 + *d7;
+    float tmp7 = *d0 - *d7;
+    float tmp1 = *d1 + *d6;
+    float tmp6 = *d1 - *d6;
+    float tmp2 = *d2 + *d5;
+    float tmp5 = *d2 - *d5;
+    float tmp3 = *d3 + *d4;
+    float tmp4 = *d3 - *d4;
+
+    float tmp10 = tmp0 + tmp3;
+    float tmp13 = tmp0 - tmp3;
+    float tmp11 = tmp1 + tmp2;
+    float tmp12 = tmp1 - tmp2;
+    *d0 = tmp10 + tmp11;
+    *d4 = tmp10 - tmp11;
+    float z1 = (tmp12 + tmp13) * 0.707106781f;
+    *d2 = tmp13 + z1;
+    *d6 = tmp13 - z1;
+
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+    float z5 = (tmp10 - tmp12) * 0.382683433f;
+    float z2 = tmp10 * 0.541196100f + z5;
+    float z4 = tmp12 * 1.306562965f + z5;
+    float z3 = tmp11 * 0.707106781f;
+    float z11 = tmp7 + z3;
+    float z13 = tmp7 - z3;
+    *d5 = z13 + z2;
+    *d3 = z13 - z2;
+    *d1 = z11 + z4;
+    *d7 = z11 - z4;
+}
+
+void forwardDct(float* block) {
+    for (int row = 0; row < 64; row += 8) {
+        float* d = block + row;
+        fdct8(d, d + 1, d + 2, d + 3, d + 4, d + 5, d + 6, d + 7);
+    }
+    for (int col = 0; col < 8; ++col) {
+        float* d = block + col;
+        fdct8(d, d + 8, d + 16, d + 24, d + 32, d + 40, d + 48, d + 56);
+    }
+}
+
+inline int magnitudeCategory(int value) {
+    unsigned magnitude = static_cast<unsigned>(value < 0 ? -value : value);
+    int bits = 0;
+    while (magnitude) {
+        ++bits;
+        magnitude >>= 1;
+    }
+    return bits;
+}
+
+class MsbBitWriter {
+public:
+    explicit MsbBitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void put(uint32_t value, int bits) {
+        m_bits = (m_bits << bits) | (value & ((1u << bits) - 1));
+        m_count += bits;
+        while (m_count >= 8) {
+            uint8_t byte = static_cast<uint8_t>(m_bits >> (m_count - 8));
+            m_out.push_back(byte);
+            if (byte == 0xFF) {
+                m_out.push_back(0x00);   // Byte stuffing inside entropy-coded data
+            }
+            m_count -= 8;
+        }
+        m_bits &= (1u << m_count) - 1;
+    }
+
+    void flush() {
+        put(0x7F, 7);   // Pad with one bits; the incomplete byte is dropped
+        m_bits = 0;
+        m_count = 0;
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint32_t m_bits = 0;
+    int m_count = 0;
+};
+
+struct JpegHuffmanTable {
+    std::vector<uint8_t> lengths;   // Indexed by symbol
+    std::vector<uint16_t> codes;
+};
+
+// Optimal table for one image; symbol 256 reserves the all-ones code that JPEG forbids
+JpegHuffmanTable buildJpegTable(std::vector<uint32_t> freqs) {
+    freqs.resize(257, 0);
+    freqs[256] = 1;
+    JpegHuffmanTable table;
+    table.lengths = buildCodeLengths(freqs, 16);
+    uint8_t longest = *std::max_element(table.lengths.begin(), table.lengths.end());
+    if (table.lengths[256] != longest) {
+        auto it = std::find(table.lengths.begin(), table.lengths.end(), longest);
+        std::swap(*it, table.lengths[256]);
+    }
+    table.codes = assignCanonicalCodes(table.lengths);
+    return table;
+}
+
+void appendJpegMarker(std::vector<uint8_t>& out, uint8_t marker, const std::vector<uint8_t>& payload) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    size_t length = payload.size() + 2;
+    out.push_back(static_cast<uint8_t>(length >> 8));
+    out.push_back(static_cast<uint8_t>(length));
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+void appendHuffmanTable(std::vector<uint8_t>& payload, uint8_t tableClassAndId, const JpegHuffmanTable& table) {
+    payload.push_back(tableClassAndId);
+    std::array<uint8_t, 17> counts{};
+    for (int symbol = 0; symbol < 256; ++symbol) {
+        counts[table.lengths[symbol]]++;
+    }
+    payload.insert(payload.end(), counts.begin() + 1, counts.end());
+    // Canonical codes were assigned in (length, symbol) order, which is the HUFFVAL order
+    for (int bits = 1; bits <= 16; ++bits) {
+        for (int symbol = 0; symbol < 256; ++symbol) {
+            if (table.lengths[symbol] == bits) {
+                payload.push_back(static_cast<uint8_t>(symbol));
+            }
+        }
+    }
+}
+
+// Walks quantized blocks in scan order, either counting symbols or writing them
+class JpegEntropyCoder {
+public:
+    // Tables are indexed 0 = luma, 1 = chroma
+    std::array<std::vector<uint32_t>, 2> dcFreqs{std::vector<uint32_t>(256, 0), std::vector<uint32_t>(256, 0)};
+    std::array<std::vector<uint32_t>, 2> acFreqs{std::vector<uint32_t>(256, 0), std::vector<uint32_t>(256, 0)};
+
+    void encodeBlock(const int16_t* zigzag, int& predictor, int table, MsbBitWriter* writer,
+                     const JpegHuffmanTable* dcTable, const JpegHuffmanTable* acTable) {
+        int diff = zigzag[0] - predictor;
+        predictor = zigzag[0];
+        emit(diff, 0, writer ? &dcTable[table] : nullptr, dcFreqs[table], writer);
+
+        int run = 0;
+        for (int k = 1; k < 64; ++k) {
+            if (zigzag[k] == 0) {
+                ++run;
+                continue;
+            }
+            while (run > 15) {
+                symbol(0xF0, writer ? &acTable[table] : nullptr, acFreqs[table], writer);
+                run -= 16;
+            }
+            emit(zigzag[k], run, writer ? &acTable[table] : nullptr, acFreqs[table], writer);
+            run = 0;
+        }
+        if (run > 0) {
+            symbol(0x00, writer ? &acTable[table] : nullptr, acFreqs[table], writer);
+        }
+    }
+
+private:
+    static void symbol(int value, const JpegHuffmanTable* table, std::vector<uint32_t>& freqs, MsbBitWriter* writer) {
+        if (writer) {
+            writer->put(table->codes[value], table->lengths[value]);
+        } else {
+            freqs[value]++;
+        }
+    }
+
+    static void emit(int value, int run, const JpegHuffmanTable* table, std::vector<uint32_t>& freqs, MsbBitWriter* writer) {
+        int category = magnitudeCategory(value);
+        symbol((run << 4) | category, table, freqs, writer);
+        if (writer && category > 0) {
+            int bits = value < 0 ? value + (1 << category) - 1 : value;
+            writer->put(static_cast<uint32_t>(bits), category);
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Area resampling
+// ---------------------------------------------------------------------------
+
+// Source span and coverage weights for each destination sample
+struct AreaWeights {
+    std::vector<int> start;
+    std::vector<int> count;
+    std::vector<int> offset;
+    std::vector<float> weights;
+};
+
+AreaWeights computeAreaWeights(int sourceSize, int targetSize) {
+    AreaWeights result;
+    result.start.resize(targetSize);
+    result.count.resize(targetSize);
+    result.offset.resize(targetSize);
+    const double scale = static_cast<double>(sourceSize) / targetSize;
+    for (int i = 0; i < targetSize; ++i) {
+        double low = i * scale;
+        double high = std::min<double>(sourceSize, (i + 1) * scale);
+        int first = static_cast<int>(std::floor(low));
+        int last = std::min(sourceSize, static_cast<int>(std::ceil(high)));
+        result.start[i] = first;
+        result.count[i] = last - first;
+        result.offset[i] = static_cast<int>(result.weights.size());
+        for (int j = first; j < last; ++j) {
+            double coverage = std::min<double>(high, j + 1) - std::max<double>(low, j);
+            result.weights.push_back(static_cast<float>(coverage / (high - low)));
+        }
+    }
+    return result;
+}
+
+// accumulator[i] += row[i] * weight
+void accumulateRow(float* accumulator, const uint8_t* row, size_t size, float weight) {
+    size_t i = 0;
+#ifdef BURWELL_IMAGE_SSE2
+    const __m128 w = _mm_set1_ps(weight);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        __m128i high = _mm_unpackhi_epi8(bytes, zero);
+        __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+        __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+        __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+        __m128 f3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+        _mm_storeu_ps(accumulator + i, _mm_add_ps(_mm_loadu_ps(accumulator + i), _mm_mul_ps(f0, w)));
+        _mm_storeu_ps(accumulator + i + 4, _mm_add_ps(_mm_loadu_ps(accumulator + i + 4), _mm_mul_ps(f1, w)));
+        _mm_storeu_ps(accumulator + i + 8, _mm_add_ps(_mm_loadu_ps(accumulator + i + 8), _mm_mul_ps(f2, w)));
+        _mm_storeu_ps(accumulator + i + 12, _mm_add_ps(_mm_loadu_ps(accumulator + i + 12), _mm_mul_ps(f3, w)));
+    }
+#endif
+    for (; i < size; ++i) {
+        accumulator[i] += row[i] * weight;
+    }
+}
+
+inline uint8_t clampToByte(float value) {
+    int rounded = static_cast<int>(value + 0.5f);
+    return static_cast<uint8_t>(std::min(255, std::max(0, rounded)));
+}
+
+} // anonymous namespace
+
+bool ImageCodec::isRawFormat(const std::string& format) {
+    std::string upper = utils::StringUtils::toUpperCase(format);
+    return upper == "RGB" || upper == "BGR" || upper == "RGBA" || upper == "BGRA";
+}
+
+RgbImage ImageCodec::fromRaw(const std::vector<uint8_t>& data, int width, int height, const std::string& format) {
+    RgbImage image;
+    if (width <= 0 || height <= 0 || !isRawFormat(format)) {
+        return image;
+    }
+    std::string upper = utils::StringUtils::toUpperCase(format);
+    const size_t bytesPerPixel = upper.size() == 4 ? 4 : 3;
+    const bool swapRedBlue = upper.compare(0, 3, "BGR") == 0;
+    const size_t tightStride = static_cast<size_t>(width) * bytesPerPixel;
+    const size_t paddedStride = (tightStride + 3) & ~size_t(3);
+    size_t stride;
+    if (data.size() == tightStride * height) {
+        stride = tightStride;
+    } else if (data.size() >= paddedStride * height) {
+        stride = paddedStride;
+    } else {
+        return image;
+    }
+
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 3);
+    uint8_t* out = image.pixels.data();
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* in = data.data() + y * stride;
+        if (!swapRedBlue && bytesPerPixel == 3) {
+            std::memcpy(out, in, tightStride);
+            out += tightStride;
+            continue;
+        }
+        for (int x = 0; x < width; ++x, in += bytesPerPixel, out += 3) {
+            out[0] = swapRedBlue ? in[2] : in[0];
+            out[1] = in[1];
+            out[2] = swapRedBlue ? in[0] : in[2];
+        }
+    }
+    return image;
+}
+
+RgbImage ImageCodec::crop(const RgbImage& image, const ImageRect& rect) {
+    RgbImage result;
+    int left = std::max(0, rect.x);
+    int top = std::max(0, rect.y);
+    int right = std::min(image.width, rect.x + rect.width);
+    int bottom = std::min(image.height, rect.y + rect.height);
+    if (!image.isValid() || right <= left || bottom <= top) {
+        return result;
+    }
+    result.width = right - left;
+    result.height = bottom - top;
+    result.pixels.resize(static_cast<size_t>(result.width) * result.height * 3);
+    const size_t rowBytes = static_cast<size_t>(result.width) * 3;
+    for (int y = 0; y < result.height; ++y) {
+        const uint8_t* in = image.pixels.data() + (static_cast<size_t>(top + y) * image.width + left) * 3;
+        std::memcpy(result.pixels.data() + y * rowBytes, in, rowBytes);
+    }
+    return result;
+}
+
+RgbImage ImageCodec::downscale(const RgbImage& image, int targetWidth, int targetHeight) {
+    if (!image.isValid() || targetWidth <= 0 || targetHeight <= 0 ||
+        (targetWidth >= image.width && targetHeight >= image.height)) {
+        return image;
+    }
+    targetWidth = std::min(targetWidth, image.width);
+    targetHeight = std::min(targetHeight, image.height);
+
+    const AreaWeights columns = computeAreaWeights(image.width, targetWidth);
+    const AreaWeights rows = computeAreaWeights(image.height, targetHeight);
+    const size_t sourceRowBytes = static_cast<size_t>(image.width) * 3;
+
+    RgbImage result;
+    result.width = targetWidth;
+    result.height = targetHeight;
+    result.pixels.resize(static_cast<size_t>(targetWidth) * targetHeight * 3);
+
+    // Vertical pass into a float row (vectorized), then horizontal pass per output pixel
+    std::vector<float> accumulator(sourceRowBytes);
+    for (int y = 0; y < targetHeight; ++y) {
+        std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+        for (int k = 0; k < rows.count[y]; ++k) {
+            const uint8_t* row = image.pixels.data() + static_cast<size_t>(rows.start[y] + k) * sourceRowBytes;
+            accumulateRow(accumulator.data(), row, sourceRowBytes, rows.weights[rows.offset[y] + k]);
+        }
+        uint8_t* out = result.pixels.data() + static_cast<size_t>(y) * targetWidth * 3;
+        for (int x = 0; x < targetWidth; ++x) {
+            float r = 0.0f;
+            float g = 0.0f;
+            float b = 0.0f;
+            const float* in = accumulator.data() + static_cast<size_t>(columns.start[x]) * 3;
+            const float* weights = columns.weights.data() + columns.offset[x];
+            for (int k = 0; k < columns.count[x]; ++k, in += 3) {
+                r += in[0] * weights[k];
+                g += in[1] * weights[k];
+                b += in[2] * weights[k];
+            }
+            out[x * 3] = clampToByte(r);
+            out[x * 3 + 1] = clampToByte(g);
+            out[x * 3 + 2] = clampToByte(b);
+        }
+    }
+    return result;
+}
+
+std::vector<uint8_t> ImageCodec::encodePng(const RgbImage& image) {
+    if (!image.isValid()) {
+        return {};
+    }
+    const size_t rowBytes = static_cast<size_t>(image.width) * 3;
+    std::vector<uint8_t> filtered((rowBytes + 1) * image.height);
+    std::vector<uint8_t> scratch(rowBytes * 6);
+    for (int y = 0; y < image.height; ++y) {
+        const uint8_t* row = image.pixels.data() + y * rowBytes;
+        const uint8_t* above = y > 0 ? row - rowBytes : nullptr;
+        filterRow(row, above, rowBytes, scratch, filtered.data() + y * (rowBytes + 1));
+    }
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> header;
+    appendBigEndian32(header, static_cast<uint32_t>(image.width));
+    appendBigEndian32(header, static_cast<uint32_t>(image.height));
+    header.insert(header.end(), {8, 2, 0, 0, 0});   // 8-bit truecolor, no interlace
+    appendPngChunk(png, "IHDR", header);
+    appendPngChunk(png, "IDAT", zlibCompress(filtered));
+    appendPngChunk(png, "IEND", {});
+    return png;
+}
+
+std::vector<uint8_t> ImageCodec::encodeJpeg(const RgbImage& image, int quality) {
+    if (!image.isValid()) {
+        return {};
+    }
+    quality = std::min(100, std::max(1, quality));
+    const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+
+    uint8_t quant[2][64];
+    float divisors[2][64];
+    for (int i = 0; i < 64; ++i) {
+        int luma = (JPEG_LUMA_QUANT[i] * scale + 50) / 100;
+        int chroma = (JPEG_CHROMA_QUANT[i] * scale + 50) / 100;
+        quant[0][i] = static_cast<uint8_t>(std::min(255, std::max(1, luma)));
+        quant[1][i] = static_cast<uint8_t>(std::min(255, std::max(1, chroma)));
+        float aan = AAN_SCALE[i / 8] * AAN_SCALE[i % 8] * 8.0f;
+        divisors[0][i] = 1.0f / (quant[0][i] * aan);
+        divisors[1][i] = 1.0f / (quant[1][i] * aan);
+    }
+
+    // Transform and quantize every block first so Huffman tables can be fitted to the image
+    const int mcuColumns = (image.width + 15) / 16;
+    const int mcuRows = (image.height + 15) / 16;
+    std::vector<int16_t> coefficients(static_cast<size_t>(mcuColumns) * mcuRows * 6 * 64);
+    int16_t* blockOut = coefficients.data();
+    float blocks[6][64];
+    for (int my = 0; my < mcuRows; ++my) {
+        for (int mx = 0; mx < mcuColumns; ++mx) {
+            std::memset(blocks[4], 0, sizeof(blocks[4]));
+            std::memset(blocks[5], 0, sizeof(blocks[5]));
+            for (int yy = 0; yy < 16; ++yy) {
+                int py = std::min(my * 16 + yy, image.height - 1);
+                const uint8_t* row = image.pixels.data() + static_cast<size_t>(py) * image.width * 3;
+                for (int xx = 0; xx < 16; ++xx) {
+                    int px = std::min(mx * 16 + xx, image.width - 1);
+                    float r = row[px * 3];
+                    float g = row[px * 3 + 1];
+                    float b = row[px * 3 + 2];
+                    int lumaBlock = (yy / 8) * 2 + xx / 8;
+                    blocks[lumaBlock][(yy % 8) * 8 + xx % 8] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+                    int chromaIndex = (yy / 2) * 8 + xx / 2;
+                    blocks[4][chromaIndex] += 0.25f * (-0.168736f * r - 0.331264f * g + 0.5f * b);
+                    blocks[5][chromaIndex] += 0.25f * (0.5f * r - 0.418688f * g - 0.081312f * b);
+                }
+            }
+            for (int block = 0; block < 6; ++block, blockOut += 64) {
+                forwardDct(blocks[block]);
+                const float* divisor = divisors[block < 4 ? 0 : 1];
+                for (int i = 0; i < 64; ++i) {
+                    blockOut[JPEG_ZIGZAG[i]] = static_cast<int16_t>(std::lround(blocks[block][i] * divisor[i]));
+                }
+            }
+        }
+    }
+
+    auto walkBlocks = [&](JpegEntropyCoder& coder, MsbBitWriter* writer, const JpegHuffmanTable* dc, const JpegHuffmanTable* ac) {
+        int predictors[3] = {0, 0, 0};
+        const int16_t* block = coefficients.data();
+        const size_t mcuCount = static_cast<size_t>(mcuColumns) * mcuRows;
+        for (size_t mcu = 0; mcu < mcuCount; ++mcu) {
+            for (int b = 0; b < 6; ++b, block += 64) {
+                int component = b < 4 ? 0 : b - 3;
+                coder.encodeBlock(block, predictors[component], component == 0 ? 0 : 1, writer, dc, ac);
+            }
+        }
+    };
+
+    JpegEntropyCoder coder;
+    walkBlocks(coder, nullptr, nullptr, nullptr);
+    JpegHuffmanTable dcTables[2] = {buildJpegTable(coder.dcFreqs[0]), buildJpegTable(coder.dcFreqs[1])};
+    JpegHuffmanTable acTables[2] = {buildJpegTable(coder.acFreqs[0]), buildJpegTable(coder.acFreqs[1])};
+
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8};
+    appendJpegMarker(jpeg, 0xE0, {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0});
+
+    std::vector<uint8_t> quantTables;
+    for (int table = 0; table < 2; ++table) {
+        quantTables.push_back(static_cast<uint8_t>(table));
+        uint8_t zigzagOrder[64];
+        for (int i = 0; i < 64; ++i) {
+            zigzagOrder[JPEG_ZIGZAG[i]] = quant[table][i];
+        }
+        quantTables.insert(quantTables.end(), zigzagOrder, zigzagOrder + 64);
+    }
+    appendJpegMarker(jpeg, 0xDB, quantTables);
+
+    appendJpegMarker(jpeg, 0xC0, {
+        8,
+        static_cast<uint8_t>(image.height >> 8), static_cast<uint8_t>(image.height),
+        static_cast<uint8_t>(image.width >> 8), static_cast<uint8_t>(image.width),
+        3,
+        1, 0x22, 0,     // Y: 2x2 sampling, quant table 0
+        2, 0x11, 1,     // Cb
+        3, 0x11, 1      // Cr
+    });
+
+    std::vector<uint8_t> huffmanTables;
+    appendHuffmanTable(huffmanTables, 0x00, dcTables[0]);
+    appendHuffmanTable(huffmanTables, 0x10, acTables[0]);
+    appendHuffmanTable(huffmanTables, 0x01, dcTables[1]);
+    appendHuffmanTable(huffmanTables, 0x11, acTables[1]);
+    appendJpegMarker(jpeg, 0xC4, huffmanTables);
+
+    appendJpegMarker(jpeg, 0xDA, {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0});
+
+    jpeg.reserve(jpeg.size() + coefficients.size() / 4);
+    MsbBitWriter writer(jpeg);
+    walkBlocks(coder, &writer, dcTables, acTables);
+    writer.flush();
+
+    jpeg.push_back(0xFF);
+    jpeg.push_back(0xD9);
+    return jpeg;
+}
+
+} // namespace burwell
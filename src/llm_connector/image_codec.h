@@ -0,0 +1,56 @@
+#ifndef BURWELL_IMAGE_CODEC_H
+#define BURWELL_IMAGE_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace burwell {
+
+struct ImageRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool isEmpty() const { return width <= 0 || height <= 0; }
+};
+
+// Packed 8-bit RGB pixels, top-down rows without padding
+struct RgbImage {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+
+    bool isValid() const {
+        return width > 0 && height > 0 && pixels.size() == static_cast<size_t>(width) * height * 3;
+    }
+};
+
+/**
+ * Minimal image pipeline for screenshot payloads: raw capture conversion,
+ * cropping, area downscaling and PNG/baseline JPEG encoding. Decoding is
+ * not supported; already encoded images are passed through by the caller.
+ */
+class ImageCodec {
+public:
+    // Raw pixel layouts understood by fromRaw: "RGB", "BGR", "RGBA", "BGRA"
+    static bool isRawFormat(const std::string& format);
+
+    // Rows may be padded to 4 bytes as in Windows DIBs; the padding is detected from the size
+    static RgbImage fromRaw(const std::vector<uint8_t>& data, int width, int height, const std::string& format);
+
+    static RgbImage crop(const RgbImage& image, const ImageRect& rect);
+
+    // Box-filter (area) resampling; only shrinks, larger targets return a copy
+    static RgbImage downscale(const RgbImage& image, int targetWidth, int targetHeight);
+
+    static std::vector<uint8_t> encodePng(const RgbImage& image);
+
+    // 4:2:0 baseline JPEG with per-image optimized Huffman tables, quality 1-100
+    static std::vector<uint8_t> encodeJpeg(const RgbImage& image, int quality);
+};
+
+} // namespace burwell
+
+#endif // BURWELL_IMAGE_CODEC_H
@@ -0,0 +1,250 @@
+#include "image_preparer.h"
+#include "../common/structured_logger.h"
+#include "../common/string_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace burwell {
+
+namespace {
+
+const int JPEG_QUALITY_STEPS[] = {85, 70, 55, 40};
+constexpr int MAX_DOWNSCALE_STEPS = 4;
+constexpr int MIN_IMAGE_EDGE = 64;
+
+std::string normalizeFormat(const std::string& format) {
+    std::string lower = utils::StringUtils::toLowerCase(format);
+    return lower == "jpg" ? "jpeg" : lower;
+}
+
+// FNV-1a over 64-bit words; only used to tell frames apart in the cache
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+uint64_t hashValue(uint64_t hash, const T& value) {
+    return hashBytes(hash, &value, sizeof(value));
+}
+
+void targetSize(int width, int height, const ImageBudget& budget, int& targetWidth, int& targetHeight) {
+    double scale = 1.0;
+    int longEdge = std::max(width, height);
+    int shortEdge = std::min(width, height);
+    if (budget.maxLongEdge > 0 && longEdge > budget.maxLongEdge) {
+        scale = std::min(scale, static_cast<double>(budget.maxLongEdge) / longEdge);
+    }
+    if (budget.maxShortEdge > 0 && shortEdge > budget.maxShortEdge) {
+        scale = std::min(scale, static_cast<double>(budget.maxShortEdge) / shortEdge);
+    }
+    targetWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+    targetHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+}
+
+} // anonymous namespace
+
+ImagePreparer::ImagePreparer(size_t cacheCapacity)
+    : m_cacheCapacity(std::max<size_t>(1, cacheCapacity))
+    , m_cacheHits(0)
+    , m_cacheMisses(0) {
+}
+
+size_t ImagePreparer::payloadSize(size_t encodedBytes, const std::string& format) {
+    // data:image/<format>;base64,<data>
+    return 11 + format.size() + 8 + 4 * ((encodedBytes + 2) / 3);
+}
+
+std::shared_ptr<const PreparedImage> ImagePreparer::prepare(const ImageSource& source, const ImageBudget& budget) {
+    if (!source.data || source.data->empty()) {
+        return nullptr;
+    }
+
+    uint64_t key = cacheKey(source, budget);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+            if (it->key == key) {
+                m_cache.splice(m_cache.begin(), m_cache, it);
+                ++m_cacheHits;
+                return m_cache.front().image;
+            }
+        }
+        ++m_cacheMisses;
+    }
+
+    // Encode outside the lock; two threads racing on one frame just both encode
+    auto prepared = prepareUncached(source, budget);
+    if (prepared) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache.push_front({key, prepared});
+        if (m_cache.size() > m_cacheCapacity) {
+            m_cache.pop_back();
+        }
+    }
+    return prepared;
+}
+
+void ImagePreparer::clearCache() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache.clear();
+}
+
+size_t ImagePreparer::getCacheHits() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cacheHits;
+}
+
+size_t ImagePreparer::getCacheMisses() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cacheMisses;
+}
+
+uint64_t ImagePreparer::cacheKey(const ImageSource& source, const ImageBudget& budget) {
+    uint64_t hash = 14695981039346656037ull;
+    if (source.frameId != 0) {
+        hash = hashValue(hash, source.frameId);
+    } else {
+        hash = hashBytes(hash, source.data->data(), source.data->size());
+    }
+    hash = hashBytes(hash, source.format.data(), source.format.size());
+    hash = hashValue(hash, source.width);
+    hash = hashValue(hash, source.height);
+    hash = hashValue(hash, source.focus.x);
+    hash = hashValue(hash, source.focus.y);
+    hash = hashValue(hash, source.focus.width);
+    hash = hashValue(hash, source.focus.height);
+    for (const auto& format : budget.formats) {
+        hash = hashBytes(hash, format.data(), format.size());
+        hash = hashValue(hash, '\0');
+    }
+    hash = hashValue(hash, budget.maxPayloadBytes);
+    hash = hashValue(hash, budget.maxLongEdge);
+    hash = hashValue(hash, budget.maxShortEdge);
+    return hash;
+}
+
+std::shared_ptr<const PreparedImage> ImagePreparer::prepareUncached(const ImageSource& source, const ImageBudget& budget) {
+    auto startTime = std::chrono::steady_clock::now();
+    const std::string format = normalizeFormat(source.format);
+
+    bool acceptsPng = false;
+    bool acceptsJpeg = false;
+    bool acceptsSource = false;
+    for (const auto& accepted : budget.formats) {
+        std::string normalized = normalizeFormat(accepted);
+        acceptsPng = acceptsPng || normalized == "png";
+        acceptsJpeg = acceptsJpeg || normalized == "jpeg";
+        acceptsSource = acceptsSource || normalized == format;
+    }
+    auto fits = [&budget](size_t encodedBytes, const std::string& encoding) {
+        return budget.maxPayloadBytes == 0 || payloadSize(encodedBytes, encoding) <= budget.maxPayloadBytes;
+    };
+    auto finish = [&](std::vector<uint8_t> data, const std::string& encoding, int width, int height) {
+        auto prepared = std::make_shared<PreparedImage>();
+        prepared->data = std::move(data);
+        prepared->format = encoding;
+        prepared->width = width;
+        prepared->height = height;
+        prepared->payloadBytes = payloadSize(prepared->data.size(), encoding);
+        prepared->prepareMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - startTime).count();
+        SLOG_DEBUG().message("Prepared image for vision request")
+            .context("source_bytes", source.data->size())
+            .context("payload_bytes", prepared->payloadBytes)
+            .context("format", encoding)
+            .context("width", width)
+            .context("height", height)
+            .context("prepare_ms", prepared->prepareMs);
+        return std::shared_ptr<const PreparedImage>(std::move(prepared));
+    };
+
+    // Already encoded captures cannot be decoded here, so they are forwarded or dropped
+    if (!ImageCodec::isRawFormat(format)) {
+        if (acceptsSource && fits(source.data->size(), format)) {
+            return finish(*source.data, format, source.width, source.height);
+        }
+        SLOG_WARNING().message("Encoded screenshot is unsupported or over budget, sending text only")
+            .context("format", format)
+            .context("bytes", source.data->size())
+            .context("max_payload_bytes", budget.maxPayloadBytes);
+        return nullptr;
+    }
+    if (!acceptsPng && !acceptsJpeg) {
+        SLOG_WARNING().message("Provider accepts neither PNG nor JPEG, sending text only");
+        return nullptr;
+    }
+
+    RgbImage image = ImageCodec::fromRaw(*source.data, source.width, source.height, format);
+    if (!image.isValid()) {
+        SLOG_WARNING().message("Raw screenshot does not match its dimensions")
+            .context("format", format)
+            .context("width", source.width)
+            .context("height", source.height)
+            .context("bytes", source.data->size());
+        return nullptr;
+    }
+    if (!source.focus.isEmpty()) {
+        RgbImage cropped = ImageCodec::crop(image, source.focus);
+        if (cropped.isValid()) {
+            image = std::move(cropped);
+        }
+    }
+    int targetWidth = 0;
+    int targetHeight = 0;
+    targetSize(image.width, image.height, budget, targetWidth, targetHeight);
+    image = ImageCodec::downscale(image, targetWidth, targetHeight);
+
+    for (int step = 0; step <= MAX_DOWNSCALE_STEPS; ++step) {
+        std::vector<uint8_t> best;
+        std::string bestFormat;
+        auto consider = [&](std::vector<uint8_t> encoded, const char* encoding) {
+            if (fits(encoded.size(), encoding) && (bestFormat.empty() || encoded.size() < best.size())) {
+                best = std::move(encoded);
+                bestFormat = encoding;
+            }
+        };
+
+        if (acceptsPng) {
+            consider(ImageCodec::encodePng(image), "png");
+        }
+        if (acceptsJpeg) {
+            for (int quality : JPEG_QUALITY_STEPS) {
+                std::vector<uint8_t> encoded = ImageCodec::encodeJpeg(image, quality);
+                bool fitted = fits(encoded.size(), "jpeg");
+                consider(std::move(encoded), "jpeg");
+                // Only give up quality while nothing fits yet
+                if (fitted || !bestFormat.empty()) {
+                    break;
+                }
+            }
+        }
+        if (!bestFormat.empty()) {
+            return finish(std::move(best), bestFormat, image.width, image.height);
+        }
+
+        int nextWidth = image.width * 3 / 4;
+        int nextHeight = image.height * 3 / 4;
+        if (std::min(nextWidth, nextHeight) < MIN_IMAGE_EDGE) {
+            break;
+        }
+        image = ImageCodec::downscale(image, nextWidth, nextHeight);
+    }
+
+    SLOG_WARNING().message("Screenshot does not fit the provider image budget, sending text only")
+        .context("max_payload_bytes", budget.maxPayloadBytes);
+    return nullptr;
+}
+
+} // namespace burwell
@@ -0,0 +1,78 @@
+#ifndef BURWELL_IMAGE_PREPARER_H
+#define BURWELL_IMAGE_PREPARER_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "image_codec.h"
+
+namespace burwell {
+
+// Limits a provider places on image inputs
+struct ImageBudget {
+    std::vector<std::string> formats;   // Accepted encodings ("png", "jpeg", ...)
+    size_t maxPayloadBytes = 0;         // Size of the base64 data URL; 0 = unlimited
+    int maxLongEdge = 0;                // Resolution the provider resizes to; 0 = unlimited
+    int maxShortEdge = 0;
+};
+
+struct ImageSource {
+    const std::vector<uint8_t>* data = nullptr;
+    std::string format;                 // Raw layout ("RGB", "BGRA", ...) or encoding ("png", "jpeg")
+    int width = 0;
+    int height = 0;
+    uint64_t frameId = 0;               // Capture sequence number; 0 keys the cache by content
+    ImageRect focus;                    // Active window or dirty region; empty = whole frame
+};
+
+struct PreparedImage {
+    std::vector<uint8_t> data;
+    std::string format;                 // "png" or "jpeg"
+    int width = 0;
+    int height = 0;
+    size_t payloadBytes = 0;            // Base64 data URL size sent to the provider
+    double prepareMs = 0.0;
+};
+
+/**
+ * Turns a captured frame into the smallest image a vision provider accepts:
+ * crop to the focus region, area-downscale to the provider resolution, then
+ * encode as PNG and/or JPEG and keep the smallest result under the byte
+ * budget, lowering JPEG quality and resolution until it fits. Results are
+ * cached per frame so retries and re-plans do not re-encode.
+ */
+class ImagePreparer {
+public:
+    explicit ImagePreparer(size_t cacheCapacity = 4);
+
+    // Returns nullptr when no supported encoding fits the budget
+    std::shared_ptr<const PreparedImage> prepare(const ImageSource& source, const ImageBudget& budget);
+
+    static size_t payloadSize(size_t encodedBytes, const std::string& format);
+
+    void clearCache();
+    size_t getCacheHits() const;
+    size_t getCacheMisses() const;
+
+private:
+    struct CacheEntry {
+        uint64_t key;
+        std::shared_ptr<const PreparedImage> image;
+    };
+
+    std::shared_ptr<const PreparedImage> prepareUncached(const ImageSource& source, const ImageBudget& budget);
+    static uint64_t cacheKey(const ImageSource& source, const ImageBudget& budget);
+
+    mutable std::mutex m_mutex;
+    std::list<CacheEntry> m_cache;      // Most recently used first
+    size_t m_cacheCapacity;
+    size_t m_cacheHits;
+    size_t m_cacheMisses;
+};
+
+} // namespace burwell
+
+#endif // BURWELL_IMAGE_PREPARER_H
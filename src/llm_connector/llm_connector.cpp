@@ -5,6 +5,8 @@
 #include "../common/os_utils.h"
 #include "../common/input_validator.h"
 #include "../common/file_utils.h"
+#include "../common/string_utils.h"
+#include "../common/json_stream_writer.h"
 #include <chrono>
 #include <algorithm>
 #include <regex>
@@ -14,6 +16,119 @@
 
 using namespace burwell;
 
+namespace {
+
+// Streamed request bodies are handed to the HTTP client in slices of this size
+constexpr size_t REQUEST_CHUNK_BYTES = 64 * 1024;
+// Image bytes are base64-encoded this many at a time (a multiple of 3, so slices concatenate)
+constexpr size_t BASE64_SLICE_BYTES = 48 * 1024;
+// Bodies carrying at least this much base64 are uploaded chunked instead of buffered
+constexpr size_t CHUNKED_BODY_MIN_IMAGE_BYTES = 1024 * 1024;
+
+void appendBase64(std::string& out, const uint8_t* data, size_t size) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const size_t offset = out.size();
+    out.resize(offset + 4 * ((size + 2) / 3));
+    char* dst = &out[offset];
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t triple = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+        *dst++ = ALPHABET[(triple >> 18) & 0x3F];
+        *dst++ = ALPHABET[(triple >> 12) & 0x3F];
+        *dst++ = ALPHABET[(triple >> 6) & 0x3F];
+        *dst++ = ALPHABET[triple & 0x3F];
+    }
+    if (i < size) {
+        uint32_t triple = uint32_t(data[i]) << 16;
+        if (i + 1 < size) {
+            triple |= uint32_t(data[i + 1]) << 8;
+        }
+        *dst++ = ALPHABET[(triple >> 18) & 0x3F];
+        *dst++ = ALPHABET[(triple >> 12) & 0x3F];
+        *dst++ = i + 1 < size ? ALPHABET[(triple >> 6) & 0x3F] : '=';
+        *dst++ = '=';
+    }
+}
+
+// Turns an OpenAI or Anthropic text/event-stream body back into the generated text
+class StreamedTextDecoder {
+public:
+    explicit StreamedTextDecoder(const LLMConnector::TextSink& onText) : m_onText(onText) {}
+    
+    // False once the consumer stops or the provider reports an error
+    bool feed(const char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            if (data[i] != '\n') {
+                m_line += data[i];
+                continue;
+            }
+            if (!m_line.empty() && m_line.back() == '\r') {
+                m_line.pop_back();
+            }
+            bool ok = onLine();
+            m_line.clear();
+            if (!ok) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    const std::string& text() const { return m_text; }
+    const std::string& error() const { return m_error; }
+    bool stopped() const { return m_stopped; }
+    
+private:
+    bool onLine() {
+        if (m_line.compare(0, 5, "data:") != 0) {
+            return true;  // Event names, comments and keep-alives
+        }
+        size_t start = m_line.size() > 5 && m_line[5] == ' ' ? 6 : 5;
+        if (m_line.compare(start, std::string::npos, "[DONE]") == 0) {
+            return true;
+        }
+        
+        nlohmann::json event = nlohmann::json::parse(m_line.begin() + start, m_line.end(), nullptr, false);
+        if (event.is_discarded() || !event.is_object()) {
+            return true;
+        }
+        if (event.contains("error")) {
+            m_error = event["error"].dump();
+            return false;
+        }
+        
+        const nlohmann::json* delta = nullptr;
+        if (event.contains("choices") && event["choices"].is_array() && !event["choices"].empty()) {
+            const auto& choice = event["choices"][0];
+            if (choice.contains("delta") && choice["delta"].contains("content")) {
+                delta = &choice["delta"]["content"];
+            }
+        } else if (event.value("type", "") == "content_block_delta" && event.contains("delta") &&
+                   event["delta"].contains("text")) {
+            delta = &event["delta"]["text"];
+        }
+        if (!delta || !delta->is_string()) {
+            return true;
+        }
+        
+        const std::string& text = delta->get_ref<const std::string&>();
+        m_text += text;
+        if (m_onText && !m_onText(text)) {
+            m_stopped = true;
+            return false;
+        }
+        return true;
+    }
+    
+    const LLMConnector::TextSink& m_onText;
+    std::string m_line;
+    std::string m_text;
+    std::string m_error;
+    bool m_stopped = false;
+};
+
+} // anonymous namespace
+
 // LLMContext implementations
 nlohmann::json LLMContext::toJson() const {
     nlohmann::json json = {
@@ -46,6 +161,13 @@ void LLMContext::fromJson(const nlohmann::json& json) {
     if (json.contains("screenshotFormat")) screenshotFormat = json["screenshotFormat"];
 }
 
+void LLMContext::setScreenshot(std::vector<uint8_t>&& data, std::string format, int width, int height) {
+    screenshotData = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+    screenshotFormat = std::move(format);
+    screenshotWidth = width;
+    screenshotHeight = height;
+}
+
 // LLMConnector implementation
 LLMConnector::LLMConnector() 
     : m_httpClient(std::make_unique<HttpClient>())
@@ -227,37 +349,91 @@ ExecutionPlan LLMConnector::generatePlan(const std::string& userRequest, const L
 }
 
 nlohmann::json LLMConnector::sendMessage(const std::vector<LLMMessage>& messages) {
+    return sendMessage(messages, ShutdownManager::getInstance().getToken());
+}
+
+nlohmann::json LLMConnector::sendMessage(const std::vector<LLMMessage>& messages, const CancellationToken& cancellation) {
+    return sendRequest(messages, nullptr, cancellation);
+}
+
+nlohmann::json LLMConnector::sendMessageStreaming(const std::vector<LLMMessage>& messages, const TextSink& onText,
+                                                  const CancellationToken& cancellation) {
+    return sendRequest(messages, &onText, cancellation);
+}
+
+nlohmann::json LLMConnector::sendRequest(const std::vector<LLMMessage>& messages, const TextSink* onText,
+                                         const CancellationToken& cancellation) {
     try {
         if (m_apiKey.empty()) {
             setError(401, "API key not configured", "AUTHENTICATION", false);
             return nlohmann::json{{"error", "No API key configured"}};
         }
         
-        // Create request payload based on provider
-        nlohmann::json requestPayload;
-        switch (m_provider) {
-            case Provider::OPENAI:
-            case Provider::AZURE_OPENAI:
-                requestPayload = createOpenAIRequest(messages);
-                break;
-            case Provider::ANTHROPIC:
-                requestPayload = createAnthropicRequest(messages);
-                break;
-            case Provider::CUSTOM:
-                requestPayload = createRequestPayload(messages);
-                break;
-        }
-        
         // Send HTTP request
-        std::string endpoint = getApiEndpoint();
-        std::map<std::string, std::string> headers = getRequestHeaders();
+        HttpRequest request;
+        request.url = getApiEndpoint();
+        request.method = "POST";
+        request.headers = getRequestHeaders();
+        request.timeoutMs = m_timeoutMs;
+        request.cancellation = cancellation;
+        
+        size_t imageBytes = 0;
+        for (const auto& msg : messages) {
+            if (msg.hasImage()) {
+                imageBytes += ImagePreparer::payloadSize(msg.imageData->size(), msg.imageFormat);
+            }
+        }
+        bool stream = onText != nullptr;
+        // Set when the body itself is unusable rather than the upload failing
+        bool invalidBody = false;
+        auto writeBody = [this, &messages, stream, &invalidBody](const HttpRequest::BodySink& sink) {
+            bool sinkFailed = false;
+            bool written = writeRequestBody(messages, [&sink, &sinkFailed](const char* data, size_t size) {
+                sinkFailed = !sink(data, size);
+                return !sinkFailed;
+            }, stream);
+            invalidBody = !written && !sinkFailed;
+            return written;
+        };
+        auto rejectInvalidBody = [this] {
+            setError(400, "Request contains invalid UTF-8 text", "INVALID_REQUEST", false);
+            return nlohmann::json{{"error", "Invalid request text"}};
+        };
+        
+        std::unique_ptr<StreamedTextDecoder> decoder;
+        if (stream) {
+            decoder = std::make_unique<StreamedTextDecoder>(*onText);
+            request.headers["Accept"] = "text/event-stream";
+            request.responseSink = [&decoder](const char* data, size_t size) {
+                return decoder->feed(data, size);
+            };
+        }
         
         SLOG_DEBUG().message("LLM Request")
-            .context("url", endpoint);
-        SLOG_DEBUG().message("LLM Request Payload")
-            .context("payload", requestPayload);
+            .context("url", request.url)
+            .context("messages", messages.size())
+            .context("image_bytes", imageBytes);
         
-        HttpResponse response = m_httpClient->post(endpoint, requestPayload.dump(), headers);
+        if (imageBytes >= CHUNKED_BODY_MIN_IMAGE_BYTES) {
+            SLOG_DEBUG().message("LLM Request Payload").context("transfer", "chunked");
+            request.streamBody = writeBody;
+        } else {
+            request.body.reserve(imageBytes + 4096);
+            if (!writeBody([&request](const char* data, size_t size) {
+                    request.body.append(data, size);
+                    return true;
+                })) {
+                return rejectInvalidBody();
+            }
+            SLOG_DEBUG().message("LLM Request Payload")
+                .context("body_length", request.body.length())
+                .context("body_preview", request.body.substr(0, 200));
+        }
+        HttpResponse response = m_httpClient->request(request);
+        if (invalidBody) {
+            // Found mid-upload; the client gave up without retrying
+            return rejectInvalidBody();
+        }
         
         SLOG_DEBUG().message("LLM Response")
             .context("status_code", response.statusCode);
@@ -265,11 +441,31 @@ nlohmann::json LLMConnector::sendMessage(const std::vector<LLMMessage>& messages
             .context("body_length", response.body.length())
             .context("body_preview", response.body.substr(0, 200));
         
+        if (!response.success && cancellation.isCancelled()) {
+            return nlohmann::json{{"error", "Request cancelled"}};
+        }
+        if (decoder && !decoder->error().empty()) {
+            setError(response.statusCode, decoder->error(), "STREAM_ERROR", false);
+            return nlohmann::json{{"error", "LLM stream reported an error"}};
+        }
+        if (decoder && decoder->stopped()) {
+            return nlohmann::json{{"error", "Response stream stopped"}};
+        }
         if (!response.success) {
             handleHttpError(response);
             return nlohmann::json{{"error", "HTTP error occurred"}};
         }
         
+        if (decoder) {
+            addRequestTime();
+            m_totalRequests++;
+            // Same shape as the non-streamed response, so the existing parsers apply
+            if (m_provider == Provider::ANTHROPIC) {
+                return nlohmann::json{{"content", {{{"type", "text"}, {"text", decoder->text()}}}}};
+            }
+            return nlohmann::json{{"choices", {{{"message", {{"role", "assistant"}, {"content", decoder->text()}}}}}}};
+        }
+        
         // Parse JSON response
         nlohmann::json jsonResponse = nlohmann::json::parse(response.body);
         
@@ -290,9 +486,20 @@ nlohmann::json LLMConnector::sendMessage(const std::vector<LLMMessage>& messages
 }
 
 nlohmann::json LLMConnector::sendPrompt(const std::string& prompt) {
+    return sendPrompt(prompt, ShutdownManager::getInstance().getToken());
+}
+
+nlohmann::json LLMConnector::sendPrompt(const std::string& prompt, const CancellationToken& cancellation) {
     std::vector<LLMMessage> messages;
     messages.emplace_back("user", prompt);
-    return sendMessage(messages);
+    return sendMessage(messages, cancellation);
+}
+
+nlohmann::json LLMConnector::sendPromptStreaming(const std::string& prompt, const TextSink& onText,
+                                                 const CancellationToken& cancellation) {
+    std::vector<LLMMessage> messages;
+    messages.emplace_back("user", prompt);
+    return sendMessageStreaming(messages, onText, cancellation);
 }
 
 std::string LLMConnector::buildSystemPrompt(const LLMContext& context) {
@@ -335,15 +542,15 @@ std::string LLMConnector::substituteTemplateVariables(const std::string& templat
     
     // Replace {{COMMAND_REFERENCE}} with available commands
     std::string commandReference = generateCommandReference();
-    result = replaceAll(result, "{{COMMAND_REFERENCE}}", commandReference);
+    utils::StringUtils::replaceAllInPlace(result, "{{COMMAND_REFERENCE}}", commandReference);
     
     // Replace {{CONTEXT}} with current system context
     std::string contextInfo = generateContextInfo(context);
-    result = replaceAll(result, "{{CONTEXT}}", contextInfo);
+    utils::StringUtils::replaceAllInPlace(result, "{{CONTEXT}}", contextInfo);
     
     // Add more variable substitutions as needed
-    result = replaceAll(result, "{{SYSTEM_NAME}}", "Burwell");
-    result = replaceAll(result, "{{VERSION}}", "1.0.0");
+    utils::StringUtils::replaceAllInPlace(result, "{{SYSTEM_NAME}}", "Burwell");
+    utils::StringUtils::replaceAllInPlace(result, "{{VERSION}}", "1.0.0");
     
     return result;
 }
@@ -496,16 +703,6 @@ std::string LLMConnector::generateContextInfo(const LLMContext& context) {
     return contextInfo.str();
 }
 
-std::string LLMConnector::replaceAll(const std::string& str, const std::string& from, const std::string& to) {
-    std::string result = str;
-    size_t startPos = 0;
-    while ((startPos = result.find(from, startPos)) != std::string::npos) {
-        result.replace(startPos, from.length(), to);
-        startPos += to.length();
-    }
-    return result;
-}
-
 // Removed hardcoded fallback - system now uses configurable templates only
 
 ExecutionPlan LLMConnector::parseResponse(const nlohmann::json& response) {
@@ -755,8 +952,7 @@ std::string LLMConnector::applyCleaningRules(const std::string& content, const n
         // Apply text transformations
         if (rule.contains("trim_whitespace") && rule["trim_whitespace"].get<bool>()) {
             // Trim leading and trailing whitespace
-            cleaned.erase(0, cleaned.find_first_not_of(" \t\n\r"));
-            cleaned.erase(cleaned.find_last_not_of(" \t\n\r") + 1);
+            utils::StringUtils::trimInPlace(cleaned);
         }
         
         if (rule.contains("normalize_line_endings") && rule["normalize_line_endings"].get<bool>()) {
@@ -958,55 +1154,6 @@ ExecutionPlan LLMConnector::parseAnthropicResponse(const nlohmann::json& respons
     return plan;
 }
 
-nlohmann::json LLMConnector::createOpenAIRequest(const std::vector<LLMMessage>& messages) {
-    nlohmann::json request;
-    
-    request["model"] = m_modelName;
-    request["temperature"] = m_temperature;
-    request["max_tokens"] = m_maxTokens;
-    
-    nlohmann::json jsonMessages = nlohmann::json::array();
-    for (const auto& msg : messages) {
-        jsonMessages.push_back({
-            {"role", msg.role},
-            {"content", msg.content}
-        });
-    }
-    request["messages"] = jsonMessages;
-    
-    return request;
-}
-
-nlohmann::json LLMConnector::createAnthropicRequest(const std::vector<LLMMessage>& messages) {
-    nlohmann::json request;
-    
-    request["model"] = m_modelName;
-    request["max_tokens"] = m_maxTokens;
-    request["temperature"] = m_temperature;
-    
-    // Anthropic format is different - separate system message
-    std::string systemMessage;
-    nlohmann::json jsonMessages = nlohmann::json::array();
-    
-    for (const auto& msg : messages) {
-        if (msg.role == "system") {
-            systemMessage = msg.content;
-        } else {
-            jsonMessages.push_back({
-                {"role", msg.role},
-                {"content", msg.content}
-            });
-        }
-    }
-    
-    if (!systemMessage.empty()) {
-        request["system"] = systemMessage;
-    }
-    request["messages"] = jsonMessages;
-    
-    return request;
-}
-
 ExecutionPlan LLMConnector::simulateLLMResponse(const std::string& request) {
     (void)request; // TODO: Use request to generate context-aware simulation
     ExecutionPlan plan;
@@ -1061,8 +1208,9 @@ void LLMConnector::setCustomHeaders(const std::map<std::string, std::string>& he
 
 // Context and history management
 void LLMConnector::updateContext(const LLMContext& context) { m_context = context; }
-void LLMConnector::addToHistory(const LLMMessage& message) {
-    m_messageHistory.push_back(message);
+void LLMConnector::addToHistory(LLMMessage message) {
+    // Image messages keep a reference to the shared buffer, never a copy
+    m_messageHistory.push_back(std::move(message));
     if (m_messageHistory.size() > m_maxHistorySize) {
         m_messageHistory.erase(m_messageHistory.begin());
     }
@@ -1206,7 +1354,148 @@ void LLMConnector::setError(int code, const std::string& message, const std::str
 LLMConnector::LLMError LLMConnector::getLastError() const { return m_lastError; }
 
 // Simple implementations for remaining methods
-nlohmann::json LLMConnector::createRequestPayload(const std::vector<LLMMessage>& messages) { return createOpenAIRequest(messages); }
+
+
+bool LLMConnector::writeRequestBody(const std::vector<LLMMessage>& messages, const HttpRequest::BodySink& sink,
+                                    bool stream) const {
+    // The only definition of the request format: OpenAI-style messages, or for
+    // Anthropic a top-level system prompt and bare base64 image sources. Keys are
+    // written in dump() order and flushed to the sink as the buffer fills
+    std::string buffer;
+    buffer.reserve(REQUEST_CHUNK_BYTES + BASE64_SLICE_BYTES / 3 * 4 + 1024);
+    utils::JsonStreamWriter writer(buffer);
+    bool sinkOk = true;
+    auto flush = [&](bool force) {
+        // Invalid UTF-8 would have made dump() throw; stop before any of it is sent
+        if (!writer.ok()) {
+            return false;
+        }
+        if (sinkOk && !buffer.empty() && (force || buffer.size() >= REQUEST_CHUNK_BYTES)) {
+            sinkOk = sink(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+        return sinkOk;
+    };
+    
+    auto writeImage = [&](const LLMMessage& msg, bool asDataUrl) {
+        writer.beginRawString();
+        if (asDataUrl) {
+            buffer += "data:image/";
+            buffer += msg.imageFormat;
+            buffer += ";base64,";
+        }
+        const std::vector<uint8_t>& data = *msg.imageData;
+        for (size_t offset = 0; offset < data.size() && flush(false); offset += BASE64_SLICE_BYTES) {
+            appendBase64(buffer, data.data() + offset, std::min(BASE64_SLICE_BYTES, data.size() - offset));
+        }
+        writer.endRawString();
+    };
+    auto writeTextMessage = [&](const LLMMessage& msg) {
+        writer.beginObject();
+        writer.key("content");
+        writer.value(msg.content);
+        writer.key("role");
+        writer.value(msg.role);
+        writer.endObject();
+    };
+    
+    writer.beginObject();
+    writer.key("max_tokens");
+    writer.value(m_maxTokens);
+    writer.key("messages");
+    writer.beginArray();
+    
+    std::string systemMessage;
+    if (m_provider == Provider::ANTHROPIC) {
+        for (const auto& msg : messages) {
+            if (msg.role == "system") {
+                systemMessage = msg.content;
+            } else if (msg.hasImage()) {
+                writer.beginObject();
+                writer.key("content");
+                writer.beginArray();
+                writer.beginObject();
+                writer.key("source");
+                writer.beginObject();
+                writer.key("data");
+                writeImage(msg, false);
+                writer.key("media_type");
+                writer.value("image/" + msg.imageFormat);
+                writer.key("type");
+                writer.value("base64");
+                writer.endObject();
+                writer.key("type");
+                writer.value("image");
+                writer.endObject();
+                writer.beginObject();
+                writer.key("text");
+                writer.value(msg.content);
+                writer.key("type");
+                writer.value("text");
+                writer.endObject();
+                writer.endArray();
+                writer.key("role");
+                writer.value(msg.role);
+                writer.endObject();
+            } else {
+                writeTextMessage(msg);
+            }
+            if (!flush(false)) {
+                return false;
+            }
+        }
+    } else {
+        for (const auto& msg : messages) {
+            if (msg.hasImage()) {
+                writer.beginObject();
+                writer.key("content");
+                writer.beginArray();
+                writer.beginObject();
+                writer.key("text");
+                writer.value(msg.content);
+                writer.key("type");
+                writer.value("text");
+                writer.endObject();
+                writer.beginObject();
+                writer.key("image_url");
+                writer.beginObject();
+                writer.key("url");
+                writeImage(msg, true);
+                writer.endObject();
+                writer.key("type");
+                writer.value("image_url");
+                writer.endObject();
+                writer.endArray();
+                writer.key("role");
+                writer.value(msg.role);
+                writer.endObject();
+            } else {
+                writeTextMessage(msg);
+            }
+            if (!flush(false)) {
+                return false;
+            }
+        }
+    }
+    
+    writer.endArray();
+    writer.key("model");
+    writer.value(m_modelName);
+    if (stream) {
+        writer.key("stream");
+        writer.value(true);
+    }
+    if (!systemMessage.empty()) {
+        writer.key("system");
+        writer.value(systemMessage);
+    }
+    writer.key("temperature");
+    writer.value(m_temperature);
+    writer.endObject();
+    
+    return flush(true);
+}
+
 bool LLMConnector::validateConfiguration() { return !m_apiKey.empty() && !m_baseUrl.empty(); }
 bool LLMConnector::testConnection() { return validateConfiguration(); }
 void LLMConnector::setRateLimit(int requestsPerMinute) { m_requestsPerMinute = requestsPerMinute; }
@@ -1227,6 +1516,26 @@ bool LLMConnector::supportsVision() const {
     return m_visionCapabilities.supportsVision;
 }
 
+std::shared_ptr<const PreparedImage> LLMConnector::prepareScreenshot(const LLMContext& context) {
+    ImageSource source;
+    source.data = context.screenshotData.get();
+    source.format = context.screenshotFormat;
+    source.width = context.screenshotWidth;
+    source.height = context.screenshotHeight;
+    source.frameId = context.screenshotFrameId;
+    if (m_visionCapabilities.cropToFocus) {
+        source.focus = context.screenshotFocus;
+    }
+    
+    ImageBudget budget;
+    budget.formats = m_visionCapabilities.supportedImageFormats;
+    budget.maxPayloadBytes = static_cast<size_t>(std::max(0, m_visionCapabilities.maxImageSize));
+    budget.maxLongEdge = m_visionCapabilities.maxImageLongEdge;
+    budget.maxShortEdge = m_visionCapabilities.maxImageShortEdge;
+    
+    return m_imagePreparer.prepare(source, budget);
+}
+
 // Dual-mode LLM interface implementation
 ExecutionPlan LLMConnector::generatePlanWithContext(const std::string& userRequest, const LLMContext& context) {
     ExecutionPlan plan;
@@ -1244,10 +1553,18 @@ ExecutionPlan LLMConnector::generatePlanWithContext(const std::string& userReque
         // Build user message with appropriate context format
         std::string userMessage = buildContextualPrompt(userRequest, context);
         
+        std::shared_ptr<const PreparedImage> screenshot;
         if (supportsVision() && context.hasScreenshot()) {
+            screenshot = prepareScreenshot(context);
+        }
+        
+        if (screenshot) {
             // Vision-capable LLM: Send screenshot + structured data
-            SLOG_DEBUG().message("Sending visual data to vision-capable LLM");
-            messages.emplace_back("user", userMessage, context.screenshotData, context.screenshotFormat);
+            SLOG_DEBUG().message("Sending visual data to vision-capable LLM")
+                .context("payload_bytes", screenshot->payloadBytes)
+                .context("format", screenshot->format);
+            // Alias the cached prepared image instead of copying its bytes
+            messages.emplace_back("user", userMessage, ImageBuffer(screenshot, &screenshot->data), screenshot->format);
         } else {
             // Text-only LLM: Send comprehensive text description
             SLOG_DEBUG().message("Sending text description to text-only LLM");
@@ -1342,19 +1659,19 @@ std::string LLMConnector::substituteContextualVariables(const std::string& templ
     std::string result = templateContent;
     
     // Replace user request
-    result = replaceAll(result, "{{USER_REQUEST}}", userRequest);
+    utils::StringUtils::replaceAllInPlace(result, "{{USER_REQUEST}}", userRequest);
     
     // Replace system context
     std::string systemContext = generateContextInfo(context);
-    result = replaceAll(result, "{{SYSTEM_CONTEXT}}", systemContext);
+    utils::StringUtils::replaceAllInPlace(result, "{{SYSTEM_CONTEXT}}", systemContext);
     
     // Replace screen description for text-only models
     std::string screenDescription = context.textDescription.empty() ? generateContextInfo(context) : context.textDescription;
-    result = replaceAll(result, "{{SCREEN_DESCRIPTION}}", screenDescription);
+    utils::StringUtils::replaceAllInPlace(result, "{{SCREEN_DESCRIPTION}}", screenDescription);
     
     // Replace structured context data
     std::string structuredContext = generateStructuredContext(context);
-    result = replaceAll(result, "{{STRUCTURED_CONTEXT}}", structuredContext);
+    utils::StringUtils::replaceAllInPlace(result, "{{STRUCTURED_CONTEXT}}", structuredContext);
     
     return result;
 }
@@ -1378,49 +1695,10 @@ std::string LLMConnector::generateStructuredContext(const LLMContext& context) {
 // Removed hardcoded fallback - system now uses configurable templates only
 
 std::string LLMConnector::encodeImageAsBase64(const std::vector<uint8_t>& imageData, const std::string& format) {
-    // Basic base64 encoding implementation
-    static const std::string chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    std::string result;
-    
-    size_t i = 0;
-    uint8_t char_array_3[3];
-    uint8_t char_array_4[4];
-    
-    for (size_t idx = 0; idx < imageData.size(); idx++) {
-        char_array_3[i++] = imageData[idx];
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-            
-            for (i = 0; i < 4; i++) {
-                result += chars[char_array_4[i]];
-            }
-            i = 0;
-        }
-    }
-    
-    if (i) {
-        for (size_t j = i; j < 3; j++) {
-            char_array_3[j] = '\0';
-        }
-        
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
-        
-        for (size_t j = 0; j < i + 1; j++) {
-            result += chars[char_array_4[j]];
-        }
-        
-        while (i++ < 3) {
-            result += '=';
-        }
-    }
-    
-    return "data:image/" + format + ";base64," + result;
+    std::string result = "data:image/" + format + ";base64,";
+    result.reserve(result.size() + 4 * ((imageData.size() + 2) / 3));
+    appendBase64(result, imageData.data(), imageData.size());
+    return result;
 }
 
 void LLMConnector::initializeVisionCapabilities(const nlohmann::json& providerConfig) {
@@ -1430,6 +1708,9 @@ void LLMConnector::initializeVisionCapabilities(const nlohmann::json& providerCo
     m_visionCapabilities.maxImageSize = 0;
     m_visionCapabilities.maxContextLength = 4096;
     m_visionCapabilities.preferredInputMode = "text";
+    m_visionCapabilities.maxImageLongEdge = 1568;
+    m_visionCapabilities.maxImageShortEdge = 0;
+    m_visionCapabilities.cropToFocus = true;
     
     // Load vision capabilities from provider configuration first
     if (!providerConfig.empty() && 
@@ -1471,14 +1752,23 @@ void LLMConnector::initializeVisionCapabilities(const nlohmann::json& providerCo
             m_visionCapabilities.preferredInputMode = "text";
         }
         
+        if (visionConfig.contains("max_image_long_edge") && visionConfig["max_image_long_edge"].is_number()) {
+            m_visionCapabilities.maxImageLongEdge = visionConfig["max_image_long_edge"].get<int>();
+        }
+        if (visionConfig.contains("max_image_short_edge") && visionConfig["max_image_short_edge"].is_number()) {
+            m_visionCapabilities.maxImageShortEdge = visionConfig["max_image_short_edge"].get<int>();
+        }
+        if (visionConfig.contains("crop_to_focus") && visionConfig["crop_to_focus"].is_boolean()) {
+            m_visionCapabilities.cropToFocus = visionConfig["crop_to_focus"].get<bool>();
+        }
+        
         SLOG_INFO().message("Vision capabilities loaded from provider configuration")
             .context("vision_support", m_visionCapabilities.supportsVision ? "enabled" : "disabled");
     } else {
         // Fallback to model name detection if provider config doesn't specify capabilities
         SLOG_DEBUG().message("No provider vision config found, using model name detection");
         
-        std::string lowerModelName = m_modelName;
-        std::transform(lowerModelName.begin(), lowerModelName.end(), lowerModelName.begin(), ::tolower);
+        std::string lowerModelName = utils::StringUtils::toLowerCase(m_modelName);
         
         // GPT-4 Vision models
         if (lowerModelName.find("gpt-4") != std::string::npos && 
@@ -1491,6 +1781,8 @@ void LLMConnector::initializeVisionCapabilities(const nlohmann::json& providerCo
             m_visionCapabilities.maxImageSize = 20971520; // 20MB
             m_visionCapabilities.maxContextLength = 128000;
             m_visionCapabilities.preferredInputMode = "hybrid";
+            m_visionCapabilities.maxImageLongEdge = 2048;  // Fit in 2048x2048, then 768 short side
+            m_visionCapabilities.maxImageShortEdge = 768;
             
             SLOG_INFO().message("Vision capabilities auto-detected for GPT-4 Vision model");
         }
@@ -1501,6 +1793,7 @@ void LLMConnector::initializeVisionCapabilities(const nlohmann::json& providerCo
             m_visionCapabilities.maxImageSize = 5242880; // 5MB
             m_visionCapabilities.maxContextLength = 200000;
             m_visionCapabilities.preferredInputMode = "hybrid";
+            m_visionCapabilities.maxImageLongEdge = 1568;
             
             SLOG_INFO().message("Vision capabilities auto-detected for Claude-3 model");
         }
@@ -1524,6 +1817,7 @@ void LLMConnector::initializeVisionCapabilities(const nlohmann::json& providerCo
             }
             
             m_visionCapabilities.preferredInputMode = "hybrid";
+            m_visionCapabilities.maxImageLongEdge = 3072;
         }
         // Text-only models (Llama, Mixtral, etc.)
         else {
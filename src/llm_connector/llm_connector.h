@@ -5,22 +5,30 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include "http_client.h"
+#include "image_preparer.h"
 
 namespace burwell {
 
+// Encoded image bytes shared by messages, history and the prepared image cache
+using ImageBuffer = std::shared_ptr<const std::vector<uint8_t>>;
+
 struct LLMMessage {
     std::string role;  // "system", "user", "assistant"
     std::string content;
-    std::vector<uint8_t> imageData;  // For vision-capable LLMs
-    std::string imageFormat;         // "png", "jpeg", "base64"
+    ImageBuffer imageData;           // For vision-capable LLMs; immutable, shared instead of copied
+    std::string imageFormat;         // "png", "jpeg"
     
-    LLMMessage(const std::string& r, const std::string& c) : role(r), content(c), imageFormat("") {}
-    LLMMessage(const std::string& r, const std::string& c, const std::vector<uint8_t>& img, const std::string& fmt) 
-        : role(r), content(c), imageData(img), imageFormat(fmt) {}
+    LLMMessage(std::string r, std::string c) : role(std::move(r)), content(std::move(c)) {}
+    LLMMessage(std::string r, std::string c, ImageBuffer img, std::string fmt)
+        : role(std::move(r)), content(std::move(c)), imageData(std::move(img)), imageFormat(std::move(fmt)) {}
+    LLMMessage(std::string r, std::string c, std::vector<uint8_t>&& img, std::string fmt)
+        : role(std::move(r)), content(std::move(c))
+        , imageData(std::make_shared<const std::vector<uint8_t>>(std::move(img))), imageFormat(std::move(fmt)) {}
     
-    bool hasImage() const { return !imageData.empty(); }
+    bool hasImage() const { return imageData && !imageData->empty(); }
 };
 
 struct ExecutionPlan {
@@ -40,12 +48,19 @@ struct LLMContext {
     std::vector<std::string> recentActions;
     
     // Vision-related data
-    std::vector<uint8_t> screenshotData;
-    std::string screenshotFormat;
+    ImageBuffer screenshotData;         // Shared, so copying the context never copies pixels
+    std::string screenshotFormat;       // "RGB"/"BGR"/"RGBA"/"BGRA" raw pixels, or "png"/"jpeg"
+    int screenshotWidth = 0;            // Required to interpret raw pixel formats
+    int screenshotHeight = 0;
+    // Set by whoever captures the screen. No built target does yet: the orchestrator
+    // plans through text prompts, so only generatePlanWithContext callers see these.
+    uint64_t screenshotFrameId = 0;     // Capture sequence number; keys the prepared image cache (0 = hash the pixels)
+    ImageRect screenshotFocus;          // Active window or dirty region to crop to; empty = full screen
     std::string textDescription;        // Comprehensive text description for text-only LLMs
     nlohmann::json structuredData;      // Structured environmental data
     
-    bool hasScreenshot() const { return !screenshotData.empty(); }
+    bool hasScreenshot() const { return screenshotData && !screenshotData->empty(); }
+    void setScreenshot(std::vector<uint8_t>&& data, std::string format, int width, int height);
     
     nlohmann::json toJson() const;
     void fromJson(const nlohmann::json& json);
@@ -60,10 +75,22 @@ public:
     ExecutionPlan generatePlan(const std::string& userRequest, const LLMContext& context);
     nlohmann::json sendMessage(const std::vector<LLMMessage>& messages);
     nlohmann::json sendPrompt(const std::string& prompt);
+    // Cancelling the token aborts the HTTP transfer and any retry delay
+    nlohmann::json sendMessage(const std::vector<LLMMessage>& messages, const CancellationToken& cancellation);
+    nlohmann::json sendPrompt(const std::string& prompt, const CancellationToken& cancellation);
+    
+    // Receives response text as the provider streams it; returning false stops the transfer
+    using TextSink = std::function<bool(const std::string& text)>;
+    // Asks the provider to stream and hands every text delta to onText as it arrives.
+    // Returns the same response shape as sendMessage, built from the streamed text.
+    nlohmann::json sendMessageStreaming(const std::vector<LLMMessage>& messages, const TextSink& onText,
+                                        const CancellationToken& cancellation);
+    nlohmann::json sendPromptStreaming(const std::string& prompt, const TextSink& onText,
+                                       const CancellationToken& cancellation);
     
     // Context management
     void updateContext(const LLMContext& context);
-    void addToHistory(const LLMMessage& message);
+    void addToHistory(LLMMessage message);
     void clearHistory();
     std::vector<LLMMessage> getHistory() const;
     
@@ -94,15 +121,19 @@ public:
         int maxImageSize;                                // Maximum image size in bytes
         int maxContextLength;                            // Maximum context tokens
         std::string preferredInputMode;                  // "vision", "text", "hybrid"
+        int maxImageLongEdge;                            // Provider resize target; larger images waste upload
+        int maxImageShortEdge;                           // 0 = no short edge limit
+        bool cropToFocus;                                // Crop screenshots to LLMContext::screenshotFocus
         
-        VisionCapabilities() : supportsVision(false), maxImageSize(4194304), maxContextLength(4096), preferredInputMode("text") {}
+        VisionCapabilities() : supportsVision(false), maxImageSize(4194304), maxContextLength(4096), preferredInputMode("text"),
+                               maxImageLongEdge(1568), maxImageShortEdge(0), cropToFocus(true) {}
     };
     
     void setVisionCapabilities(const VisionCapabilities& capabilities);
     VisionCapabilities getVisionCapabilities() const;
     bool supportsVision() const;
     
-    // Dual-mode LLM interface
+    // Dual-mode LLM interface; the only path that attaches screenshots (unused by the orchestrator so far)
     ExecutionPlan generatePlanWithContext(const std::string& userRequest, const LLMContext& context);
     std::string buildContextualPrompt(const std::string& userRequest, const LLMContext& context);
     std::string encodeImageAsBase64(const std::vector<uint8_t>& imageData, const std::string& format);
@@ -128,6 +159,11 @@ public:
     };
     
     LLMError getLastError() const;
+    
+    // Serializes the provider request straight into the sink; the one place the request format is defined.
+    // Returns false when the sink stops or a message is not valid UTF-8 (nothing is written past it)
+    bool writeRequestBody(const std::vector<LLMMessage>& messages, const HttpRequest::BodySink& sink,
+                          bool stream = false) const;
 
 private:
     std::unique_ptr<HttpClient> m_httpClient;
@@ -145,6 +181,7 @@ private:
     
     // Vision capabilities
     VisionCapabilities m_visionCapabilities;
+    ImagePreparer m_imagePreparer;
     
     // Context and history
     LLMContext m_context;
@@ -163,7 +200,8 @@ private:
     LLMError m_lastError;
     
     // Internal methods
-    nlohmann::json createRequestPayload(const std::vector<LLMMessage>& messages);
+    nlohmann::json sendRequest(const std::vector<LLMMessage>& messages, const TextSink* onText,
+                               const CancellationToken& cancellation);
     ExecutionPlan parseResponse(const nlohmann::json& response);
     ExecutionPlan parseResponseWithRules(const nlohmann::json& response);
     ExecutionPlan parseResponseFallback(const nlohmann::json& response);
@@ -172,6 +210,7 @@ private:
     std::string applyCleaningRules(const std::string& content, const nlohmann::json& parsingRules);
     bool validateParsedContent(const nlohmann::json& parsedJson, const nlohmann::json& parsingRules);
     void initializeVisionCapabilities(const nlohmann::json& providerConfig = nlohmann::json{});
+    std::shared_ptr<const PreparedImage> prepareScreenshot(const LLMContext& context);
     std::string buildSystemPrompt(const LLMContext& context);
     
     // Configurable prompt system methods
@@ -180,7 +219,6 @@ private:
     std::string generateCommandReference();
     std::string generateFallbackCommandReference();
     std::string generateContextInfo(const LLMContext& context);
-    std::string replaceAll(const std::string& str, const std::string& from, const std::string& to);
     // Removed hardcoded fallback methods - using configurable templates only
     
     // Contextual prompt template methods
@@ -194,8 +232,6 @@ private:
     std::map<std::string, std::string> getRequestHeaders() const;
     
     // Provider-specific implementations
-    nlohmann::json createOpenAIRequest(const std::vector<LLMMessage>& messages);
-    nlohmann::json createAnthropicRequest(const std::vector<LLMMessage>& messages);
     ExecutionPlan parseOpenAIResponse(const nlohmann::json& response);
     ExecutionPlan parseAnthropicResponse(const nlohmann::json& response);
     
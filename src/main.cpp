@@ -12,6 +12,7 @@
 #endif
 #include "common/os_utils.h"
 #include "common/structured_logger.h"
+#include "common/binary_log_sink.h"
 #include "common/config_manager.h"
 #include "common/service_factory.h"
 #include "common/shutdown_manager.h"
@@ -530,7 +531,9 @@ void testComprehensiveDeepSeekAutomation(Orchestrator& orchestrator, const std::
 
 int main(int argc, char* argv[]) {
     try {
-        // Register signal handler for graceful shutdown
+        // Register signal handler for graceful shutdown. Construct the manager
+        // first so its relay thread is not started from inside a signal handler.
+        ShutdownManager::getInstance();
         #ifdef _WIN32
         // Windows: Use SetConsoleCtrlHandler
         if (!SetConsoleCtrlHandler(consoleHandler, TRUE)) {
@@ -633,6 +636,16 @@ int main(int argc, char* argv[]) {
         auto fileSink = std::make_shared<RotatingFileLogSink>(fileConfig, jsonFormatter);
         slogger.addSink(fileSink);
         
+        // Add compact binary logging when configured (decode with burwell-logdecode)
+        std::string binaryLogFile = config.getBinaryLogFile();
+        if (!binaryLogFile.empty()) {
+            BinaryLogSink::Config binaryConfig;
+            binaryConfig.base_path = binaryLogFile;
+            binaryConfig.segment_size = static_cast<size_t>(config.getBinaryLogSegmentSizeMb()) * 1024 * 1024;
+            binaryConfig.segment_count = static_cast<size_t>(config.getBinaryLogSegments());
+            slogger.addSink(std::make_shared<BinaryLogSink>(binaryConfig), config.getBinaryLogLoggers());
+        }
+        
         // Add console logging only if not in daemon mode
         if (!daemonMode) {
             auto textFormatter = std::make_shared<TextLogFormatter>();
@@ -647,8 +660,11 @@ int main(int argc, char* argv[]) {
         }
         #endif
         
-        // Enable async logging for better performance
-        slogger.setAsyncLogging(true);
+        // Enable async logging: each sink gets its own bounded queue and writer thread
+        AsyncLogSink::Config asyncConfig;
+        asyncConfig.capacity = static_cast<size_t>(config.getLogAsyncQueueCapacity());
+        asyncConfig.policy = AsyncLogSink::overflowPolicyFromString(config.getLogAsyncOverflowPolicy());
+        slogger.setAsyncLogging(true, asyncConfig);
         
         // Enable performance tracking with periodic reporting
         slogger.getPerformanceTracker().enablePeriodicReporting(std::chrono::seconds(300)); // Every 5 minutes
@@ -656,8 +672,10 @@ int main(int argc, char* argv[]) {
         SLOG_INFO().message("Structured logging configured")
             .context("log_level", logLevelStr)
             .context("log_file", config.getLogFile())
+            .context("binary_log_file", binaryLogFile)
             .context("rotation_enabled", true)
-            .context("async_logging", true);
+            .context("async_logging", true)
+            .context("async_overflow_policy", config.getLogAsyncOverflowPolicy());
         
         SLOG_DEBUG().message("DEBUG logging test - if you see this, DEBUG works");
         
@@ -2,6 +2,7 @@
 #include "../common/structured_logger.h"
 #include "../common/input_validator.h"
 #include "../common/os_utils.h"
+#include "../common/blocking_region.h"
 #include <iostream>
 #include <sstream>
 #include <chrono>
@@ -82,6 +83,8 @@ CommandResult executeCommand(const std::string& command,
     }
     
     try {
+        // Held until the command has exited and its output is read
+        BlockingRegion blocking;
         
 #ifdef _WIN32
         // Windows implementation using CreateProcess
@@ -393,7 +396,11 @@ CommandResult waitForProcess(unsigned long processId, int timeoutMs) {
         return result;
     }
     
-    DWORD waitResult = WaitForSingleObject(hProcess, timeoutMs);
+    DWORD waitResult;
+    {
+        BlockingRegion blocking;
+        waitResult = WaitForSingleObject(hProcess, timeoutMs);
+    }
     
     if (waitResult == WAIT_OBJECT_0) {
         DWORD exitCode;
@@ -411,7 +418,11 @@ CommandResult waitForProcess(unsigned long processId, int timeoutMs) {
 #else
     // Linux implementation
     int status;
-    pid_t waitResult = waitpid(static_cast<pid_t>(processId), &status, 0);
+    pid_t waitResult;
+    {
+        BlockingRegion blocking;
+        waitResult = waitpid(static_cast<pid_t>(processId), &status, 0);
+    }
     
     if (waitResult == processId) {
         result.exitCode = WEXITSTATUS(status);
@@ -4,17 +4,63 @@
 #include "../environmental_perception/environmental_perception.h"
 #include "../ui_module/ui_module.h"
 #include "../common/structured_logger.h"
+#include "../common/shutdown_manager.h"
 #include <algorithm>
 #include <sstream>
 #include <random>
 #include <iomanip>
+#include <future>
 
 namespace burwell {
 
+namespace {
+
+// Keys gatherWindowLayout() fills; gatherEnvironmentInfo() uses the same ones
+const char* const WINDOW_LAYOUT_KEYS[] = {"activeWindow", "openWindows"};
+
+// Hash of only the environment fields a speculative prompt is built from
+size_t windowLayoutHash(const nlohmann::json& environment) {
+    nlohmann::json layout = nlohmann::json::object();
+    for (const char* key : WINDOW_LAYOUT_KEYS) {
+        if (environment.is_object() && environment.contains(key)) {
+            layout[key] = environment[key];
+        }
+    }
+    return std::hash<std::string>{}(layout.dump());
+}
+
+struct SpeculativeResponse {
+    nlohmann::json response;
+    double requestMs = 0.0;
+};
+
+// Makes sure the speculative request is stopped and finished on every exit path
+class SpeculationGuard {
+public:
+    SpeculationGuard(CancellationSource& cancel, std::future<SpeculativeResponse>& future)
+        : m_cancel(cancel), m_future(future) {}
+    ~SpeculationGuard() {
+        if (m_future.valid()) {
+            m_cancel.cancel();
+            m_future.wait();
+        }
+    }
+
+    SpeculationGuard(const SpeculationGuard&) = delete;
+    SpeculationGuard& operator=(const SpeculationGuard&) = delete;
+
+private:
+    CancellationSource& m_cancel;
+    std::future<SpeculativeResponse>& m_future;
+};
+
+} // anonymous namespace
+
 ConversationManager::ConversationManager()
     : m_maxConversationTurns(10)
     , m_conversationTimeoutMs(300000)  // 5 minutes
-    , m_conversationExpirationMs(600000) {  // 10 minutes
+    , m_conversationExpirationMs(600000)  // 10 minutes
+    , m_speculativePlanning(false) {
     SLOG_DEBUG().message("ConversationManager initialized");
 }
 
@@ -46,36 +92,88 @@ void ConversationManager::setConversationExpirationMs(int expirationMs) {
     m_conversationExpirationMs = expirationMs;
 }
 
+void ConversationManager::setSpeculativePlanningEnabled(bool enabled) {
+    m_speculativePlanning = enabled;
+}
+
+bool ConversationManager::isSpeculativePlanningEnabled() const {
+    return m_speculativePlanning;
+}
+
+nlohmann::json ConversationManager::getSpeculationStats() const {
+    std::lock_guard<std::mutex> lock(m_speculationMutex);
+    const SpeculationStats& stats = m_speculationStats;
+    return {
+        {"enabled", m_speculativePlanning.load()},
+        {"requests", stats.requests},
+        {"hits", stats.hits},
+        {"hitRate", stats.requests > 0 ? static_cast<double>(stats.hits) / stats.requests : 0.0},
+        {"savedMs", stats.savedMs},
+        {"averageSavedMs", stats.hits > 0 ? stats.savedMs / stats.hits : 0.0},
+        {"wastedMs", stats.wastedMs}
+    };
+}
+
 std::string ConversationManager::initiateConversation(const std::string& userInput, ExecutionContext& context) {
     std::string conversationId = generateConversationId();
+    CancellationToken cancellation = context.cancellation.token();
+    
+    ConversationState initialState;
+    initialState.conversationId = conversationId;
+    initialState.originalRequest = userInput;
+    initialState.executionContext = &context;
+    initialState.maxTurns = m_maxConversationTurns;
+    
+    // Initialize conversation context; the environment is filled in below
+    initialState.currentContext = {
+        {"userRequest", userInput},
+        {"environment", nullptr},
+        {"executionContext", {
+            {"requestId", context.requestId},
+            {"variables", context.variables}
+        }}
+    };
+    
+    // Add initial user message to history
+    nlohmann::json userMessage = {
+        {"role", "user"},
+        {"content", userInput},
+        {"timestamp", std::chrono::system_clock::now().time_since_epoch().count()}
+    };
+    initialState.messageHistory.push_back(userMessage);
+    
+    // Start planning on the window layout while the full capture runs
+    auto startTime = std::chrono::steady_clock::now();
+    size_t speculativeLayoutHash = 0;
+    CancellationSource speculationCancel(cancellation);
+    std::future<SpeculativeResponse> speculativeResponse;
+    SpeculationGuard speculationGuard(speculationCancel, speculativeResponse);
+    if (m_speculativePlanning && m_llmConnector && m_perception) {
+        ConversationState speculativeState = initialState;
+        speculativeState.currentContext["environment"] = gatherWindowLayout();
+        speculativeLayoutHash = windowLayoutHash(speculativeState.currentContext["environment"]);
+        
+        auto llm = m_llmConnector;
+        std::string prompt = buildLLMPrompt(speculativeState, userInput).dump();
+        CancellationToken token = speculationCancel.token();
+        speculativeResponse = std::async(std::launch::async, [llm, prompt, token] {
+            auto requestStart = std::chrono::steady_clock::now();
+            SpeculativeResponse result;
+            result.response = llm->sendPrompt(prompt, token);
+            result.requestMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - requestStart).count();
+            return result;
+        });
+    }
+    
+    initialState.currentContext["environment"] = gatherRequestedEnvironmentalData({});
+    double captureMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - startTime).count();
+    initialState.lastInteraction = std::chrono::steady_clock::now();
     
     {
         std::lock_guard<std::mutex> lock(m_conversationMutex);
-        
-        ConversationState& state = m_activeConversations[conversationId];
-        state.conversationId = conversationId;
-        state.originalRequest = userInput;
-        state.executionContext = &context;
-        state.maxTurns = m_maxConversationTurns;
-        state.lastInteraction = std::chrono::steady_clock::now();
-        
-        // Initialize conversation context
-        state.currentContext = {
-            {"userRequest", userInput},
-            {"environment", gatherRequestedEnvironmentalData({})},
-            {"executionContext", {
-                {"requestId", context.requestId},
-                {"variables", context.variables}
-            }}
-        };
-        
-        // Add initial user message to history
-        nlohmann::json userMessage = {
-            {"role", "user"},
-            {"content", userInput},
-            {"timestamp", std::chrono::system_clock::now().time_since_epoch().count()}
-        };
-        state.messageHistory.push_back(userMessage);
+        m_activeConversations[conversationId] = std::move(initialState);
     }
     
     SLOG_INFO().message("Initiated conversation").context("conversation_id", conversationId);
@@ -83,12 +181,42 @@ std::string ConversationManager::initiateConversation(const std::string& userInp
     // Build and send initial LLM prompt
     if (m_llmConnector) {
         ConversationState& state = m_activeConversations[conversationId];
-        auto prompt = buildLLMPrompt(state, userInput);
-        
         state.awaitingLLMResponse = true;
         
         try {
-            auto llmResponse = m_llmConnector->sendPrompt(prompt.dump());
+            nlohmann::json llmResponse;
+            bool haveResponse = false;
+            std::string prompt = buildLLMPrompt(state, userInput).dump();
+            
+            if (speculativeResponse.valid()) {
+                // The plan stands if the windows it was made for are still the ones on screen
+                double speculativeMs = 0.0;
+                if (windowLayoutHash(state.currentContext["environment"]) == speculativeLayoutHash) {
+                    SpeculativeResponse speculative = speculativeResponse.get();
+                    llmResponse = std::move(speculative.response);
+                    speculativeMs = speculative.requestMs;
+                    haveResponse = !llmResponse.contains("error");
+                } else {
+                    speculationCancel.cancel();
+                    speculativeResponse.wait();
+                }
+                
+                double elapsedMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - startTime).count();
+                if (haveResponse) {
+                    recordSpeculation(true, captureMs + speculativeMs - elapsedMs, 0.0);
+                } else {
+                    recordSpeculation(false, 0.0, elapsedMs - captureMs);
+                }
+                SLOG_DEBUG().message("Speculative plan " + std::string(haveResponse ? "accepted" : "discarded"))
+                    .context("conversation_id", conversationId)
+                    .context("capture_ms", captureMs)
+                    .context("elapsed_ms", elapsedMs);
+            }
+            
+            if (!haveResponse) {
+                llmResponse = m_llmConnector->sendPrompt(prompt, cancellation);
+            }
             processConversationTurn(conversationId, llmResponse);
         } catch (const std::exception& e) {
             SLOG_ERROR().message("Failed to get LLM response").context("error", e.what());
@@ -442,24 +570,35 @@ TaskExecutionResult ConversationManager::waitForUserResponse(const std::string&
     TaskExecutionResult result;
     result.success = false;
     
-    auto startTime = std::chrono::steady_clock::now();
-    auto endTime = startTime + std::chrono::milliseconds(timeoutMs);
-    
-    while (std::chrono::steady_clock::now() < endTime) {
-        {
-            std::lock_guard<std::mutex> lock(m_interactionMutex);
-            auto it = m_pendingUserInteractions.find(interactionId);
-            if (it != m_pendingUserInteractions.end() && it->second.hasResponse) {
-                result.success = true;
-                result.output = it->second.userResponse.dump();
-                m_pendingUserInteractions.erase(it);
-                return result;
-            }
+    auto endTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    CancellationToken shutdown = ShutdownManager::getInstance().getToken();
+    
+    std::unique_lock<std::mutex> lock(m_interactionMutex);
+    while (!shutdown.isCancelled()) {
+        auto it = m_pendingUserInteractions.find(interactionId);
+        if (it != m_pendingUserInteractions.end() && it->second.hasResponse) {
+            result.success = true;
+            result.output = it->second.userResponse.dump();
+            m_pendingUserInteractions.erase(it);
+            return result;
         }
         
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            endTime - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            break;
+        }
+        shutdown.waitFor(lock, m_interactionResponded, remaining, [&] {
+            auto pending = m_pendingUserInteractions.find(interactionId);
+            return pending != m_pendingUserInteractions.end() && pending->second.hasResponse;
+        });
     }
     
+    if (shutdown.isCancelled()) {
+        result.status = ExecutionStatus::CANCELLED;
+        result.errorMessage = "Wait for user response cancelled";
+        return result;
+    }
     result.errorMessage = "User response timeout";
     return result;
 }
@@ -474,6 +613,7 @@ bool ConversationManager::provideUserResponse(const std::string& interactionId,
         
         it->second.userResponse = validatedResponse;
         it->second.hasResponse = true;
+        m_interactionResponded.notify_all();
         
         SLOG_INFO().message("User response provided").context("interaction_id", interactionId);
         return true;
@@ -717,6 +857,29 @@ nlohmann::json ConversationManager::gatherRequestedEnvironmentalData(const nlohm
     return data;
 }
 
+nlohmann::json ConversationManager::gatherWindowLayout() {
+    // Same keys gatherEnvironmentInfo uses, without the screenshot and OCR
+    nlohmann::json openWindows = nlohmann::json::array();
+    for (const auto& window : m_perception->getVisibleWindows()) {
+        openWindows.push_back(window.title);
+    }
+    return {
+        {"activeWindow", m_perception->getActiveWindow().title},
+        {"openWindows", openWindows}
+    };
+}
+
+void ConversationManager::recordSpeculation(bool hit, double savedMs, double wastedMs) {
+    std::lock_guard<std::mutex> lock(m_speculationMutex);
+    m_speculationStats.requests++;
+    if (hit) {
+        m_speculationStats.hits++;
+        m_speculationStats.savedMs += std::max(0.0, savedMs);
+    } else {
+        m_speculationStats.wastedMs += std::max(0.0, wastedMs);
+    }
+}
+
 nlohmann::json ConversationManager::getWindowInformation() {
     if (!m_perception) {
         return nlohmann::json::array();
@@ -816,8 +979,7 @@ void ConversationManager::handleConversationTimeout(const std::string& conversat
 }
 
 void ConversationManager::finalizeConversation(const std::string& conversationId, const TaskExecutionResult& result) {
-    std::lock_guard<std::mutex> lock(m_conversationMutex);
-    
+    // Should be called with lock already held (from processConversationTurn)
     auto it = m_activeConversations.find(conversationId);
     if (it != m_activeConversations.end()) {
         // Log final state
@@ -827,7 +989,7 @@ void ConversationManager::finalizeConversation(const std::string& conversationId
         
         // Store final result in execution context if available
         if (it->second.executionContext) {
-            it->second.executionContext->variables["conversation_result"] = {
+            it->second.executionContext->variables["conversation_result"] = nlohmann::json{
                 {"success", result.success},
                 {"output", result.output},
                 {"turns", it->second.turnCount}
@@ -7,6 +7,8 @@
 #include <vector>
 #include <chrono>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <nlohmann/json.hpp>
 #include "../common/types.h"
 
@@ -40,6 +42,15 @@ public:
     void setConversationTimeoutMs(int timeoutMs);
     void setConversationExpirationMs(int expirationMs);
 
+    // Speculative planning (off by default): the first LLM request starts on a
+    // cheap window-layout snapshot while the full capture (screenshot, OCR) runs.
+    // Its plan is kept only if the prompt built from the full capture is
+    // identical, i.e. the capture added nothing the LLM would see; otherwise it
+    // is cancelled and the request is re-sent with the full context
+    void setSpeculativePlanningEnabled(bool enabled);
+    bool isSpeculativePlanningEnabled() const;
+    nlohmann::json getSpeculationStats() const;
+
     // Conversation lifecycle
     std::string initiateConversation(const std::string& userInput, ExecutionContext& context);
     TaskExecutionResult processConversationTurn(const std::string& conversationId, const nlohmann::json& llmResponse);
@@ -123,11 +134,23 @@ private:
     int m_conversationTimeoutMs;
     int m_conversationExpirationMs;
 
+    // Speculation tracking
+    struct SpeculationStats {
+        size_t requests = 0;
+        size_t hits = 0;
+        double savedMs = 0.0;       // Sequential capture + LLM time minus actual time, on hits
+        double wastedMs = 0.0;      // Snapshot and cancellation overhead, on misses
+    };
+    std::atomic<bool> m_speculativePlanning;
+    SpeculationStats m_speculationStats;
+    mutable std::mutex m_speculationMutex;
+
     // State storage
     std::map<std::string, ConversationState> m_activeConversations;
     std::map<std::string, UserInteractionRequest> m_pendingUserInteractions;
     mutable std::mutex m_conversationMutex;
     mutable std::mutex m_interactionMutex;
+    std::condition_variable m_interactionResponded;
 
     // Helper methods
     std::string generateConversationId();
@@ -139,6 +162,8 @@ private:
     
     // Environmental data helpers
     nlohmann::json gatherRequestedEnvironmentalData(const nlohmann::json& request);
+    nlohmann::json gatherWindowLayout();
+    void recordSpeculation(bool hit, double savedMs, double wastedMs);
     nlohmann::json getWindowInformation();
     nlohmann::json getApplicationState();
     nlohmann::json getSystemResources();
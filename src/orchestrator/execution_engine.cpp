@@ -3,7 +3,6 @@
 #include "../common/structured_logger.h"
 #include "../common/input_validator.h"
 #include "../common/file_utils.h"
-#include "../common/shutdown_manager.h"
 #include "../ocal/ocal.h"
 #include "../ocal/window_operations.h"
 #include "../ocal/input_operations.h"
@@ -12,16 +11,82 @@
 #include <thread>
 #include <chrono>
 #include <algorithm>
-#include <regex>
 #include <sstream>
 #include <atomic>
+#include <charconv>
 
 namespace burwell {
 
+namespace {
+
+// Splits "left op right" exactly as ECMAScript matching of
+// (.+?)\s*(==|!=|>|<|>=|<=)\s*(.+) would, without running a regex per evaluation
+bool splitComparison(const std::string& expression, std::string& left, std::string& op, std::string& right) {
+    static const char* const OPERATORS[] = {"==", "!=", ">", "<", ">=", "<="};
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; };
+    auto isLineBreak = [](char c) { return c == '\n' || c == '\r'; };
+    
+    const size_t size = expression.size();
+    const size_t lastBreak = expression.find_last_of("\r\n");
+    for (size_t leftEnd = 1; leftEnd < size && !isLineBreak(expression[leftEnd - 1]); ++leftEnd) {
+        size_t opStart = leftEnd;
+        while (opStart < size && isSpace(expression[opStart])) {
+            ++opStart;
+        }
+        for (const char* candidate : OPERATORS) {
+            size_t opLength = std::char_traits<char>::length(candidate);
+            if (expression.compare(opStart, opLength, candidate) != 0) {
+                continue;
+            }
+            // Greedy \s* backs off until (.+) can take the rest of the line
+            size_t spaceStart = opStart + opLength;
+            if (spaceStart >= size) {
+                continue;
+            }
+            size_t rightStart = spaceStart;
+            while (rightStart + 1 < size && isSpace(expression[rightStart])) {
+                ++rightStart;
+            }
+            if (lastBreak != std::string::npos && lastBreak >= rightStart) {
+                continue;
+            }
+            left = expression.substr(0, leftEnd);
+            op = candidate;
+            right = expression.substr(rightStart);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Loops and sub-scripts run nested sequences; each level gets its own status line
+thread_local size_t t_sequenceDepth = 0;
+
+class SequenceDepthScope {
+public:
+    SequenceDepthScope() : m_depth(t_sequenceDepth++) {}
+    ~SequenceDepthScope() { --t_sequenceDepth; }
+    std::string statusKey() const {
+        return m_depth == 0 ? "execution" : "execution." + std::to_string(m_depth);
+    }
+private:
+    size_t m_depth;
+};
+
+} // anonymous namespace
+
 ExecutionEngine::ExecutionEngine()
     : m_commandSequenceDelayMs(1000)
     , m_executionTimeoutMs(30000)
-    , m_confirmationRequired(true) {
+    , m_confirmationRequired(true)
+    , m_optimizeScripts(true)
+    , m_traceExecution(false)
+    , m_scriptCache([this](nlohmann::json& script) {
+          if (m_optimizeScripts) {
+              recordOptimization(ScriptOptimizer::foldConstants(script));
+          }
+          m_variablePaths.precompile(script);
+      }) {
     SLOG_DEBUG().message("ExecutionEngine initialized");
 }
 
@@ -41,6 +106,31 @@ void ExecutionEngine::setUIModule(std::shared_ptr<UIModule> ui) {
     m_ui = ui;
 }
 
+ScriptCache::PreloadReport ExecutionEngine::preloadScripts(const nlohmann::json& commands) {
+    auto report = m_scriptCache.preloadCallTree(commands);
+    if (report.scriptsLoaded + report.cacheHits > 0 || !report.errors.empty()) {
+        SLOG_INFO().message("Preloaded script call tree")
+            .context("scripts_loaded", report.scriptsLoaded)
+            .context("cache_hits", report.cacheHits)
+            .context("depth", report.depth)
+            .context("errors", report.errors.size())
+            .context("elapsed_ms", report.elapsedMs);
+    }
+    return report;
+}
+
+nlohmann::json ExecutionEngine::getScriptCacheStats() const {
+    auto stats = m_scriptCache.getStats();
+    std::lock_guard<std::mutex> lock(m_optimizerMutex);
+    stats["optimizer"] = m_optimizerStats.toJson();
+    return stats;
+}
+
+void ExecutionEngine::recordOptimization(const ScriptOptimizer::Stats& stats) {
+    std::lock_guard<std::mutex> lock(m_optimizerMutex);
+    m_optimizerStats += stats;
+}
+
 void ExecutionEngine::setCommandSequenceDelayMs(int delayMs) {
     m_commandSequenceDelayMs = delayMs;
 }
@@ -53,6 +143,14 @@ void ExecutionEngine::setConfirmationRequired(bool required) {
     m_confirmationRequired = required;
 }
 
+void ExecutionEngine::setScriptOptimizationEnabled(bool enabled) {
+    m_optimizeScripts = enabled;
+}
+
+void ExecutionEngine::setExecutionTraceEnabled(bool enabled) {
+    m_traceExecution = enabled;
+}
+
 TaskExecutionResult ExecutionEngine::executeCommandSequence(const nlohmann::json& commands, ExecutionContext& context) {
     TaskExecutionResult result;
     result.success = false;
@@ -65,12 +163,14 @@ TaskExecutionResult ExecutionEngine::executeCommandSequence(const nlohmann::json
     
     double startTime = std::chrono::duration<double, std::milli>(
         std::chrono::steady_clock::now().time_since_epoch()).count();
+    SequenceDepthScope depth;
+    const std::string statusKey = depth.statusKey();
     
     for (size_t i = 0; i < commands.size(); ++i) {
         const auto& command = commands[i];
         
-        // Check for shutdown request
-        if (ShutdownManager::getInstance().isShutdownRequested()) {
+        // Check for shutdown or request cancellation
+        if (context.cancellation.isCancelled()) {
             result.errorMessage = "Execution cancelled by user";
             result.status = ExecutionStatus::CANCELLED;
             break;
@@ -83,6 +183,13 @@ TaskExecutionResult ExecutionEngine::executeCommandSequence(const nlohmann::json
             break;
         }
         
+        // Coalesced by the terminal writer, so per-step updates are cheap
+        if (m_ui) {
+            bool named = command.is_object() && command.contains("command") && command["command"].is_string();
+            m_ui->displayProgress(statusKey, "Executing " + (named ? command["command"].get<std::string>() : "command"),
+                                  i + 1, commands.size());
+        }
+        
         // Execute individual command
         auto cmdResult = executeCommand(command, context);
         
@@ -102,10 +209,15 @@ TaskExecutionResult ExecutionEngine::executeCommandSequence(const nlohmann::json
         
         // Delay between commands if configured
         if (m_commandSequenceDelayMs > 0 && i < commands.size() - 1) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(m_commandSequenceDelayMs));
+            // Cancellation is picked up by the check at the top of the loop
+            context.cancellation.token().sleepFor(std::chrono::milliseconds(m_commandSequenceDelayMs));
         }
     }
     
+    if (m_ui) {
+        m_ui->clearStatus(statusKey);
+    }
+    
     // Calculate execution time
     double endTime = std::chrono::duration<double, std::milli>(
         std::chrono::steady_clock::now().time_since_epoch()).count();
@@ -137,8 +249,9 @@ TaskExecutionResult ExecutionEngine::executeCommand(const nlohmann::json& comman
         if (command.contains("description")) {
             logEntry += " - " + command["description"].get<std::string>();
         }
-        updateExecutionLog(context, logEntry);
-        SLOG_INFO().message(logEntry);
+        updateExecutionLog(context, commandType, logEntry);
+        // Loop bodies run this thousands of times; keep bursts, throttle floods
+        SLOG_INFO_THROTTLED(50, 10).message(logEntry);
         
         // Check if command requires confirmation
         if (m_confirmationRequired && requiresUserConfirmation(command)) {
@@ -198,28 +311,14 @@ TaskExecutionResult ExecutionEngine::executeScriptFile(const std::string& script
     TaskExecutionResult result;
     result.success = false;
     
-    // Validate script path
-    auto validationResult = InputValidator::validateFilePath(scriptPath);
-    if (!validationResult.isValid) {
-        result.errorMessage = "Invalid script path: " + validationResult.errorMessage;
-        return result;
-    }
-    
-    // Load script file
-    std::string scriptContent;
-    if (!utils::FileUtils::readFileToString(scriptPath, scriptContent)) {
-        result.errorMessage = "Failed to read script file: " + scriptPath;
-        return result;
-    }
-    
-    // Parse JSON
-    nlohmann::json script;
-    try {
-        script = nlohmann::json::parse(scriptContent);
-    } catch (const nlohmann::json::parse_error& e) {
-        result.errorMessage = "Invalid JSON in script file: " + std::string(e.what());
+    // Load script file; preloaded scripts come straight from the cache
+    std::string loadError;
+    auto loadedScript = m_scriptCache.load(scriptPath, loadError);
+    if (!loadedScript) {
+        result.errorMessage = loadError;
         return result;
     }
+    const nlohmann::json& script = *loadedScript;
     
     // Execute script commands - support both "commands" and "sequence" arrays
     if (script.contains("commands") && script["commands"].is_array()) {
@@ -234,27 +333,18 @@ TaskExecutionResult ExecutionEngine::executeScriptFile(const std::string& script
 }
 
 std::string ExecutionEngine::substituteVariables(const std::string& input, const ExecutionContext& context) {
-    std::string result = input;
-    
-    // Pattern for variable substitution: ${varName} or ${varName.field}
-    std::regex varPattern(R"(\$\{([^}]+)\})");
-    std::smatch match;
-    std::string temp = result;
-    
-    while (std::regex_search(temp, match, varPattern)) {
-        std::string varExpr = match[1].str();
-        std::string replacement = evaluateVariableExpression(varExpr, context);
-        
-        // Replace the variable with its value
-        size_t pos = result.find(match[0].str());
-        if (pos != std::string::npos) {
-            result.replace(pos, match[0].str().length(), replacement);
-        }
-        
-        // Continue searching after the replacement
-        temp = result.substr(pos + replacement.length());
+    // Pattern for variable substitution: ${varName}, ${varName.field} or ${varName[0].field}
+    if (input.find("${") == std::string::npos) {
+        return input;
     }
     
+    std::string result;
+    result.reserve(input.size());
+    expandVariables(input, result, [this, &context](const std::string& expression, std::string& out) {
+        out += evaluateVariableExpression(expression, context);
+        return true;
+    });
+    
     return result;
 }
 
@@ -342,8 +432,15 @@ bool ExecutionEngine::requiresUserConfirmation(const nlohmann::json& command) {
 
 // Private helper methods
 
-void ExecutionEngine::updateExecutionLog(ExecutionContext& context, const std::string& entry) {
-    context.executionLog.push_back(entry);
+void ExecutionEngine::updateExecutionLog(ExecutionContext& context, const std::string& commandType, const std::string& entry) {
+    context.executionLog.appendCommand(commandType, entry);
+    if (m_traceExecution) {
+        // Memory keeps a summary; sinks routed to the trace logger get every entry
+        SLOG_INFO().logger(ExecutionLog::TRACE_LOGGER).message(entry)
+            .context("request_id", context.requestId)
+            .context("sequence", context.executionLog.size())
+            .context("nesting_level", context.nestingLevel);
+    }
 }
 
 std::string ExecutionEngine::formatCommandDescription(const nlohmann::json& command) {
@@ -375,84 +472,31 @@ bool ExecutionEngine::checkTimeout(double startTime, int timeoutMs) {
 }
 
 std::string ExecutionEngine::evaluateVariableExpression(const std::string& expression, const ExecutionContext& context) {
-    // Handle array access: varName[index]
-    std::regex arrayPattern(R"((\w+)\[(\d+)\])");
-    std::smatch arrayMatch;
-    
-    if (std::regex_match(expression, arrayMatch, arrayPattern)) {
-        std::string varName = arrayMatch[1].str();
-        int index = std::stoi(arrayMatch[2].str());
-        
-        auto it = context.variables.find(varName);
-        if (it != context.variables.end() && it->second.is_array()) {
-            if (index >= 0 && index < static_cast<int>(it->second.size())) {
-                // Get the array element
-                const auto& element = it->second[index];
-                std::string value;
-                
-                // Return string values without quotes
-                if (element.is_string()) {
-                    value = element.get<std::string>();
-                } else {
-                    value = element.dump();
-                }
-                
-                SLOG_DEBUG().message("Array access successful")
-                    .context("expression", expression)
-                    .context("value", value);
-                return value;
-            } else {
-                SLOG_DEBUG().message("Array index out of bounds")
-                    .context("expression", expression)
-                    .context("array_size", it->second.size())
-                    .context("requested_index", index);
-            }
-        } else {
-            SLOG_DEBUG().message("Variable not found or not an array")
-                .context("expression", expression)
-                .context("var_exists", it != context.variables.end())
-                .context("is_array", it != context.variables.end() ? it->second.is_array() : false);
-        }
-        return "";
-    }
+    auto formatValue = [](const nlohmann::json& value) {
+        // Return string values without quotes
+        return value.is_string() ? value.get<std::string>() : value.dump();
+    };
     
-    // Handle nested field access: varName.field.subfield
-    size_t dotPos = expression.find('.');
-    if (dotPos != std::string::npos) {
-        std::string varName = expression.substr(0, dotPos);
-        std::string fieldPath = expression.substr(dotPos + 1);
-        
-        auto it = context.variables.find(varName);
+    // Handle nested access: varName.field.subfield, varName[index], varName[0].field
+    auto path = m_variablePaths.get(expression);
+    if (path->isPath() && path->hasSteps()) {
+        auto it = context.variables.find(path->root());
         if (it != context.variables.end()) {
-            // Navigate through nested fields
-            nlohmann::json current = it->second;
-            std::istringstream fieldStream(fieldPath);
-            std::string field;
-            
-            while (std::getline(fieldStream, field, '.')) {
-                if (current.is_object() && current.contains(field)) {
-                    current = current[field];
-                } else {
-                    return "";
-                }
-            }
-            
-            if (current.is_string()) {
-                return current.get<std::string>();
-            } else {
-                return current.dump();
+            const nlohmann::json* value = it->second.isJson() ? path->resolve(it->second.asJson()) : nullptr;
+            if (value) {
+                return formatValue(*value);
             }
+            SLOG_DEBUG_THROTTLED(20, 5).message("Variable path not found")
+                .context("expression", expression)
+                .context("type", it->second.typeName());
+            return "";
         }
     }
     
     // Simple variable lookup
     auto it = context.variables.find(expression);
     if (it != context.variables.end()) {
-        if (it->second.is_string()) {
-            return it->second.get<std::string>();
-        } else {
-            return it->second.dump();
-        }
+        return it->second.toString();
     }
     
     // Check sub-script results
@@ -469,17 +513,54 @@ std::string ExecutionEngine::evaluateVariableExpression(const std::string& expre
     return "";
 }
 
+const ScriptValue* ExecutionEngine::findPlainVariable(const std::string& expression, const ExecutionContext& context) {
+    // Same resolution order as evaluateVariableExpression for step-less names
+    if (m_variablePaths.get(expression)->hasSteps()) {
+        return nullptr;
+    }
+    auto it = context.variables.find(expression);
+    return it != context.variables.end() ? &it->second : nullptr;
+}
+
 bool ExecutionEngine::evaluateConditionExpression(const std::string& expression, const ExecutionContext& context) {
     // Simple condition evaluation
     // Support basic comparisons: var == value, var != value, var > value, etc.
     
-    std::regex comparisonPattern(R"((.+?)\s*(==|!=|>|<|>=|<=)\s*(.+))");
-    std::smatch match;
+    std::string leftExpr;
+    std::string op;
+    std::string rightExpr;
     
-    if (std::regex_match(expression, match, comparisonPattern)) {
-        std::string leftExpr = match[1].str();
-        std::string op = match[2].str();
-        std::string rightExpr = match[3].str();
+    if (splitComparison(expression, leftExpr, op, rightExpr)) {
+        
+        // Typed fast path: integer, boolean and string variables compare without formatting
+        const ScriptValue* left = findPlainVariable(leftExpr, context);
+        if (left && rightExpr.compare(0, 2, "${") != 0) {
+            if ((op == "==" || op == "!=") && (left->isInteger() || left->isBool() || left->isString())) {
+                char digits[24];
+                std::string_view leftText;
+                if (left->isInteger()) {
+                    auto converted = std::to_chars(digits, digits + sizeof(digits), left->asInteger());
+                    leftText = std::string_view(digits, converted.ptr - digits);
+                } else if (left->isBool()) {
+                    leftText = left->asBool() ? "true" : "false";
+                } else {
+                    leftText = left->asString();
+                }
+                return (leftText == rightExpr) == (op == "==");
+            }
+            if (left->isInteger() && op != "==" && op != "!=") {
+                try {
+                    double leftNum = static_cast<double>(left->asInteger());
+                    double rightNum = std::stod(rightExpr);
+                    if (op == ">") return leftNum > rightNum;
+                    if (op == "<") return leftNum < rightNum;
+                    if (op == ">=") return leftNum >= rightNum;
+                    if (op == "<=") return leftNum <= rightNum;
+                } catch (...) {
+                    // Non-numeric right side; use the string comparison below
+                }
+            }
+        }
         
         // Evaluate both sides
         std::string leftValue = substituteVariables("${" + leftExpr + "}", context);
@@ -516,6 +597,17 @@ bool ExecutionEngine::evaluateConditionExpression(const std::string& expression,
     }
     
     // Check for boolean variable
+    if (const ScriptValue* flag = findPlainVariable(expression, context)) {
+        if (flag->isBool()) {
+            return flag->asBool();
+        }
+        if (flag->isInteger()) {
+            return flag->asInteger() == 1;
+        }
+        if (flag->isString()) {
+            return flag->asString() == "true" || flag->asString() == "1";
+        }
+    }
     std::string value = substituteVariables("${" + expression + "}", context);
     return value == "true" || value == "1";
 }
@@ -569,7 +661,6 @@ TaskExecutionResult ExecutionEngine::executeWindowCommand(const nlohmann::json&
 }
 
 TaskExecutionResult ExecutionEngine::executeWaitCommand(const nlohmann::json& command, ExecutionContext& context) {
-    (void)context; // TODO: Use context for wait operations
     TaskExecutionResult result;
     result.success = true;
     
@@ -592,20 +683,13 @@ TaskExecutionResult ExecutionEngine::executeWaitCommand(const nlohmann::json& co
             }
         }
         
-        if (duration_ms > 0) {
-            // Make wait interruptible by checking shutdown flag periodically
-            auto end_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(duration_ms);
-            
-            while (std::chrono::steady_clock::now() < end_time) {
-                if (ShutdownManager::getInstance().isShutdownRequested()) {
-                    result.success = false;
-                    result.errorMessage = "Wait interrupted by shutdown signal";
-                    return result;
-                }
-                
-                // Sleep in small increments to check shutdown flag
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            }
+        // Wakes immediately on shutdown or request cancellation
+        if (duration_ms > 0 &&
+            !context.cancellation.token().sleepFor(std::chrono::milliseconds(duration_ms))) {
+            result.success = false;
+            result.status = ExecutionStatus::CANCELLED;
+            result.errorMessage = "Wait interrupted by cancellation";
+            return result;
         }
     }
     
@@ -616,8 +700,9 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
     TaskExecutionResult result;
     
     try {
+        static const nlohmann::json noParameters = nlohmann::json::object();
         std::string commandType = command["command"];
-        auto params = command.contains("parameters") ? command["parameters"] : nlohmann::json::object();
+        const auto& params = command.contains("parameters") ? command["parameters"] : noParameters;
         
         if (commandType == "SET_VARIABLE") {
             // Set a variable in the context
@@ -662,18 +747,15 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             // Get variable value from context
             std::string variableValue = "";
-            if (context.variables.find(varName) != context.variables.end()) {
-                if (context.variables[varName].is_string()) {
-                    variableValue = context.variables[varName].get<std::string>();
-                } else {
-                    variableValue = context.variables[varName].dump();
-                }
-                SLOG_DEBUG().message("Variable found in context")
+            auto varIt = context.variables.find(varName);
+            if (varIt != context.variables.end()) {
+                variableValue = varIt->second.toString();
+                SLOG_DEBUG_THROTTLED(20, 5).message("Variable found in context")
                     .context("variable", varName)
-                    .context("type", context.variables[varName].type_name())
-                    .context("raw_dump", context.variables[varName].dump());
+                    .context("type", varIt->second.typeName())
+                    .context("raw_dump", varIt->second.dump());
             } else {
-                SLOG_DEBUG().message("Variable NOT found in context")
+                SLOG_DEBUG_THROTTLED(20, 5).message("Variable NOT found in context")
                     .context("variable", varName);
             }
             
@@ -685,7 +767,7 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             bool notContains = (lowerValue.find(lowerSubstring) == std::string::npos);
             
-            SLOG_DEBUG().message("IF_NOT_CONTAINS check")
+            SLOG_DEBUG_THROTTLED(20, 5).message("IF_NOT_CONTAINS check")
                 .context("variable", varName)
                 .context("value", variableValue)
                 .context("substring", substring)
@@ -713,18 +795,15 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             // Get variable value from context
             std::string variableValue = "";
-            if (context.variables.find(varName) != context.variables.end()) {
-                if (context.variables[varName].is_string()) {
-                    variableValue = context.variables[varName].get<std::string>();
-                } else {
-                    variableValue = context.variables[varName].dump();
-                }
-                SLOG_DEBUG().message("Variable found in context")
+            auto varIt = context.variables.find(varName);
+            if (varIt != context.variables.end()) {
+                variableValue = varIt->second.toString();
+                SLOG_DEBUG_THROTTLED(20, 5).message("Variable found in context")
                     .context("variable", varName)
-                    .context("type", context.variables[varName].type_name())
-                    .context("raw_dump", context.variables[varName].dump());
+                    .context("type", varIt->second.typeName())
+                    .context("raw_dump", varIt->second.dump());
             } else {
-                SLOG_DEBUG().message("Variable NOT found in context")
+                SLOG_DEBUG_THROTTLED(20, 5).message("Variable NOT found in context")
                     .context("variable", varName);
             }
             
@@ -736,7 +815,7 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             bool contains = (lowerValue.find(lowerSubstring) != std::string::npos);
             
-            SLOG_DEBUG().message("IF_CONTAINS check")
+            SLOG_DEBUG_THROTTLED(20, 5).message("IF_CONTAINS check")
                 .context("variable", varName)
                 .context("value", variableValue)
                 .context("substring", substring)
@@ -764,18 +843,15 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             // Get variable value from context
             std::string variableValue = "";
-            if (context.variables.find(varName) != context.variables.end()) {
-                if (context.variables[varName].is_string()) {
-                    variableValue = context.variables[varName].get<std::string>();
-                } else {
-                    variableValue = context.variables[varName].dump();
-                }
-                SLOG_DEBUG().message("Variable found in context")
+            auto varIt = context.variables.find(varName);
+            if (varIt != context.variables.end()) {
+                variableValue = varIt->second.toString();
+                SLOG_DEBUG_THROTTLED(20, 5).message("Variable found in context")
                     .context("variable", varName)
-                    .context("type", context.variables[varName].type_name())
-                    .context("raw_dump", context.variables[varName].dump());
+                    .context("type", varIt->second.typeName())
+                    .context("raw_dump", varIt->second.dump());
             } else {
-                SLOG_DEBUG().message("Variable NOT found in context")
+                SLOG_DEBUG_THROTTLED(20, 5).message("Variable NOT found in context")
                     .context("variable", varName);
             }
             
@@ -787,7 +863,7 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             bool equals = (lowerValue == lowerCompare);
             
-            SLOG_DEBUG().message("IF_EQUALS check")
+            SLOG_DEBUG_THROTTLED(20, 5).message("IF_EQUALS check")
                 .context("variable", varName)
                 .context("value", variableValue)
                 .context("compare_to", compareValue)
@@ -815,18 +891,15 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             // Get variable value from context
             std::string variableValue = "";
-            if (context.variables.find(varName) != context.variables.end()) {
-                if (context.variables[varName].is_string()) {
-                    variableValue = context.variables[varName].get<std::string>();
-                } else {
-                    variableValue = context.variables[varName].dump();
-                }
-                SLOG_DEBUG().message("Variable found in context")
+            auto varIt = context.variables.find(varName);
+            if (varIt != context.variables.end()) {
+                variableValue = varIt->second.toString();
+                SLOG_DEBUG_THROTTLED(20, 5).message("Variable found in context")
                     .context("variable", varName)
-                    .context("type", context.variables[varName].type_name())
-                    .context("raw_dump", context.variables[varName].dump());
+                    .context("type", varIt->second.typeName())
+                    .context("raw_dump", varIt->second.dump());
             } else {
-                SLOG_DEBUG().message("Variable NOT found in context")
+                SLOG_DEBUG_THROTTLED(20, 5).message("Variable NOT found in context")
                     .context("variable", varName);
             }
             
@@ -838,7 +911,7 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             bool notEquals = (lowerValue != lowerCompare);
             
-            SLOG_DEBUG().message("IF_NOT_EQUALS check")
+            SLOG_DEBUG_THROTTLED(20, 5).message("IF_NOT_EQUALS check")
                 .context("variable", varName)
                 .context("value", variableValue)
                 .context("compare_to", compareValue)
@@ -866,15 +939,9 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             // Get condition value from context
             bool conditionValue = false;
-            if (context.variables.find(conditionVar) != context.variables.end()) {
-                auto& value = context.variables[conditionVar];
-                if (value.is_boolean()) {
-                    conditionValue = value.get<bool>();
-                } else if (value.is_string()) {
-                    std::string strValue = value.get<std::string>();
-                    std::transform(strValue.begin(), strValue.end(), strValue.begin(), ::tolower);
-                    conditionValue = (strValue == "true" || strValue == "1" || strValue == "yes");
-                }
+            auto varIt = context.variables.find(conditionVar);
+            if (varIt != context.variables.end()) {
+                conditionValue = varIt->second.isTruthy();
             }
             
             // Apply invert logic if specified
@@ -882,7 +949,7 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
                 conditionValue = !conditionValue;
             }
             
-            SLOG_DEBUG().message("CONDITIONAL_STOP check")
+            SLOG_DEBUG_THROTTLED(20, 5).message("CONDITIONAL_STOP check")
                 .context("condition_variable", conditionVar)
                 .context("condition_value", conditionValue)
                 .context("inverted", invertCondition)
@@ -910,18 +977,12 @@ TaskExecutionResult ExecutionEngine::executeControlCommand(const nlohmann::json&
             
             // Get condition value from context
             bool conditionValue = false;
-            if (context.variables.find(conditionVar) != context.variables.end()) {
-                auto& value = context.variables[conditionVar];
-                if (value.is_boolean()) {
-                    conditionValue = value.get<bool>();
-                } else if (value.is_string()) {
-                    std::string strValue = value.get<std::string>();
-                    std::transform(strValue.begin(), strValue.end(), strValue.begin(), ::tolower);
-                    conditionValue = (strValue == "true" || strValue == "1" || strValue == "yes");
-                }
+            auto varIt = context.variables.find(conditionVar);
+            if (varIt != context.variables.end()) {
+                conditionValue = varIt->second.isTruthy();
             }
             
-            SLOG_DEBUG().message("BREAK_IF check")
+            SLOG_DEBUG_THROTTLED(20, 5).message("BREAK_IF check")
                 .context("condition_variable", conditionVar)
                 .context("condition_value", conditionValue);
             
@@ -959,8 +1020,9 @@ TaskExecutionResult ExecutionEngine::executeScriptCommand(const nlohmann::json&
     
     std::string scriptPath = command["parameters"]["script_path"];
     
-    // Create a child context with inherited variables
+    // Create a child context with inherited variables, in its own cancellation scope
     ExecutionContext childContext = context;
+    childContext.cancellation = CancellationSource(context.cancellation.token());
     
     // Check if variables are passed to the nested script
     if (command["parameters"].contains("variables") && command["parameters"]["variables"].is_object()) {
@@ -1012,9 +1074,12 @@ TaskExecutionResult ExecutionEngine::executeUiaCommand(const nlohmann::json& com
         return result;
     }
     
+    static const nlohmann::json noParameters = nlohmann::json::object();
     std::string commandType = command["command"];
-    nlohmann::json params = command.contains("parameters") ? command["parameters"] : nlohmann::json::object();
+    const auto& params = command.contains("parameters") ? command["parameters"] : noParameters;
     
+    // ScriptOptimizer pre-substitutes the parameters passed through
+    // substituteVariables below; keep its table in sync
     try {
         if (commandType == "UIA_ENUM_WINDOWS") {
             // Enumerate all windows
@@ -1419,14 +1484,14 @@ TaskExecutionResult ExecutionEngine::executeWhileLoop(const nlohmann::json& comm
         return result;
     }
     
-    auto params = command["parameters"];
+    const auto& params = command["parameters"];
     
     // Support both "commands" and "sequence" for the loop body
-    nlohmann::json commands;
+    const nlohmann::json* commands = nullptr;
     if (params.contains("commands")) {
-        commands = params["commands"];
+        commands = &params["commands"];
     } else if (params.contains("sequence")) {
-        commands = params["sequence"];
+        commands = &params["sequence"];
     } else {
         result.errorMessage = "While loop missing commands or sequence";
         return result;
@@ -1441,16 +1506,21 @@ TaskExecutionResult ExecutionEngine::executeWhileLoop(const nlohmann::json& comm
         return result;
     }
     
+    // Loop bodies resolve the same paths every iteration
+    m_variablePaths.precompile(params);
+    
     int maxIterations = 1000; // Safety limit
     if (params.contains("max_iterations")) {
         maxIterations = params["max_iterations"];
     }
     
     int iteration = 0;
+    bool conditionInvariant = false;
+    ScriptOptimizer::LoopPlan plan;
     
     while (iteration < maxIterations) {
-        // Check for shutdown request
-        if (ShutdownManager::getInstance().isShutdownRequested()) {
+        // Check for shutdown or request cancellation
+        if (context.cancellation.isCancelled()) {
             result.errorMessage = "Loop execution cancelled by user";
             result.status = ExecutionStatus::CANCELLED;
             return result;
@@ -1458,7 +1528,7 @@ TaskExecutionResult ExecutionEngine::executeWhileLoop(const nlohmann::json& comm
         
         // Evaluate loop condition
         bool shouldContinue = false;
-        if (alwaysTrue) {
+        if (alwaysTrue || conditionInvariant) {
             shouldContinue = true;
         } else if (hasCondition) {
             shouldContinue = evaluateLoopCondition(params["condition"], context);
@@ -1468,7 +1538,17 @@ TaskExecutionResult ExecutionEngine::executeWhileLoop(const nlohmann::json& comm
             break;
         }
         
-        auto loopResult = executeCommandSequence(commands, context);
+        // Plan once the loop is known to repeat; what the first pass left
+        // unchanged stays unchanged until the loop exits
+        if (iteration == 1 && m_optimizeScripts) {
+            ScriptOptimizer::Stats stats;
+            plan = ScriptOptimizer::planLoop(*commands, hasCondition ? &params["condition"] : nullptr,
+                [this, &context](const std::string& text) { return substituteVariables(text, context); }, stats);
+            conditionInvariant = plan.conditionInvariant;
+            recordOptimization(stats);
+        }
+        
+        auto loopResult = executeCommandSequence(plan.body.is_null() ? *commands : plan.body, context);
         
         if (!loopResult.success) {
             // Check for break or continue
@@ -5,8 +5,14 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <atomic>
 #include <nlohmann/json.hpp>
 #include "../common/types.h"
+#include "variable_path.h"
+#include "script_value.h"
+#include "script_cache.h"
+#include "script_optimizer.h"
 
 namespace burwell {
 
@@ -37,12 +43,18 @@ public:
     void setCommandSequenceDelayMs(int delayMs);
     void setExecutionTimeoutMs(int timeoutMs);
     void setConfirmationRequired(bool required);
+    void setScriptOptimizationEnabled(bool enabled);  // Constant folding and loop-invariant hoisting
+    void setExecutionTraceEnabled(bool enabled);      // Stream every log entry to ExecutionLog::TRACE_LOGGER
 
     // Main execution methods
     TaskExecutionResult executeCommandSequence(const nlohmann::json& commands, ExecutionContext& context);
     TaskExecutionResult executeCommand(const nlohmann::json& command, ExecutionContext& context);
     TaskExecutionResult executeScriptFile(const std::string& scriptPath, ExecutionContext& context);
 
+    // Loads, compiles and validates every script reachable from commands before they run
+    ScriptCache::PreloadReport preloadScripts(const nlohmann::json& commands);
+    nlohmann::json getScriptCacheStats() const;         // Includes ScriptOptimizer totals
+
     // Variable substitution
     std::string substituteVariables(const std::string& input, const ExecutionContext& context);
     nlohmann::json substituteVariablesInParams(const nlohmann::json& params, const ExecutionContext& context);
@@ -65,6 +77,14 @@ private:
     int m_commandSequenceDelayMs;
     int m_executionTimeoutMs;
     bool m_confirmationRequired;
+    std::atomic<bool> m_optimizeScripts;
+    std::atomic<bool> m_traceExecution;
+
+    // Variable expressions compiled once per script
+    VariablePathCache m_variablePaths;
+    ScriptCache m_scriptCache;
+    ScriptOptimizer::Stats m_optimizerStats;
+    mutable std::mutex m_optimizerMutex;
 
     // Command type handlers
     TaskExecutionResult executeMouseCommand(const nlohmann::json& command, ExecutionContext& context);
@@ -79,13 +99,15 @@ private:
 
     // Helper methods
     bool validateCommandParameters(const nlohmann::json& command);
-    void updateExecutionLog(ExecutionContext& context, const std::string& entry);
+    void updateExecutionLog(ExecutionContext& context, const std::string& commandType, const std::string& entry);
     std::string formatCommandDescription(const nlohmann::json& command);
     bool checkTimeout(double startTime, int timeoutMs);
     
     // Variable evaluation
     std::string evaluateVariableExpression(const std::string& expression, const ExecutionContext& context);
     bool evaluateConditionExpression(const std::string& expression, const ExecutionContext& context);
+    const ScriptValue* findPlainVariable(const std::string& expression, const ExecutionContext& context);
+    void recordOptimization(const ScriptOptimizer::Stats& stats);
 };
 
 } // namespace burwell
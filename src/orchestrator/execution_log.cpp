@@ -0,0 +1,63 @@
+#include "execution_log.h"
+
+namespace burwell {
+
+ExecutionLog::ExecutionLog(size_t headEntries, size_t tailEntries)
+    : m_headCapacity(headEntries)
+    , m_tailCapacity(tailEntries)
+    , m_tailStart(0)
+    , m_total(0) {
+}
+
+void ExecutionLog::append(const std::string& entry) {
+    ++m_total;
+    if (m_head.size() < m_headCapacity) {
+        m_head.push_back(entry);
+    } else if (m_tail.size() < m_tailCapacity) {
+        m_tail.push_back(entry);
+    } else if (m_tailCapacity > 0) {
+        // Overwrite the oldest slot; its buffer is reused once the ring is warm
+        m_tail[m_tailStart] = entry;
+        m_tailStart = (m_tailStart + 1) % m_tailCapacity;
+    }
+}
+
+void ExecutionLog::appendCommand(const std::string& commandType, const std::string& entry) {
+    ++m_commandCounts[commandType];
+    append(entry);
+}
+
+std::vector<std::string> ExecutionLog::entries() const {
+    std::vector<std::string> result;
+    result.reserve(m_head.size() + m_tail.size() + 1);
+    result.insert(result.end(), m_head.begin(), m_head.end());
+    if (omitted() > 0) {
+        result.push_back("... " + std::to_string(omitted()) + " entries omitted ...");
+    }
+    for (size_t i = 0; i < m_tail.size(); ++i) {
+        result.push_back(m_tail[(m_tailStart + i) % m_tail.size()]);
+    }
+    return result;
+}
+
+nlohmann::json ExecutionLog::summary() const {
+    return {
+        {"total", m_total},
+        {"omitted", omitted()},
+        {"command_counts", m_commandCounts}
+    };
+}
+
+void ExecutionLog::clear() {
+    m_head.clear();
+    m_tail.clear();
+    m_tailStart = 0;
+    m_total = 0;
+    m_commandCounts.clear();
+}
+
+void to_json(nlohmann::json& j, const ExecutionLog& log) {
+    j = log.entries();
+}
+
+} // namespace burwell
@@ -0,0 +1,60 @@
+#ifndef BURWELL_EXECUTION_LOG_H
+#define BURWELL_EXECUTION_LOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <nlohmann/json.hpp>
+
+namespace burwell {
+
+/**
+ * @class ExecutionLog
+ * @brief Bounded record of the steps an execution took
+ *
+ * The first and last entries are kept verbatim and everything in between is
+ * only counted, per command type, so a loop that runs a million iterations
+ * holds the same memory (and costs the same to copy into a child context) as
+ * one that runs a hundred. Full detail is streamed by ExecutionEngine to the
+ * TRACE_LOGGER logger when execution tracing is enabled.
+ */
+class ExecutionLog {
+public:
+    static constexpr size_t DEFAULT_HEAD_ENTRIES = 32;
+    static constexpr size_t DEFAULT_TAIL_ENTRIES = 224;
+    static constexpr const char* TRACE_LOGGER = "execution_trace";
+
+    explicit ExecutionLog(size_t headEntries = DEFAULT_HEAD_ENTRIES, size_t tailEntries = DEFAULT_TAIL_ENTRIES);
+
+    void append(const std::string& entry);
+    // Also counts the entry under its command type
+    void appendCommand(const std::string& commandType, const std::string& entry);
+
+    size_t size() const { return m_total; }             // Every entry appended, kept or not
+    bool empty() const { return m_total == 0; }
+    size_t omitted() const { return m_total - m_head.size() - m_tail.size(); }
+
+    // Oldest first, with one "... N entries omitted ..." line where entries were dropped
+    std::vector<std::string> entries() const;
+    const std::map<std::string, uint64_t>& commandCounts() const { return m_commandCounts; }
+    nlohmann::json summary() const;
+
+    void clear();
+
+private:
+    size_t m_headCapacity;
+    size_t m_tailCapacity;
+    std::vector<std::string> m_head;
+    std::vector<std::string> m_tail;                     // Ring once full; m_tailStart is the oldest
+    size_t m_tailStart;
+    size_t m_total;
+    std::map<std::string, uint64_t> m_commandCounts;
+};
+
+// Serializes entries(), the same shape as the list of strings it replaces
+void to_json(nlohmann::json& j, const ExecutionLog& log);
+
+} // namespace burwell
+
+#endif // BURWELL_EXECUTION_LOG_H
@@ -3,6 +3,7 @@
 #include "../environmental_perception/environmental_perception.h"
 #include "../llm_connector/llm_connector.h"
 #include "../common/structured_logger.h"
+#include "../common/shutdown_manager.h"
 #include <algorithm>
 #include <thread>
 
@@ -13,8 +14,7 @@ FeedbackController::FeedbackController()
     , m_adaptationThresholdMs(2000)
     , m_continuousMonitoringEnabled(true)
     , m_maxEnvironmentHistorySize(100)
-    , m_monitoringActive(false)
-    , m_shouldStop(false) {
+    , m_monitoringActive(false) {
     SLOG_DEBUG().message("FeedbackController initialized");
 }
 
@@ -56,10 +56,11 @@ void FeedbackController::startContinuousMonitoring() {
         return;
     }
     
-    m_shouldStop = false;
+    m_monitoringCancellation = CancellationSource(ShutdownManager::getInstance().getToken());
     m_monitoringActive = true;
     
-    m_monitoringThread = std::thread(&FeedbackController::monitoringWorker, this);
+    m_monitoringThread = std::thread(&FeedbackController::monitoringWorker, this,
+                                     m_monitoringCancellation.token());
     SLOG_INFO().message("Continuous environment monitoring started");
 }
 
@@ -68,7 +69,7 @@ void FeedbackController::stopContinuousMonitoring() {
         return;
     }
     
-    m_shouldStop = true;
+    m_monitoringCancellation.cancel();
     
     if (m_monitoringThread.joinable()) {
         m_monitoringThread.join();
@@ -122,7 +123,7 @@ nlohmann::json FeedbackController::captureEnvironmentSnapshot() {
         };
         
     } catch (const std::exception& e) {
-        SLOG_ERROR().message("Error capturing environment snapshot").context("error", e.what());
+        SLOG_ERROR_THROTTLED(5, 0.2).message("Error capturing environment snapshot").context("error", e.what());
     }
     
     return snapshot;
@@ -313,6 +314,24 @@ void FeedbackController::updateCommandSuccessRate(const std::string& command, bo
     }
 }
 
+void FeedbackController::setPlanOutcomeListener(PlanOutcomeListener listener) {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_planOutcomeListener = std::move(listener);
+}
+
+void FeedbackController::reportPlanOutcome(const std::string& planKey, bool success) {
+    updateCommandSuccessRate("PLAN", success);
+    
+    PlanOutcomeListener listener;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        listener = m_planOutcomeListener;
+    }
+    if (listener && !planKey.empty()) {
+        listener(planKey, success);
+    }
+}
+
 double FeedbackController::getCommandSuccessRate(const std::string& command) const {
     std::lock_guard<std::mutex> lock(m_stateMutex);
     
@@ -336,10 +355,12 @@ nlohmann::json FeedbackController::getSuccessMetrics() const {
     nlohmann::json metrics;
     
     for (const auto& [command, count] : m_state.commandSuccessCounts) {
-        double successRate = getCommandSuccessRate(command);
+        // getCommandSuccessRate would re-lock m_stateMutex
+        int failures = m_state.commandFailureCounts.count(command) ? m_state.commandFailureCounts.at(command) : 0;
+        double successRate = static_cast<double>(count) / (count + failures);
         metrics[command] = {
             {"successCount", count},
-            {"failureCount", m_state.commandFailureCounts.count(command) ? m_state.commandFailureCounts.at(command) : 0},
+            {"failureCount", failures},
             {"successRate", successRate}
         };
     }
@@ -399,8 +420,8 @@ void FeedbackController::setAdaptationRuleEnabled(const std::string& ruleName, b
 
 // Private methods
 
-void FeedbackController::monitoringWorker() {
-    while (!m_shouldStop && m_continuousMonitoringEnabled) {
+void FeedbackController::monitoringWorker(CancellationToken cancellation) {
+    while (!cancellation.isCancelled() && m_continuousMonitoringEnabled) {
         auto startTime = std::chrono::steady_clock::now();
         
         // Capture environment
@@ -428,13 +449,13 @@ void FeedbackController::monitoringWorker() {
         auto elapsed = std::chrono::steady_clock::now() - startTime;
         auto sleepTime = std::chrono::milliseconds(m_environmentCheckIntervalMs) - elapsed;
         if (sleepTime.count() > 0) {
-            std::this_thread::sleep_for(sleepTime);
+            cancellation.sleepFor(std::chrono::duration_cast<std::chrono::milliseconds>(sleepTime));
         }
     }
 }
 
 void FeedbackController::processEnvironmentChange(const nlohmann::json& environmentDelta) {
-    SLOG_INFO().message("Processing environment change").context("environment_delta", environmentDelta.dump());
+    SLOG_INFO_THROTTLED(10, 1).message("Processing environment change").context("environment_delta", environmentDelta.dump());
     
     // Evaluate adaptation rules
     auto applicableRules = evaluateAdaptationRules(environmentDelta);
@@ -442,7 +463,7 @@ void FeedbackController::processEnvironmentChange(const nlohmann::json& environm
     // Log summary
     if (!applicableRules.empty()) {
         std::string summary = generateAdaptationSummary(applicableRules);
-        SLOG_INFO().message("Adaptation summary").context("summary", summary);
+        SLOG_INFO_THROTTLED(10, 1).message("Adaptation summary").context("summary", summary);
     }
 }
 
@@ -481,7 +502,7 @@ std::vector<FeedbackController::AdaptationRule> FeedbackController::evaluateAdap
 }
 
 void FeedbackController::applyAdaptationRule(const AdaptationRule& rule, ExecutionContext& context) {
-    SLOG_INFO().message("Applying adaptation rule").context("rule_name", rule.name);
+    SLOG_INFO_THROTTLED(10, 1).message("Applying adaptation rule").context("rule_name", rule.name);
     
     if (rule.action == "retry_command") {
         context.variables["retry_required"] = true;
@@ -8,8 +8,10 @@
 #include <chrono>
 #include <vector>
 #include <map>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include "../common/types.h"
+#include "../common/cancellation_token.h"
 
 namespace burwell {
 
@@ -61,6 +63,11 @@ public:
     nlohmann::json getSuccessMetrics() const;
     void resetSuccessMetrics();
 
+    // Plan outcomes; the listener validates or invalidates cached plans
+    using PlanOutcomeListener = std::function<void(const std::string& planKey, bool success)>;
+    void setPlanOutcomeListener(PlanOutcomeListener listener);
+    void reportPlanOutcome(const std::string& planKey, bool success);
+
     // Environment history
     std::vector<nlohmann::json> getEnvironmentHistory() const;
     nlohmann::json getLastEnvironmentSnapshot() const;
@@ -108,14 +115,16 @@ private:
     // Monitoring thread
     std::thread m_monitoringThread;
     std::atomic<bool> m_monitoringActive;
-    std::atomic<bool> m_shouldStop;
+    CancellationSource m_monitoringCancellation;  // Cancelled by stop or shutdown
+
+    PlanOutcomeListener m_planOutcomeListener;
 
     // Adaptation rules
     std::vector<AdaptationRule> m_adaptationRules;
     mutable std::mutex m_rulesMutex;
 
     // Worker methods
-    void monitoringWorker();
+    void monitoringWorker(CancellationToken cancellation);
     void processEnvironmentChange(const nlohmann::json& environmentDelta);
     std::vector<AdaptationRule> evaluateAdaptationRules(const nlohmann::json& environmentDelta);
     void applyAdaptationRule(const AdaptationRule& rule, ExecutionContext& context);
@@ -119,10 +119,11 @@ void Orchestrator::run() {
         // Start the facade
         m_impl->facade->run();
         
-        // Main loop for interactive mode
-        while (m_isRunning && !m_emergencyStop) {
+        // Main loop for interactive mode; shutdown ends it without waiting out a delay
+        CancellationToken shutdown = ShutdownManager::getInstance().getToken();
+        while (m_isRunning && !m_emergencyStop && !shutdown.isCancelled()) {
             if (m_isPaused) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                shutdown.sleepFor(std::chrono::milliseconds(100));
                 continue;
             }
             
@@ -130,7 +131,7 @@ void Orchestrator::run() {
             if (m_impl->facade->isIdle()) {
                 // In interactive mode, this would wait for user input
                 // For now, just sleep
-                std::this_thread::sleep_for(std::chrono::milliseconds(m_mainLoopDelayMs));
+                shutdown.sleepFor(std::chrono::milliseconds(m_mainLoopDelayMs));
             }
         }
         
@@ -372,12 +373,7 @@ std::string Orchestrator::substituteVariables(const std::string& input, const Ex
         std::string placeholder = "${" + key + "}";
         size_t pos = 0;
         while ((pos = result.find(placeholder, pos)) != std::string::npos) {
-            std::string replacement;
-            if (value.is_string()) {
-                replacement = value.get<std::string>();
-            } else {
-                replacement = value.dump();
-            }
+            std::string replacement = value.toString();
             result.replace(pos, placeholder.length(), replacement);
             pos += replacement.length();
         }
@@ -450,7 +446,7 @@ bool Orchestrator::shouldContinueExecution() const {
 void Orchestrator::handleExecutionError(const std::string& error, ExecutionContext& context) {
     SLOG_ERROR().message("Execution error")
         .context("error", error);
-    context.executionLog.push_back("ERROR: " + error);
+    context.executionLog.append("ERROR: " + error);
 }
 
 void Orchestrator::updateEnvironmentSnapshot(ExecutionContext& context) {
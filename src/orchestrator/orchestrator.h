@@ -12,7 +12,10 @@
 #include <nlohmann/json.hpp>
 #include "../common/types.h"
 #include "../common/resource_monitor.h"
+#include "../common/shutdown_manager.h"
 #include "event_manager.h"
+#include "script_value.h"
+#include "execution_log.h"
 
 namespace burwell {
 
@@ -29,17 +32,23 @@ struct ExecutionContext {
     std::string requestId;
     std::string originalRequest;
     nlohmann::json currentEnvironment;
-    std::vector<std::string> executionLog;
+    ExecutionLog executionLog;                          // First and last entries plus per-command counts
     bool requiresUserConfirmation;
-    std::map<std::string, nlohmann::json> variables;  // Store variables from command results
+    std::map<std::string, ScriptValue> variables;     // Store variables from command results
     
     // Nested script execution support
     int nestingLevel;                                    // Current nesting depth
     int maxNestingLevel;                                 // Maximum allowed nesting depth
     std::vector<std::string> scriptStack;               // Stack of executing scripts
     std::map<std::string, nlohmann::json> subScriptResults;  // Results from executed sub-scripts
+    std::string planCacheKey;                            // Plan cache entry of the plan being run; kept out of script variables
     
-    ExecutionContext() : requiresUserConfirmation(false), nestingLevel(0), maxNestingLevel(3) {}
+    // Request scope; nested scripts run in a child scope. Copies share it.
+    CancellationSource cancellation;
+    
+    ExecutionContext()
+        : requiresUserConfirmation(false), nestingLevel(0), maxNestingLevel(3)
+        , cancellation(ShutdownManager::getInstance().getToken()) {}
     
     // Move constructor
     ExecutionContext(ExecutionContext&& other) noexcept
@@ -52,7 +61,9 @@ struct ExecutionContext {
         , nestingLevel(other.nestingLevel)
         , maxNestingLevel(other.maxNestingLevel)
         , scriptStack(std::move(other.scriptStack))
-        , subScriptResults(std::move(other.subScriptResults)) {}
+        , subScriptResults(std::move(other.subScriptResults))
+        , planCacheKey(std::move(other.planCacheKey))
+        , cancellation(other.cancellation) {}
     
     // Move assignment
     ExecutionContext& operator=(ExecutionContext&& other) noexcept {
@@ -67,6 +78,8 @@ struct ExecutionContext {
             maxNestingLevel = other.maxNestingLevel;
             scriptStack = std::move(other.scriptStack);
             subScriptResults = std::move(other.subScriptResults);
+            planCacheKey = std::move(other.planCacheKey);
+            cancellation = other.cancellation;
         }
         return *this;
     }
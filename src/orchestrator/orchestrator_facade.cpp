@@ -5,14 +5,19 @@
 #include "script_manager.h"
 #include "feedback_controller.h"
 #include "conversation_manager.h"
+#include "plan_cache.h"
 #include "orchestrator.h"  // For ExecutionContext
 #include "../command_parser/command_parser.h"
 #include "../llm_connector/llm_connector.h"
 #include "../task_engine/task_engine.h"
+#include "../environmental_perception/environmental_perception.h"
 #include "../common/structured_logger.h"
 #include "../common/config_manager.h"
+#include "../common/string_utils.h"
 #include <thread>
 #include <queue>
+#include <set>
+#include <algorithm>
 
 namespace burwell {
 
@@ -38,6 +43,13 @@ OrchestratorFacade::OrchestratorFacade()
     m_scriptManager = std::make_unique<ScriptManager>();
     m_feedbackController = std::make_unique<FeedbackController>();
     m_conversationManager = std::make_unique<ConversationManager>();
+    m_planCache = std::make_unique<PlanCache>();
+    
+    // Execution feedback decides which cached plans may be reused
+    PlanCache* planCache = m_planCache.get();
+    m_feedbackController->setPlanOutcomeListener([planCache](const std::string& planKey, bool success) {
+        planCache->recordOutcome(planKey, success);
+    });
     
     SLOG_INFO().message("OrchestratorFacade initialized");
 }
@@ -84,6 +96,30 @@ void OrchestratorFacade::initialize() {
         // Use default value
     }
     
+    try {
+        m_conversationManager->setSpeculativePlanningEnabled(config.get<bool>("orchestrator.speculative_planning"));
+    } catch (const std::runtime_error&) {
+        // Use default value
+    }
+    
+    try {
+        m_planCache->setCapacity(config.get<int>("orchestrator.plan_cache_capacity"));
+    } catch (const std::runtime_error&) {
+        // Use default value
+    }
+    
+    try {
+        m_executionEngine->setScriptOptimizationEnabled(config.get<bool>("orchestrator.optimize_scripts"));
+    } catch (const std::runtime_error&) {
+        // Use default value
+    }
+    
+    try {
+        m_executionEngine->setExecutionTraceEnabled(config.get<bool>("orchestrator.execution_trace"));
+    } catch (const std::runtime_error&) {
+        // Use default value
+    }
+    
     // Enable event history
     m_eventManager->enableEventHistory(true);
     
@@ -344,6 +380,9 @@ void OrchestratorFacade::cancelExecution(const std::string& requestId) {
         m_requestQueue = newQueue;
     }
     
+    // Wake whatever the request is blocked on (waits, delays, HTTP)
+    m_stateManager->cancelExecution(requestId);
+    
     // Mark as cancelled
     TaskExecutionResult result;
     result.success = false;
@@ -365,6 +404,11 @@ void OrchestratorFacade::emergencyStop() {
         std::swap(m_requestQueue, empty);
     }
     
+    // Interrupt requests that are already executing
+    for (const auto& requestId : m_stateManager->getActiveRequests()) {
+        m_stateManager->cancelExecution(requestId);
+    }
+    
     m_eventManager->raiseEvent(OrchestratorEvent::EMERGENCY_STOP, "Emergency stop activated");
     SLOG_CRITICAL().message("Emergency stop activated");
 }
@@ -397,7 +441,10 @@ nlohmann::json OrchestratorFacade::getSystemStatus() const {
         {"queuedRequests", 0},
         {"activeConversations", m_conversationManager->getActiveConversationCount()},
         {"feedbackLoopActive", m_feedbackController->isMonitoringActive()},
-        {"successMetrics", m_feedbackController->getSuccessMetrics()}
+        {"successMetrics", m_feedbackController->getSuccessMetrics()},
+        {"speculation", m_conversationManager->getSpeculationStats()},
+        {"planCache", m_planCache->getStats()},
+        {"scriptCache", m_executionEngine->getScriptCacheStats()}
     };
     
     {
@@ -433,6 +480,14 @@ void OrchestratorFacade::setEnvironmentCheckInterval(int intervalMs) {
     m_feedbackController->setEnvironmentCheckIntervalMs(intervalMs);
 }
 
+void OrchestratorFacade::setSpeculativePlanningEnabled(bool enabled) {
+    m_conversationManager->setSpeculativePlanningEnabled(enabled);
+}
+
+void OrchestratorFacade::setPlanCacheCapacity(size_t capacity) {
+    m_planCache->setCapacity(capacity);
+}
+
 // Private methods
 
 void OrchestratorFacade::initializeComponents() {
@@ -475,7 +530,7 @@ void OrchestratorFacade::workerThreadFunction() {
         if (m_stateManager->getActiveExecutionCount() >= static_cast<size_t>(m_maxConcurrentTasks)) {
             // Wait a bit before checking again
             lock.unlock();
-            std::this_thread::sleep_for(std::chrono::milliseconds(m_mainLoopDelayMs));
+            ShutdownManager::getInstance().getToken().sleepFor(std::chrono::milliseconds(m_mainLoopDelayMs));
             continue;
         }
         
@@ -548,13 +603,20 @@ TaskExecutionResult OrchestratorFacade::processRequestInternal(const std::string
         
         // Execute plan
         if (context.variables.find("execution_plan") != context.variables.end()) {
-            nlohmann::json plan = context.variables["execution_plan"];
+            nlohmann::json plan = context.variables["execution_plan"].toJson();
             
             if (m_errorRecoveryEnabled) {
                 result = executeWithErrorRecovery(plan, requestId);
             } else {
                 result = m_executionEngine->executeCommandSequence(plan["commands"], context);
             }
+            
+            // A plan only counts as good if it worked without a recovery rewrite
+            if (!context.planCacheKey.empty()) {
+                const auto& executedPlan = context.variables["execution_plan"];
+                bool planWorked = result.success && executedPlan.isJson() && executedPlan.asJson() == plan;
+                m_feedbackController->reportPlanOutcome(context.planCacheKey, planWorked);
+            }
         } else {
             result.success = false;
             result.errorMessage = "No execution plan generated";
@@ -604,7 +666,7 @@ TaskExecutionResult OrchestratorFacade::parseUserRequest(const std::string& user
         commandsArray.push_back(cmdJson);
     }
     context.variables["parsed_commands"] = commandsArray;
-    context.variables["intent"] = {
+    context.variables["intent"] = nlohmann::json{
         {"type", static_cast<int>(parseResult.intent.type)},
         {"confidence", static_cast<int>(parseResult.intent.confidence)}
     };
@@ -637,18 +699,44 @@ TaskExecutionResult OrchestratorFacade::generateExecutionPlan(const std::string&
         return result;
     }
     
+    // Recurring requests reuse a plan that already worked in this environment
+    bool planCacheEnabled = m_planCache->getCapacity() > 0;
+    std::string fingerprint;
+    if (planCacheEnabled) {
+        fingerprint = planCacheFingerprint();
+        PlanCache::Lookup cached = m_planCache->lookup(userInput, fingerprint);
+        if (cached.hit && planTargetsPresent(cached.plan)) {
+            SLOG_DEBUG().message("Using cached execution plan").context("request_id", requestId);
+            context.variables["execution_plan"] = std::move(cached.plan);
+            context.planCacheKey = cached.key;
+            result.success = true;
+            return result;
+        }
+        if (cached.hit) {
+            // The fingerprint is coarse; a fresh plan replaces this one when stored
+            SLOG_DEBUG().message("Cached execution plan targets a window that is gone")
+                .context("request_id", requestId);
+        }
+    }
+    
     // Initiate conversation for complex planning
     std::string conversationId = m_conversationManager->initiateConversation(userInput, context);
     
     // Wait for initial plan
     int attempts = 0;
+    CancellationToken cancellation = context.cancellation.token();
     while (attempts < 10 && m_conversationManager->isConversationActive(conversationId)) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (!cancellation.sleepFor(std::chrono::milliseconds(500))) {
+            break;
+        }
         
         // Check if plan is available
         auto convContext = m_conversationManager->getConversationContext(conversationId);
         if (convContext.find("execution_plan") != convContext.end()) {
             context.variables["execution_plan"] = convContext["execution_plan"];
+            if (planCacheEnabled) {
+                context.planCacheKey = m_planCache->store(userInput, fingerprint, convContext["execution_plan"]);
+            }
             result.success = true;
             break;
         }
@@ -689,7 +777,12 @@ TaskExecutionResult OrchestratorFacade::executeWithErrorRecovery(const nlohmann:
         }
         
         // Wait before retry
-        std::this_thread::sleep_for(std::chrono::milliseconds(m_errorRecoveryDelayMs));
+        if (!context.cancellation.token().sleepFor(std::chrono::milliseconds(m_errorRecoveryDelayMs))) {
+            result.success = false;
+            result.status = ExecutionStatus::CANCELLED;
+            result.errorMessage = "Execution cancelled by user";
+            break;
+        }
         
         retryCount++;
     }
@@ -697,6 +790,83 @@ TaskExecutionResult OrchestratorFacade::executeWithErrorRecovery(const nlohmann:
     return result;
 }
 
+std::string OrchestratorFacade::planCacheFingerprint() const {
+    if (!m_perception) {
+        return std::string();
+    }
+    
+    // Coarse on purpose: which application is in front and which kinds of windows are open
+    WindowInfo activeWindow = m_perception->getActiveWindow();
+    std::set<std::string> windowClasses;
+    for (const auto& window : m_perception->getVisibleWindows()) {
+        windowClasses.insert(window.className);
+    }
+    
+    std::string fingerprint = activeWindow.processName + "|" + activeWindow.className + "|";
+    for (const auto& windowClass : windowClasses) {
+        fingerprint += windowClass + ",";
+    }
+    return fingerprint;
+}
+
+bool OrchestratorFacade::planTargetsPresent(const nlohmann::json& plan) const {
+    if (!m_perception) {
+        return true;
+    }
+    
+    std::vector<WindowInfo> windows = m_perception->getVisibleWindows();
+    std::vector<std::string> titles;
+    for (const auto& window : windows) {
+        titles.push_back(utils::StringUtils::toLowerCase(window.title));
+    }
+    
+    // Literal window targets only; {{variables}} are resolved while the plan runs
+    auto literal = [](const nlohmann::json& params, const char* key, std::string& value) {
+        if (!params.contains(key) || !params[key].is_string()) {
+            return false;
+        }
+        value = params[key].get<std::string>();
+        return !value.empty() && value.find("{{") == std::string::npos;
+    };
+    std::function<bool(const nlohmann::json&)> commandsPresent = [&](const nlohmann::json& commands) {
+        if (!commands.is_array()) {
+            return true;
+        }
+        for (const auto& command : commands) {
+            if (!command.is_object()) {
+                continue;
+            }
+            if (command.contains("commands") && !commandsPresent(command["commands"])) {
+                return false;
+            }
+            if (!command.contains("command") || !command["command"].is_string() ||
+                command["command"].get<std::string>().find("WINDOW_") != 0 ||
+                !command.contains("parameters") || !command["parameters"].is_object()) {
+                continue;
+            }
+            const auto& params = command["parameters"];
+            std::string value;
+            if (literal(params, "title", value) || literal(params, "windowTitle", value)) {
+                std::string needle = utils::StringUtils::toLowerCase(value);
+                if (std::none_of(titles.begin(), titles.end(), [&needle](const std::string& title) {
+                        return title.find(needle) != std::string::npos;
+                    })) {
+                    return false;
+                }
+            }
+            if (literal(params, "className", value) || literal(params, "class_name", value)) {
+                if (std::none_of(windows.begin(), windows.end(), [&value](const WindowInfo& window) {
+                        return window.className == value;
+                    })) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    return !plan.contains("commands") || commandsPresent(plan["commands"]);
+}
+
 void OrchestratorFacade::handleExecutionError(const std::string& requestId, const std::string& error) {
     SLOG_ERROR().message("Execution error").context("request_id", requestId).context("error", error);
     
@@ -707,8 +877,9 @@ void OrchestratorFacade::handleExecutionError(const std::string& requestId, cons
     ExecutionContext& context = m_stateManager->getExecutionContext(requestId);
     context.variables["last_error"] = error;
     int errorCount = 0;
-    if (context.variables.find("error_count") != context.variables.end()) {
-        errorCount = context.variables["error_count"].get<int>();
+    auto errorCountIt = context.variables.find("error_count");
+    if (errorCountIt != context.variables.end() && errorCountIt->second.isInteger()) {
+        errorCount = static_cast<int>(errorCountIt->second.asInteger());
     }
     context.variables["error_count"] = errorCount + 1;
 }
@@ -730,6 +901,7 @@ TaskExecutionResult OrchestratorFacade::attemptErrorRecovery(const std::string&
         {"error", error},
         {"original_request", context.originalRequest},
         {"execution_log", context.executionLog},
+        {"execution_summary", context.executionLog.summary()},
         {"variables", context.variables}
     };
     
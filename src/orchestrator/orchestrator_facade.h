@@ -27,6 +27,7 @@ class EventManager;
 class ScriptManager;
 class FeedbackController;
 class ConversationManager;
+class PlanCache;
 
 /**
  * @class OrchestratorFacade
@@ -98,6 +99,12 @@ public:
     void setFeedbackLoopEnabled(bool enabled);
     void setEnvironmentCheckInterval(int intervalMs);
 
+    // Speculative planning (see ConversationManager)
+    void setSpeculativePlanningEnabled(bool enabled);
+
+    // Plan caching (see PlanCache); 0 disables
+    void setPlanCacheCapacity(size_t capacity);
+
 private:
     // Core components (injected dependencies)
     std::shared_ptr<CommandParser> m_commandParser;
@@ -114,6 +121,7 @@ private:
     std::unique_ptr<ScriptManager> m_scriptManager;
     std::unique_ptr<FeedbackController> m_feedbackController;
     std::unique_ptr<ConversationManager> m_conversationManager;
+    std::unique_ptr<PlanCache> m_planCache;
 
     // State management
     std::atomic<bool> m_isRunning;
@@ -149,6 +157,8 @@ private:
     TaskExecutionResult parseUserRequest(const std::string& userInput, const std::string& requestId);
     TaskExecutionResult generateExecutionPlan(const std::string& userInput, const std::string& requestId);
     TaskExecutionResult executeWithErrorRecovery(const nlohmann::json& plan, const std::string& requestId);
+    std::string planCacheFingerprint() const;
+    bool planTargetsPresent(const nlohmann::json& plan) const;
 
     // Error handling
     void handleExecutionError(const std::string& requestId, const std::string& error);
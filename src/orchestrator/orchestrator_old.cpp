@@ -365,8 +365,9 @@ TaskExecutionResult Orchestrator::generateExecutionPlan(const std::string& userI
             if (m_llmConnector->supportsVision()) {
                 auto screenshot = m_perception->captureScreen();
                 if (screenshot.isValid()) {
-                    llmContext.screenshotData = screenshot.data;
-                    llmContext.screenshotFormat = screenshot.format.empty() ? "png" : screenshot.format;
+                    llmContext.setScreenshot(std::move(screenshot.data),
+                                             screenshot.format.empty() ? "png" : screenshot.format,
+                                             screenshot.width, screenshot.height);
                     Logger::log(LogLevel::DEBUG, "Screenshot added to LLM context for vision-capable model");
                 }
             }
@@ -0,0 +1,401 @@
+#include "plan_cache.h"
+#include "../common/structured_logger.h"
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <numeric>
+
+namespace burwell {
+
+namespace {
+
+// Words whose following phrase is free-form input ("search for cute cats and ...")
+const char* const ARGUMENT_KEYWORDS[] = {"search", "type", "find", "named", "called", "titled"};
+// Words that end such a phrase
+const char* const PHRASE_TERMINATORS[] = {"and", "then"};
+
+const std::string SLOT_PLACEHOLDER = "{{slot:";
+
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0;
+}
+
+bool isOneOf(const std::string& word, const char* const* begin, const char* const* end) {
+    return std::find_if(begin, end, [&word](const char* candidate) { return word == candidate; }) != end;
+}
+
+bool looksLikeSlot(const std::string& word) {
+    if (word.find("://") != std::string::npos || word.compare(0, 4, "www.") == 0) {
+        return true;  // URL
+    }
+    if (word.find('/') != std::string::npos || word.find('\\') != std::string::npos ||
+        (word.size() >= 2 && std::isalpha(static_cast<unsigned char>(word[0])) && word[1] == ':')) {
+        return true;  // Path
+    }
+    bool hasDigit = false;
+    for (char c : word) {
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            hasDigit = true;
+        } else if (c != '.' && c != ',') {
+            return false;
+        }
+    }
+    return hasDigit;  // Number
+}
+
+// Whole-word occurrence of slot at pos; edges that are punctuation need no boundary
+bool matchesAt(const std::string& text, size_t pos, const std::string& slot) {
+    if (text.compare(pos, slot.size(), slot) != 0) {
+        return false;
+    }
+    size_t end = pos + slot.size();
+    bool leftBounded = pos == 0 || !isWordChar(text[pos - 1]) || !isWordChar(slot.front());
+    bool rightBounded = end == text.size() || !isWordChar(text[end]) || !isWordChar(slot.back());
+    return leftBounded && rightBounded;
+}
+
+// Parses "{{slot:N}}" at pos; returns the placeholder length or 0
+size_t parsePlaceholder(const std::string& text, size_t pos, size_t& index) {
+    if (text.compare(pos, SLOT_PLACEHOLDER.size(), SLOT_PLACEHOLDER) != 0) {
+        return 0;
+    }
+    size_t digitsStart = pos + SLOT_PLACEHOLDER.size();
+    size_t digitsEnd = digitsStart;
+    while (digitsEnd < text.size() && std::isdigit(static_cast<unsigned char>(text[digitsEnd]))) {
+        ++digitsEnd;
+    }
+    if (digitsEnd == digitsStart || text.compare(digitsEnd, 2, "}}") != 0) {
+        return 0;
+    }
+    index = std::stoul(text.substr(digitsStart, digitsEnd - digitsStart));
+    return digitsEnd + 2 - pos;
+}
+
+} // anonymous namespace
+
+PlanCache::PlanCache(size_t capacity)
+    : m_capacity(capacity)
+    , m_lookups(0)
+    , m_hits(0)
+    , m_stores(0)
+    , m_invalidations(0) {
+}
+
+void PlanCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    evictOverflow();
+}
+
+size_t PlanCache::getCapacity() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+}
+
+PlanCache::RequestTemplate PlanCache::normalizeRequest(const std::string& request) {
+    struct Item {
+        std::string text;
+        bool isSlot;
+    };
+    std::vector<Item> items;
+
+    size_t pos = 0;
+    while (pos < request.size()) {
+        char c = request[pos];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++pos;
+            continue;
+        }
+
+        // Quoted text is always a slot; a lone apostrophe ("don't") is not a quote
+        if (c == '"' || c == '\'') {
+            size_t close = request.find(c, pos + 1);
+            if (close != std::string::npos) {
+                items.push_back({request.substr(pos + 1, close - pos - 1), true});
+                pos = close + 1;
+                continue;
+            }
+        }
+
+        size_t end = pos;
+        while (end < request.size() && !std::isspace(static_cast<unsigned char>(request[end]))) {
+            ++end;
+        }
+        std::string word = request.substr(pos, end - pos);
+        pos = end;
+        while (!word.empty() && std::string(",.!?;:").find(word.back()) != std::string::npos) {
+            word.pop_back();
+        }
+        if (word.empty()) {
+            continue;
+        }
+        if (looksLikeSlot(word)) {
+            items.push_back({word, true});
+        } else {
+            items.push_back({word, false});
+        }
+    }
+
+    RequestTemplate result;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (items[i].isSlot) {
+            result.slots.push_back(items[i].text);
+            result.text += result.text.empty() ? "{}" : " {}";
+            continue;
+        }
+
+        std::string lower = items[i].text;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+        result.text += result.text.empty() ? lower : " " + lower;
+
+        if (!isOneOf(lower, std::begin(ARGUMENT_KEYWORDS), std::end(ARGUMENT_KEYWORDS))) {
+            continue;
+        }
+        if (lower == "search" && i + 1 < items.size() && !items[i + 1].isSlot) {
+            std::string next = items[i + 1].text;
+            std::transform(next.begin(), next.end(), next.begin(),
+                           [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+            if (next == "for") {
+                result.text += " for";
+                ++i;
+            }
+        }
+
+        // The free-form phrase up to "and"/"then" becomes one slot
+        std::string phrase;
+        size_t j = i + 1;
+        for (; j < items.size() && !items[j].isSlot; ++j) {
+            std::string word = items[j].text;
+            std::transform(word.begin(), word.end(), word.begin(),
+                           [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+            if (isOneOf(word, std::begin(PHRASE_TERMINATORS), std::end(PHRASE_TERMINATORS))) {
+                break;
+            }
+            phrase += phrase.empty() ? items[j].text : " " + items[j].text;
+        }
+        if (!phrase.empty()) {
+            result.slots.push_back(phrase);
+            result.text += " {}";
+            i = j - 1;
+        }
+    }
+
+    return result;
+}
+
+PlanCache::Lookup PlanCache::lookup(const std::string& request, const std::string& environmentFingerprint) {
+    RequestTemplate requestTemplate = normalizeRequest(request);
+    Lookup result;
+    result.key = makeKey(requestTemplate.text, environmentFingerprint);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_lookups;
+
+    auto indexIt = m_index.find(result.key);
+    if (indexIt == m_index.end()) {
+        return result;
+    }
+    const Entry& entry = *indexIt->second;
+    if (!entry.validated || entry.boundSlots.size() != requestTemplate.slots.size()) {
+        return result;
+    }
+    // Slots the plan does not mention must match exactly
+    for (size_t i = 0; i < entry.boundSlots.size(); ++i) {
+        if (!entry.boundSlots[i] && entry.literalSlots[i] != requestTemplate.slots[i]) {
+            return result;
+        }
+    }
+
+    nlohmann::json plan = entry.plan;
+    if (!bind(plan, requestTemplate.slots)) {
+        return result;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, indexIt->second);
+    ++m_hits;
+    result.hit = true;
+    result.plan = std::move(plan);
+    return result;
+}
+
+std::string PlanCache::store(const std::string& request, const std::string& environmentFingerprint,
+                             const nlohmann::json& plan) {
+    RequestTemplate requestTemplate = normalizeRequest(request);
+
+    Entry entry;
+    entry.key = makeKey(requestTemplate.text, environmentFingerprint);
+    entry.plan = parameterize(plan, requestTemplate.slots, entry.boundSlots);
+    entry.literalSlots.resize(requestTemplate.slots.size());
+    for (size_t i = 0; i < requestTemplate.slots.size(); ++i) {
+        if (!entry.boundSlots[i]) {
+            entry.literalSlots[i] = requestTemplate.slots[i];
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_capacity == 0) {
+        return std::string();
+    }
+
+    auto indexIt = m_index.find(entry.key);
+    if (indexIt != m_index.end()) {
+        m_entries.erase(indexIt->second);
+        m_index.erase(indexIt);
+    }
+    m_entries.push_front(std::move(entry));
+    m_index[m_entries.front().key] = m_entries.begin();
+    ++m_stores;
+    evictOverflow();
+
+    return m_entries.empty() ? std::string() : m_entries.front().key;
+}
+
+void PlanCache::recordOutcome(const std::string& key, bool success) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto indexIt = m_index.find(key);
+    if (indexIt == m_index.end()) {
+        return;
+    }
+
+    if (success) {
+        indexIt->second->validated = true;
+        indexIt->second->successCount++;
+        return;
+    }
+
+    SLOG_DEBUG().message("Invalidating cached plan after failed execution")
+        .context("successful_runs", indexIt->second->successCount);
+    m_entries.erase(indexIt->second);
+    m_index.erase(indexIt);
+    ++m_invalidations;
+}
+
+void PlanCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+}
+
+nlohmann::json PlanCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t validated = std::count_if(m_entries.begin(), m_entries.end(),
+                                     [](const Entry& entry) { return entry.validated; });
+    return {
+        {"capacity", m_capacity},
+        {"entries", m_entries.size()},
+        {"validatedEntries", validated},
+        {"lookups", m_lookups},
+        {"hits", m_hits},
+        {"hitRate", m_lookups > 0 ? static_cast<double>(m_hits) / m_lookups : 0.0},
+        {"stores", m_stores},
+        {"invalidations", m_invalidations}
+    };
+}
+
+std::string PlanCache::makeKey(const std::string& templateText, const std::string& environmentFingerprint) {
+    return templateText + '\n' + environmentFingerprint;
+}
+
+nlohmann::json PlanCache::parameterize(const nlohmann::json& plan, const std::vector<std::string>& slots,
+                                       std::vector<bool>& boundSlots) {
+    boundSlots.assign(slots.size(), false);
+
+    // Longest first so "new york" wins over "york"
+    std::vector<size_t> order(slots.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&slots](size_t a, size_t b) { return slots[a].size() > slots[b].size(); });
+
+    std::function<nlohmann::json(const nlohmann::json&)> walk = [&](const nlohmann::json& value) -> nlohmann::json {
+        if (value.is_object()) {
+            nlohmann::json result = nlohmann::json::object();
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                result[it.key()] = walk(it.value());
+            }
+            return result;
+        }
+        if (value.is_array()) {
+            nlohmann::json result = nlohmann::json::array();
+            for (const auto& element : value) {
+                result.push_back(walk(element));
+            }
+            return result;
+        }
+        // Only text is re-bound; a number equal to a slot may be a coincidence
+        if (!value.is_string()) {
+            return value;
+        }
+
+        const std::string& text = value.get_ref<const std::string&>();
+        std::string result;
+        result.reserve(text.size());
+        size_t pos = 0;
+        while (pos < text.size()) {
+            bool replaced = false;
+            for (size_t index : order) {
+                const std::string& slot = slots[index];
+                if (!slot.empty() && matchesAt(text, pos, slot)) {
+                    result += SLOT_PLACEHOLDER + std::to_string(index) + "}}";
+                    pos += slot.size();
+                    boundSlots[index] = true;
+                    replaced = true;
+                    break;
+                }
+            }
+            if (!replaced) {
+                result += text[pos++];
+            }
+        }
+        return result;
+    };
+
+    return walk(plan);
+}
+
+bool PlanCache::bind(nlohmann::json& plan, const std::vector<std::string>& slots) {
+    if (plan.is_object() || plan.is_array()) {
+        for (auto& element : plan) {
+            if (!bind(element, slots)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!plan.is_string()) {
+        return true;
+    }
+
+    const std::string& text = plan.get_ref<const std::string&>();
+    if (text.find(SLOT_PLACEHOLDER) == std::string::npos) {
+        return true;
+    }
+
+    std::string result;
+    size_t pos = 0;
+    size_t index = 0;
+    while (pos < text.size()) {
+        size_t length = parsePlaceholder(text, pos, index);
+        if (length == 0) {
+            result += text[pos++];
+            continue;
+        }
+        if (index >= slots.size()) {
+            return false;
+        }
+        result += slots[index];
+        pos += length;
+    }
+    plan = std::move(result);
+    return true;
+}
+
+void PlanCache::evictOverflow() {
+    while (m_entries.size() > m_capacity) {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+} // namespace burwell
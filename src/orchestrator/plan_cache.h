@@ -0,0 +1,84 @@
+#ifndef BURWELL_PLAN_CACHE_H
+#define BURWELL_PLAN_CACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+namespace burwell {
+
+/**
+ * @class PlanCache
+ * @brief Reuses execution plans for recurring requests
+ *
+ * Requests are reduced to a template ("open firefox and search {}") whose
+ * slots (quoted text, URLs, paths, numbers, search/type arguments) are
+ * re-bound into the cached plan, so "search cats" can reuse the plan made
+ * for "search dogs". Entries are keyed by template and a coarse environment
+ * fingerprint, are only served after one successful execution, and are
+ * dropped as soon as an execution of them fails.
+ */
+class PlanCache {
+public:
+    struct RequestTemplate {
+        std::string text;                   // Lower-case request with slots replaced by {}
+        std::vector<std::string> slots;     // Slot values in order of appearance
+    };
+
+    struct Lookup {
+        bool hit = false;
+        std::string key;                    // Pass to recordOutcome after execution
+        nlohmann::json plan;                // Plan with this request's slot values bound
+    };
+
+    explicit PlanCache(size_t capacity = 256);
+
+    void setCapacity(size_t capacity);      // 0 disables the cache
+    size_t getCapacity() const;
+
+    Lookup lookup(const std::string& request, const std::string& environmentFingerprint);
+
+    // Remembers a freshly generated plan; it is served once recordOutcome reports success
+    std::string store(const std::string& request, const std::string& environmentFingerprint,
+                      const nlohmann::json& plan);
+
+    void recordOutcome(const std::string& key, bool success);
+    void clear();
+    nlohmann::json getStats() const;
+
+    static RequestTemplate normalizeRequest(const std::string& request);
+
+private:
+    struct Entry {
+        std::string key;
+        nlohmann::json plan;                // Bound slots replaced by placeholders
+        std::vector<std::string> literalSlots;  // Values of slots the plan does not contain
+        std::vector<bool> boundSlots;
+        bool validated = false;
+        int successCount = 0;
+    };
+
+    static std::string makeKey(const std::string& templateText, const std::string& environmentFingerprint);
+    static nlohmann::json parameterize(const nlohmann::json& plan, const std::vector<std::string>& slots,
+                                       std::vector<bool>& boundSlots);
+    static bool bind(nlohmann::json& plan, const std::vector<std::string>& slots);
+    void evictOverflow();
+
+    size_t m_capacity;
+    std::list<Entry> m_entries;             // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+    mutable std::mutex m_mutex;
+
+    // Statistics
+    size_t m_lookups;
+    size_t m_hits;
+    size_t m_stores;
+    size_t m_invalidations;
+};
+
+} // namespace burwell
+
+#endif // BURWELL_PLAN_CACHE_H
@@ -0,0 +1,197 @@
+#include "script_cache.h"
+#include "../common/structured_logger.h"
+#include "../common/input_validator.h"
+#include "../common/file_utils.h"
+#include <chrono>
+#include <set>
+
+namespace burwell {
+
+ScriptCache::ScriptCache(CompileHook compile)
+    : m_compile(std::move(compile))
+    , m_hits(0)
+    , m_loads(0) {
+}
+
+std::shared_ptr<const nlohmann::json> ScriptCache::load(const std::string& scriptPath, std::string& error) {
+    bool cacheHit = false;
+    return load(scriptPath, error, cacheHit);
+}
+
+std::shared_ptr<const nlohmann::json> ScriptCache::load(const std::string& scriptPath, std::string& error, bool& cacheHit) {
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(scriptPath, ec);
+    if (!ec) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(scriptPath);
+        if (it != m_entries.end() && it->second.modified == modified) {
+            ++m_hits;
+            cacheHit = true;
+            return it->second.script;
+        }
+    }
+
+    auto validationResult = InputValidator::validateFilePath(scriptPath);
+    if (!validationResult.isValid) {
+        error = "Invalid script path: " + validationResult.errorMessage;
+        return nullptr;
+    }
+
+    std::string scriptContent;
+    if (!utils::FileUtils::readFileToString(scriptPath, scriptContent)) {
+        error = "Failed to read script file: " + scriptPath;
+        return nullptr;
+    }
+
+    nlohmann::json parsed;
+    try {
+        parsed = nlohmann::json::parse(scriptContent);
+    } catch (const nlohmann::json::parse_error& e) {
+        error = "Invalid JSON in script file: " + std::string(e.what());
+        return nullptr;
+    }
+
+    if (m_compile) {
+        m_compile(parsed);
+    }
+    auto script = std::make_shared<const nlohmann::json>(std::move(parsed));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_loads;
+    if (!ec) {
+        m_entries[scriptPath] = {script, modified};
+    }
+    return script;
+}
+
+ScriptCache::PreloadReport ScriptCache::preloadCallTree(const nlohmann::json& commands) {
+    auto startTime = std::chrono::steady_clock::now();
+    PreloadReport report;
+
+    struct Loaded {
+        std::shared_ptr<const nlohmann::json> script;
+        std::string error;
+        bool cacheHit = false;
+    };
+
+    std::set<std::string> seen;
+    std::vector<std::string> level;
+    for (auto& callee : findCallees(commands)) {
+        if (seen.insert(callee).second) {
+            level.push_back(std::move(callee));
+        }
+    }
+
+    while (!level.empty()) {
+        ++report.depth;
+        std::vector<Loaded> loaded(level.size());
+        for (size_t i = 0; i < level.size(); ++i) {
+            Loaded& result = loaded[i];
+            try {
+                result.script = load(level[i], result.error, result.cacheHit);
+                if (result.script && !validate(*result.script, result.error)) {
+                    result.script.reset();
+                }
+            } catch (const std::exception& e) {
+                result.script.reset();
+                result.error = e.what();
+            }
+        }
+
+        std::vector<std::string> nextLevel;
+        for (size_t i = 0; i < level.size(); ++i) {
+            if (!loaded[i].script) {
+                report.errors.push_back(level[i] + ": " + loaded[i].error);
+                SLOG_WARNING().message("Script in call tree cannot be executed")
+                    .context("script_path", level[i])
+                    .context("error", loaded[i].error);
+                continue;
+            }
+            if (loaded[i].cacheHit) {
+                ++report.cacheHits;
+            } else {
+                ++report.scriptsLoaded;
+            }
+            for (auto& callee : findCallees(*loaded[i].script)) {
+                if (seen.insert(callee).second) {
+                    nextLevel.push_back(std::move(callee));
+                }
+            }
+        }
+        level.swap(nextLevel);
+    }
+
+    report.elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - startTime).count();
+    return report;
+}
+
+std::vector<std::string> ScriptCache::findCallees(const nlohmann::json& commands) {
+    std::vector<std::string> callees;
+    collectCallees(commands, callees);
+    return callees;
+}
+
+void ScriptCache::collectCallees(const nlohmann::json& node, std::vector<std::string>& callees) {
+    if (node.is_object()) {
+        auto command = node.find("command");
+        auto parameters = node.find("parameters");
+        if (command != node.end() && *command == "EXECUTE_SCRIPT" &&
+            parameters != node.end() && parameters->is_object()) {
+            auto scriptPath = parameters->find("script_path");
+            // Paths built from variables are only known at run time
+            if (scriptPath != parameters->end() && scriptPath->is_string() &&
+                scriptPath->get_ref<const std::string&>().find("${") == std::string::npos) {
+                callees.push_back(scriptPath->get<std::string>());
+            }
+        }
+    }
+    if (node.is_structured()) {
+        for (const auto& child : node) {
+            collectCallees(child, callees);
+        }
+    }
+}
+
+bool ScriptCache::validate(const nlohmann::json& script, std::string& error) {
+    const nlohmann::json* commandArray = nullptr;
+    if (script.contains("commands") && script["commands"].is_array()) {
+        commandArray = &script["commands"];
+    } else if (script.contains("sequence") && script["sequence"].is_array()) {
+        commandArray = &script["sequence"];
+    }
+    if (!commandArray) {
+        error = "Script file must contain 'commands' or 'sequence' array";
+        return false;
+    }
+
+    for (size_t i = 0; i < commandArray->size(); ++i) {
+        const auto& command = (*commandArray)[i];
+        if (!command.is_object() || !command.contains("command") || !command["command"].is_string()) {
+            error = "Command " + std::to_string(i) + " is missing a 'command' name";
+            return false;
+        }
+    }
+    return true;
+}
+
+void ScriptCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+size_t ScriptCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+nlohmann::json ScriptCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return {
+        {"entries", m_entries.size()},
+        {"hits", m_hits},
+        {"loads", m_loads}
+    };
+}
+
+} // namespace burwell
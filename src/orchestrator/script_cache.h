@@ -0,0 +1,73 @@
+#ifndef BURWELL_SCRIPT_CACHE_H
+#define BURWELL_SCRIPT_CACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+#include <functional>
+#include <nlohmann/json.hpp>
+
+namespace burwell {
+
+/**
+ * @class ScriptCache
+ * @brief Parsed, validated scripts shared by every EXECUTE_SCRIPT call
+ *
+ * Entries are revalidated against the file's modification time, so edited
+ * scripts are picked up without re-reading unchanged ones. preloadCallTree
+ * walks the literal script_path values reachable from a command list and
+ * loads the whole call tree up front, so nested calls do not stall UI automation on disk I/O and broken callees
+ * are reported before the first command runs.
+ */
+class ScriptCache {
+public:
+    using CompileHook = std::function<void(nlohmann::json& script)>;
+
+    struct PreloadReport {
+        size_t scriptsLoaded = 0;
+        size_t cacheHits = 0;
+        size_t depth = 0;                       // Levels of the call tree walked
+        std::vector<std::string> errors;        // One "path: reason" per broken callee
+        double elapsedMs = 0.0;
+    };
+
+    // The hook runs once per (re)load, on the loading thread, and may rewrite the script
+    explicit ScriptCache(CompileHook compile = nullptr);
+
+    // Returns nullptr and sets error when the script cannot be read or parsed
+    std::shared_ptr<const nlohmann::json> load(const std::string& scriptPath, std::string& error);
+
+    PreloadReport preloadCallTree(const nlohmann::json& commands);
+
+    // Literal script_path values of EXECUTE_SCRIPT commands, including those in loop bodies
+    static std::vector<std::string> findCallees(const nlohmann::json& commands);
+    static bool validate(const nlohmann::json& script, std::string& error);
+
+    void clear();
+    size_t size() const;
+    nlohmann::json getStats() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const nlohmann::json> script;
+        std::filesystem::file_time_type modified;
+    };
+
+    std::shared_ptr<const nlohmann::json> load(const std::string& scriptPath, std::string& error, bool& cacheHit);
+    static void collectCallees(const nlohmann::json& node, std::vector<std::string>& callees);
+
+    CompileHook m_compile;
+    std::map<std::string, Entry> m_entries;
+    mutable std::mutex m_mutex;
+
+    // Statistics
+    size_t m_hits;
+    size_t m_loads;
+};
+
+} // namespace burwell
+
+#endif // BURWELL_SCRIPT_CACHE_H
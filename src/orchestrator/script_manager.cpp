@@ -10,6 +10,31 @@
 
 namespace burwell {
 
+namespace {
+
+// Read back through ${name}; longer outputs keep their start and end
+constexpr size_t MAX_SUB_SCRIPT_RESULT_BYTES = 64 * 1024;
+
+std::string boundedResult(const std::string& text) {
+    if (text.size() <= MAX_SUB_SCRIPT_RESULT_BYTES) {
+        return text;
+    }
+    // Cut on UTF-8 character boundaries so the result stays valid json text
+    auto isContinuation = [&text](size_t i) { return (static_cast<unsigned char>(text[i]) & 0xC0) == 0x80; };
+    size_t headEnd = MAX_SUB_SCRIPT_RESULT_BYTES / 2;
+    while (headEnd > 0 && isContinuation(headEnd)) {
+        --headEnd;
+    }
+    size_t tailStart = text.size() - MAX_SUB_SCRIPT_RESULT_BYTES / 2;
+    while (tailStart < text.size() && isContinuation(tailStart)) {
+        ++tailStart;
+    }
+    return text.substr(0, headEnd) + "\n... [" + std::to_string(tailStart - headEnd) + " bytes omitted] ...\n" +
+           text.substr(tailStart);
+}
+
+} // anonymous namespace
+
 ScriptManager::ScriptManager()
     : m_maxNestingLevel(3)
     , m_cachingEnabled(true)
@@ -89,12 +114,16 @@ TaskExecutionResult ScriptManager::executeScriptFile(const std::string& scriptPa
     }
     
     if (m_executionEngine && !commandArray.is_null()) {
+        // Top-level scripts warm their whole call tree so nested calls never wait on disk
+        if (context.nestingLevel == 1) {
+            m_executionEngine->preloadScripts(commandArray);
+        }
         result = m_executionEngine->executeCommandSequence(commandArray, context);
         
         // Store script result if requested
         if (script.contains("result_variable") && script["result_variable"].is_string()) {
             std::string resultVar = script["result_variable"];
-            context.subScriptResults[resultVar] = result.success ? result.output : result.errorMessage;
+            context.subScriptResults[resultVar] = boundedResult(result.success ? result.output : result.errorMessage);
         }
     } else {
         result.errorMessage = "Script must contain 'commands' or 'sequence' array";
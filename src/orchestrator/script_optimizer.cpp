@@ -0,0 +1,354 @@
+#include "script_optimizer.h"
+#include "variable_path.h"
+#include <algorithm>
+
+namespace burwell {
+
+namespace {
+
+// The parameter each UIA handler passes through substituteVariables; keep in
+// sync with ExecutionEngine::executeUiaCommand
+const std::map<std::string, std::string>& substitutedParameters() {
+    static const std::map<std::string, std::string> parameters = {
+        {"UIA_FOCUS_WINDOW", "hwnd"},
+        {"UIA_GET_WINDOW_TITLE", "hwnd"},
+        {"UIA_WINDOW_RESIZE", "hwnd"},
+        {"UIA_WINDOW_MOVE", "hwnd"},
+        {"UIA_GET_WINDOW_CLASS", "hwnd"},
+        {"UIA_GET_WINDOW_RECT", "hwnd"},
+        {"UIA_SET_CLIPBOARD", "text"},
+        {"UIA_KEY_PRESS", "key"},
+        {"UIA_KEY_RELEASE", "key"}
+    };
+    return parameters;
+}
+
+// Calls visit on every string the interpreter substitutes when it runs command
+template <typename Visit>
+void forEachSubstitutedParameter(nlohmann::json& command, Visit&& visit) {
+    auto type = command.find("command");
+    auto params = command.find("parameters");
+    if (type == command.end() || !type->is_string() || params == command.end() || !params->is_object()) {
+        return;
+    }
+
+    const std::string& commandType = type->get_ref<const std::string&>();
+    if (commandType == "EXECUTE_SCRIPT") {
+        auto variables = params->find("variables");
+        if (variables != params->end() && variables->is_object()) {
+            for (auto& value : *variables) {
+                if (value.is_string()) {
+                    visit(value.get_ref<std::string&>());
+                }
+            }
+        }
+        return;
+    }
+
+    auto parameter = substitutedParameters().find(commandType);
+    if (parameter != substitutedParameters().end()) {
+        auto value = params->find(parameter->second);
+        if (value != params->end() && value->is_string()) {
+            visit(value->get_ref<std::string&>());
+        }
+    }
+}
+
+bool isComparison(const std::string& commandType) {
+    return commandType == "IF_CONTAINS" || commandType == "IF_NOT_CONTAINS" ||
+           commandType == "IF_EQUALS" || commandType == "IF_NOT_EQUALS";
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+} // anonymous namespace
+
+ScriptOptimizer::Stats& ScriptOptimizer::Stats::operator+=(const Stats& other) {
+    foldedParameters += other.foldedParameters;
+    removedCommands += other.removedCommands;
+    hoistedParameters += other.hoistedParameters;
+    invariantConditions += other.invariantConditions;
+    return *this;
+}
+
+nlohmann::json ScriptOptimizer::Stats::toJson() const {
+    return {
+        {"folded_parameters", foldedParameters},
+        {"removed_commands", removedCommands},
+        {"hoisted_parameters", hoistedParameters},
+        {"invariant_conditions", invariantConditions}
+    };
+}
+
+bool ScriptOptimizer::WriteSet::mayAffect(const std::string& text) const {
+    if (unknown) {
+        return true;
+    }
+    for (const auto& name : names) {
+        if (text.find(name) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ScriptOptimizer::WriteSet ScriptOptimizer::collectWrites(const nlohmann::json& commands) {
+    WriteSet writes;
+    if (commands.is_array()) {
+        for (const auto& command : commands) {
+            collectCommandWrites(command, writes);
+        }
+    }
+    return writes;
+}
+
+void ScriptOptimizer::collectCommandWrites(const nlohmann::json& command, WriteSet& writes) {
+    if (!command.is_object()) {
+        return;
+    }
+    auto addName = [&writes](const nlohmann::json& name) {
+        if (name.is_string()) {
+            writes.names.insert(name.get<std::string>());
+        } else {
+            writes.unknown = true;
+        }
+    };
+
+    auto resultVariable = command.find("result_variable");
+    if (resultVariable != command.end()) {
+        addName(*resultVariable);
+    }
+
+    auto type = command.find("command");
+    auto params = command.find("parameters");
+    if (type == command.end() || !type->is_string() || params == command.end() || !params->is_object()) {
+        return;
+    }
+
+    const std::string& commandType = type->get_ref<const std::string&>();
+    if (commandType == "SET_VARIABLE" && params->contains("name")) {
+        addName((*params)["name"]);
+    }
+    if (params->contains("store_as")) {
+        addName((*params)["store_as"]);
+    }
+    if (commandType == "EXECUTE_SCRIPT" && params->contains("result_variable")) {
+        writes.unknown = true;
+    }
+    if (commandType == "WHILE_LOOP") {
+        const nlohmann::json* body = params->contains("commands") ? &(*params)["commands"]
+                                   : params->contains("sequence") ? &(*params)["sequence"] : nullptr;
+        if (body && body->is_array()) {
+            for (const auto& nested : *body) {
+                collectCommandWrites(nested, writes);
+            }
+        }
+    }
+}
+
+ScriptOptimizer::Stats ScriptOptimizer::foldConstants(nlohmann::json& script) {
+    Stats stats;
+    if (!script.is_object()) {
+        return stats;
+    }
+
+    // Same choice of command list as ExecutionEngine::executeScriptFile
+    nlohmann::json* commands = nullptr;
+    if (script.contains("commands") && script["commands"].is_array()) {
+        commands = &script["commands"];
+    } else if (script.contains("sequence") && script["sequence"].is_array()) {
+        commands = &script["sequence"];
+    }
+    if (commands) {
+        // Nothing is known on entry; callers pass their own variables in
+        Constants constants;
+        foldSequence(*commands, constants, stats);
+    }
+    return stats;
+}
+
+void ScriptOptimizer::foldSequence(nlohmann::json& commands, Constants& constants, Stats& stats) {
+    for (size_t i = 0; i < commands.size(); ++i) {
+        auto& command = commands[i];
+        if (!command.is_object() || !command.contains("command") || !command["command"].is_string()) {
+            // Execution fails here, nothing after it runs
+            return;
+        }
+        const std::string commandType = command["command"];
+
+        forEachSubstitutedParameter(command, [&constants, &stats](std::string& text) {
+            if (text.find("${") == std::string::npos) {
+                return;
+            }
+            std::string folded;
+            bool resolved = expandVariables(text, folded, [&constants](const std::string& expression, std::string& out) {
+                // Nested paths may still resolve through a variable the caller passes in
+                if (VariablePath::compile(expression).hasSteps()) {
+                    return false;
+                }
+                auto constant = constants.find(expression);
+                if (constant == constants.end()) {
+                    return false;
+                }
+                constant->second.appendTo(out);
+                return true;
+            });
+            if (resolved && folded.find("${") == std::string::npos) {
+                text = std::move(folded);
+                ++stats.foldedParameters;
+            }
+        });
+
+        static const nlohmann::json noParameters = nlohmann::json::object();
+        const nlohmann::json& params = command.contains("parameters") && command["parameters"].is_object()
+                                       ? command["parameters"] : noParameters;
+
+        // Values this command is known to assign, decided before its writes land
+        std::string definedName;
+        ScriptValue definedValue;
+        bool defines = false;
+
+        if (commandType == "SET_VARIABLE") {
+            if (params.contains("name") && params["name"].is_string() && params.contains("value")) {
+                definedName = params["name"].get<std::string>();
+                definedValue = ScriptValue(params["value"]);
+                defines = true;
+            }
+        } else if (isComparison(commandType)) {
+            const char* operandKey = commandType.find("CONTAINS") != std::string::npos ? "substring" : "value";
+            auto variable = params.find("variable");
+            auto operand = params.find(operandKey);
+            auto storeAs = params.find("store_as");
+            if (variable != params.end() && variable->is_string() && operand != params.end() && operand->is_string() &&
+                storeAs != params.end() && storeAs->is_string()) {
+                auto constant = constants.find(variable->get<std::string>());
+                if (constant != constants.end()) {
+                    std::string value = toLower(constant->second.toString());
+                    std::string compareTo = toLower(operand->get<std::string>());
+                    bool outcome = commandType.find("CONTAINS") != std::string::npos
+                                   ? value.find(compareTo) != std::string::npos
+                                   : value == compareTo;
+                    if (commandType.find("_NOT_") != std::string::npos) {
+                        outcome = !outcome;
+                    }
+                    definedName = storeAs->get<std::string>();
+                    definedValue = outcome;
+                    defines = true;
+                }
+            }
+        } else if (commandType == "CONDITIONAL_STOP" || commandType == "BREAK_IF") {
+            auto variable = params.find("condition_variable");
+            auto invert = params.find("invert");
+            bool invertible = commandType == "CONDITIONAL_STOP";
+            if (variable != params.end() && variable->is_string() &&
+                (!invertible || invert == params.end() || invert->is_boolean())) {
+                auto constant = constants.find(variable->get<std::string>());
+                if (constant != constants.end()) {
+                    bool fires = constant->second.isTruthy();
+                    if (invertible && invert != params.end() && invert->get<bool>()) {
+                        fires = !fires;
+                    }
+                    if (fires) {
+                        stats.removedCommands += commands.size() - i - 1;
+                        commands.erase(commands.begin() + static_cast<std::ptrdiff_t>(i) + 1, commands.end());
+                        return;
+                    }
+                }
+            }
+        } else if (commandType == "WHILE_LOOP") {
+            if (nlohmann::json* body = loopBody(command)) {
+                // Every iteration starts with what the body leaves alone
+                WriteSet bodyWrites = collectWrites(*body);
+                Constants bodyConstants;
+                if (!bodyWrites.unknown) {
+                    bodyConstants = constants;
+                    for (const auto& name : bodyWrites.names) {
+                        bodyConstants.erase(name);
+                    }
+                }
+                foldSequence(*body, bodyConstants, stats);
+            }
+        }
+
+        WriteSet writes;
+        collectCommandWrites(command, writes);
+        if (writes.unknown) {
+            constants.clear();
+        } else {
+            for (const auto& name : writes.names) {
+                constants.erase(name);
+            }
+        }
+        if (defines) {
+            constants[definedName] = std::move(definedValue);
+            // result_variable is stored after the handler runs
+            auto resultVariable = command.find("result_variable");
+            if (resultVariable != command.end() && resultVariable->is_string()) {
+                constants.erase(resultVariable->get<std::string>());
+            }
+        }
+    }
+}
+
+ScriptOptimizer::LoopPlan ScriptOptimizer::planLoop(const nlohmann::json& body, const nlohmann::json* condition,
+                                                     const Substitute& substitute, Stats& stats) {
+    LoopPlan plan;
+    WriteSet writes = collectWrites(body);
+    if (writes.unknown) {
+        return plan;
+    }
+
+    if (condition && condition->is_string() && !writes.mayAffect(condition->get_ref<const std::string&>())) {
+        plan.conditionInvariant = true;
+        ++stats.invariantConditions;
+    }
+
+    nlohmann::json rewritten = body;
+    size_t hoisted = stats.hoistedParameters;
+    hoistSequence(rewritten, writes, substitute, stats);
+    if (stats.hoistedParameters != hoisted) {
+        plan.body = std::move(rewritten);
+    }
+    return plan;
+}
+
+void ScriptOptimizer::hoistSequence(nlohmann::json& commands, const WriteSet& writes,
+                                    const Substitute& substitute, Stats& stats) {
+    if (!commands.is_array()) {
+        return;
+    }
+    for (auto& command : commands) {
+        forEachSubstitutedParameter(command, [&](std::string& text) {
+            if (text.find("${") == std::string::npos || writes.mayAffect(text)) {
+                return;
+            }
+            std::string value = substitute(text);
+            // Runtime substitution of the result must leave it unchanged
+            if (value.find("${") == std::string::npos) {
+                text = std::move(value);
+                ++stats.hoistedParameters;
+            }
+        });
+        if (command.is_object() && command.value("command", nlohmann::json()) == "WHILE_LOOP") {
+            if (nlohmann::json* body = loopBody(command)) {
+                hoistSequence(*body, writes, substitute, stats);
+            }
+        }
+    }
+}
+
+nlohmann::json* ScriptOptimizer::loopBody(nlohmann::json& command) {
+    auto params = command.find("parameters");
+    if (params == command.end() || !params->is_object()) {
+        return nullptr;
+    }
+    // Same precedence as ExecutionEngine::executeWhileLoop
+    nlohmann::json* body = params->contains("commands") ? &(*params)["commands"]
+                         : params->contains("sequence") ? &(*params)["sequence"] : nullptr;
+    return body && body->is_array() ? body : nullptr;
+}
+
+} // namespace burwell
@@ -0,0 +1,79 @@
+#ifndef BURWELL_SCRIPT_OPTIMIZER_H
+#define BURWELL_SCRIPT_OPTIMIZER_H
+
+#include <string>
+#include <set>
+#include <map>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include "script_value.h"
+
+namespace burwell {
+
+/**
+ * @class ScriptOptimizer
+ * @brief Dataflow passes that keep loop bodies from redoing work whose result cannot change
+ *
+ * foldConstants runs once when a script is compiled: values assigned by
+ * literal SET_VARIABLE commands, and the IF_* results they decide, are
+ * propagated forward; ${...} references to them are replaced by the text
+ * they expand to, and commands after a CONDITIONAL_STOP or BREAK_IF that
+ * always fires are dropped. planLoop runs when a loop starts its second
+ * iteration: variables the body never assigns keep their values until the
+ * loop exits, so parameters built only from them are substituted once and
+ * a condition that only reads them is not evaluated again.
+ *
+ * Only parameters the interpreter substitutes itself are rewritten, and only
+ * when the whole string can be, so optimized commands behave exactly like
+ * the originals.
+ */
+class ScriptOptimizer {
+public:
+    struct Stats {
+        size_t foldedParameters = 0;            // Replaced by compile-time constants
+        size_t removedCommands = 0;             // Unreachable after a stop that always fires
+        size_t hoistedParameters = 0;           // Substituted once per loop instead of per iteration
+        size_t invariantConditions = 0;         // Loop conditions evaluated once
+
+        Stats& operator+=(const Stats& other);
+        nlohmann::json toJson() const;
+    };
+
+    // Variables a command list may assign, including nested loop bodies
+    struct WriteSet {
+        std::set<std::string> names;
+        bool unknown = false;                   // EXECUTE_SCRIPT with result_variable copies back every child variable
+
+        // Conservative: true when any assigned name occurs anywhere in text
+        bool mayAffect(const std::string& text) const;
+    };
+
+    struct LoopPlan {
+        nlohmann::json body;                    // Rewritten body; null when the original is unchanged
+        bool conditionInvariant = false;
+    };
+
+    using Substitute = std::function<std::string(const std::string& text)>;
+
+    static WriteSet collectWrites(const nlohmann::json& commands);
+
+    // Folds the command list of a freshly loaded script in place
+    static Stats foldConstants(nlohmann::json& script);
+
+    // substitute expands text against the loop's current variables
+    static LoopPlan planLoop(const nlohmann::json& body, const nlohmann::json* condition,
+                             const Substitute& substitute, Stats& stats);
+
+private:
+    using Constants = std::map<std::string, ScriptValue>;
+
+    static void collectCommandWrites(const nlohmann::json& command, WriteSet& writes);
+    static void foldSequence(nlohmann::json& commands, Constants& constants, Stats& stats);
+    static void hoistSequence(nlohmann::json& commands, const WriteSet& writes,
+                              const Substitute& substitute, Stats& stats);
+    static nlohmann::json* loopBody(nlohmann::json& command);
+};
+
+} // namespace burwell
+
+#endif // BURWELL_SCRIPT_OPTIMIZER_H
@@ -0,0 +1,265 @@
+#include "script_value.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace burwell {
+
+ScriptValue::ScriptValue(std::string_view value) : ScriptValue() {
+    assignString(value);
+}
+
+ScriptValue::ScriptValue(std::string&& value) : ScriptValue() {
+    if (value.size() <= INLINE_CAPACITY) {
+        assignString(value);
+    } else {
+        m_storage.heapString = new std::string(std::move(value));
+        m_heapString = true;
+        m_type = Type::String;
+    }
+}
+
+ScriptValue::ScriptValue(const nlohmann::json& value) : ScriptValue() {
+    switch (value.type()) {
+        case nlohmann::json::value_t::null:
+            break;
+        case nlohmann::json::value_t::boolean:
+            m_storage.boolean = value.get<bool>();
+            m_type = Type::Boolean;
+            break;
+        case nlohmann::json::value_t::number_integer:
+            assignInteger(value.get<int64_t>());
+            break;
+        case nlohmann::json::value_t::number_unsigned:
+            assignInteger(value.get<uint64_t>());
+            break;
+        case nlohmann::json::value_t::number_float:
+            m_storage.number = value.get<double>();
+            m_type = Type::Double;
+            break;
+        case nlohmann::json::value_t::string:
+            assignString(value.get_ref<const std::string&>());
+            break;
+        default:
+            m_storage.json = new nlohmann::json(value);
+            m_type = Type::Json;
+            break;
+    }
+}
+
+ScriptValue::ScriptValue(nlohmann::json&& value) : ScriptValue() {
+    if (value.is_structured()) {
+        m_storage.json = new nlohmann::json(std::move(value));
+        m_type = Type::Json;
+    } else if (value.is_string() && value.get_ref<const std::string&>().size() > INLINE_CAPACITY) {
+        m_storage.heapString = new std::string(std::move(value.get_ref<std::string&>()));
+        m_heapString = true;
+        m_type = Type::String;
+    } else {
+        *this = ScriptValue(static_cast<const nlohmann::json&>(value));
+    }
+}
+
+ScriptValue::ScriptValue(const ScriptValue& other) : ScriptValue() {
+    copyFrom(other);
+}
+
+ScriptValue::ScriptValue(ScriptValue&& other) noexcept : ScriptValue() {
+    moveFrom(other);
+}
+
+ScriptValue& ScriptValue::operator=(const ScriptValue& other) {
+    if (this != &other) {
+        ScriptValue copy(other);
+        reset();
+        moveFrom(copy);
+    }
+    return *this;
+}
+
+ScriptValue& ScriptValue::operator=(ScriptValue&& other) noexcept {
+    if (this != &other) {
+        reset();
+        moveFrom(other);
+    }
+    return *this;
+}
+
+std::string_view ScriptValue::asString() const {
+    if (m_heapString) {
+        return *m_storage.heapString;
+    }
+    return std::string_view(m_storage.inlineChars, m_inlineSize);
+}
+
+std::string ScriptValue::toString() const {
+    if (m_type == Type::String) {
+        return std::string(asString());
+    }
+    return dump();
+}
+
+void ScriptValue::appendTo(std::string& out) const {
+    switch (m_type) {
+        case Type::String:
+            out.append(asString());
+            break;
+        case Type::Integer:
+            out += std::to_string(m_storage.integer);
+            break;
+        case Type::Boolean:
+            out += m_storage.boolean ? "true" : "false";
+            break;
+        default:
+            out += dump();
+            break;
+    }
+}
+
+std::string ScriptValue::dump() const {
+    switch (m_type) {
+        case Type::Null:
+            return "null";
+        case Type::Boolean:
+            return m_storage.boolean ? "true" : "false";
+        case Type::Integer:
+            return std::to_string(m_storage.integer);
+        case Type::Double:
+            return nlohmann::json(m_storage.number).dump();
+        case Type::String:
+            return nlohmann::json(std::string(asString())).dump();
+        case Type::Json:
+            return m_storage.json->dump();
+    }
+    return "null";
+}
+
+nlohmann::json ScriptValue::toJson() const {
+    switch (m_type) {
+        case Type::Null:
+            return nullptr;
+        case Type::Boolean:
+            return m_storage.boolean;
+        case Type::Integer:
+            return m_storage.integer;
+        case Type::Double:
+            return m_storage.number;
+        case Type::String:
+            return std::string(asString());
+        case Type::Json:
+            return *m_storage.json;
+    }
+    return nullptr;
+}
+
+const char* ScriptValue::typeName() const {
+    switch (m_type) {
+        case Type::Null:
+            return "null";
+        case Type::Boolean:
+            return "boolean";
+        case Type::Integer:
+        case Type::Double:
+            return "number";
+        case Type::String:
+            return "string";
+        case Type::Json:
+            return m_storage.json->type_name();
+    }
+    return "null";
+}
+
+bool ScriptValue::isTruthy() const {
+    if (m_type == Type::Boolean) {
+        return m_storage.boolean;
+    }
+    if (m_type != Type::String) {
+        return false;
+    }
+    auto equalsIgnoreCase = [](std::string_view text, std::string_view lower) {
+        return text.size() == lower.size() &&
+               std::equal(text.begin(), text.end(), lower.begin(),
+                          [](char a, char b) { return ::tolower(static_cast<unsigned char>(a)) == b; });
+    };
+    std::string_view text = asString();
+    return equalsIgnoreCase(text, "true") || text == "1" || equalsIgnoreCase(text, "yes");
+}
+
+bool ScriptValue::operator==(const ScriptValue& other) const {
+    if (m_type == Type::Json || other.m_type == Type::Json) {
+        return toJson() == other.toJson();
+    }
+    if (isNumber() && other.isNumber()) {
+        if (m_type == Type::Integer && other.m_type == Type::Integer) {
+            return m_storage.integer == other.m_storage.integer;
+        }
+        return asNumber() == other.asNumber();
+    }
+    if (m_type != other.m_type) {
+        return false;
+    }
+    switch (m_type) {
+        case Type::Boolean:
+            return m_storage.boolean == other.m_storage.boolean;
+        case Type::String:
+            return asString() == other.asString();
+        default:
+            return true;
+    }
+}
+
+void ScriptValue::assignString(std::string_view value) {
+    if (value.size() <= INLINE_CAPACITY) {
+        std::memcpy(m_storage.inlineChars, value.data(), value.size());
+        m_storage.inlineChars[value.size()] = '\0';
+        m_inlineSize = static_cast<uint8_t>(value.size());
+        m_heapString = false;
+    } else {
+        m_storage.heapString = new std::string(value);
+        m_heapString = true;
+    }
+    m_type = Type::String;
+}
+
+void ScriptValue::copyFrom(const ScriptValue& other) {
+    if (other.m_type == Type::Json) {
+        m_storage.json = new nlohmann::json(*other.m_storage.json);
+    } else if (other.m_heapString) {
+        m_storage.heapString = new std::string(*other.m_storage.heapString);
+    } else {
+        m_storage = other.m_storage;
+    }
+    m_type = other.m_type;
+    m_heapString = other.m_heapString;
+    m_inlineSize = other.m_inlineSize;
+}
+
+void ScriptValue::moveFrom(ScriptValue& other) noexcept {
+    // Heap pointers are stolen with the raw storage
+    m_storage = other.m_storage;
+    m_type = other.m_type;
+    m_heapString = other.m_heapString;
+    m_inlineSize = other.m_inlineSize;
+    other.m_type = Type::Null;
+    other.m_heapString = false;
+}
+
+void ScriptValue::reset() noexcept {
+    if (m_type == Type::Json) {
+        delete m_storage.json;
+    } else if (m_heapString) {
+        delete m_storage.heapString;
+    }
+    m_type = Type::Null;
+    m_heapString = false;
+}
+
+void to_json(nlohmann::json& j, const ScriptValue& value) {
+    j = value.toJson();
+}
+
+void from_json(const nlohmann::json& j, ScriptValue& value) {
+    value = ScriptValue(j);
+}
+
+} // namespace burwell
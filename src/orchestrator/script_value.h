@@ -0,0 +1,112 @@
+#ifndef BURWELL_SCRIPT_VALUE_H
+#define BURWELL_SCRIPT_VALUE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <nlohmann/json.hpp>
+
+namespace burwell {
+
+/**
+ * @class ScriptValue
+ * @brief Compact tagged value stored in ExecutionContext::variables
+ *
+ * Loop counters, flags and short strings are held inline (strings up to
+ * INLINE_CAPACITY bytes need no allocation); objects, arrays and anything
+ * else json can express are kept as a heap-allocated nlohmann::json.
+ * Conversion to and from json is lossless, so scripts, saved state and LLM
+ * prompts see exactly the values they stored.
+ */
+class ScriptValue {
+public:
+    enum class Type : uint8_t { Null, Boolean, Integer, Double, String, Json };
+
+    static constexpr size_t INLINE_CAPACITY = 22;
+
+    ScriptValue() noexcept : m_type(Type::Null), m_heapString(false) { m_storage.integer = 0; }
+    ScriptValue(std::nullptr_t) noexcept : ScriptValue() {}
+    ScriptValue(bool value) noexcept : m_type(Type::Boolean), m_heapString(false) { m_storage.boolean = value; }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                                  !std::is_same<T, char>::value, int>::type = 0>
+    ScriptValue(T value) : ScriptValue() { assignInteger(value); }
+    ScriptValue(double value) noexcept : m_type(Type::Double), m_heapString(false) { m_storage.number = value; }
+    ScriptValue(const char* value) : ScriptValue(std::string_view(value)) {}
+    ScriptValue(std::string_view value);
+    ScriptValue(const std::string& value) : ScriptValue(std::string_view(value)) {}
+    ScriptValue(std::string&& value);
+    ScriptValue(const nlohmann::json& value);
+    ScriptValue(nlohmann::json&& value);
+
+    ScriptValue(const ScriptValue& other);
+    ScriptValue(ScriptValue&& other) noexcept;
+    ScriptValue& operator=(const ScriptValue& other);
+    ScriptValue& operator=(ScriptValue&& other) noexcept;
+    ~ScriptValue() { reset(); }
+
+    Type type() const { return m_type; }
+    bool isNull() const { return m_type == Type::Null; }
+    bool isBool() const { return m_type == Type::Boolean; }
+    bool isInteger() const { return m_type == Type::Integer; }
+    bool isDouble() const { return m_type == Type::Double; }
+    bool isNumber() const { return m_type == Type::Integer || m_type == Type::Double; }
+    bool isString() const { return m_type == Type::String; }
+    bool isJson() const { return m_type == Type::Json; }
+
+    // Accessors for the matching type; callers check the type first
+    bool asBool() const { return m_storage.boolean; }
+    int64_t asInteger() const { return m_storage.integer; }
+    double asNumber() const { return m_type == Type::Integer ? static_cast<double>(m_storage.integer) : m_storage.number; }
+    std::string_view asString() const;
+    const nlohmann::json& asJson() const { return *m_storage.json; }
+
+    // Strings without quotes, everything else as json text (what ${var} expands to)
+    std::string toString() const;
+    void appendTo(std::string& out) const;
+    // json text, as nlohmann::json::dump() would produce
+    std::string dump() const;
+    nlohmann::json toJson() const;
+    const char* typeName() const;
+    // Flag semantics of CONDITIONAL_STOP and BREAK_IF: booleans, or "true"/"1"/"yes" in any case
+    bool isTruthy() const;
+
+    bool operator==(const ScriptValue& other) const;
+    bool operator!=(const ScriptValue& other) const { return !(*this == other); }
+
+private:
+    template <typename T>
+    void assignInteger(T value) {
+        if (std::is_unsigned<T>::value && static_cast<uint64_t>(value) > static_cast<uint64_t>(INT64_MAX)) {
+            // Keep the unsigned json type so the value round-trips unchanged
+            m_storage.json = new nlohmann::json(value);
+            m_type = Type::Json;
+        } else {
+            m_storage.integer = static_cast<int64_t>(value);
+            m_type = Type::Integer;
+        }
+    }
+    void assignString(std::string_view value);
+    void copyFrom(const ScriptValue& other);
+    void moveFrom(ScriptValue& other) noexcept;
+    void reset() noexcept;
+
+    union Storage {
+        bool boolean;
+        int64_t integer;
+        double number;
+        char inlineChars[INLINE_CAPACITY + 1];
+        std::string* heapString;
+        nlohmann::json* json;
+    } m_storage;
+    Type m_type;
+    bool m_heapString;
+    uint8_t m_inlineSize = 0;
+};
+
+void to_json(nlohmann::json& j, const ScriptValue& value);
+void from_json(const nlohmann::json& j, ScriptValue& value);
+
+} // namespace burwell
+
+#endif // BURWELL_SCRIPT_VALUE_H
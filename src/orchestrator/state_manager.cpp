@@ -101,6 +101,23 @@ bool StateManager::isExecutionActive(const std::string& requestId) const {
            !hasExecutionResult(requestId);
 }
 
+bool StateManager::cancelExecution(const std::string& requestId) {
+    CancellationSource cancellation;
+    {
+        std::lock_guard<std::mutex> lock(m_contextMutex);
+        auto it = m_executionContexts.find(requestId);
+        if (it == m_executionContexts.end()) {
+            return false;
+        }
+        cancellation = it->second.cancellation;
+    }
+    
+    // Outside the lock: cancellation callbacks wake the executing thread
+    cancellation.cancel();
+    logActivity("Execution cancellation requested: " + requestId);
+    return true;
+}
+
 std::vector<std::string> StateManager::getActiveRequests() const {
     std::vector<std::string> activeRequests;
     
@@ -174,7 +191,7 @@ nlohmann::json StateManager::getVariable(const std::string& requestId, const std
     if (it != m_executionContexts.end()) {
         auto varIt = it->second.variables.find(name);
         if (varIt != it->second.variables.end()) {
-            return varIt->second;
+            return varIt->second.toJson();
         }
     }
     return nlohmann::json();
@@ -337,7 +354,8 @@ void StateManager::importState(const nlohmann::json& state) {
             ExecutionContext context;
             context.requestId = contextData.value("requestId", "");
             context.originalRequest = contextData.value("originalRequest", "");
-            context.variables = contextData.value("variables", nlohmann::json::object());
+            context.variables = contextData.value("variables", nlohmann::json::object())
+                .get<std::map<std::string, ScriptValue>>();
             context.nestingLevel = contextData.value("nestingLevel", 0);
             
             if (contextData.contains("scriptStack")) {
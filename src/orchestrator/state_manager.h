@@ -45,6 +45,7 @@ public:
     void markExecutionActive(const std::string& requestId);
     void markExecutionComplete(const std::string& requestId, const TaskExecutionResult& result);
     bool isExecutionActive(const std::string& requestId) const;
+    bool cancelExecution(const std::string& requestId);
     std::vector<std::string> getActiveRequests() const;
     size_t getActiveExecutionCount() const;
 
@@ -0,0 +1,131 @@
+#include "variable_path.h"
+#include <limits>
+#include <mutex>
+
+namespace burwell {
+
+VariablePath VariablePath::compile(const std::string& expression) {
+    VariablePath path;
+    size_t pos = expression.find_first_of(".[");
+    path.m_root = expression.substr(0, pos);
+    if (path.m_root.empty()) {
+        path.m_root = expression;
+        return path;
+    }
+
+    while (pos < expression.size()) {
+        Step step;
+        if (expression[pos] == '.') {
+            size_t end = expression.find_first_of(".[", pos + 1);
+            step.field = expression.substr(pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+            if (step.field.empty()) {
+                break;
+            }
+            pos = end;
+        } else {
+            size_t digit = pos + 1;
+            size_t index = 0;
+            for (; digit < expression.size() && expression[digit] >= '0' && expression[digit] <= '9'; ++digit) {
+                if (index > (std::numeric_limits<size_t>::max() - 9) / 10) {
+                    break;
+                }
+                index = index * 10 + static_cast<size_t>(expression[digit] - '0');
+            }
+            if (digit == pos + 1 || digit >= expression.size() || expression[digit] != ']') {
+                break;
+            }
+            step.index = index;
+            step.isIndex = true;
+            pos = digit + 1;
+        }
+        path.m_steps.push_back(std::move(step));
+    }
+
+    if (pos < expression.size()) {
+        // Malformed path such as "a..b" or "a[x]"
+        path.m_root = expression;
+        path.m_steps.clear();
+        return path;
+    }
+    path.m_isPath = true;
+    return path;
+}
+
+const nlohmann::json* VariablePath::resolve(const nlohmann::json& value) const {
+    const nlohmann::json* current = &value;
+    for (const auto& step : m_steps) {
+        if (step.isIndex) {
+            if (!current->is_array() || step.index >= current->size()) {
+                return nullptr;
+            }
+            current = &(*current)[step.index];
+        } else {
+            if (!current->is_object()) {
+                return nullptr;
+            }
+            auto it = current->find(step.field);
+            if (it == current->end()) {
+                return nullptr;
+            }
+            current = &*it;
+        }
+    }
+    return current;
+}
+
+VariablePathCache::VariablePathCache(size_t capacity)
+    : m_capacity(capacity) {
+}
+
+std::shared_ptr<const VariablePath> VariablePathCache::get(const std::string& expression) {
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_paths.find(expression);
+        if (it != m_paths.end()) {
+            return it->second;
+        }
+    }
+
+    auto path = std::make_shared<const VariablePath>(VariablePath::compile(expression));
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if (m_paths.size() < m_capacity) {
+        m_paths.emplace(expression, path);
+    }
+    return path;
+}
+
+void VariablePathCache::precompile(const nlohmann::json& script) {
+    if (script.is_string()) {
+        precompileString(script.get_ref<const std::string&>());
+    } else if (script.is_structured()) {
+        for (const auto& item : script) {
+            precompile(item);
+        }
+    }
+}
+
+void VariablePathCache::precompileString(const std::string& text) {
+    size_t start = text.find("${");
+    while (start != std::string::npos) {
+        size_t end = text.find('}', start + 2);
+        if (end == std::string::npos) {
+            return;
+        }
+        if (end > start + 2) {
+            get(text.substr(start + 2, end - start - 2));
+        }
+        start = text.find("${", end + 1);
+    }
+}
+
+size_t VariablePathCache::size() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_paths.size();
+}
+
+void VariablePathCache::clear() {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_paths.clear();
+}
+
+} // namespace burwell
@@ -0,0 +1,103 @@
+#ifndef BURWELL_VARIABLE_PATH_H
+#define BURWELL_VARIABLE_PATH_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <shared_mutex>
+#include <nlohmann/json.hpp>
+
+namespace burwell {
+
+/**
+ * @class VariablePath
+ * @brief Pre-parsed form of a ${...} variable expression
+ *
+ * "windows[2].title" is split once into a root variable name and a list of
+ * field and index steps, so resolving it inside a loop walks the variable
+ * by reference instead of re-parsing the string and copying every
+ * intermediate value.
+ */
+class VariablePath {
+public:
+    struct Step {
+        std::string field;                  // Object key; empty for index steps
+        size_t index = 0;                   // Array index when isIndex is set
+        bool isIndex = false;
+    };
+
+    static VariablePath compile(const std::string& expression);
+
+    // False when the expression is not a well-formed path; it is then looked up verbatim
+    bool isPath() const { return m_isPath; }
+    bool hasSteps() const { return !m_steps.empty(); }
+    const std::string& root() const { return m_root; }
+    const std::vector<Step>& steps() const { return m_steps; }
+
+    // Returns nullptr when a field is missing or an index is out of range
+    const nlohmann::json* resolve(const nlohmann::json& value) const;
+
+private:
+    std::string m_root;
+    std::vector<Step> m_steps;
+    bool m_isPath = false;
+};
+
+/**
+ * @class VariablePathCache
+ * @brief Compiles each variable expression once and shares it across executions
+ *
+ * Scripts are pre-scanned when they are loaded so loop bodies only ever
+ * take the read lock.
+ */
+class VariablePathCache {
+public:
+    explicit VariablePathCache(size_t capacity = 4096);
+
+    std::shared_ptr<const VariablePath> get(const std::string& expression);
+
+    // Compiles every ${...} expression found in the strings of a script or command
+    void precompile(const nlohmann::json& script);
+
+    size_t size() const;
+    void clear();
+
+private:
+    void precompileString(const std::string& text);
+
+    size_t m_capacity;                      // Expressions past this are compiled per use
+    std::unordered_map<std::string, std::shared_ptr<const VariablePath>> m_paths;
+    mutable std::shared_mutex m_mutex;
+};
+
+// Copies text into result with each ${expression} replaced by what
+// evaluate(expression, result) appends; "${}" and an unterminated "${" are
+// kept verbatim. Stops and returns false as soon as evaluate does.
+template <typename Evaluate>
+bool expandVariables(const std::string& text, std::string& result, Evaluate&& evaluate) {
+    size_t copied = 0;
+    size_t start = text.find("${");
+    while (start != std::string::npos) {
+        size_t end = text.find('}', start + 2);
+        if (end == std::string::npos) {
+            break;
+        }
+        if (end == start + 2) {
+            start = text.find("${", end + 1);
+            continue;
+        }
+        result.append(text, copied, start - copied);
+        if (!evaluate(text.substr(start + 2, end - start - 2), result)) {
+            return false;
+        }
+        copied = end + 1;
+        start = text.find("${", copied);
+    }
+    result.append(text, copied, std::string::npos);
+    return true;
+}
+
+} // namespace burwell
+
+#endif // BURWELL_VARIABLE_PATH_H
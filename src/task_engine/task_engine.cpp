@@ -3,6 +3,8 @@
 #include "../common/error_handler.h"
 #include "../common/os_utils.h"
 #include "../common/file_utils.h"
+#include "../common/string_utils.h"
+#include "../common/shutdown_manager.h"
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -286,19 +288,23 @@ std::vector<std::string> TaskEngine::findTasksByTag(const std::string& tag) {
 
 std::vector<std::string> TaskEngine::searchTasks(const std::string& query) {
     std::vector<std::string> results;
-    std::string lowerQuery = query;
-    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
+    std::string lowerQuery = utils::StringUtils::toLowerCase(query);
     
+    // One buffer for all tasks; it only reallocates when a task outgrows it
+    std::string searchText;
     for (const auto& pair : m_tasks) {
         const TaskDefinition& task = pair.second;
         
         // Search in name, description, and tags
-        std::string searchText = task.name + " " + task.description;
+        searchText.assign(task.name);
+        searchText += ' ';
+        searchText += task.description;
         for (const auto& tag : task.tags) {
-            searchText += " " + tag;
+            searchText += ' ';
+            searchText += tag;
         }
         
-        std::transform(searchText.begin(), searchText.end(), searchText.begin(), ::tolower);
+        utils::StringUtils::toLowerCaseInPlace(searchText);
         
         if (searchText.find(lowerQuery) != std::string::npos) {
             results.push_back(pair.first);
@@ -356,6 +362,7 @@ TaskExecutionResult TaskEngine::executeTaskDefinition(const TaskDefinition& task
         
         // Execute commands
         bool executionSuccess = true;
+        CancellationToken shutdown = ShutdownManager::getInstance().getToken();
         for (size_t i = 0; i < task.commands.size(); ++i) {
             context.currentCommandIndex = i;
             
@@ -367,8 +374,11 @@ TaskExecutionResult TaskEngine::executeTaskDefinition(const TaskDefinition& task
             }
             
             // Add delay if specified
-            if (task.commands[i].delayAfterMs > 0) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(task.commands[i].delayAfterMs));
+            if (task.commands[i].delayAfterMs > 0 &&
+                !shutdown.sleepFor(std::chrono::milliseconds(task.commands[i].delayAfterMs))) {
+                result.status = ExecutionStatus::CANCELLED;
+                executionSuccess = false;
+                break;
             }
         }
         
@@ -28,7 +28,7 @@ void testConcurrentStateAccess() {
     auto start = std::chrono::high_resolution_clock::now();
     
     // Launch many concurrent operations
-    std::vector<std::future<void>> futures;
+    std::vector<ThreadPool::Future<void>> futures;
     
     // 70% read operations (benefit from shared locks)
     for (int i = 0; i < NUM_OPERATIONS * 0.7; ++i) {
@@ -110,7 +110,7 @@ void testThreadPoolPriorities() {
     std::vector<int> results(10, -1);
     
     // Submit tasks with different priorities
-    std::vector<std::future<void>> futures;
+    std::vector<ThreadPool::Future<void>> futures;
     
     // Submit low priority tasks
     for (int i = 0; i < 3; ++i) {
@@ -0,0 +1,793 @@
+#include "line_editor.h"
+#include "../common/structured_logger.h"
+#include "../common/shutdown_manager.h"
+#include "../common/terminal_writer.h"
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+namespace burwell {
+
+namespace {
+
+constexpr size_t DEFAULT_MAX_HISTORY = 500;
+constexpr size_t READ_CHUNK_SIZE = 256;
+constexpr int STDOUT_FD = 1;
+
+inline bool isContinuationByte(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+size_t countCodePoints(const std::string& text, size_t from) {
+    size_t count = 0;
+    for (size_t i = from; i < text.size(); ++i) {
+        if (!isContinuationByte(text[i])) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+#ifdef _WIN32
+constexpr DWORD CONSOLE_RECORD_BATCH = 32;
+// Pipe handles are always signalled, so an empty pipe is polled at this interval
+constexpr DWORD PIPE_POLL_INTERVAL_MS = 50;
+
+void appendUtf8(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+// Translate a console key press into the bytes a VT terminal sends for it
+void appendKeyEvent(std::string& out, const KEY_EVENT_RECORD& key, wchar_t& highSurrogate) {
+    const char* sequence = nullptr;
+    switch (key.wVirtualKeyCode) {
+        case VK_UP: sequence = "\x1b[A"; break;
+        case VK_DOWN: sequence = "\x1b[B"; break;
+        case VK_RIGHT: sequence = "\x1b[C"; break;
+        case VK_LEFT: sequence = "\x1b[D"; break;
+        case VK_HOME: sequence = "\x1b[H"; break;
+        case VK_END: sequence = "\x1b[F"; break;
+        case VK_DELETE: sequence = "\x1b[3~"; break;
+        default: break;
+    }
+
+    WORD repeat = std::max<WORD>(1, key.wRepeatCount);
+    for (WORD i = 0; i < repeat; ++i) {
+        if (sequence) {
+            out += sequence;
+            continue;
+        }
+        wchar_t c = key.uChar.UnicodeChar;
+        if (c == 0) {
+            return;
+        }
+        if (c >= 0xD800 && c <= 0xDBFF) {
+            highSurrogate = c;
+            continue;
+        }
+        uint32_t codePoint = c;
+        if (c >= 0xDC00 && c <= 0xDFFF) {
+            if (highSurrogate == 0) {
+                continue;
+            }
+            codePoint = 0x10000 + ((static_cast<uint32_t>(highSurrogate) - 0xD800) << 10) + (c - 0xDC00);
+            highSurrogate = 0;
+        } else if (c == 0x1A) {
+            codePoint = 0x04;  // Ctrl-Z ends input like Ctrl-D
+        }
+        appendUtf8(out, codePoint);
+    }
+}
+#endif
+
+} // anonymous namespace
+
+LineEditor::LineEditor(int inputFd, int outputFd)
+    : m_inputFd(inputFd)
+    , m_outputFd(outputFd)
+    , m_isTerminal(false)
+    , m_sharedTerminal(false)
+    , m_active(false)
+    , m_eof(false)
+    , m_cancelRequested(false)
+    , m_stopping(false)
+    , m_cursor(0)
+    , m_escapeState(EscapeState::NONE)
+    , m_historyIndex(0)
+    , m_maxHistory(DEFAULT_MAX_HISTORY)
+    , m_shutdown(ShutdownManager::getInstance().getToken())
+#ifdef _WIN32
+    , m_inputHandle(nullptr)
+    , m_wakeEvent(nullptr)
+    , m_highSurrogate(0)
+#else
+    , m_rawMode(false)
+#endif
+{
+    m_wakePipe[0] = -1;
+    m_wakePipe[1] = -1;
+#ifdef _WIN32
+    m_inputHandle = reinterpret_cast<void*>(_get_osfhandle(m_inputFd));
+    DWORD consoleMode = 0;
+    // _isatty is also true for NUL; only a console delivers key events
+    m_isTerminal = GetConsoleMode(static_cast<HANDLE>(m_inputHandle), &consoleMode) != 0;
+    m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!m_wakeEvent) {
+        SLOG_ERROR().message("Failed to create line editor wake event").context("error", GetLastError());
+    }
+#else
+    m_isTerminal = isatty(m_inputFd) != 0;
+    if (pipe(m_wakePipe) == 0) {
+        fcntl(m_wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(m_wakePipe[1], F_SETFL, O_NONBLOCK);
+    } else {
+        SLOG_ERROR().message("Failed to create line editor wake pipe").context("errno", errno);
+    }
+#endif
+    m_sharedTerminal = m_isTerminal && m_outputFd == STDOUT_FD &&
+                       utils::TerminalWriter::getInstance().isAnsiEnabled();
+    m_shutdownWake = m_shutdown.onCancel([this] { wake(); });
+}
+
+LineEditor::~LineEditor() {
+    m_shutdownWake.reset();
+    m_stopping = true;
+    wake();
+    if (m_reader.joinable()) {
+        m_reader.join();
+    }
+    completeAll(PromptResult::Status::CANCELLED);
+#ifdef _WIN32
+    if (m_wakeEvent) {
+        CloseHandle(static_cast<HANDLE>(m_wakeEvent));
+    }
+#else
+    disableRawMode();
+    for (int fd : m_wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+std::future<PromptResult> LineEditor::prompt(const std::string& promptText,
+                                             std::chrono::milliseconds timeout) {
+    PendingPrompt pending;
+    pending.text = promptText;
+    pending.hasDeadline = timeout.count() > 0;
+    pending.deadline = std::chrono::steady_clock::now() + timeout;
+    std::future<PromptResult> future = pending.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_prompts.push_back(std::move(pending));
+    }
+    startReader();
+    wake();
+    return future;
+}
+
+void LineEditor::startReader() {
+    // Input is left alone until something actually prompts
+    std::call_once(m_readerStarted, [this] {
+        m_reader = std::thread(&LineEditor::readerLoop, this);
+    });
+}
+
+void LineEditor::cancel() {
+    m_cancelRequested = true;
+    wake();
+}
+
+std::vector<std::string> LineEditor::getHistory() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_history;
+}
+
+void LineEditor::setMaxHistory(size_t maxEntries) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxHistory = maxEntries;
+    if (m_history.size() > m_maxHistory) {
+        m_history.erase(m_history.begin(), m_history.end() - static_cast<std::ptrdiff_t>(m_maxHistory));
+    }
+}
+
+void LineEditor::wake() {
+#ifdef _WIN32
+    if (m_wakeEvent) {
+        SetEvent(static_cast<HANDLE>(m_wakeEvent));
+    }
+#else
+    if (m_wakePipe[1] >= 0) {
+        char byte = 1;
+        // A full pipe already guarantees a wake-up
+        ssize_t ignored = ::write(m_wakePipe[1], &byte, 1);
+        (void)ignored;
+    }
+#endif
+}
+
+void LineEditor::readerLoop() {
+#ifdef _WIN32
+    char chunk[READ_CHUNK_SIZE];
+    HANDLE input = static_cast<HANDLE>(m_inputHandle);
+    bool isPipe = GetFileType(input) == FILE_TYPE_PIPE;
+    while (!m_stopping) {
+        beginPromptIfNeeded();
+
+        DWORD timeoutMs = INFINITE;
+        std::chrono::steady_clock::time_point deadline;
+        if (nextDeadline(deadline)) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            timeoutMs = static_cast<DWORD>(std::max<long long>(0, remaining));
+        }
+
+        bool waitForInput = !m_eof;
+        if (waitForInput && isPipe) {
+            DWORD available = 0;
+            if (!PeekNamedPipe(input, nullptr, 0, nullptr, &available, nullptr)) {
+                // The writer closed the pipe
+                m_eof = true;
+                waitForInput = false;
+                timeoutMs = 0;
+            } else if (available == 0) {
+                waitForInput = false;
+                timeoutMs = std::min(timeoutMs, PIPE_POLL_INTERVAL_MS);
+            }
+        }
+
+        HANDLE handles[2] = {static_cast<HANDLE>(m_wakeEvent), input};
+        DWORD ready = WaitForMultipleObjects(waitForInput ? 2 : 1, handles, FALSE, timeoutMs);
+        if (ready == WAIT_FAILED) {
+            SLOG_ERROR().message("Waiting for console input failed").context("error", GetLastError());
+            completeAll(PromptResult::Status::CLOSED);
+            break;
+        }
+
+        if (m_cancelRequested.exchange(false) || m_shutdown.isCancelled()) {
+            completeAll(PromptResult::Status::CANCELLED);
+        }
+        checkDeadline();
+
+        if (ready == WAIT_OBJECT_0 + 1) {
+            if (m_isTerminal) {
+                readConsoleKeys();
+            } else {
+                DWORD bytes = 0;
+                if (ReadFile(input, chunk, sizeof(chunk), &bytes, nullptr) && bytes > 0) {
+                    handleInput(chunk, bytes);
+                } else {
+                    m_eof = true;
+                }
+            }
+        }
+
+        if (m_eof) {
+            if (m_active && !m_buffer.empty() && !m_isTerminal) {
+                submitLine();
+            }
+            completeAll(PromptResult::Status::CLOSED);
+        }
+    }
+#else
+    char chunk[READ_CHUNK_SIZE];
+    while (!m_stopping) {
+        beginPromptIfNeeded();
+
+        // Cancel and shutdown arrive through the wake pipe; only deadlines need a timeout
+        int timeoutMs = -1;
+        std::chrono::steady_clock::time_point deadline;
+        if (nextDeadline(deadline)) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            timeoutMs = static_cast<int>(std::max<long long>(0, remaining));
+        }
+
+        struct pollfd fds[2];
+        fds[0].fd = m_wakePipe[0];
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = m_inputFd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        nfds_t count = m_eof ? 1 : 2;
+
+        int ready = poll(fds, count, timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            SLOG_ERROR().message("Polling console input failed").context("errno", errno);
+            completeAll(PromptResult::Status::CLOSED);
+            break;
+        }
+
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            char drain[64];
+            while (::read(m_wakePipe[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+
+        if (m_cancelRequested.exchange(false) || m_shutdown.isCancelled()) {
+            completeAll(PromptResult::Status::CANCELLED);
+        }
+        checkDeadline();
+
+        if (ready > 0 && count == 2 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+            ssize_t bytes = ::read(m_inputFd, chunk, sizeof(chunk));
+            if (bytes > 0) {
+                handleInput(chunk, static_cast<size_t>(bytes));
+            } else if (bytes == 0 || (errno != EINTR && errno != EAGAIN)) {
+                m_eof = true;
+            }
+        }
+
+        if (m_eof) {
+            // Complete a line that ended without a newline before reporting EOF
+            if (m_active && !m_buffer.empty() && !m_isTerminal) {
+                submitLine();
+            }
+            completeAll(PromptResult::Status::CLOSED);
+        }
+    }
+#endif
+}
+
+#ifdef _WIN32
+void LineEditor::readConsoleKeys() {
+    INPUT_RECORD records[CONSOLE_RECORD_BATCH];
+    DWORD count = 0;
+    if (!ReadConsoleInputW(static_cast<HANDLE>(m_inputHandle), records, CONSOLE_RECORD_BATCH, &count)) {
+        m_eof = true;
+        return;
+    }
+    // Focus, mouse and resize events also signal the handle; only key presses matter
+    std::string bytes;
+    for (DWORD i = 0; i < count; ++i) {
+        if (records[i].EventType == KEY_EVENT && records[i].Event.KeyEvent.bKeyDown) {
+            appendKeyEvent(bytes, records[i].Event.KeyEvent, m_highSurrogate);
+        }
+    }
+    if (!bytes.empty()) {
+        handleInput(bytes.data(), bytes.size());
+    }
+}
+#endif
+
+bool LineEditor::nextDeadline(std::chrono::steady_clock::time_point& deadline) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_prompts.empty() || !m_prompts.front().hasDeadline) {
+        return false;
+    }
+    deadline = m_prompts.front().deadline;
+    return true;
+}
+
+void LineEditor::beginPromptIfNeeded() {
+    std::string promptText;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_active || m_prompts.empty()) {
+            return;
+        }
+        m_active = true;
+        promptText = m_prompts.front().text;
+    }
+
+    m_buffer.clear();
+    m_cursor = 0;
+    m_escapeState = EscapeState::NONE;
+    m_historyIndex = m_history.size();
+    m_savedLine.clear();
+
+#ifndef _WIN32
+    if (m_isTerminal) {
+        enableRawMode();
+    }
+#endif
+    if (m_sharedTerminal) {
+        redrawLine();
+    } else {
+        writeOutput(promptText);
+    }
+
+    // Keystrokes that arrived between prompts belong to this one
+    if (!m_typeAhead.empty()) {
+        std::string pending;
+        pending.swap(m_typeAhead);
+        handleInput(pending.data(), pending.size());
+    }
+}
+
+void LineEditor::completeActive(PromptResult::Status status, std::string line) {
+    std::promise<PromptResult> promise;
+    bool wasActive;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_prompts.empty()) {
+            return;
+        }
+        promise = std::move(m_prompts.front().promise);
+        m_prompts.pop_front();
+        wasActive = m_active;
+        m_active = false;
+    }
+
+    if (wasActive) {
+#ifndef _WIN32
+        disableRawMode();
+#endif
+        if (status != PromptResult::Status::OK && m_isTerminal) {
+            // Leave the abandoned input line intact and start a fresh one
+            endLine();
+        }
+    }
+    m_buffer.clear();
+    m_cursor = 0;
+
+    PromptResult result;
+    result.status = status;
+    result.line = std::move(line);
+    promise.set_value(std::move(result));
+}
+
+void LineEditor::completeAll(PromptResult::Status status) {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_prompts.empty()) {
+                return;
+            }
+        }
+        completeActive(status, "");
+    }
+}
+
+void LineEditor::checkDeadline() {
+    bool expired = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Queued prompts start their clock when queued; the first overdue one expires
+        expired = !m_prompts.empty() && m_prompts.front().hasDeadline &&
+                  std::chrono::steady_clock::now() >= m_prompts.front().deadline;
+    }
+    if (expired) {
+        completeActive(PromptResult::Status::TIMED_OUT, "");
+    }
+}
+
+void LineEditor::handleInput(const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        bool active;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            active = m_active;
+        }
+        if (!active) {
+            m_typeAhead.append(data + i, size - i);
+            return;
+        }
+        handleByte(data[i]);
+    }
+}
+
+void LineEditor::handleByte(char c) {
+    if (!m_isTerminal) {
+        if (c == '\n') {
+            if (!m_buffer.empty() && m_buffer.back() == '\r') {
+                m_buffer.pop_back();
+            }
+            submitLine();
+        } else {
+            m_buffer += c;
+        }
+        return;
+    }
+
+    switch (m_escapeState) {
+        case EscapeState::ESCAPE:
+            m_escapeState = c == '[' ? EscapeState::CSI
+                          : c == 'O' ? EscapeState::SS3
+                          : EscapeState::NONE;
+            m_escapeParams.clear();
+            return;
+        case EscapeState::CSI:
+            if ((c >= '0' && c <= '9') || c == ';') {
+                m_escapeParams += c;
+                return;
+            }
+            m_escapeState = EscapeState::NONE;
+            handleEscapeSequence(c);
+            return;
+        case EscapeState::SS3:
+            m_escapeState = EscapeState::NONE;
+            handleEscapeSequence(c);
+            return;
+        case EscapeState::NONE:
+            break;
+    }
+
+    switch (c) {
+        case '\r':
+        case '\n':
+            submitLine();
+            break;
+        case 0x1B:
+            m_escapeState = EscapeState::ESCAPE;
+            break;
+        case 0x7F:
+        case 0x08:
+            deleteBackward();
+            break;
+        case 0x01:  // Ctrl-A
+            m_cursor = 0;
+            redrawLine();
+            break;
+        case 0x05:  // Ctrl-E
+            m_cursor = m_buffer.size();
+            redrawLine();
+            break;
+        case 0x0B:  // Ctrl-K
+            m_buffer.erase(m_cursor);
+            redrawLine();
+            break;
+        case 0x15:  // Ctrl-U
+            m_buffer.erase(0, m_cursor);
+            m_cursor = 0;
+            redrawLine();
+            break;
+        case 0x17:  // Ctrl-W
+            deleteWordBackward();
+            break;
+        case 0x04:  // Ctrl-D: end of input on an empty line, delete otherwise
+            if (m_buffer.empty()) {
+                completeActive(PromptResult::Status::CLOSED, "");
+            } else {
+                deleteForward();
+            }
+            break;
+        default:
+            if (static_cast<unsigned char>(c) >= 0x20) {
+                insertText(c);
+            }
+            break;
+    }
+}
+
+void LineEditor::handleEscapeSequence(char final) {
+    switch (final) {
+        case 'A': recallHistory(-1); break;
+        case 'B': recallHistory(1); break;
+        case 'C': moveRight(); break;
+        case 'D': moveLeft(); break;
+        case 'H': m_cursor = 0; redrawLine(); break;
+        case 'F': m_cursor = m_buffer.size(); redrawLine(); break;
+        case '~':
+            if (m_escapeParams == "3") {
+                deleteForward();
+            } else if (m_escapeParams == "1" || m_escapeParams == "7") {
+                m_cursor = 0;
+                redrawLine();
+            } else if (m_escapeParams == "4" || m_escapeParams == "8") {
+                m_cursor = m_buffer.size();
+                redrawLine();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void LineEditor::submitLine() {
+    std::string line = m_buffer;
+    if (m_isTerminal) {
+        endLine();
+    }
+    if (!line.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_history.empty() || m_history.back() != line) {
+            m_history.push_back(line);
+            if (m_history.size() > m_maxHistory) {
+                m_history.erase(m_history.begin());
+            }
+        }
+    }
+    completeActive(PromptResult::Status::OK, std::move(line));
+}
+
+void LineEditor::endLine() {
+    if (m_sharedTerminal) {
+        utils::TerminalWriter::getInstance().finishInputLine();
+    } else {
+        writeOutput("\n");
+    }
+}
+
+void LineEditor::insertText(char c) {
+    m_buffer.insert(m_cursor, 1, c);
+    ++m_cursor;
+    // Redraw once a multi-byte character is complete
+    bool atCharacterEnd = m_cursor >= m_buffer.size() || !isContinuationByte(m_buffer[m_cursor]);
+    if (!atCharacterEnd) {
+        return;
+    }
+    if (!m_sharedTerminal && m_cursor == m_buffer.size() && (static_cast<unsigned char>(c) < 0x80 || isContinuationByte(c))) {
+        // Appending at the end: echo instead of redrawing the whole line
+        size_t start = m_cursor - 1;
+        while (start > 0 && isContinuationByte(m_buffer[start])) {
+            --start;
+        }
+        if (static_cast<unsigned char>(m_buffer[start]) < 0x80 || isContinuationByte(c)) {
+            writeOutput(m_buffer.substr(start));
+            return;
+        }
+    }
+    redrawLine();
+}
+
+void LineEditor::moveLeft() {
+    if (m_cursor == 0) return;
+    do {
+        --m_cursor;
+    } while (m_cursor > 0 && isContinuationByte(m_buffer[m_cursor]));
+    redrawLine();
+}
+
+void LineEditor::moveRight() {
+    if (m_cursor >= m_buffer.size()) return;
+    do {
+        ++m_cursor;
+    } while (m_cursor < m_buffer.size() && isContinuationByte(m_buffer[m_cursor]));
+    redrawLine();
+}
+
+void LineEditor::deleteBackward() {
+    if (m_cursor == 0) return;
+    size_t end = m_cursor;
+    moveLeft();
+    m_buffer.erase(m_cursor, end - m_cursor);
+    redrawLine();
+}
+
+void LineEditor::deleteForward() {
+    if (m_cursor >= m_buffer.size()) return;
+    size_t end = m_cursor + 1;
+    while (end < m_buffer.size() && isContinuationByte(m_buffer[end])) {
+        ++end;
+    }
+    m_buffer.erase(m_cursor, end - m_cursor);
+    redrawLine();
+}
+
+void LineEditor::deleteWordBackward() {
+    size_t start = m_cursor;
+    while (start > 0 && m_buffer[start - 1] == ' ') --start;
+    while (start > 0 && m_buffer[start - 1] != ' ') --start;
+    m_buffer.erase(start, m_cursor - start);
+    m_cursor = start;
+    redrawLine();
+}
+
+void LineEditor::recallHistory(int direction) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (direction < 0) {
+            if (m_historyIndex == 0 || m_history.empty()) return;
+            if (m_historyIndex >= m_history.size()) {
+                m_historyIndex = m_history.size();
+                m_savedLine = m_buffer;
+            }
+            --m_historyIndex;
+            m_buffer = m_history[m_historyIndex];
+        } else {
+            if (m_historyIndex >= m_history.size()) return;
+            ++m_historyIndex;
+            m_buffer = m_historyIndex == m_history.size() ? m_savedLine : m_history[m_historyIndex];
+        }
+    }
+    m_cursor = m_buffer.size();
+    redrawLine();
+}
+
+void LineEditor::redrawLine() {
+    std::string prompt;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_prompts.empty()) {
+            prompt = m_prompts.front().text;
+        }
+    }
+    size_t trailing = countCodePoints(m_buffer, m_cursor);
+    if (m_sharedTerminal) {
+        utils::TerminalWriter::getInstance().setInputLine(prompt + m_buffer, trailing);
+        return;
+    }
+    std::string line = "\r" + prompt + m_buffer + "\x1b[K";
+    if (trailing > 0) {
+        line += "\x1b[" + std::to_string(trailing) + "D";
+    }
+    writeOutput(line);
+}
+
+void LineEditor::writeOutput(const std::string& text) {
+    if (m_outputFd == STDOUT_FD) {
+        // Keep ordering with queued log output
+        auto& terminal = utils::TerminalWriter::getInstance();
+        terminal.write(text);
+        terminal.flush();
+        return;
+    }
+#ifdef _WIN32
+    size_t written = 0;
+    while (written < text.size()) {
+        int result = _write(m_outputFd, text.data() + written, static_cast<unsigned int>(text.size() - written));
+        if (result < 0) {
+            return;
+        }
+        written += static_cast<size_t>(result);
+    }
+#else
+    size_t written = 0;
+    while (written < text.size()) {
+        ssize_t result = ::write(m_outputFd, text.data() + written, text.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        written += static_cast<size_t>(result);
+    }
+#endif
+}
+
+bool LineEditor::enableRawMode() {
+#ifdef _WIN32
+    return false;
+#else
+    if (m_rawMode) return true;
+    if (tcgetattr(m_inputFd, &m_savedTermios) != 0) {
+        return false;
+    }
+    struct termios raw = m_savedTermios;
+    // Keep ISIG so Ctrl-C still reaches the shutdown handler
+    raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | IEXTEN);
+    raw.c_iflag &= ~static_cast<tcflag_t>(ICRNL | IXON);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(m_inputFd, TCSANOW, &raw) != 0) {
+        return false;
+    }
+    m_rawMode = true;
+    return true;
+#endif
+}
+
+void LineEditor::disableRawMode() {
+#ifndef _WIN32
+    if (m_rawMode) {
+        tcsetattr(m_inputFd, TCSANOW, &m_savedTermios);
+        m_rawMode = false;
+    }
+#endif
+}
+
+} // namespace burwell
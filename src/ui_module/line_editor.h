@@ -0,0 +1,160 @@
+#ifndef BURWELL_LINE_EDITOR_H
+#define BURWELL_LINE_EDITOR_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <future>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "../common/cancellation_token.h"
+
+#ifndef _WIN32
+#include <termios.h>
+#endif
+
+namespace burwell {
+
+struct PromptResult {
+    enum class Status {
+        OK,
+        CANCELLED,
+        TIMED_OUT,
+        CLOSED      // Input reached end of file
+    };
+
+    Status status = Status::CLOSED;
+    std::string line;
+
+    bool ok() const { return status == Status::OK; }
+};
+
+/**
+ * @brief Event-driven line input with editing and history
+ *
+ * A single reader thread polls the input descriptor together with a wake pipe
+ * (a wake event and the console input handle on Windows), so prompts can be
+ * cancelled or time out without a thread parked in getline. The thread starts
+ * with the first prompt and is joined on destruction. On a terminal, raw mode
+ * is enabled while a prompt is active. It supports cursor keys, Home/End,
+ * Delete, Ctrl-A/E/K/U/W and Up/Down history. When the input is not a
+ * terminal, lines are read as-is. Prompts are answered in the order they were
+ * requested.
+ *
+ * When writing to stdout on an ANSI terminal, the input line is drawn by
+ * TerminalWriter below its status region, so log output redraws around it.
+ */
+class LineEditor {
+public:
+    explicit LineEditor(int inputFd = 0, int outputFd = 1);
+    ~LineEditor();
+
+    LineEditor(const LineEditor&) = delete;
+    LineEditor& operator=(const LineEditor&) = delete;
+
+    /**
+     * @brief Queue a prompt and return its result future
+     * @param promptText Text shown before the input line
+     * @param timeout Zero waits indefinitely
+     */
+    std::future<PromptResult> prompt(const std::string& promptText,
+                                     std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    // Complete the active and all queued prompts as CANCELLED (shutdown does the same)
+    void cancel();
+
+    std::vector<std::string> getHistory() const;
+    void setMaxHistory(size_t maxEntries);
+    bool isTerminal() const { return m_isTerminal; }
+
+private:
+    struct PendingPrompt {
+        std::string text;
+        bool hasDeadline;
+        std::chrono::steady_clock::time_point deadline;
+        std::promise<PromptResult> promise;
+    };
+
+    enum class EscapeState {
+        NONE,
+        ESCAPE,     // Saw ESC
+        CSI,        // Saw ESC [
+        SS3         // Saw ESC O
+    };
+
+    void startReader();
+    void readerLoop();
+    void wake();
+    void beginPromptIfNeeded();
+    void completeActive(PromptResult::Status status, std::string line);
+    void completeAll(PromptResult::Status status);
+    void checkDeadline();
+    bool nextDeadline(std::chrono::steady_clock::time_point& deadline) const;
+
+    void handleInput(const char* data, size_t size);
+    void handleByte(char c);
+    void handleEscapeSequence(char final);
+    void submitLine();
+    void endLine();
+
+    void insertText(char c);
+    void moveLeft();
+    void moveRight();
+    void deleteBackward();
+    void deleteForward();
+    void deleteWordBackward();
+    void recallHistory(int direction);
+    void redrawLine();
+    void writeOutput(const std::string& text);
+
+    bool enableRawMode();
+    void disableRawMode();
+
+    int m_inputFd;
+    int m_outputFd;
+    bool m_isTerminal;
+    bool m_sharedTerminal;                 // Input line drawn through TerminalWriter
+    int m_wakePipe[2];
+
+    mutable std::mutex m_mutex;
+    std::deque<PendingPrompt> m_prompts;   // Front is the active prompt
+    bool m_active;                         // Front prompt has been drawn
+    bool m_eof;
+    std::atomic<bool> m_cancelRequested;
+    std::atomic<bool> m_stopping;
+
+    // Editing state, owned by the reader thread
+    std::string m_buffer;
+    size_t m_cursor;
+    std::string m_typeAhead;               // Input received with no prompt active
+    EscapeState m_escapeState;
+    std::string m_escapeParams;
+    std::vector<std::string> m_history;
+    size_t m_historyIndex;
+    std::string m_savedLine;               // Line being edited before browsing history
+    size_t m_maxHistory;
+
+    // Shutdown completes open prompts as CANCELLED and wakes the reader
+    CancellationToken m_shutdown;
+    CancellationRegistration m_shutdownWake;
+
+#ifdef _WIN32
+    void readConsoleKeys();
+
+    void* m_inputHandle;
+    void* m_wakeEvent;                     // Auto-reset; set by cancel, prompt and shutdown
+    wchar_t m_highSurrogate;               // First half of a pair split across key events
+#else
+    bool m_rawMode;
+    struct termios m_savedTermios;
+#endif
+
+    std::once_flag m_readerStarted;
+    std::thread m_reader;
+};
+
+} // namespace burwell
+
+#endif // BURWELL_LINE_EDITOR_H
@@ -2,20 +2,57 @@
 #include "../common/structured_logger.h"
 #include "../common/input_validator.h"
 #include "../common/string_utils.h"
-#include <iostream>
+#include "../common/terminal_writer.h"
 #include <algorithm>
 #include <cctype>
 
 using namespace burwell;
 
-UIModule::UIModule() {
-    SLOG_INFO().message("UIModule initialized");
+namespace {
+
+constexpr int PROGRESS_BAR_WIDTH = 20;
+
+// Keeps the status region out of the way while the user types
+class StatusPause {
+public:
+    StatusPause() { utils::TerminalWriter::getInstance().pauseStatus(); }
+    ~StatusPause() { utils::TerminalWriter::getInstance().resumeStatus(); }
+};
+
+} // anonymous namespace
+
+UIModule::UIModule()
+    : m_editor(std::make_unique<LineEditor>()) {
+    SLOG_INFO().message("UIModule initialized")
+        .context("interactive", m_editor->isTerminal());
+}
+
+bool UIModule::readLine(const std::string& prompt, std::string& line) {
+    StatusPause pause;
+    PromptResult result = m_editor->prompt(prompt).get();
+    if (!result.ok()) {
+        SLOG_DEBUG().message("User input ended without a line")
+            .context("status", static_cast<int>(result.status));
+        line.clear();
+        return false;
+    }
+    line = std::move(result.line);
+    return true;
+}
+
+std::future<PromptResult> UIModule::getUserInputAsync(const std::string& prompt,
+                                                      std::chrono::milliseconds timeout) {
+    // Status and log lines keep redrawing above the input line meanwhile
+    return m_editor->prompt(prompt, timeout);
+}
+
+void UIModule::cancelInput() {
+    m_editor->cancel();
 }
 
 std::string UIModule::getUserInput() {
     std::string input;
-    std::cout << "> ";
-    std::getline(std::cin, input);
+    readLine("> ", input);
     
     // Trim whitespace from input
     input = utils::StringUtils::trim(input);
@@ -40,11 +77,12 @@ void UIModule::displayFeedback(const std::string& message) {
             .context("length", message.length())
             .context("max_length", MAX_MESSAGE_LENGTH);
         // Display truncated message
-        std::cout << "[Agent]: " << message.substr(0, MAX_MESSAGE_LENGTH) << "... [truncated]" << std::endl;
+        utils::TerminalWriter::getInstance().writeLine(
+            "[Agent]: " + message.substr(0, MAX_MESSAGE_LENGTH) + "... [truncated]");
         return;
     }
     
-    std::cout << "[Agent]: " << message << std::endl;
+    utils::TerminalWriter::getInstance().writeLine("[Agent]: " + message);
 }
 
 void UIModule::displayLog(const std::string& logEntry) {
@@ -61,11 +99,12 @@ void UIModule::displayLog(const std::string& logEntry) {
             .context("length", logEntry.length())
             .context("max_length", MAX_LOG_LENGTH);
         // Display truncated log
-        std::cout << "[Log]: " << logEntry.substr(0, MAX_LOG_LENGTH) << "... [truncated]" << std::endl;
+        utils::TerminalWriter::getInstance().writeLine(
+            "[Log]: " + logEntry.substr(0, MAX_LOG_LENGTH) + "... [truncated]");
         return;
     }
     
-    std::cout << "[Log]: " << logEntry << std::endl;
+    utils::TerminalWriter::getInstance().writeLine("[Log]: " + logEntry);
 }
 
 bool UIModule::promptUser(const std::string& question) {
@@ -87,9 +126,13 @@ bool UIModule::promptUser(const std::string& question) {
     int attempts = 0;
     const int MAX_ATTEMPTS = 10;
     
+    auto& terminal = utils::TerminalWriter::getInstance();
     while (attempts < MAX_ATTEMPTS) {
-        std::cout << "[Agent]: " << question << " (yes/no): ";
-        std::getline(std::cin, response);
+        if (!readLine("[Agent]: " + question + " (yes/no): ", response)) {
+            SLOG_WARNING().message("Prompt ended without an answer")
+                .context("question", question.substr(0, 50));
+            return false;
+        }
         
         // Trim whitespace and convert to lowercase
         response = utils::StringUtils::trim(response);
@@ -104,7 +147,7 @@ bool UIModule::promptUser(const std::string& question) {
                 .context("question", question.substr(0, 50));
             return false;
         } else {
-            std::cout << "Invalid response. Please type \'yes\' or \'no\'." << std::endl;
+            terminal.writeLine("Invalid response. Please type 'yes' or 'no'.");
             attempts++;
         }
     }
@@ -114,4 +157,24 @@ bool UIModule::promptUser(const std::string& question) {
     return false;
 }
 
+void UIModule::displayStatus(const std::string& key, const std::string& status) {
+    utils::TerminalWriter::getInstance().setStatus(key, status);
+}
+
+void UIModule::displayProgress(const std::string& key, const std::string& label,
+                               size_t current, size_t total) {
+    // Without a redraw region every step would become a line of piped output
+    if (!utils::TerminalWriter::getInstance().isAnsiEnabled()) {
+        return;
+    }
+    std::string line = label + " [";
+    size_t filled = total > 0 ? std::min(current, total) * PROGRESS_BAR_WIDTH / total : 0;
+    line.append(filled, '#');
+    line.append(PROGRESS_BAR_WIDTH - filled, '.');
+    line += "] " + std::to_string(current) + "/" + std::to_string(total);
+    utils::TerminalWriter::getInstance().setStatus(key, line);
+}
 
+void UIModule::clearStatus(const std::string& key) {
+    utils::TerminalWriter::getInstance().clearStatus(key);
+}
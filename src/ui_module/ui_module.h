@@ -2,6 +2,10 @@
 #define BURWELL_UI_MODULE_H
 
 #include <string>
+#include <memory>
+#include <future>
+#include <chrono>
+#include "line_editor.h"
 
 namespace burwell {
 
@@ -12,6 +16,21 @@ public:
     void displayFeedback(const std::string& message);
     void displayLog(const std::string& logEntry);
     bool promptUser(const std::string& question);
+    
+    // Non-blocking input: the future completes with OK, CANCELLED, TIMED_OUT or CLOSED
+    std::future<PromptResult> getUserInputAsync(const std::string& prompt = "> ",
+                                                std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+    void cancelInput();
+    
+    // Status region (redrawn in place on ANSI terminals, plain lines otherwise; progress only on ANSI terminals)
+    void displayStatus(const std::string& key, const std::string& status);
+    void displayProgress(const std::string& key, const std::string& label, size_t current, size_t total);
+    void clearStatus(const std::string& key);
+
+private:
+    bool readLine(const std::string& prompt, std::string& line);
+
+    std::unique_ptr<LineEditor> m_editor;
 };
 
 } // namespace burwell
@@ -0,0 +1,410 @@
+// Round-trip tests for ImageCodec and ImagePreparer: every encoded image is
+// decoded again with libpng / libjpeg and compared with its source pixels.
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <csetjmp>
+#include <random>
+#include <string>
+#include <vector>
+#include <png.h>
+#include <jpeglib.h>
+#include <zlib.h>
+#include "image_codec.h"
+#include "image_preparer.h"
+
+using namespace burwell;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "  [FAIL] " << __FILE__ << ":" << __LINE__ << ": " #condition "\n"; \
+            ++g_failures; \
+        } \
+    } while (0)
+
+RgbImage makeImage(int width, int height, const std::string& pattern, uint32_t seed = 1) {
+    RgbImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 3);
+    std::mt19937 rng(seed);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = &image.pixels[(static_cast<size_t>(y) * width + x) * 3];
+            if (pattern == "noise" || pattern == "grain") {
+                // Grain keeps 4 bits of noise: no matches, but a skewed literal alphabet
+                uint8_t mask = pattern == "noise" ? 0xFF : 0x0F;
+                p[0] = static_cast<uint8_t>(rng() & mask);
+                p[1] = static_cast<uint8_t>(rng() & mask);
+                p[2] = static_cast<uint8_t>(rng() & mask);
+            } else if (pattern == "ui") {
+                // Flat panels with text-like strokes, as in a screenshot
+                bool stroke = (y % 14 < 9) && ((x * 7 + y * 3) % 11 < 3) && (x % 160 < 120);
+                uint8_t base = (y / 40) % 2 ? 240 : 250;
+                p[0] = stroke ? 30 : base;
+                p[1] = stroke ? 30 : base;
+                p[2] = stroke ? 40 : static_cast<uint8_t>(base - (x / 200) * 20);
+            } else {
+                // Smooth gradient
+                p[0] = static_cast<uint8_t>(x * 255 / std::max(1, width - 1));
+                p[1] = static_cast<uint8_t>(y * 255 / std::max(1, height - 1));
+                p[2] = static_cast<uint8_t>((x + y) * 255 / std::max(1, width + height - 2));
+            }
+        }
+    }
+    return image;
+}
+
+// --- libpng --------------------------------------------------------------
+
+struct PngReadState {
+    const std::vector<uint8_t>* data;
+    size_t offset;
+};
+
+void readPngBytes(png_structp png, png_bytep out, png_size_t length) {
+    auto* state = static_cast<PngReadState*>(png_get_io_ptr(png));
+    if (state->offset + length > state->data->size()) {
+        png_error(png, "read past end of PNG");
+    }
+    std::memcpy(out, state->data->data() + state->offset, length);
+    state->offset += length;
+}
+
+bool decodePng(const std::vector<uint8_t>& data, RgbImage& image) {
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    if (!info) {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        return false;
+    }
+    PngReadState state{&data, 0};
+    std::vector<png_bytep> rows;
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return false;
+    }
+    png_set_read_fn(png, &state, readPngBytes);
+    png_read_info(png, info);
+    if (png_get_color_type(png, info) != PNG_COLOR_TYPE_RGB || png_get_bit_depth(png, info) != 8) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return false;
+    }
+    image.width = static_cast<int>(png_get_image_width(png, info));
+    image.height = static_cast<int>(png_get_image_height(png, info));
+    image.pixels.assign(static_cast<size_t>(image.width) * image.height * 3, 0);
+    rows.resize(image.height);
+    for (int y = 0; y < image.height; ++y) {
+        rows[y] = &image.pixels[static_cast<size_t>(y) * image.width * 3];
+    }
+    png_read_image(png, rows.data());
+    png_read_end(png, nullptr);
+    png_destroy_read_struct(&png, &info, nullptr);
+    return true;
+}
+
+// Concatenated IDAT payloads, i.e. the zlib stream
+std::vector<uint8_t> extractIdat(const std::vector<uint8_t>& png) {
+    std::vector<uint8_t> stream;
+    size_t pos = 8;
+    while (pos + 12 <= png.size()) {
+        uint32_t length = (uint32_t(png[pos]) << 24) | (uint32_t(png[pos + 1]) << 16) |
+                          (uint32_t(png[pos + 2]) << 8) | png[pos + 3];
+        if (std::memcmp(&png[pos + 4], "IDAT", 4) == 0) {
+            stream.insert(stream.end(), png.begin() + pos + 8, png.begin() + pos + 8 + length);
+        }
+        pos += 12 + length;
+    }
+    return stream;
+}
+
+// Walks the deflate stream with zlib, which stops at every block boundary under Z_BLOCK
+bool countDeflateBlocks(const std::vector<uint8_t>& zlibStream, size_t rawSize, int& stored, int& dynamic) {
+    stored = 0;
+    dynamic = 0;
+    std::vector<uint8_t> out(rawSize + 1);
+    z_stream stream{};
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+    stream.next_in = const_cast<Bytef*>(zlibStream.data());
+    stream.avail_in = static_cast<uInt>(zlibStream.size());
+    stream.next_out = out.data();
+    stream.avail_out = static_cast<uInt>(out.size());
+    int result = Z_OK;
+    while (result == Z_OK) {
+        if ((stream.data_type & 128) && !(stream.data_type & 64) && stream.avail_in > 0) {
+            // Next block header starts at the unused high bits of the previous byte
+            int unused = stream.data_type & 7;
+            unsigned header = unused > 0
+                ? (stream.next_in[-1] >> (8 - unused)) | (unsigned(stream.next_in[0]) << unused)
+                : stream.next_in[0];
+            int type = (header >> 1) & 3;
+            stored += type == 0;
+            dynamic += type == 2;
+        }
+        result = inflate(&stream, Z_BLOCK);
+    }
+    bool complete = result == Z_STREAM_END && stream.total_out == rawSize;
+    inflateEnd(&stream);
+    return complete;
+}
+
+// --- libjpeg -------------------------------------------------------------
+
+struct JpegError {
+    jpeg_error_mgr manager;
+    jmp_buf jump;
+};
+
+void onJpegError(j_common_ptr info) {
+    longjmp(reinterpret_cast<JpegError*>(info->err)->jump, 1);
+}
+
+bool decodeJpeg(const std::vector<uint8_t>& data, RgbImage& image) {
+    jpeg_decompress_struct info;
+    JpegError error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = onJpegError;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, data.data(), static_cast<unsigned long>(data.size()));
+    if (jpeg_read_header(&info, TRUE) != JPEG_HEADER_OK) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    info.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&info);
+    image.width = static_cast<int>(info.output_width);
+    image.height = static_cast<int>(info.output_height);
+    image.pixels.assign(static_cast<size_t>(image.width) * image.height * 3, 0);
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = &image.pixels[static_cast<size_t>(info.output_scanline) * image.width * 3];
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    return true;
+}
+
+double psnr(const RgbImage& a, const RgbImage& b) {
+    double squared = 0.0;
+    for (size_t i = 0; i < a.pixels.size(); ++i) {
+        double diff = static_cast<double>(a.pixels[i]) - b.pixels[i];
+        squared += diff * diff;
+    }
+    if (squared == 0.0) {
+        return 99.0;
+    }
+    return 10.0 * std::log10(255.0 * 255.0 * a.pixels.size() / squared);
+}
+
+// --- tests ---------------------------------------------------------------
+
+const int ODD_SIZES[][2] = {{1, 1}, {2, 3}, {7, 5}, {17, 9}, {31, 33}, {100, 1}, {1, 100}, {129, 67}};
+
+void testPngRoundTrip() {
+    std::cout << "\n[TEST] PNG round trip over odd sizes and patterns\n";
+    for (const auto& size : ODD_SIZES) {
+        for (const char* pattern : {"gradient", "ui", "noise"}) {
+            RgbImage source = makeImage(size[0], size[1], pattern);
+            RgbImage decoded;
+            CHECK(decodePng(ImageCodec::encodePng(source), decoded));
+            CHECK(decoded.width == source.width && decoded.height == source.height);
+            CHECK(decoded.pixels == source.pixels);
+        }
+    }
+}
+
+void testPngDeflateBlocks() {
+    std::cout << "\n[TEST] PNG deflate multi-block and stored-block paths\n";
+    struct Case {
+        const char* pattern;
+        int width;
+        int height;
+        bool expectStored;
+        bool expectDynamic;
+        int minBlocks;
+    };
+    const Case cases[] = {
+        {"noise", 301, 211, true, false, 3},      // Incompressible: stored blocks only
+        {"grain", 301, 211, false, true, 3},      // Literal-only but compressible: dynamic blocks
+        {"ui", 1283, 719, false, true, 1},
+        {"gradient", 640, 480, false, true, 1},
+    };
+    for (const auto& test : cases) {
+        RgbImage source = makeImage(test.width, test.height, test.pattern);
+        std::vector<uint8_t> png = ImageCodec::encodePng(source);
+        size_t rawSize = static_cast<size_t>(test.height) * (test.width * 3 + 1);
+        int stored = 0;
+        int dynamic = 0;
+        CHECK(countDeflateBlocks(extractIdat(png), rawSize, stored, dynamic));
+        std::cout << "  " << test.pattern << " " << test.width << "x" << test.height
+                  << ": " << stored << " stored, " << dynamic << " dynamic, " << png.size() << " bytes\n";
+        CHECK((stored > 0) == test.expectStored);
+        CHECK((dynamic > 0) == test.expectDynamic);
+        CHECK(stored + dynamic >= test.minBlocks);
+        if (test.expectStored) {
+            // Stored data may not grow by more than the block framing
+            CHECK(png.size() < rawSize + rawSize / 1000 + 128);
+        }
+
+        RgbImage decoded;
+        CHECK(decodePng(png, decoded));
+        CHECK(decoded.pixels == source.pixels);
+    }
+
+    // Noise followed by flat rows mixes stored and dynamic blocks in one stream
+    RgbImage mixed = makeImage(400, 300, "noise");
+    std::fill(mixed.pixels.begin() + mixed.pixels.size() / 2, mixed.pixels.end(), 200);
+    std::vector<uint8_t> png = ImageCodec::encodePng(mixed);
+    int stored = 0;
+    int dynamic = 0;
+    CHECK(countDeflateBlocks(extractIdat(png), 300 * (400 * 3 + 1), stored, dynamic));
+    CHECK(stored > 0 && dynamic > 0);
+    RgbImage decoded;
+    CHECK(decodePng(png, decoded));
+    CHECK(decoded.pixels == mixed.pixels);
+}
+
+void testJpegRoundTrip() {
+    std::cout << "\n[TEST] JPEG round trip over odd sizes and qualities\n";
+    for (const auto& size : ODD_SIZES) {
+        for (int quality : {1, 40, 85, 100}) {
+            RgbImage source = makeImage(size[0], size[1], "gradient");
+            RgbImage decoded;
+            CHECK(decodeJpeg(ImageCodec::encodeJpeg(source, quality), decoded));
+            CHECK(decoded.width == source.width && decoded.height == source.height);
+            if (quality >= 85 && size[0] >= 16 && size[1] >= 16) {
+                CHECK(psnr(source, decoded) > 30.0);
+            }
+        }
+    }
+
+    RgbImage screenshot = makeImage(333, 217, "ui");
+    RgbImage decoded;
+    CHECK(decodeJpeg(ImageCodec::encodeJpeg(screenshot, 90), decoded));
+    CHECK(psnr(screenshot, decoded) > 25.0);
+    // Noise exercises every Huffman category
+    RgbImage noise = makeImage(65, 47, "noise");
+    CHECK(decodeJpeg(ImageCodec::encodeJpeg(noise, 100), decoded));
+    CHECK(decoded.width == 65 && decoded.height == 47);
+}
+
+void testRawConversionAndCrop() {
+    std::cout << "\n[TEST] Raw conversion, crop and downscale\n";
+    // 3-pixel BGR rows are padded to 12 bytes as in a DIB
+    std::vector<uint8_t> bgr = {
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0, 0,
+        10, 11, 12, 13, 14, 15, 16, 17, 18, 0, 0, 0,
+    };
+    RgbImage image = ImageCodec::fromRaw(bgr, 3, 2, "BGR");
+    CHECK(image.isValid());
+    CHECK(image.pixels[0] == 3 && image.pixels[1] == 2 && image.pixels[2] == 1);
+    CHECK(image.pixels[15] == 18 && image.pixels[17] == 16);
+
+    RgbImage cropped = ImageCodec::crop(image, {1, 1, 5, 5});
+    CHECK(cropped.width == 2 && cropped.height == 1);
+    CHECK(cropped.pixels[0] == 15 && cropped.pixels[3] == 18);
+
+    RgbImage flat = makeImage(101, 77, "gradient");
+    std::fill(flat.pixels.begin(), flat.pixels.end(), 77);
+    RgbImage small = ImageCodec::downscale(flat, 33, 25);
+    CHECK(small.width == 33 && small.height == 25);
+    CHECK(std::all_of(small.pixels.begin(), small.pixels.end(), [](uint8_t v) { return v == 77; }));
+}
+
+void testImagePreparer() {
+    std::cout << "\n[TEST] ImagePreparer output decodes within budget\n";
+    RgbImage screen = makeImage(1283, 721, "ui");
+    std::vector<uint8_t> bgra;
+    bgra.reserve(screen.pixels.size() / 3 * 4);
+    for (size_t i = 0; i < screen.pixels.size(); i += 3) {
+        bgra.push_back(screen.pixels[i + 2]);
+        bgra.push_back(screen.pixels[i + 1]);
+        bgra.push_back(screen.pixels[i]);
+        bgra.push_back(255);
+    }
+
+    ImagePreparer preparer;
+    ImageSource source;
+    source.data = &bgra;
+    source.format = "BGRA";
+    source.width = screen.width;
+    source.height = screen.height;
+    source.frameId = 7;
+
+    // PNG only, unlimited: lossless at full size
+    ImageBudget lossless;
+    lossless.formats = {"png"};
+    auto prepared = preparer.prepare(source, lossless);
+    CHECK(prepared && prepared->format == "png");
+    RgbImage decoded;
+    CHECK(prepared && decodePng(prepared->data, decoded));
+    CHECK(decoded.pixels == screen.pixels);
+
+    // Resolution cap and a tight payload budget over both encodings
+    ImageBudget budget;
+    budget.formats = {"png", "jpeg"};
+    budget.maxLongEdge = 800;
+    budget.maxPayloadBytes = 40 * 1024;
+    prepared = preparer.prepare(source, budget);
+    CHECK(prepared != nullptr);
+    if (prepared) {
+        CHECK(prepared->width <= 800 && prepared->height <= 800);
+        CHECK(prepared->payloadBytes <= budget.maxPayloadBytes);
+        bool ok = prepared->format == "png" ? decodePng(prepared->data, decoded) : decodeJpeg(prepared->data, decoded);
+        CHECK(ok);
+        CHECK(decoded.width == prepared->width && decoded.height == prepared->height);
+    }
+    size_t misses = preparer.getCacheMisses();
+    auto again = preparer.prepare(source, budget);
+    CHECK(again == prepared);
+    CHECK(preparer.getCacheHits() == 1 && preparer.getCacheMisses() == misses);
+
+    // Focus crop with odd bounds
+    source.frameId = 8;
+    source.focus = {101, 53, 333, 211};
+    prepared = preparer.prepare(source, lossless);
+    CHECK(prepared && prepared->width == 333 && prepared->height == 211);
+    CHECK(prepared && decodePng(prepared->data, decoded));
+    if (prepared) {
+        RgbImage expected = ImageCodec::crop(screen, source.focus);
+        CHECK(decoded.pixels == expected.pixels);
+    }
+
+    // Nothing fits: text only
+    ImageBudget impossible;
+    impossible.formats = {"png", "jpeg"};
+    impossible.maxPayloadBytes = 64;
+    CHECK(preparer.prepare(source, impossible) == nullptr);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "=== Burwell Image Codec Test ===\n";
+
+    testPngRoundTrip();
+    testPngDeflateBlocks();
+    testJpegRoundTrip();
+    testRawConversionAndCrop();
+    testImagePreparer();
+
+    if (g_failures > 0) {
+        std::cerr << "\n[ERROR] " << g_failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "\n[SUCCESS] All image codec tests passed\n";
+    return 0;
+}
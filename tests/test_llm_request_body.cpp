@@ -0,0 +1,255 @@
+// Checks that the streamed request body is byte-for-byte the document the
+// former nlohmann builders (createOpenAIRequest / createAnthropicRequest)
+// produced with dump(), for both providers, with and without images.
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "llm_connector.h"
+
+using namespace burwell;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "  [FAIL] " << __FILE__ << ":" << __LINE__ << ": " #condition "\n"; \
+            ++g_failures; \
+        } \
+    } while (0)
+
+std::string referenceBase64(const std::vector<uint8_t>& data) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    uint32_t bits = 0;
+    int count = 0;
+    for (uint8_t byte : data) {
+        bits = (bits << 8) | byte;
+        count += 8;
+        while (count >= 6) {
+            count -= 6;
+            out += ALPHABET[(bits >> count) & 0x3F];
+        }
+    }
+    if (count > 0) {
+        out += ALPHABET[(bits << (6 - count)) & 0x3F];
+    }
+    while (out.size() % 4 != 0) {
+        out += '=';
+    }
+    return out;
+}
+
+struct Settings {
+    std::string model;
+    double temperature;
+    int maxTokens;
+};
+
+// The builders as they were before the request body was streamed
+nlohmann::json createOpenAIRequest(const std::vector<LLMMessage>& messages, const Settings& settings) {
+    nlohmann::json request;
+    request["model"] = settings.model;
+    request["temperature"] = settings.temperature;
+    request["max_tokens"] = settings.maxTokens;
+
+    nlohmann::json jsonMessages = nlohmann::json::array();
+    for (const auto& msg : messages) {
+        if (msg.hasImage()) {
+            jsonMessages.push_back({
+                {"role", msg.role},
+                {"content", nlohmann::json::array({
+                    {{"type", "text"}, {"text", msg.content}},
+                    {{"type", "image_url"}, {"image_url", {{"url", "data:image/" + msg.imageFormat + ";base64," +
+                                                                    referenceBase64(*msg.imageData)}}}}
+                })}
+            });
+            continue;
+        }
+        jsonMessages.push_back({{"role", msg.role}, {"content", msg.content}});
+    }
+    request["messages"] = jsonMessages;
+    return request;
+}
+
+nlohmann::json createAnthropicRequest(const std::vector<LLMMessage>& messages, const Settings& settings) {
+    nlohmann::json request;
+    request["model"] = settings.model;
+    request["max_tokens"] = settings.maxTokens;
+    request["temperature"] = settings.temperature;
+
+    std::string systemMessage;
+    nlohmann::json jsonMessages = nlohmann::json::array();
+    for (const auto& msg : messages) {
+        if (msg.role == "system") {
+            systemMessage = msg.content;
+        } else if (msg.hasImage()) {
+            jsonMessages.push_back({
+                {"role", msg.role},
+                {"content", nlohmann::json::array({
+                    {{"type", "image"}, {"source", {
+                        {"type", "base64"},
+                        {"media_type", "image/" + msg.imageFormat},
+                        {"data", referenceBase64(*msg.imageData)}
+                    }}},
+                    {{"type", "text"}, {"text", msg.content}}
+                })}
+            });
+        } else {
+            jsonMessages.push_back({{"role", msg.role}, {"content", msg.content}});
+        }
+    }
+    if (!systemMessage.empty()) {
+        request["system"] = systemMessage;
+    }
+    request["messages"] = jsonMessages;
+    return request;
+}
+
+std::vector<uint8_t> randomBytes(size_t size, uint32_t seed) {
+    std::vector<uint8_t> data(size);
+    std::mt19937 rng(seed);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+std::vector<LLMMessage> textMessages() {
+    std::vector<LLMMessage> messages;
+    messages.emplace_back("system", "You are a planner.\nReply with JSON only.");
+    messages.emplace_back("user", "Open \"notes.txt\" in C:\\Users\\me\\Desktop\t(tab) and type \xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+    messages.emplace_back("assistant", "{\"commands\": []}");
+    messages.emplace_back("user", std::string("control \x01\x1f chars and a nul-free </script>"));
+    return messages;
+}
+
+std::vector<LLMMessage> imageMessages(size_t imageBytes) {
+    std::vector<LLMMessage> messages = textMessages();
+    // Sizes 0, 1 and 2 mod 3 exercise base64 padding
+    messages.emplace_back("user", "What is on screen?", randomBytes(imageBytes, 1), "png");
+    messages.emplace_back("user", "And now?", randomBytes(imageBytes + 1, 2), "jpeg");
+    messages.emplace_back("user", "Last one", randomBytes(imageBytes + 2, 3), "png");
+    return messages;
+}
+
+std::string writeBody(const LLMConnector& connector, const std::vector<LLMMessage>& messages, bool stream,
+                      size_t* chunks = nullptr) {
+    std::string body;
+    size_t count = 0;
+    bool ok = connector.writeRequestBody(messages, [&body, &count](const char* data, size_t size) {
+        body.append(data, size);
+        ++count;
+        return true;
+    }, stream);
+    CHECK(ok);
+    if (chunks) {
+        *chunks = count;
+    }
+    return body;
+}
+
+void compare(LLMConnector::Provider provider, const char* name, const std::vector<LLMMessage>& messages,
+             size_t minChunks = 1) {
+    const Settings settings{"test-model-1", 0.7, 4000};
+    LLMConnector connector;
+    connector.setProvider(provider);
+    connector.setModelName(settings.model);
+    connector.setTemperature(settings.temperature);
+    connector.setMaxTokens(settings.maxTokens);
+
+    nlohmann::json expected = provider == LLMConnector::Provider::ANTHROPIC
+        ? createAnthropicRequest(messages, settings)
+        : createOpenAIRequest(messages, settings);
+
+    size_t chunks = 0;
+    std::string body = writeBody(connector, messages, false, &chunks);
+    bool same = body == expected.dump();
+    std::cout << "  " << name << ": " << body.size() << " bytes in " << chunks << " chunk(s)"
+              << (same ? "" : " MISMATCH") << "\n";
+    CHECK(same);
+    CHECK(chunks >= minChunks);
+    if (!same) {
+        std::string dumped = expected.dump();
+        size_t at = 0;
+        while (at < body.size() && at < dumped.size() && body[at] == dumped[at]) {
+            ++at;
+        }
+        std::cerr << "    first difference at " << at << ":\n    got      "
+                  << body.substr(at > 40 ? at - 40 : 0, 80) << "\n    expected "
+                  << dumped.substr(at > 40 ? at - 40 : 0, 80) << "\n";
+    }
+
+    // Streaming only adds the flag
+    expected["stream"] = true;
+    CHECK(writeBody(connector, messages, true) == expected.dump());
+}
+
+void testMatchesBuilders() {
+    std::cout << "\n[TEST] Streamed request body matches the nlohmann builders\n";
+    compare(LLMConnector::Provider::OPENAI, "openai text", textMessages());
+    compare(LLMConnector::Provider::ANTHROPIC, "anthropic text", textMessages());
+    compare(LLMConnector::Provider::OPENAI, "openai images", imageMessages(3000));
+    compare(LLMConnector::Provider::ANTHROPIC, "anthropic images", imageMessages(3000));
+    // Large enough to be flushed in several slices
+    compare(LLMConnector::Provider::OPENAI, "openai large images", imageMessages(300 * 1024), 4);
+    compare(LLMConnector::Provider::ANTHROPIC, "anthropic large images", imageMessages(300 * 1024), 4);
+
+    std::vector<LLMMessage> systemOnly;
+    systemOnly.emplace_back("system", "");
+    systemOnly.emplace_back("user", "");
+    compare(LLMConnector::Provider::OPENAI, "openai empty strings", systemOnly);
+    compare(LLMConnector::Provider::ANTHROPIC, "anthropic empty system", systemOnly);
+}
+
+void testInvalidUtf8() {
+    std::cout << "\n[TEST] Invalid UTF-8 stops the body and is not retried\n";
+    LLMConnector connector;
+    connector.setProvider(LLMConnector::Provider::OPENAI);
+
+    std::vector<LLMMessage> messages;
+    messages.emplace_back("user", "broken \xC3 text");
+    messages.emplace_back("user", "screenshot", randomBytes(1024 * 1024, 4), "png");
+    std::string sent;
+    bool ok = connector.writeRequestBody(messages, [&sent](const char* data, size_t size) {
+        sent.append(data, size);
+        return true;
+    });
+    CHECK(!ok);
+    // Nothing from the offending message onwards reaches the sink
+    CHECK(sent.find("broken") == std::string::npos);
+
+    // Buffered and chunked uploads both report a non-retryable request error
+    connector.setApiKey("test-key");
+    nlohmann::json result = connector.sendMessage(messages);
+    CHECK(result.contains("error"));
+    CHECK(connector.getLastError().type == "INVALID_REQUEST");
+    CHECK(!connector.getLastError().isRetryable);
+
+    messages.pop_back();
+    result = connector.sendMessage(messages);
+    CHECK(result.contains("error"));
+    CHECK(connector.getLastError().type == "INVALID_REQUEST");
+    CHECK(!connector.getLastError().isRetryable);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::cout << "=== Burwell LLM Request Body Test ===\n";
+
+    testMatchesBuilders();
+    testInvalidUtf8();
+
+    if (g_failures > 0) {
+        std::cerr << "\n[ERROR] " << g_failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "\n[SUCCESS] All request body tests passed\n";
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "binary_log_sink.h"
+#include <iostream>
+#include <string>
+#include <cstdio>
+
+void printUsage() {
+    std::cout << "Burwell Log Decoder - Convert binary logs to text or JSON lines\n";
+    std::cout << "Usage: burwell-logdecode <base-path> [options]\n\n";
+    std::cout << "  <base-path>       Binary log path as configured (e.g. logs/burwell.blog)\n";
+    std::cout << "\nOptions:\n";
+    std::cout << "  --format <fmt>    Output format: text or json (default: json)\n";
+    std::cout << "  --help            Show this help message\n";
+    std::cout << "\nExamples:\n";
+    std::cout << "  burwell-logdecode logs/burwell.blog\n";
+    std::cout << "  burwell-logdecode logs/burwell.blog --format text\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    std::string basePath;
+    std::string format = "json";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (basePath.empty()) {
+            basePath = arg;
+        }
+    }
+
+    std::shared_ptr<burwell::ILogFormatter> formatter;
+    if (format == "json") {
+        formatter = std::make_shared<burwell::JsonLogFormatter>();
+    } else if (format == "text") {
+        formatter = std::make_shared<burwell::TextLogFormatter>();
+    } else {
+        std::cerr << "Error: Unknown format '" << format << "' (expected text or json)\n";
+        return 1;
+    }
+
+    if (basePath.empty()) {
+        std::cerr << "Error: Binary log base path is required\n";
+        return 1;
+    }
+
+    burwell::BinaryLogReader reader(basePath);
+    std::string buffer;
+    bool success = reader.read([&](const burwell::LogEntry& entry) {
+        buffer.clear();
+        formatter->formatTo(entry, buffer);
+        std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+    });
+    std::fflush(stdout);
+
+    if (!success) {
+        std::cerr << "Error: " << reader.getLastError() << "\n";
+        return 1;
+    }
+    if (reader.getSkippedRecords() > 0) {
+        std::cerr << "Warning: skipped " << reader.getSkippedRecords() << " undecodable records\n";
+    }
+    return 0;
+}